@@ -553,6 +553,9 @@ cefnetd_incoming_piggyback_process (
 static int										/* No care now							*/
 cefnetd_input_message_from_csmgr_process (
 	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	unsigned char* rcv_buff,					/* receive buffer of the connection		*/
+	uint16_t* rcv_len,							/* length of data in the buffer			*/
+	int member,									/* cluster member (0 for single csmgrd)	*/
 	unsigned char* msg, 						/* the received message(s)				*/
 	int msg_size								/* size of received message(s)			*/
 );
@@ -561,10 +564,18 @@ cefnetd_input_message_from_csmgr_process (
 ----------------------------------------------------------------------------------------*/
 static int									/* Returns a negative value if it fails 	*/
 cefnetd_csmgr_messege_head_seek (
-	CefT_Cs_Stat* cs_stat,
+	unsigned char* rcv_buff,					/* receive buffer of the connection		*/
+	uint16_t* rcv_len,							/* length of data in the buffer			*/
 	uint16_t* payload_len,
 	uint16_t* header_len
 );
+/*--------------------------------------------------------------------------------------
+	Handles the message(s) csmgrd wrote to the shared ring
+----------------------------------------------------------------------------------------*/
+static int										/* No care now							*/
+cefnetd_input_from_csmgr_shm_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+);
 /*--------------------------------------------------------------------------------------
 	Handles the received Interest message
 ----------------------------------------------------------------------------------------*/
@@ -792,6 +803,22 @@ static int										/* No care now							*/
 cefnetd_input_from_txque_process (
 	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
 );
+static int									/* 0: verified, 1: offloaded, -1: failed	*/
+cefnetd_msg_verify (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	uint8_t type, 							/* CefC_PT_INTEREST or CefC_PT_OBJECT		*/
+	int faceid, 							/* Face-ID where messages arrived at		*/
+	int peer_faceid, 						/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	unsigned char* msg, 					/* received message to handle				*/
+	uint16_t payload_len, 					/* Payload Length of this message			*/
+	uint16_t header_len,					/* Header Length of this message			*/
+	char*	user_id
+);
+static void
+cefnetd_verified_msg_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+);
 /*--------------------------------------------------------------------------------------
 	check state of port use
 ----------------------------------------------------------------------------------------*/
@@ -960,6 +987,10 @@ cefnetd_handle_create (
 	hdl->ccninfo_valid_type = CefC_T_CRC32C;	/* ccninfo-05 */
 	strcpy(hdl->ccninfo_sha256_key_prfx ,CefC_Default_CcninfoSha256KeyPrfx);
 	hdl->ccninfo_reply_timeout = CefC_Default_CcninfoReplyTimeout;
+	hdl->verify_thread_num = CefC_Default_VerifyThreadNum;
+	hdl->verify_que_size = CefC_Default_VerifyQueueSize;
+	hdl->verify_cache_size = CefC_Default_VerifyCacheSize;
+	hdl->verify_cache_ttl = CefC_Default_VerifyCacheTtl;
 
 	//0.8.3
 	hdl->IntrestRetrans			= CefC_IntRetrans_Type_RFC;
@@ -1018,6 +1049,27 @@ cefnetd_handle_create (
 			return (NULL);
 		}
 	}
+	/* Creates the cache of the signature verification results 	*/
+	if (hdl->verify_cache_size > 0) {
+		res = cef_valid_vcache_init (
+				(size_t) hdl->verify_cache_size * 1024, hdl->verify_cache_ttl);
+		if (res < 0) {
+			cef_log_write (CefC_Log_Error, "Failed to create the verification cache\n");
+			return (NULL);
+		}
+	}
+
+	/* Starts the threads which verify the signature in the background 	*/
+	if (hdl->verify_thread_num > 0) {
+		res = cef_valid_pool_init (hdl->verify_thread_num, hdl->verify_que_size);
+		if (res < 0) {
+			cef_log_write (CefC_Log_Error, "Failed to start the verification threads\n");
+			return (NULL);
+		}
+		cef_log_write (CefC_Log_Info, "Starting %d verification thread(s) ... OK\n"
+						, hdl->verify_thread_num);
+	}
+
 	/* Clear information used in authentication & authorization */
 	hdl->ccninfousr_id_len = 0;
 	memset (hdl->ccninfousr_node_id, 0, sizeof(hdl->ccninfousr_node_id));
@@ -1333,6 +1385,17 @@ cefnetd_handle_destroy (
 		"<STAT> Frame Size Max   = "FMTU64"\n", stat_rcv_size_max);
 #endif // CefC_Debug
 
+	/* Stops the verification threads 		*/
+	if (hdl->verify_thread_num > 0) {
+		CefT_Valid_Job* job;
+
+		cef_valid_pool_destroy ();
+		while ((job = cef_valid_pool_pop ()) != NULL) {
+			free (job->arg);
+		}
+	}
+	cef_valid_vcache_destroy ();
+
 	cefnetd_faces_destroy (hdl);
 	if (hdl->babel_use_f) {
 		cef_client_babel_sock_name_get (sock_path);
@@ -1462,8 +1525,31 @@ cefnetd_event_dispatch (
 			}
 		}
 
+#ifdef CefC_ContentStore
+		/* Handles the Cobs csmgrd returned through the shared ring 	*/
+		if (hdl->cs_stat->shm != NULL) {
+			cefnetd_input_from_csmgr_shm_process (hdl);
+		}
+		/* Sends the lookups coalesced during the window to csmgrd 	*/
+		if (hdl->cs_stat->lookup_window > 0) {
+			cef_csmgr_excache_lookup_flush (hdl->cs_stat, 0);
+		}
+		/* Takes the sockets of the members which joined or left the cluster, 	*/
+		/* or the socket connected to the single csmgrd again 					*/
+		if (hdl->cs_stat->cluster != NULL) {
+			cef_csmgr_cluster_member_update (hdl->cs_stat);
+		} else if (hdl->cs_stat->cache_type == CefC_Cache_Type_Excache) {
+			cef_csmgr_csmgr_sock_update (hdl->cs_stat);
+		}
+#endif // CefC_ContentStore
+
 		cefnetd_input_from_txque_process (hdl);
 
+		/* Re-injects the messages whose signature has been verified 	*/
+		if (hdl->verify_thread_num > 0) {
+			cefnetd_verified_msg_process (hdl);
+		}
+
 #ifdef CefC_ContentStore
 		if ((hdl->cs_stat->cache_type != CefC_Cache_Type_None) &&
 			(nowt > ccninfo_push_time)) {
@@ -1686,6 +1772,19 @@ cefnetd_poll_socket_prepare (
 		faceids[res] = 0;
 		res++;
 	}
+
+	if (hdl->cs_stat->cluster != NULL) {
+		for (i = 0 ; i < hdl->cs_stat->cluster->member_num ; i++) {
+			if ((hdl->cs_stat->cluster->member[i].sock != -1) &&
+				(hdl->cs_stat->cluster->member[i].down_f == 0)) {
+				fds[res].events = POLLIN | POLLERR;
+				fds[res].fd = hdl->cs_stat->cluster->member[i].sock;
+				fd_type[res] = CefC_Connection_Type_Csm;
+				faceids[res] = 0;
+				res++;
+			}
+		}
+	}
 #endif // CefC_ContentStore
 
 #ifdef CefC_Ccore
@@ -2865,8 +2964,35 @@ cefnetd_csm_input_process (
 
 	recv_len = recv (fd, buff, CefC_Max_Length, 0);
 
+	if (hdl->cs_stat->cluster != NULL) {
+		CefT_Csmgr_Member* mp = NULL;
+		int m;
+
+		for (m = 0 ; m < hdl->cs_stat->cluster->member_num ; m++) {
+			if (hdl->cs_stat->cluster->member[m].sock == fd) {
+				mp = &hdl->cs_stat->cluster->member[m];
+				break;
+			}
+		}
+		if (mp == NULL) {
+			return (1);
+		}
+		if (recv_len > 0) {
+			cefnetd_input_message_from_csmgr_process (
+				hdl, mp->rcv_buff, &mp->rcv_len, m, buff, recv_len);
+		} else {
+			/* Its contents move to the other members until it joins again 	*/
+			cef_csmgr_cluster_member_down (hdl->cs_stat->cluster, fd);
+		}
+		return (1);
+	}
+
 	if (recv_len > 0) {
-		cefnetd_input_message_from_csmgr_process (hdl, buff, recv_len);
+		cefnetd_input_message_from_csmgr_process (
+			hdl, hdl->cs_stat->rcv_buff, &hdl->cs_stat->rcv_len, 0, buff, recv_len);
+	} else if (hdl->cs_stat->cache_type == CefC_Cache_Type_Excache) {
+		/* The sending thread may be using it, so it is closed in the main loop 	*/
+		cef_csmgr_csmgr_sock_down (hdl->cs_stat);
 	} else {
 		cef_log_write (CefC_Log_Warn,
 			"csmgr is down or connection refused, so mode moves to no cache\n");
@@ -4180,6 +4306,9 @@ cefnetd_input_message_process (
 static int										/* No care now							*/
 cefnetd_input_message_from_csmgr_process (
 	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	unsigned char* rcv_buff,					/* receive buffer of the connection		*/
+	uint16_t* rcv_len,							/* length of data in the buffer			*/
+	int member,									/* cluster member (0 for single csmgrd)	*/
 	unsigned char* msg, 						/* the received message(s)				*/
 	int msg_size								/* size of received message(s)			*/
 ) {
@@ -4192,52 +4321,99 @@ cefnetd_input_message_from_csmgr_process (
 	/* Handles the received message(s) 		*/
 	while (msg_size > 0) {
 		/* Calculates the size of the message which have not been yet handled 	*/
-		if (msg_size > CefC_Max_Length - hdl->cs_stat->rcv_len) {
-			move_len = CefC_Max_Length - hdl->cs_stat->rcv_len;
+		if (msg_size > CefC_Max_Length - *rcv_len) {
+			move_len = CefC_Max_Length - *rcv_len;
 		} else {
 			move_len = (uint16_t) msg_size;
 		}
 		msg_size -= move_len;
 
 		/* Updates the receive buffer 		*/
-		memcpy (hdl->cs_stat->rcv_buff + hdl->cs_stat->rcv_len, msg, move_len);
-		hdl->cs_stat->rcv_len += move_len;
+		memcpy (rcv_buff + *rcv_len, msg, move_len);
+		(*rcv_len) += move_len;
 		msg += move_len;
 
-		while (hdl->cs_stat->rcv_len > 0) {
+		while (*rcv_len > 0) {
 			/* Seeks the top of the message */
 			res = cefnetd_csmgr_messege_head_seek (
-						hdl->cs_stat, &fdv_payload_len, &fdv_header_len);
+						rcv_buff, rcv_len, &fdv_payload_len, &fdv_header_len);
 			if (res < 0) {
 				break;
 			}
 
 			/* Calls the function corresponding to the type of the message 	*/
-			if (hdl->cs_stat->rcv_buff[1] > CefC_PT_MAX) {
+			if (rcv_buff[1] == CefC_Csmgr_PT_Presence) {
+				cef_csmgr_presence_msg_process (hdl->cs_stat,
+					rcv_buff + fdv_header_len, fdv_payload_len);
+			} else if (rcv_buff[1] == CefC_Csmgr_PT_Credit) {
+				cef_csmgr_credit_msg_process (hdl->cs_stat, member,
+					rcv_buff + fdv_header_len, fdv_payload_len);
+			} else if (rcv_buff[1] > CefC_PT_MAX) {
 				cef_log_write (CefC_Log_Warn,
 					"Detects the unknown PT_XXX=%d from csmgr\n",
-					hdl->cs_stat->rcv_buff[1]);
+					rcv_buff[1]);
 			} else {
-				(*cefnetd_incoming_csmgr_msg_process[hdl->cs_stat->rcv_buff[1]])
-					(hdl, 0, 0, hdl->cs_stat->rcv_buff, fdv_payload_len, fdv_header_len, user_id);
+				(*cefnetd_incoming_csmgr_msg_process[rcv_buff[1]])
+					(hdl, 0, 0, rcv_buff, fdv_payload_len, fdv_header_len, user_id);
 			}
 
 			/* Updates the receive buffer 		*/
 			move_len = fdv_payload_len + fdv_header_len;
-			wp = hdl->cs_stat->rcv_buff + move_len;
-			memmove( hdl->cs_stat->rcv_buff, wp, hdl->cs_stat->rcv_len - move_len);
-			hdl->cs_stat->rcv_len -= move_len;
+			wp = rcv_buff + move_len;
+			memmove( rcv_buff, wp, *rcv_len - move_len);
+			(*rcv_len) -= move_len;
 		}
 	}
 
 	return (1);
 }
+/*--------------------------------------------------------------------------------------
+	Handles the message(s) csmgrd wrote to the shared ring
+----------------------------------------------------------------------------------------*/
+static int										/* No care now							*/
+cefnetd_input_from_csmgr_shm_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+) {
+	CefT_Csmgr_Shm* shm = hdl->cs_stat->shm;
+	unsigned char* msg;
+	uint16_t msg_len;
+	uint16_t pkt_len;
+	uint16_t hdr_len;
+	struct cef_hdr* chp;
+	char	user_id[512];
+	int n;
+
+	for (n = 0 ; n < CefC_Csmgr_Shm_Batch ; n++) {
+		msg = cef_csmgr_shm_peek (shm, &msg_len);
+		if (msg == NULL) {
+			break;
+		}
+
+		/* The message is handled in place, it stays in the ring until released 	*/
+		chp = (struct cef_hdr*) msg;
+		pkt_len = ntohs (chp->pkt_len);
+		hdr_len = chp->hdr_len;
+
+		if ((msg_len < CefC_S_Fix_Header) || (chp->version != CefC_Version) ||
+			(chp->type > CefC_PT_MAX) || (pkt_len != msg_len) || (hdr_len > pkt_len)) {
+			cef_log_write (CefC_Log_Warn,
+				"Detects the invalid message in the shared ring from csmgr\n");
+		} else {
+			(*cefnetd_incoming_csmgr_msg_process[chp->type])
+				(hdl, 0, 0, msg, pkt_len - hdr_len, hdr_len, user_id);
+		}
+		cef_csmgr_shm_release (shm);
+	}
+
+	return (1);
+}
 /*--------------------------------------------------------------------------------------
 	Seeks the top of the frame from the receive buffer
 ----------------------------------------------------------------------------------------*/
 static int									/* Returns a negative value if it fails 	*/
 cefnetd_csmgr_messege_head_seek (
-	CefT_Cs_Stat* cs_stat,
+	unsigned char* rcv_buff,					/* receive buffer of the connection		*/
+	uint16_t* rcv_len,							/* length of data in the buffer			*/
 	uint16_t* payload_len,
 	uint16_t* header_len
 ) {
@@ -4252,15 +4428,15 @@ cefnetd_csmgr_messege_head_seek (
 	uint16_t pkt_len;
 	uint16_t hdr_len;
 
-	while (cs_stat->rcv_len > 7) {
-		chp = (struct cef_hdr*) &(cs_stat->rcv_buff[index]);
+	while (*rcv_len > 7) {
+		chp = (struct cef_hdr*) &(rcv_buff[index]);
 
 		pkt_len = ntohs (chp->pkt_len);
 		hdr_len = chp->hdr_len;
 
 		if (chp->version != CefC_Version) {
-			wp = &cs_stat->rcv_buff[index];
-			ep = cs_stat->rcv_buff + index + cs_stat->rcv_len;
+			wp = &rcv_buff[index];
+			ep = rcv_buff + index + *rcv_len;
 			move_len = 0;
 
 			while (wp < ep) {
@@ -4269,10 +4445,10 @@ cefnetd_csmgr_messege_head_seek (
 				} else {
 					move_len = ep - wp;
 					memcpy (buff, wp, move_len);
-					memcpy (cs_stat->rcv_buff, buff, move_len);
-					cs_stat->rcv_len -= wp - cs_stat->rcv_buff;
+					memcpy (rcv_buff, buff, move_len);
+					(*rcv_len) -= wp - rcv_buff;
 
-					chp = (struct cef_hdr*) &(cs_stat->rcv_buff);
+					chp = (struct cef_hdr*) rcv_buff;
 					pkt_len = ntohs (chp->pkt_len);
 					hdr_len = chp->hdr_len;
 					index = 0;
@@ -4285,13 +4461,14 @@ cefnetd_csmgr_messege_head_seek (
 				}
 			}
 			if (move_len == 0) {
-				cs_stat->rcv_len = 0;
+				*rcv_len = 0;
 				return (-1);
 			}
 		}
 
-		if (chp->type > CefC_PT_MAX) {
-			cs_stat->rcv_len--;
+		if ((chp->type > CefC_PT_MAX) &&
+			(chp->type != CefC_Csmgr_PT_Presence) && (chp->type != CefC_Csmgr_PT_Credit)) {
+			(*rcv_len)--;
 			index++;
 			continue;
 		}
@@ -4300,11 +4477,11 @@ cefnetd_csmgr_messege_head_seek (
 		*payload_len 	= pkt_len - hdr_len;
 		*header_len 	= hdr_len;
 
-		if (cs_stat->rcv_len < *payload_len + *header_len) {
+		if (*rcv_len < *payload_len + *header_len) {
 			short_step++;
 			if (short_step > 2) {
 				short_step = 0;
-				cs_stat->rcv_len--;
+				(*rcv_len)--;
 				index++;
 				continue;
 			}
@@ -4312,7 +4489,7 @@ cefnetd_csmgr_messege_head_seek (
 		}
 
 		if (index > 0) {
-			memmove (cs_stat->rcv_buff, cs_stat->rcv_buff + index, cs_stat->rcv_len);
+			memmove (rcv_buff, rcv_buff + index, *rcv_len);
 		}
 		short_step = 0;
 		return (1);
@@ -4465,9 +4642,10 @@ cefnetd_incoming_interest_process (
 	}
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	res = cefnetd_msg_verify (hdl, CefC_PT_INTEREST, faceid, peer_faceid,
+								msg, payload_len, header_len, user_id);
 	if (res != 0) {
-		return (-1);
+		return ((res > 0) ? 1 : -1);
 	}
 
 	//0.8.3
@@ -4958,6 +5136,95 @@ FORWARD_INTEREST:
 
 	return (1);
 }
+/*--------------------------------------------------------------------------------------
+	Verifies the received message, or queues it to the verification threads
+	if it is signed with RSA-SHA256
+----------------------------------------------------------------------------------------*/
+static int									/* 0: verified, 1: offloaded, -1: failed	*/
+cefnetd_msg_verify (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	uint8_t type, 							/* CefC_PT_INTEREST or CefC_PT_OBJECT		*/
+	int faceid, 							/* Face-ID where messages arrived at		*/
+	int peer_faceid, 						/* Face-ID to reply to the origin of 		*/
+											/* transmission of the message(s)			*/
+	unsigned char* msg, 					/* received message to handle				*/
+	uint16_t payload_len, 					/* Payload Length of this message			*/
+	uint16_t header_len,					/* Header Length of this message			*/
+	char*	user_id
+) {
+	CefT_Vrf_Elem* elem;
+	int msg_len = payload_len + header_len;
+
+	/* The re-injected message has already been verified 	*/
+	if (hdl->verify_reinject_f) {
+		return (0);
+	}
+
+	if ((hdl->verify_thread_num > 0) &&
+		(cef_valid_msg_alg_get (msg, msg_len) == CefC_T_RSA_SHA256)) {
+
+		elem = (CefT_Vrf_Elem*) malloc (sizeof (CefT_Vrf_Elem) + msg_len);
+		if (elem != NULL) {
+			elem->type 			= type;
+			elem->faceid 		= faceid;
+			elem->peer_faceid 	= peer_faceid;
+			elem->payload_len 	= payload_len;
+			elem->header_len 	= header_len;
+			elem->user_id[0] 	= 0x00;
+			if (user_id != NULL) {
+				strncpy (elem->user_id, user_id, CefC_Vrf_User_Id_Len - 1);
+				elem->user_id[CefC_Vrf_User_Id_Len - 1] = 0x00;
+			}
+			memcpy (elem->msg, msg, msg_len);
+			elem->job.msg 		= elem->msg;
+			elem->job.msg_len 	= msg_len;
+			elem->job.res 		= -1;
+			elem->job.arg 		= elem;
+
+			if (cef_valid_pool_push (&elem->job) > 0) {
+				return (1);
+			}
+			/* The pool is full, so verifies it on this thread 	*/
+			free (elem);
+		}
+	}
+
+	return ((cef_valid_msg_verify (msg, msg_len) == 0) ? 0 : -1);
+}
+/*--------------------------------------------------------------------------------------
+	Handles the messages whose verification has been completed
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_verified_msg_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+) {
+	CefT_Valid_Job* job;
+	CefT_Vrf_Elem* elem;
+	int cnt = 0;
+
+	while (cnt < CefC_Vrf_Reinject_Max) {
+		job = cef_valid_pool_pop ();
+		if (job == NULL) {
+			break;
+		}
+		elem = (CefT_Vrf_Elem*) job->arg;
+
+		if (job->res == 0) {
+			hdl->verify_reinject_f = 1;
+			(*cefnetd_incoming_msg_process[elem->type])
+				(hdl, elem->faceid, elem->peer_faceid,
+					elem->msg, elem->payload_len, elem->header_len, elem->user_id);
+			hdl->verify_reinject_f = 0;
+		}
+#ifdef	__VALID_NG__
+		else {
+			fprintf( stderr, "[%s] Validation NG\n", __func__ );
+		}
+#endif
+		free (elem);
+		cnt++;
+	}
+}
 /*--------------------------------------------------------------------------------------
 	Handles the received Content Object message
 ----------------------------------------------------------------------------------------*/
@@ -5008,7 +5275,12 @@ cefnetd_incoming_object_process (
 	pkt_len = payload_len + header_len;	//0.8.3
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	res = cefnetd_msg_verify (hdl, CefC_PT_OBJECT, faceid, peer_faceid,
+								msg, payload_len, header_len, user_id);
+	if (res > 0) {
+		/* Processed again after the offloaded verification 	*/
+		return (1);
+	}
 	if (res != 0) {
 #ifdef	__VALID_NG__
 		fprintf( stderr, "[%s] Validation NG\n", __func__ );
@@ -7033,6 +7305,44 @@ cefnetd_config_read (
 			}
 			hdl->ccninfo_reply_timeout =  res;
 		}
+		else if (strcasecmp (pname, CefC_ParamName_VerifyThreadNum) == 0) {
+			res = atoi (ws);
+			if (!(0 <= res && res <= CefC_Valid_Pool_Thread_Max)) {
+				cef_log_write (CefC_Log_Error
+				               , "VERIFY_THREAD_NUM must be higher than or equal to 0 and lower than or equal to %d.\n"
+				               , CefC_Valid_Pool_Thread_Max);
+				return (-1);
+			}
+			hdl->verify_thread_num = res;
+		}
+		else if (strcasecmp (pname, CefC_ParamName_VerifyQueueSize) == 0) {
+			res = atoi (ws);
+			if (!(1 <= res && res <= CefC_Valid_Pool_Que_Max)) {
+				cef_log_write (CefC_Log_Error
+				               , "VERIFY_QUEUE_SIZE must be higher than 0 and lower than or equal to %d.\n"
+				               , CefC_Valid_Pool_Que_Max);
+				return (-1);
+			}
+			hdl->verify_que_size = res;
+		}
+		else if (strcasecmp (pname, CefC_ParamName_VerifyCacheSize) == 0) {
+			res = atoi (ws);
+			if (res < 0) {
+				cef_log_write (CefC_Log_Error
+				               , "VERIFY_CACHE_SIZE must be higher than or equal to 0.\n");
+				return (-1);
+			}
+			hdl->verify_cache_size = res;
+		}
+		else if (strcasecmp (pname, CefC_ParamName_VerifyCacheTtl) == 0) {
+			res = atoi (ws);
+			if (res < 1) {
+				cef_log_write (CefC_Log_Error
+				               , "VERIFY_CACHE_TTL must be higher than 0.\n");
+				return (-1);
+			}
+			hdl->verify_cache_ttl = res;
+		}
 
 		else if (strcasecmp (pname, CefC_ParamName_Node_Name) == 0) {
 			unsigned char	out_name[CefC_Max_Length];
@@ -7314,6 +7624,10 @@ cefnetd_config_read (
 								, hdl->ccninfo_sha256_key_prfx);
 	cef_dbg_write (CefC_Dbg_Fine, "CCNINFO_REPLY_TIMEOUT = %d\n"
 								, hdl->ccninfo_reply_timeout);
+	cef_dbg_write (CefC_Dbg_Fine, "VERIFY_THREAD_NUM = %d\n", hdl->verify_thread_num);
+	cef_dbg_write (CefC_Dbg_Fine, "VERIFY_QUEUE_SIZE = %d\n", hdl->verify_que_size);
+	cef_dbg_write (CefC_Dbg_Fine, "VERIFY_CACHE_SIZE = %u\n", hdl->verify_cache_size);
+	cef_dbg_write (CefC_Dbg_Fine, "VERIFY_CACHE_TTL = %u\n", hdl->verify_cache_ttl);
 
 	if ( hdl->My_Node_Name != NULL ) {
 		cef_dbg_write (CefC_Dbg_Fine, "NODE_NAME = %s\n", hdl->My_Node_Name );
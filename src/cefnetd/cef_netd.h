@@ -122,6 +122,13 @@
 
 #define CefC_Listen_Face_Max		CefC_Face_Router_Max
 
+/*------------------------------------------------------------------*/
+/* Verification offload												*/
+/*------------------------------------------------------------------*/
+
+#define CefC_Vrf_User_Id_Len		512
+#define CefC_Vrf_Reinject_Max		256		/* maximum messages re-injected at once		*/
+
 /* cefstatus output option */
 #define CefC_Ctrl_StatusOpt_Stat	0x0001
 #define CefC_Ctrl_StatusOpt_Metric	0x0002
@@ -172,6 +179,20 @@ typedef struct {
 
 } CefT_Nbrs;
 
+/********** Message waiting for the offloaded verification 	***********/
+typedef struct {
+
+	CefT_Valid_Job		job;
+	uint8_t 			type;					/* CefC_PT_INTEREST or CefC_PT_OBJECT	*/
+	int 				faceid;					/* Face-ID where the message arrived at	*/
+	int 				peer_faceid;			/* Face-ID to reply to					*/
+	uint16_t 			payload_len;
+	uint16_t 			header_len;
+	char				user_id[CefC_Vrf_User_Id_Len];
+	unsigned char 		msg[1];					/* copy of the message (variable length)*/
+
+} CefT_Vrf_Elem;
+
 /********** cefned main handle  	***********/
 typedef struct {
 
@@ -282,6 +303,17 @@ typedef struct {
 												/*  This value must be 					*/
 												/*  higher than or equal to 2 			*/
 												/*  and lower than or equal to 5.		*/
+	int 				verify_thread_num;		/* Number of threads which verify the 	*/
+												/* RSA-SHA256 signature. 0 means the 	*/
+												/* signature is verified inline. 		*/
+	int 				verify_que_size;		/* Maximum number of messages waiting 	*/
+												/* for the offloaded verification 		*/
+	int 				verify_reinject_f;		/* 1 while re-injecting the verified 	*/
+												/* message 								*/
+	uint32_t 			verify_cache_size;		/* Memory for the cache of RSA-SHA256 	*/
+												/* verification results [KB]. 			*/
+												/* 0 means the cache is not used. 		*/
+	uint32_t 			verify_cache_ttl;		/* Lifetime of the cached result [sec] 	*/
 
 	/********** Tables				***********/
 	CefT_Hash_Handle	fib;					/* FIB 									*/
@@ -54,7 +54,7 @@
 #include <cefore/cef_frame.h>
 #include <cefore/cef_print.h>
 #include <cefore/cef_plugin_com.h>
-#if ((defined CefC_CefnetdCache) && (defined CefC_Develop))
+#ifdef CefC_CefnetdCache
 #include <cefore/cef_mem_cache.h>
 #endif
 
@@ -223,6 +223,107 @@ cef_status_stats_output (
 			(unsigned long long)hdl->stat_send_frames,
 			cache_type,
 			hdl->forwarding_strategy);
+	if (hdl->verify_thread_num > 0) {
+		CefT_Valid_Pool_Stat vstat;
+
+		cef_valid_pool_stat_get (&vstat);
+		sprintf (work_str,
+			"Verify Offload   : %d threads, Queue %d/%d (Max %d)\n"
+			"                   Queued %llu, Verified %llu, NG %llu, Backpressure %llu\n",
+			vstat.thread_num, vstat.que_num, vstat.que_size, vstat.que_max,
+			(unsigned long long) vstat.push_num,
+			(unsigned long long) vstat.done_num,
+			(unsigned long long) vstat.ng_num,
+			(unsigned long long) vstat.full_num);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+
+	if (hdl->verify_cache_size > 0) {
+		CefT_Valid_Vcache_Stat cstat;
+
+		cef_valid_vcache_stat_get (&cstat);
+		sprintf (work_str,
+			"Verify Cache     : Entries %u/%u, Hit %llu, Miss %llu, "
+			"Evicted %llu, Invalidated %llu\n",
+			cstat.entry_num, cstat.entry_max,
+			(unsigned long long) cstat.hit_num,
+			(unsigned long long) cstat.miss_num,
+			(unsigned long long) cstat.evict_num,
+			(unsigned long long) cstat.invalidate_num);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+
+	if ((hdl->cs_stat) && (hdl->cs_stat->cache_type == CefC_Cache_Type_Excache)) {
+		CefT_Csmgr_Insert_Stat istat;
+		char* policy;
+
+		cef_csmgr_insert_stat_get (hdl->cs_stat, &istat);
+		switch (istat.policy) {
+			case CefC_Csmgr_Insert_Drop_Oldest: {
+				policy = "drop_oldest";
+				break;
+			}
+			case CefC_Csmgr_Insert_Sample: {
+				policy = "sample";
+				break;
+			}
+			default: {
+				policy = "drop_newest";
+				break;
+			}
+		}
+		sprintf (work_str,
+			"Csmgr Insert     : Queue %llu/%llu KB, Policy %s, Flow %s\n"
+			"                   Queued %llu, Sent %llu, Dropped %llu, Retried %llu Bytes\n"
+			"                   Requests Dropped %llu\n",
+			(unsigned long long)(istat.used / 1024),
+			(unsigned long long)(istat.size / 1024),
+			policy,
+			(istat.credit_f) ? "Credit" : "Free",
+			(unsigned long long) istat.queued_bytes,
+			(unsigned long long) istat.sent_bytes,
+			(unsigned long long) istat.dropped_bytes,
+			(unsigned long long) istat.retried_bytes,
+			(unsigned long long) istat.req_dropped);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+
+#ifdef CefC_CefnetdCache
+	if ((hdl->cs_stat) && (hdl->cs_stat->cache_type == CefC_Cache_Type_Localcache)) {
+		CefMemCacheT_Stat mstat;
+		uint64_t frag = 0;
+
+		cef_mem_cache_stat_get (&mstat);
+		if (mstat.slab.used_bytes > 0) {
+			frag = (mstat.slab.used_bytes - mstat.slab.req_bytes) * 100
+						/ mstat.slab.used_bytes;
+		}
+		sprintf (work_str,
+			"Local Cache      : Entries %u/%u, Memory %llu/%llu KB, Evicted %llu, Rejected %llu\n"
+			"                   Slab %llu KB reserved, %llu KB used, "
+			"Fragmentation %llu%%, Classes %d, Large %llu\n",
+			mstat.entry_num, mstat.entry_max,
+			(unsigned long long)(mstat.mem_used / 1024),
+			(unsigned long long)(mstat.mem_max / 1024),
+			(unsigned long long) mstat.evict_num,
+			(unsigned long long) mstat.reject_num,
+			(unsigned long long)(mstat.slab.reserved_bytes / 1024),
+			(unsigned long long)(mstat.slab.used_bytes / 1024),
+			(unsigned long long) frag,
+			mstat.slab.class_num,
+			(unsigned long long) mstat.slab.large_num);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
+#endif //CefC_CefnetdCache
+
 #ifdef CefC_INTEREST_RETURN
 	sprintf (work_str, "Interest Return  : %s\n"
 		, (hdl->IR_Option != 1) ? "Disabled" : "Enabled");
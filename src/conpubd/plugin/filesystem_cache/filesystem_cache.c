@@ -60,6 +60,7 @@
 #include "filesystem_cache.h"
 #include <cefore/cef_client.h>
 #include <cefore/cef_conpub.h>
+#include <cefore/cef_csmgr.h>
 #include <cefore/cef_frame.h>
 #include <conpubd/conpubd_plugin.h>
 
@@ -91,6 +92,17 @@
 
 #define FSC_RECORD_CORRECT_SIZE		CefC_Max_Header_Size
 
+#define FscC_Rec_Lz				0x0001			/* the msg is compressed			*/
+#define FscC_Comp_Min_Len		128				/* Shorter cobs are stored raw		*/
+#define FscC_Comp_Rate			88				/* Cobs compressed to more than 	*/
+												/* this rate (%) are stored raw		*/
+#define FscC_Comp_Fail_Max		32				/* Cobs stored raw in a row before	*/
+												/* the compression is tried 		*/
+												/* only sometimes					*/
+#define FscC_Comp_Probe			64				/* Interval (cobs) of the tries		*/
+
+#define FscC_Aio_Thread_Num		2				/* I/O threads if io_uring is not used	*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -110,6 +122,16 @@ typedef struct {
 
 } ConpubdT_Content_Fsc_Entry;
 
+/***** page read waited by the lookup out of the lock *****/
+typedef struct {
+
+	CefT_Csmgr_Aio_Req	req;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		cond;
+	int					done_f;
+
+} FscT_Page_Read;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -122,6 +144,24 @@ static pthread_mutex_t 			conpub_fsc_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static ConpubdT_Content_Entry* 	fsc_proc_cob_buff = NULL;
 
+/* The records keep the compressed msg in the page files, and the msg is 	*/
+/* decompressed when it is sent 											*/
+static int 						fsc_comp_f = 0;
+static int 						fsc_comp_fail = 0;
+static uint32_t 				fsc_comp_cnt = 0;
+static uint64_t 				fsc_comp_raw = 0;
+static uint64_t 				fsc_comp_stored = 0;
+static uint64_t 				fsc_comp_skip = 0;
+static uint64_t 				fsc_comp_ns = 0;
+static uint64_t 				fsc_decomp_cobs = 0;
+static uint64_t 				fsc_decomp_ns = 0;
+static unsigned char 			fsc_unz_buf[UINT16_MAX];
+
+/* The pages are read and written out of the lock, and the generation of the 	*/
+/* index drops the I/O of the content removed meanwhile 						*/
+static CefT_Csmgr_Aio* 			fsc_aio = NULL;
+static uint32_t* 				fsc_cont_gen = NULL;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -177,6 +217,54 @@ fsc_cache_cob_write (
 	ConpubdT_Content_Entry* cobs, 
 	int cob_num
 );
+/*--------------------------------------------------------------------------------------
+	Sets the msg of the cob to the record, compressed if it is worth it
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_set (
+	ConpubdT_Content_Entry* entry,				/* cob 									*/
+	unsigned char* rec							/* record to be written 				*/
+);
+/*--------------------------------------------------------------------------------------
+	Reads the block of the page file through the disk I/O engine
+----------------------------------------------------------------------------------------*/
+static int							/* read length, negative if an error occurs			*/
+fsc_page_read (
+	const char* file_path,						/* page file 							*/
+	unsigned char* buf,							/* buffer for the block 				*/
+	size_t len,									/* length of the block 					*/
+	off_t off									/* offset of the block 					*/
+);
+/*--------------------------------------------------------------------------------------
+	Completes the page read
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_read_done (
+	CefT_Csmgr_Aio_Req* req
+);
+/*--------------------------------------------------------------------------------------
+	Removes the content and its directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_remove (
+	CsmgrT_Stat* rcd							/* content information 					*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the cob in the record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_send (
+	int sock,									/* socket to send the cob 				*/
+	unsigned char* rec,							/* record 								*/
+	uint64_t cachetime							/* cache time set to the cob 			*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the monotonic time (ns) to measure the compression
+----------------------------------------------------------------------------------------*/
+static uint64_t
+fsc_comp_time_get (
+	void
+);
 /*--------------------------------------------------------------------------------------
 	Read config file
 ----------------------------------------------------------------------------------------*/
@@ -303,8 +391,22 @@ fsc_cs_create (
 	}
 	cobpub_hdl->cache_capacity = conf_param.cache_capacity;
 	cobpub_hdl->cache_cobs = 0;
+	
+	fsc_cont_gen = (uint32_t*) calloc (CsmgrT_Stat_Max, sizeof (uint32_t));
+	if (fsc_cont_gen == NULL) {
+		conpubd_log_write (CefC_Log_Error, "malloc error\n");
+		return (-1);
+	}
+	fsc_aio = cef_csmgr_aio_create (FscC_Aio_Thread_Num);
+	if (fsc_aio == NULL) {
+		conpubd_log_write (CefC_Log_Error, "Failed to create the disk I/O engine\n");
+		return (-1);
+	}
+	conpubd_log_write (CefC_Log_Info, "Disk I/O : %s\n", 
+		(fsc_aio->type == CefC_Csmgr_Aio_Type_Uring) ? "io_uring" : "threads");
 	strcpy (cobpub_hdl->fsc_root_path, conf_param.cache_path);
 	cobpub_hdl->cache_default_rct = conf_param.cache_default_rct;
+	fsc_comp_f = conf_param.compression;
 	
 	/* Check and create root directory	*/
 	if (fsc_root_dir_check (cobpub_hdl->fsc_root_path) < 0) {
@@ -326,6 +428,9 @@ fsc_cs_create (
 	conpubd_log_write (CefC_Log_Info, "Start\n");
 	conpubd_log_write (CefC_Log_Info, "Capacity : "FMTU64"\n", cobpub_hdl->cache_capacity);
 	conpubd_log_write (CefC_Log_Info, "cache_default_rct : %u\n", cobpub_hdl->cache_default_rct);
+	if (fsc_comp_f) {
+		conpubd_log_write (CefC_Log_Info, "Compression : lz\n");
+	}
 	conpub_stat_hdl = stat_hdl;
 	conpubd_stat_cache_capacity_update (conpub_stat_hdl, cobpub_hdl->cache_capacity);
 	
@@ -348,11 +453,25 @@ fsc_cs_destroy (
 	void
 ) {
 
+	if (fsc_aio) {
+		cef_csmgr_aio_destroy (fsc_aio);
+		fsc_aio = NULL;
+	}
 	pthread_mutex_destroy (&conpub_fsc_cs_mutex);
 	
 	if (cobpub_hdl == NULL) {
 		return;
 	}
+	if (fsc_comp_raw > 0) {
+		conpubd_log_write (CefC_Log_Info, 
+			"Compression : "FMTU64" -> "FMTU64" bytes (%.1f%%), "FMTU64" raw cobs, "
+			FMTU64" us\n", fsc_comp_raw, fsc_comp_stored, 
+			(double) fsc_comp_stored * 100.0 / (double) fsc_comp_raw, 
+			fsc_comp_skip, fsc_comp_ns / 1000);
+		conpubd_log_write (CefC_Log_Info, 
+			"Decompression : "FMTU64" cobs, "FMTU64" us\n", 
+			fsc_decomp_cobs, fsc_decomp_ns / 1000);
+	}
 	if (cobpub_hdl->fsc_cache_path[0] != 0x00) {
 		fsc_recursive_dir_clear (cobpub_hdl->fsc_cache_path);
 	}
@@ -361,6 +480,10 @@ fsc_cs_destroy (
 		free (cobpub_hdl);
 		cobpub_hdl = NULL;
 	}
+	if (fsc_cont_gen) {
+		free (fsc_cont_gen);
+		fsc_cont_gen = NULL;
+	}
 	
 	return;
 	
@@ -375,7 +498,6 @@ fsc_cs_expire_check (
 ) {
 	int 			index = 0;
 	CsmgrT_Stat* 	rcd = NULL;
-	char			file_path[PATH_MAX];
 	
 	if (pthread_mutex_trylock (&conpub_fsc_cs_mutex) != 0) {
 		return;
@@ -385,12 +507,7 @@ fsc_cs_expire_check (
 		if (!rcd) {
 			break;
 		}
-
-		sprintf (file_path, "%s/%d", cobpub_hdl->fsc_cache_path, (int) rcd->index);
-		fsc_recursive_dir_clear (file_path);
-
-		conpubd_stat_content_info_delete (conpub_stat_hdl, rcd->name, rcd->name_len);
-		cobpub_hdl->cache_cobs -= rcd->cob_num;
+		fsc_content_remove (rcd);
 	}
 	pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 	
@@ -418,15 +535,20 @@ fsc_cache_item_get (
 	static char	red_file_path[PATH_MAX] = {0};
 	int 		cob_block_index;
 	static int  red_cob_block_index = -1;
-	int			rtc;
+	static int  red_rcdsize = 0;
 	int 		page_index;
 	int 		pos_index;
-	FILE*		fp = NULL;
+	uint16_t 	rec_len;
+	uint32_t 	con_index;
+	uint32_t 	con_gen;
+	unsigned char* 	read_buf;
+	int 		read_len;
 	int 		i;
 	int 		tx_cnt = 0;
 	int			resend_1cob_f = 0;
 	int			send_cob_f = 0;
 	uint64_t	nowt;
+	uint64_t	cachetime;
 	struct timeval tv;
 	static unsigned char*	page_cob_buf = NULL;
 	int			rcdsize;
@@ -449,15 +571,13 @@ fsc_cache_item_get (
 #ifdef CefC_Debug
 		conpubd_dbg_write (CefC_Dbg_Fine, "Delete the expired content = %s\n", file_path);
 #endif // CefC_Debug
-		fsc_recursive_dir_clear (file_path);
-		conpubd_stat_content_info_delete (conpub_stat_hdl, key, key_size);
-		cobpub_hdl->cache_cobs -= rcd->cob_num;
+		fsc_content_remove (rcd);
 		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 		return (-1);
 	}
 	
 	file_msglen = rcd->file_msglen;
-	rcdsize = sizeof (uint16_t) + file_msglen;
+	rcdsize = sizeof (FscT_Rec_Head) + file_msglen;
 	
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
@@ -499,28 +619,63 @@ fsc_cache_item_get (
 		update_ver = 0;
 	}
 	
+	/* The cached block may have been read before the requested cob was written 	*/
+	pos_index = (int)(seqno % FscC_Page_Cob_Num);
+	if (rcdsize != red_rcdsize) {
+		red_file_path[0] = 0x00;
+	} else if ((strcmp (red_file_path, file_path) == 0) && 
+				(cob_block_index == red_cob_block_index)) {
+		memcpy (&rec_len, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
+		mask = 1;
+		x = seqno / 64;
+		mask <<= (seqno % 64);
+		if ((rec_len == 0) && ((rcd->map_max-1) >= x) && (rcd->cob_map[x] & mask)) {
+			red_file_path[0] = 0x00;
+		}
+	}
+	
 	if (strcmp (red_file_path, file_path) != 0 || cob_block_index != red_cob_block_index ||
 		(strcmp (red_file_path, file_path) == 0 && update_ver != 0)) {
-		if (page_cob_buf != NULL) {
-			free (page_cob_buf);
-			page_cob_buf = NULL;
+		
+		/* The block is read without the lock, and dropped if the content is 	*/
+		/* removed while it is read 											*/
+		con_index 	= rcd->index;
+		con_gen 	= fsc_cont_gen[con_index];
+		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
+		
+		/* The records are written up to their length, so the block is read at 	*/
+		/* once and the rest of the last record is left zero 					*/
+		read_buf = calloc (FscC_Page_Cob_Num, rcdsize);
+		if (read_buf == NULL) {
+			return (-1);
 		}
-
-		fp = fopen (file_path, "rb");
-		if (fp == NULL) {
+		read_len = fsc_page_read (file_path, read_buf, (size_t) rcdsize * FscC_Page_Cob_Num, 
+						(off_t)((int64_t)cob_block_index * (int64_t)rcdsize * FscC_Page_Cob_Num));
+		
+		pthread_mutex_lock (&conpub_fsc_cs_mutex);
+		rcd = csmgr_stat_content_is_exist (conpub_stat_hdl, key, key_size);
+		if ((rcd == NULL) || (rcd->index != con_index) || 
+			(fsc_cont_gen[con_index] != con_gen) || (rcd->file_msglen != file_msglen)) {
+			pthread_mutex_unlock (&conpub_fsc_cs_mutex);
+			free (read_buf);
+			return (-1);
+		}
+		if (read_len < 0) {
 			conpubd_log_write (CefC_Log_Error, "Failed to open the cache file (%s)\n", file_path);
-			goto ItemGetPost;
+			pthread_mutex_unlock (&conpub_fsc_cs_mutex);
+			free (read_buf);
+			return (0);
+		}
+		if (read_len == 0) {
+			conpubd_log_write (CefC_Log_Error, "Failed to read the cache file (%s)\n", file_path);
 		}
+		if (page_cob_buf != NULL) {
+			free (page_cob_buf);
+		}
+		page_cob_buf = read_buf;
+		red_rcdsize = rcdsize;
 		strcpy (red_file_path, file_path);
 		red_cob_block_index = cob_block_index;
-		page_cob_buf = calloc (FscC_Page_Cob_Num, rcdsize);
-		fseek (fp, (int64_t)cob_block_index * (int64_t)rcdsize * FscC_Page_Cob_Num, SEEK_SET);
-		for (int i=0; i<FscC_Page_Cob_Num; i++) {
-			rtc = fread (&page_cob_buf[i*rcdsize], rcdsize, 1, fp);
-			if (rtc != 1) {
-				break;
-			}
-		}
 		if (red_ver_len) {
 			memset (red_version, 0, PATH_MAX);
 		}
@@ -528,12 +683,9 @@ fsc_cache_item_get (
 		if (ver_len) {
 			memcpy (red_version, version, ver_len);
 		}
-	} else {
-		fp = NULL;
 	}
 	
 	/* Send the cobs 		*/
-	pos_index = (int)(seqno % FscC_Page_Cob_Num);
 #ifdef CefC_Debug
 	{
 		uint16_t mlen;
@@ -546,22 +698,14 @@ fsc_cache_item_get (
 	
 	/* Set cache time */
 	{
-	uint64_t cachetime;
 	time_t timer = time (NULL);
 	struct tm* local = localtime (&timer);
 	time_t now_time = mktime (local);
 	cachetime = (uint64_t)(now_time + cobpub_hdl->cache_default_rct) * 1000;
-	cef_frame_opheader_cachetime_update (&page_cob_buf[pos_index*rcdsize+sizeof (uint16_t)], cachetime);
 	}
 	/* Send Cob to cefnetd */
-	uint16_t mlen;
-	memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-	conpubd_plugin_cob_msg_send (
-						sock, &page_cob_buf[pos_index*rcdsize+sizeof (uint16_t)], mlen);
+	fsc_rec_send (sock, &page_cob_buf[pos_index*rcdsize], cachetime);
 	if (resend_1cob_f == 1) {
-		if (fp != NULL) {
-			fclose (fp);
-		}
 		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 		return (0);
 	}
@@ -585,21 +729,7 @@ fsc_cache_item_get (
 				conpubd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
 			}
 #endif // CefC_Debug
-	/* Set cache time */
-			{
-			uint64_t cachetime;
-			time_t timer = time (NULL);
-			struct tm* local = localtime (&timer);
-			time_t now_time = mktime (local);
-			cachetime = (uint64_t)(now_time + cobpub_hdl->cache_default_rct) * 1000;
-			cef_frame_opheader_cachetime_update (&page_cob_buf[i*rcdsize+sizeof (uint16_t)], cachetime);
-			}
-			uint16_t mlen;
-			memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-			if (mlen != 0) {
-				conpubd_plugin_cob_msg_send (
-					sock, &page_cob_buf[i*rcdsize+sizeof (uint16_t)], mlen);
-			}
+			fsc_rec_send (sock, &page_cob_buf[i*rcdsize], cachetime);
 			tx_cnt++;
 			seqno++;
 		} else {
@@ -607,10 +737,6 @@ fsc_cache_item_get (
 		}
 	}
 	
-ItemGetPost:
-	if (fp != NULL) {
-		fclose (fp);
-	}
 	pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 	return (0);
 }
@@ -630,18 +756,14 @@ fsc_cache_item_puts (
 	
 	if (entry == NULL) {
 		if (cob_num != 0) {
-			pthread_mutex_lock (&conpub_fsc_cs_mutex);
 			rtc = fsc_cache_cob_write (fsc_proc_cob_buff, cob_num);
-			pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 			cob_num = 0;
 		}
 	} else {
 		memcpy (&fsc_proc_cob_buff[cob_num], entry, sizeof (ConpubdT_Content_Entry));
 		cob_num ++;
 		if (cob_num == ConpubC_Buff_Num) {
-			pthread_mutex_lock (&conpub_fsc_cs_mutex);
 			rtc = fsc_cache_cob_write (fsc_proc_cob_buff, cob_num);
-			pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 			cob_num = 0;
 		}
 	}
@@ -659,9 +781,10 @@ fsc_cache_cob_write (
 	uint64_t nowt;
 	struct timeval tv;
 	CsmgrT_Stat* 	rcd = NULL;
-	unsigned char 	name[CsmgrT_Name_Max];
-	uint16_t 		name_len = 0;
 	int				work_con_index = -1;
+	uint32_t		work_con_gen = 0;
+	uint32_t		con_index;
+	uint32_t		con_gen;
 	int 			prev_page_index = -1;
 	int 			work_page_index;
 	char			file_path[PATH_MAX];
@@ -669,10 +792,14 @@ fsc_cache_cob_write (
 	int 			rcdsize;
 	char			cont_path[PATH_MAX];
 	FILE*			fp = NULL;
-	int				rbpflag = 0;
-	int				swindx[FscC_Page_Cob_Num];
 	uint32_t		file_msglen;
+	uint64_t 		mask;
+	uint32_t 		x;
 	CsmgrT_DB_COB_MAP**	cob_map = NULL;		//0.8.3c
+	unsigned char 	wbuff[sizeof (FscT_Rec_Head) + UINT16_MAX];
+	FscT_Rec_Head 	rec_head;
+	int 			write_index;
+	struct stat 	st;
 	
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
@@ -684,114 +811,128 @@ fsc_cache_cob_write (
 		if (cobs[index].expiry < nowt) {
 			goto NEXTCOB;
 		}
+		
+		/* Takes the content information, the cob is written out of the lock 	*/
+		pthread_mutex_lock (&conpub_fsc_cs_mutex);
 		if (cobpub_hdl->cache_cobs >= cobpub_hdl->cache_capacity) {
+			pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 			goto NEXTCOB;
 		}
-		/* Update the directory to write the received cob 		*/
-		if ((cobs[index].name_len != name_len) ||
-			(memcmp (cobs[index].name, name, cobs[index].name_len))) {
-			rcd = conpubd_stat_content_info_access (
-					conpub_stat_hdl, cobs[index].name, cobs[index].name_len);
-			
+		rcd = csmgr_stat_content_is_exist (
+				conpub_stat_hdl, cobs[index].name, cobs[index].name_len);
+		if (!rcd) {
+			rcd = conpubd_stat_content_info_init (
+					conpub_stat_hdl, cobs[index].name, cobs[index].name_len, cob_map);
 			if (!rcd) {
-				rcd = conpubd_stat_content_info_init (
-						conpub_stat_hdl, cobs[index].name, cobs[index].name_len, cob_map);
-				if (!rcd) {
-					goto NEXTCOB;
-				}
+				pthread_mutex_unlock (&conpub_fsc_cs_mutex);
+				goto NEXTCOB;
+			}
+		}
+		/* Cotrol record size */
+		if (rcd->file_msglen == 0) {
+			rcd->file_msglen = cobs[index].msg_len + 3;
+			rcd->detect_chnkno = chunk_num;
+		}
+		file_msglen = rcd->file_msglen;
+		con_index 	= rcd->index;
+		con_gen 	= fsc_cont_gen[con_index];
+		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
+		
+		rcdsize = sizeof (FscT_Rec_Head) + file_msglen;
+		if ( file_msglen < cobs[index].msg_len ) {
+			goto NEXTCOB;
+		}
+		
+		/* Update the directory to write the received cob 		*/
+		if (((int) con_index != work_con_index) || (con_gen != work_con_gen)) {
+			if (fp != NULL) {
+				fflush (fp);
+				fclose (fp);
+				fp = NULL;
 			}
-			work_con_index = (int) rcd->index;
+			work_con_index 	= (int) con_index;
+			work_con_gen 	= con_gen;
 			prev_page_index = -1;
+			fsc_comp_fail = 0;
 			sprintf (cont_path, "%s/%d", cobpub_hdl->fsc_cache_path, work_con_index);
-			memcpy (name, cobs[index].name, cobs[index].name_len);
-			name_len = cobs[index].name_len;
 			
 			if (mkdir (cont_path, 0766) != 0) {
 				if (errno == ENOENT) {
 					conpubd_log_write (CefC_Log_Error, 
 						"Failed to create the cache directory for the each content\n");
+					work_con_index = -1;
 					goto NEXTCOB;
 				}
 				if (errno == EACCES) {
 					conpubd_log_write (CefC_Log_Error, 
 						"Please make sure that you have write permission for %s.\n", 
 						cobpub_hdl->fsc_cache_path);
+					work_con_index = -1;
 					goto NEXTCOB;
 				}
 			}
 		}
-
-		/* Cotrol record size */
-		if (rcd->file_msglen == 0) {
-			rcd->file_msglen = cobs[index].msg_len + 3;
-			rcd->detect_chnkno = chunk_num;
-		} else {
-			;
-		}
-		file_msglen = rcd->file_msglen;
-		rcdsize = sizeof (uint16_t) + file_msglen;
-
-		if ( file_msglen < cobs[index].msg_len ) {
-			goto NEXTCOB;
-		}
+		
 		/* Update the page to write the received cob 		*/
 		work_page_index = chunk_num / FscC_Page_Cob_Num / FscC_File_Page_Num;
 		cob_block_index = (chunk_num / FscC_Page_Cob_Num) % FscC_File_Page_Num;
-		if (work_page_index != prev_page_index) {
+		if ((work_page_index != prev_page_index) || (fp == NULL)) {
 			if (fp != NULL) {
 #ifdef CefC_Debug
 				conpubd_dbg_write (CefC_Dbg_Finer, 
 					"cob put thread writes the page: %s\n", cont_path);
 #endif // CefC_Debug
-				if (rbpflag == 1) {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;
-					rbpflag = 0;
-				} else {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;	
-				}
+				fflush (fp);
+				fclose (fp);
+				fp = NULL;
 			}
 			
 			prev_page_index = work_page_index;
-			struct stat st;
 			sprintf (file_path, 
 				"%s/%d/%d", cobpub_hdl->fsc_cache_path, work_con_index, work_page_index);
-            if (stat (file_path, &st) != 0) {
+			if (stat (file_path, &st) != 0) {
 				fp = fopen (file_path, "w");
-            	fclose (fp);
-            	fp = fopen (file_path, "rb+");
-			}
-			else {
-				fp = fopen (file_path, "rb+");
-				if (!fp) {
-					conpubd_log_write (CefC_Log_Error, 
-						"Failed to open the cache file (%s)\n", file_path);
-					goto NEXTCOB;
+				if (fp != NULL) {
+					fclose (fp);
 				}
-				memset (swindx, 0 , sizeof (swindx));
-				rbpflag = 1;
+			}
+			fp = fopen (file_path, "rb+");
+			if (!fp) {
+				conpubd_log_write (CefC_Log_Error, 
+					"Failed to open the cache file (%s)\n", file_path);
+				goto NEXTCOB;
 			}
 		}
 		
-		/* Updates the content information 			*/
-		conpubd_stat_cob_update (conpub_stat_hdl, cobs[index].name, cobs[index].name_len, 
-				chunk_num, cobs[index].pay_len, cobs[index].expiry, 
-				nowt, cobs[index].node);
-
-		/* Set to write buffer 							*/
-		unsigned char wbuff[sizeof (uint16_t) + UINT16_MAX];
-		int write_index = chunk_num % FscC_Page_Cob_Num;
+		/* Set to write buffer, only the stored msg is written to the record 	*/
+		write_index = chunk_num % FscC_Page_Cob_Num;
 		fseek (fp, (int64_t)cob_block_index * FscC_Page_Cob_Num * (int64_t)rcdsize
 					+ (int64_t)write_index * (int64_t)rcdsize, SEEK_SET);
-		memcpy (wbuff, &cobs[index].msg_len, sizeof (uint16_t));
-		memcpy (&wbuff[sizeof (uint16_t)], cobs[index].msg, cobs[index].msg_len);
-		fwrite (wbuff, sizeof (uint16_t) + file_msglen, 1, fp);
+		fsc_rec_set (&cobs[index], wbuff);
+		memcpy (&rec_head, wbuff, sizeof (FscT_Rec_Head));
+		if (fwrite (wbuff, sizeof (FscT_Rec_Head) + rec_head.msg_len, 1, fp) != 1) {
+			goto NEXTCOB;
+		}
 		fflush (fp);
-
-			cobpub_hdl->cache_cobs++;
+		
+		/* Updates the content information after the record is written, unless 	*/
+		/* the content was removed meanwhile 										*/
+		pthread_mutex_lock (&conpub_fsc_cs_mutex);
+		rcd = csmgr_stat_content_is_exist (
+				conpub_stat_hdl, cobs[index].name, cobs[index].name_len);
+		if ((rcd != NULL) && (rcd->index == con_index) && 
+			(fsc_cont_gen[con_index] == con_gen)) {
+			mask = 1;
+			x = chunk_num / 64;
+			mask <<= (chunk_num % 64);
+			if (((rcd->map_max-1) < x) || ((rcd->cob_map[x] & mask) == 0)) {
+				cobpub_hdl->cache_cobs++;
+			}
+			conpubd_stat_cob_update (conpub_stat_hdl, cobs[index].name, cobs[index].name_len, 
+					chunk_num, cobs[index].pay_len, cobs[index].expiry, 
+					nowt, cobs[index].node);
+		}
+		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 		
 NEXTCOB:
 		free (cobs[index].msg);
@@ -805,6 +946,187 @@ NEXTCOB:
 	}
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Sets the msg of the cob to the record, compressed if it is worth it
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_set (
+	ConpubdT_Content_Entry* entry,				/* cob 									*/
+	unsigned char* rec							/* record to be written 				*/
+) {
+	FscT_Rec_Head head;
+	uint64_t start;
+	int len = 0;
+	
+	head.msg_len 	= entry->msg_len;
+	head.flags 		= 0;
+	
+	/* After the cobs which did not shrink, the others of the content are 	*/
+	/* stored raw without the compression except the probes 				*/
+	if (fsc_comp_f) {
+		fsc_comp_cnt++;
+		if ((entry->msg_len >= FscC_Comp_Min_Len) && 
+			((fsc_comp_fail < FscC_Comp_Fail_Max) || ((fsc_comp_cnt % FscC_Comp_Probe) == 0))) {
+			start = fsc_comp_time_get ();
+			len = cef_csmgr_lz_compress (entry->msg, entry->msg_len, 
+					&rec[sizeof (FscT_Rec_Head)], 
+					(int)((uint32_t) entry->msg_len * FscC_Comp_Rate / 100));
+			fsc_comp_ns += fsc_comp_time_get () - start;
+			if (len > 0) {
+				fsc_comp_fail = 0;
+			} else if (fsc_comp_fail < FscC_Comp_Fail_Max) {
+				fsc_comp_fail++;
+			}
+		}
+		/* Every cob is counted, so the ratio is that of the bytes on the disk 	*/
+		fsc_comp_raw += entry->msg_len;
+		if (len > 0) {
+			fsc_comp_stored += (uint64_t) len;
+			head.msg_len 	= (uint16_t) len;
+			head.flags 		= FscC_Rec_Lz;
+		} else {
+			fsc_comp_stored += entry->msg_len;
+			fsc_comp_skip++;
+		}
+	}
+	if (head.flags == 0) {
+		memcpy (&rec[sizeof (FscT_Rec_Head)], entry->msg, entry->msg_len);
+	}
+	memcpy (rec, &head, sizeof (FscT_Rec_Head));
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the cob in the record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_send (
+	int sock,									/* socket to send the cob 				*/
+	unsigned char* rec,							/* record 								*/
+	uint64_t cachetime							/* cache time set to the cob 			*/
+) {
+	FscT_Rec_Head head;
+	unsigned char* msg = &rec[sizeof (FscT_Rec_Head)];
+	uint64_t start;
+	int msg_len;
+	
+	memcpy (&head, rec, sizeof (FscT_Rec_Head));
+	if (head.msg_len == 0) {
+		return;
+	}
+	msg_len = head.msg_len;
+	
+	/* The record is kept compressed in the page, and expanded for each send 	*/
+	if (head.flags & FscC_Rec_Lz) {
+		start = fsc_comp_time_get ();
+		msg_len = cef_csmgr_lz_decompress (msg, head.msg_len, fsc_unz_buf, sizeof (fsc_unz_buf));
+		fsc_decomp_ns += fsc_comp_time_get () - start;
+		if (msg_len <= 0) {
+			conpubd_log_write (CefC_Log_Error, "Failed to decompress the cob\n");
+			return;
+		}
+		fsc_decomp_cobs++;
+		msg = fsc_unz_buf;
+	}
+	cef_frame_opheader_cachetime_update (msg, cachetime);
+	conpubd_plugin_cob_msg_send (sock, msg, (uint16_t) msg_len);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reads the block of the page file through the disk I/O engine
+----------------------------------------------------------------------------------------*/
+static int							/* read length, negative if an error occurs			*/
+fsc_page_read (
+	const char* file_path,						/* page file 							*/
+	unsigned char* buf,							/* buffer for the block 				*/
+	size_t len,									/* length of the block 					*/
+	off_t off									/* offset of the block 					*/
+) {
+	FscT_Page_Read rd;
+	int fd;
+	
+	fd = open (file_path, O_RDONLY);
+	if (fd < 0) {
+		return (-1);
+	}
+	
+	/* The cobs are sent on the thread which reads the socket, so the lookup 	*/
+	/* waits for the read, but other lookups and the writer take the lock 		*/
+	memset (&rd, 0, sizeof (FscT_Page_Read));
+	pthread_mutex_init (&rd.mutex, NULL);
+	pthread_cond_init (&rd.cond, NULL);
+	rd.req.op 	= CefC_Csmgr_Aio_Read;
+	rd.req.fd 	= fd;
+	rd.req.buf 	= buf;
+	rd.req.len 	= len;
+	rd.req.off 	= off;
+	rd.req.done = fsc_page_read_done;
+	rd.req.arg 	= &rd;
+	cef_csmgr_aio_submit (fsc_aio, &rd.req);
+	
+	pthread_mutex_lock (&rd.mutex);
+	while (!rd.done_f) {
+		pthread_cond_wait (&rd.cond, &rd.mutex);
+	}
+	pthread_mutex_unlock (&rd.mutex);
+	pthread_cond_destroy (&rd.cond);
+	pthread_mutex_destroy (&rd.mutex);
+	close (fd);
+	
+	if (rd.req.err) {
+		return (0);
+	}
+	return ((int) rd.req.done_len);
+}
+/*--------------------------------------------------------------------------------------
+	Completes the page read
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_read_done (
+	CefT_Csmgr_Aio_Req* req
+) {
+	FscT_Page_Read* rd = (FscT_Page_Read*) req->arg;
+	
+	pthread_mutex_lock (&rd->mutex);
+	rd->done_f = 1;
+	pthread_cond_signal (&rd->cond);
+	pthread_mutex_unlock (&rd->mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the content and its directory
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_remove (
+	CsmgrT_Stat* rcd							/* content information 					*/
+) {
+	char file_path[PATH_MAX];
+	
+	/* The pending reads and writes of the content are dropped by the generation 	*/
+	fsc_cont_gen[rcd->index]++;
+	sprintf (file_path, "%s/%d", cobpub_hdl->fsc_cache_path, (int) rcd->index);
+	fsc_recursive_dir_clear (file_path);
+	
+	cobpub_hdl->cache_cobs -= rcd->cob_num;
+	conpubd_stat_content_info_delete (conpub_stat_hdl, rcd->name, rcd->name_len);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the monotonic time (ns) to measure the compression
+----------------------------------------------------------------------------------------*/
+static uint64_t
+fsc_comp_time_get (
+	void
+) {
+	struct timespec ts;
+	
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ((uint64_t) ts.tv_sec * 1000000000llu + (uint64_t) ts.tv_nsec);
+}
 /*--------------------------------------------------------------------------------------
 	Function to increment access count
 ----------------------------------------------------------------------------------------*/
@@ -852,7 +1174,6 @@ fsc_content_del (
 	uint64_t cob_num							/* Total number of Cob					*/
 ) {
 	CsmgrT_Stat*	rcd = NULL;
-	char			file_path[PATH_MAX];
 	
 	pthread_mutex_lock (&conpub_fsc_cs_mutex);
 	
@@ -861,12 +1182,7 @@ fsc_content_del (
 		pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 		return (-1);
 	}
-	
-	sprintf (file_path, "%s/%d", cobpub_hdl->fsc_cache_path, (int) rcd->index);
-	fsc_recursive_dir_clear (file_path);
-
-	conpubd_stat_content_info_delete (conpub_stat_hdl, rcd->name, rcd->name_len);
-	cobpub_hdl->cache_cobs -= cob_num;
+	fsc_content_remove (rcd);
 
 	pthread_mutex_unlock (&conpub_fsc_cs_mutex);
 
@@ -903,6 +1219,7 @@ fsc_config_read (
 	params->cache_capacity 			= CefC_CnpbDefault_Contents_Capacity;
 	strcpy(params->cache_path, 		  conpub_conf_dir);
 	params->cache_default_rct = CefC_CnpbDefault_Cache_Default_Rct;
+	params->compression = 0;
 
 	/* Obtains the directory path where the conpubd's config file is located. */
 #if 0 //+++++ GCC v9 +++++
@@ -996,6 +1313,15 @@ fsc_config_read (
 				fclose (fp);
 				return (-1);
 			}
+		} else
+		if (strcmp (option, "CACHE_COMPRESSION") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= 1)) {
+				conpubd_log_write (CefC_Log_Error, "CACHE_COMPRESSION must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->compression = res;
 		} else {
 			/* NOP */;
 		}
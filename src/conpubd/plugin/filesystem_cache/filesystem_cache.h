@@ -61,9 +61,16 @@ typedef struct {
 	char				cache_path[CefC_Conpubd_File_Path_Length];
 														/* FileSystemCache root dir		*/
 	uint32_t			cache_default_rct;
+	int					compression;					/* 1: the cobs are compressed		*/
 	
 } FscT_Config_Param;
 
+typedef struct {
+	/********** Head of the record in the page file ***********/
+	uint16_t			msg_len;						/* length of the stored msg			*/
+	uint16_t			flags;							/* FscC_Rec_XXX						*/
+} FscT_Rec_Head;
+
 typedef struct {
 	
 	/********** FileSystemCache Status ***********/
@@ -134,6 +134,11 @@ static pthread_mutex_t 		csmgr_Lack_of_resources_mutex = PTHREAD_MUTEX_INITIALIZ
 
 static CsmgrT_Stat* stat_for_PM[CsmgrT_Stat_Max];
 
+/* Locks of the sockets shared with the plugin, NULL if the library lacks them 	*/
+static void (*csmgrd_sock_lock)(int) 	= NULL;
+static void (*csmgrd_sock_unlock)(int) 	= NULL;
+static void (*csmgrd_sock_close)(int) 	= NULL;
+
 
 
 /****************************************************************************************
@@ -250,6 +255,60 @@ csmgrd_incoming_interest (
 	int buff_len,								/* receive message length				*/
 	uint8_t type								/* receive message type					*/
 );
+/*--------------------------------------------------------------------------------------
+	Incoming Bulk Interest Message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_interest (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+);
+/*--------------------------------------------------------------------------------------
+	Starts the threads which serve the Interests
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_req_workers_start (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the threads which serve the Interests
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_req_workers_stop (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	Queues the Interest to the thread of its flow
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is not queued	*/
+csmgrd_req_dispatch (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	int faceid,									/* Face-ID which received the Interest	*/
+	unsigned char* name,						/* content name							*/
+	uint16_t name_len,							/* length of content name				*/
+	uint32_t chunk_num,							/* chunk number							*/
+	unsigned char* ver,							/* version								*/
+	uint16_t ver_len							/* length of version					*/
+);
+/*--------------------------------------------------------------------------------------
+	Thread which serves the queued Interests
+----------------------------------------------------------------------------------------*/
+static void*
+csmgrd_req_thread (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Sends the message without splitting the Cobs sent by the request threads
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_msg_send (
+	int sock,									/* send socket							*/
+	unsigned char* msg,							/* message								*/
+	uint16_t msg_len							/* message length						*/
+);
 /*--------------------------------------------------------------------------------------
 	Parse Interest message
 ----------------------------------------------------------------------------------------*/
@@ -264,7 +323,8 @@ cef_csmgr_interest_msg_parse (
 	unsigned char op_data[],					/* Optional Data Field					*/
 	uint16_t* op_data_len,						/* Length of Optional Data Field		*/
 	unsigned char ver[],						/* Content Version						*/
-	uint16_t* ver_len							/* Length of content version			*/
+	uint16_t* ver_len,							/* Length of content version			*/
+	int* faceid									/* Face-ID which received the Interest	*/
 );
 /*--------------------------------------------------------------------------------------
 	Incoming Get Status Message
@@ -324,6 +384,104 @@ csmgrd_incoming_echo_msg (
 	unsigned char* buff,						/* receive message						*/
 	int buff_len								/* receive message length				*/
 );
+/*--------------------------------------------------------------------------------------
+	Receive Attach Shared Memory message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_shm_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+);
+/*--------------------------------------------------------------------------------------
+	Receives the message(s) and the memfd from the local peer
+----------------------------------------------------------------------------------------*/
+static int
+csmgrd_local_peer_recv (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* buff,						/* receive buffer						*/
+	int buff_len								/* size of receive buffer				*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the local peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_local_peer_close (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the TCP peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_tcp_peer_close (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int idx										/* index of the peer					*/
+);
+#ifndef CefC_DB_INDEX
+/*--------------------------------------------------------------------------------------
+	Receive Subscribe Presence Filter message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_presence_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the whole bitmap of the presence filter
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_presence_snapshot_send (
+	int sock,									/* send socket							*/
+	uint32_t seq								/* sequence number of the next changes	*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the bit changes of the presence filter to the subscribers
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_presence_push (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+#endif // CefC_DB_INDEX
+/*--------------------------------------------------------------------------------------
+	Obtains the index of the peer connected with the socket
+----------------------------------------------------------------------------------------*/
+static int							/* 0: local peer, -1: unknown socket				*/
+csmgrd_peer_index_get (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* peer socket							*/
+);
+/*--------------------------------------------------------------------------------------
+	Receive Subscribe Insert Credit message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_credit_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+);
+/*--------------------------------------------------------------------------------------
+	Grants the credits for the Upload Requests handed to the plugin
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_credit_push (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the credit message
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_credit_msg_send (
+	int sock,									/* send socket							*/
+	uint32_t credit								/* granted bytes						*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the packet which cefnetd receives from csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_pkt_send (
+	int sock,									/* send socket							*/
+	uint8_t type,								/* CefC_Csmgr_PT_XXX					*/
+	unsigned char* buff,						/* message								*/
+	uint16_t len								/* message length						*/
+);
 /*--------------------------------------------------------------------------------------
 	Read white list
 ----------------------------------------------------------------------------------------*/
@@ -715,6 +873,11 @@ csmgrd_handle_create (
 	hdl->tcp_listen_fd 		= -1;
 	hdl->local_listen_fd 	= -1;
 	hdl->local_peer_sock 	= -1;
+	hdl->local_shm_fd 		= -1;
+	for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
+		hdl->presence_fd[i] = -1;
+		hdl->credit_fd[i] 	= -1;
+	}
 
 	/* Records the user which launched cefnetd 		*/
 	envp = getenv ("USER");
@@ -743,6 +906,8 @@ csmgrd_handle_create (
 		return (NULL);
 	}
 	hdl->interval = conf_param.interval;
+	hdl->credit_window = conf_param.credit_window * 1024;
+	hdl->req_worker_num = conf_param.req_threads;
 
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Fine, "Create the listen socket.\n");
@@ -861,6 +1026,16 @@ csmgrd_handle_create (
 			csmgrd_handle_destroy (&hdl);
 			return (NULL);
 		}
+#ifndef CefC_DB_INDEX
+		if (conf_param.presence_capacity > 0) {
+			if (csmgr_stat_presence_enable (stat_hdl, conf_param.presence_capacity,
+					conf_param.presence_fp_rate / 100.0) < 0) {
+				cef_log_write (CefC_Log_Warn, "Failed to create the presence filter.\n");
+			} else {
+				hdl->presence_f = 1;
+			}
+		}
+#endif // CefC_DB_INDEX
 //0.8.3c		if (hdl->cs_mod_int->init (stat_hdl) < 0) {
 		if (hdl->cs_mod_int->init (stat_hdl, hdl->First_Node_f) < 0) {		//0.8.3c
 			cef_log_write (CefC_Log_Error, "Failed to initialize cache plugin.\n");
@@ -868,6 +1043,13 @@ csmgrd_handle_create (
 			return (NULL);
 		}
 		cef_log_write (CefC_Log_Info, "Initialization the cache plugin ... OK\n");
+
+		/* The Interests are served by one thread unless the plugin allows more 	*/
+		if ((hdl->cs_mod_int->item_get_mt == 0) ||
+			(csmgrd_sock_lock == NULL) || (csmgrd_sock_unlock == NULL)) {
+			hdl->req_worker_num = 0;
+		}
+		cef_log_write (CefC_Log_Info, "Request threads : %d\n", hdl->req_worker_num);
 	} else {
 		csmgrd_handle_destroy (&hdl);
 		cef_log_write (CefC_Log_Info, "Failed to call INIT API.\n");
@@ -992,6 +1174,9 @@ csmgrd_event_dispatch (
 						"Failed to create the new thread\n");
 		csmgrd_running_f = 0;
 	}
+	if (csmgrd_req_workers_start (hdl) < 0) {
+		csmgrd_running_f = 0;
+	}
 
 	/* Main loop */
 	while (csmgrd_running_f) {
@@ -1002,6 +1187,18 @@ csmgrd_event_dispatch (
 		/* Checks socket accept 			*/
 		csmgrd_tcp_connect_accept (hdl);
 
+#ifndef CefC_DB_INDEX
+		/* Sends the changes of the cached contents to cefnetd(s) 	*/
+		if (hdl->presence_f) {
+			csmgrd_presence_push (hdl);
+		}
+#endif // CefC_DB_INDEX
+
+		/* Returns the credits for the Upload Requests to cefnetd(s) 	*/
+		if (hdl->credit_window > 0) {
+			csmgrd_credit_push (hdl);
+		}
+
 		/* Sets fds to be polled 			*/
 		fdnum = csmgrd_poll_socket_prepare (hdl, fds, fds_index);
 		res = poll (fds, fdnum, 1);
@@ -1032,21 +1229,16 @@ csmgrd_event_dispatch (
 #endif // CefC_Debug
 				if ((hdl->local_peer_sock != -1) && (fds[i].fd == hdl->local_peer_sock)) {
 					/* Close Local socket */
-					close (hdl->local_peer_sock);
-					hdl->local_peer_sock = -1;
+					csmgrd_local_peer_close (hdl);
 					cef_log_write (CefC_Log_Info, "Close Local peer\n");
 				} else {
 					/* Close TCP socket */
 					if (hdl->tcp_fds[fds_index[i]] != -1) {
-						close (hdl->tcp_fds[fds_index[i]]);
-						hdl->tcp_fds[fds_index[i]] = -1;
 						cef_log_write (CefC_Log_Info, "Close TCP peer: %s:%s\n",
 							hdl->peer_id_str[fds_index[i]],
 							hdl->peer_sv_str[fds_index[i]]);
-						hdl->peer_num--;
 					}
-					/* Reset buffer */
-					hdl->tcp_index[fds_index[i]] = 0;
+					csmgrd_tcp_peer_close (hdl, fds_index[i]);
 				}
 				res--;
 				continue;
@@ -1054,9 +1246,16 @@ csmgrd_event_dispatch (
 
 			if (fds[i].revents & POLLIN) {
 				res--;
-				len = recv (fds[i].fd,
-					&hdl->tcp_buff[fds_index[i]][hdl->tcp_index[fds_index[i]]],
-					CefC_Cefnetd_Buff_Max - hdl->tcp_index[fds_index[i]], 0);
+				if ((hdl->local_peer_sock != -1) &&
+					(fds[i].fd == hdl->local_peer_sock)) {
+					len = csmgrd_local_peer_recv (hdl,
+						&hdl->tcp_buff[fds_index[i]][hdl->tcp_index[fds_index[i]]],
+						CefC_Cefnetd_Buff_Max - hdl->tcp_index[fds_index[i]]);
+				} else {
+					len = recv (fds[i].fd,
+						&hdl->tcp_buff[fds_index[i]][hdl->tcp_index[fds_index[i]]],
+						CefC_Cefnetd_Buff_Max - hdl->tcp_index[fds_index[i]], 0);
+				}
 				if (len > 0) {
 					/* receive message */
 					len += hdl->tcp_index[fds_index[i]];
@@ -1075,21 +1274,16 @@ csmgrd_event_dispatch (
 					if ((hdl->local_peer_sock != -1) &&
 						(fds[i].fd == hdl->local_peer_sock)) {
 						/* Close Local socket */
-						close (hdl->local_peer_sock);
-						hdl->local_peer_sock = -1;
+						csmgrd_local_peer_close (hdl);
 						cef_log_write (CefC_Log_Info, "Close Local peer\n");
 					} else {
 						/* Close TCP socket */
 						if (hdl->tcp_fds[fds_index[i]] != -1) {
-							close (hdl->tcp_fds[fds_index[i]]);
-							hdl->tcp_fds[fds_index[i]] = -1;
 							cef_log_write (CefC_Log_Info, "Close TCP peer: %s:%s\n",
 								hdl->peer_id_str[fds_index[i]],
 								hdl->peer_sv_str[fds_index[i]]);
-							hdl->peer_num--;
 						}
-						/* Reset buffer */
-						hdl->tcp_index[fds_index[i]] = 0;
+						csmgrd_tcp_peer_close (hdl, fds_index[i]);
 					}
 				} else {
 					if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
@@ -1099,8 +1293,7 @@ csmgrd_event_dispatch (
 							/* Close Local socket */
 							cef_log_write (CefC_Log_Warn,
 								"Receive error (%d) . Close Local socket\n", errno);
-							close (hdl->local_peer_sock);
-							hdl->local_peer_sock = -1;
+							csmgrd_local_peer_close (hdl);
 							cef_log_write (CefC_Log_Info, "Close Local peer\n");
 						} else {
 							/* Close TCP socket */
@@ -1111,18 +1304,15 @@ csmgrd_event_dispatch (
 								cef_log_write (CefC_Log_Warn, "Close TCP peer: %s:%s\n",
 									hdl->peer_id_str[fds_index[i]],
 									hdl->peer_sv_str[fds_index[i]]);
-								close (hdl->tcp_fds[fds_index[i]]);
-								hdl->tcp_fds[fds_index[i]] = -1;
-								hdl->peer_num--;
 							}
-							/* Reset buffer */
-							hdl->tcp_index[fds_index[i]] = 0;
+							csmgrd_tcp_peer_close (hdl, fds_index[i]);
 						}
 					}
 				}
 			}
 		}
 	}
+	csmgrd_req_workers_stop (hdl);
 	pthread_cond_signal (&csmgr_comn_buff_cond);		/* To avoid deadlock */
 	pthread_join (csmgrd_msg_process_th, &status);
 	pthread_join (csmgrd_expire_check_th, &status);
@@ -1239,6 +1429,15 @@ csmgr_input_bytes_process (
 	uint16_t value16;
 	int rec_buff_len = buff_len;
 	int res;
+	int peer_idx = -1;
+
+	/* The bytes of the Upload Requests are granted back to the subscriber 	*/
+	if (hdl->credit_window > 0) {
+		peer_idx = csmgrd_peer_index_get (hdl, peer_fd);
+		if ((peer_idx >= 0) && (hdl->credit_fd[peer_idx] != peer_fd)) {
+			peer_idx = -1;
+		}
+	}
 
 	while (buff_len > CefC_Csmgr_Msg_HeaderLen) {
 		/* searches the top of massage 		*/
@@ -1284,24 +1483,27 @@ csmgr_input_bytes_process (
 			}
 		} else {
 			int cstat;
+			hdl->insert_rcv += len;
+			if (peer_idx >= 0) {
+				hdl->credit_used[peer_idx] += len;
+			}
 			cstat = cef_csmgr_frame_check (&buff[index], len);
 			if (cstat < 0) {
 //@@@@@fprintf(stderr, "[%s]: [------ goto SKIP; [cstat < 0] -----\n", __FUNCTION__);
-				goto SKIP;
+				goto DROP;
 			}
 			pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
 			if (Lack_of_F_resources == 1) {
 				pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-				goto SKIP;
+				goto DROP;
 			}
 			if (Lack_of_M_resources == 1) {
 				pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-				goto SKIP;
+				goto DROP;
 			}
 			pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
-			if (pthread_mutex_trylock (&csmgr_main_cob_buff_mutex) != 0) {
-				goto SKIP;
-			}
+			/* Waits for the push thread, cefnetd has sent it under the credits 	*/
+			pthread_mutex_lock (&csmgr_main_cob_buff_mutex);
 			if (csmgr_main_cob_buff_idx + len > CsmgrC_Buff_Size) {
 				pthread_mutex_lock (&csmgr_comn_buff_mutex);
 
@@ -1321,6 +1523,9 @@ csmgr_input_bytes_process (
 
 			csmgr_main_cob_buff_idx += len;
 			pthread_mutex_unlock (&csmgr_main_cob_buff_mutex);
+			goto SKIP;
+DROP:;
+			hdl->insert_drop += len;
 		}
 
 SKIP:;
@@ -1451,7 +1656,7 @@ csmgrd_local_sock_check (
 			}
 		}
 		if (hdl->local_peer_sock != -1) {
-			close (hdl->local_peer_sock);
+			csmgrd_local_peer_close (hdl);
 		}
 		hdl->local_peer_sock = sock;
 	}
@@ -1483,8 +1688,7 @@ csmgrd_handle_destroy (
 		hdl->local_listen_fd = -1;
 	}
 	if (hdl->local_peer_sock != -1) {
-		close (hdl->local_peer_sock);
-		hdl->local_peer_sock = -1;
+		csmgrd_local_peer_close (hdl);
 	}
 
 	/* Close Tcp listen socket */
@@ -1630,6 +1834,10 @@ csmgrd_config_read (
 	strcpy (conf_param->fsc_cache_path, csmgr_conf_dir);
 	conf_param->port_num 	= CefC_Default_Tcp_Prot;
 	strcpy (conf_param->local_sock_id, "0");
+	conf_param->presence_capacity = 0;
+	conf_param->presence_fp_rate  = 1.0;
+	conf_param->credit_window 	  = CsmgrdC_Credit_Window_Default;
+	conf_param->req_threads 	  = CsmgrdC_Req_Thread_Default;
 
 	/* get parameter */
 	while (fgets (param_buff, sizeof (param_buff), fp) != NULL) {
@@ -1714,6 +1922,46 @@ csmgrd_config_read (
 				return (-1);
 			}
 			strcpy (conf_param->local_sock_id, value);
+		} else if (strcmp (option, "PRESENCE_FILTER_CAPACITY") == 0) {
+			res = csmgrd_config_value_get (option, value);
+			if ((res < 0) || (res > CsmgrT_Stat_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"PRESENCE_FILTER_CAPACITY must be higher than or equal to 0 and "
+					"lower than or equal to %d.\n", CsmgrT_Stat_Max);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->presence_capacity = (uint32_t) res;
+		} else if (strcmp (option, "PRESENCE_FILTER_FP_RATE") == 0) {
+			char* endp;
+			conf_param->presence_fp_rate = strtod (value, &endp);
+			if ((*endp != '\0') ||
+				(conf_param->presence_fp_rate <= 0.0) || (conf_param->presence_fp_rate >= 100.0)) {
+				cef_log_write (CefC_Log_Error,
+					"PRESENCE_FILTER_FP_RATE must be higher than 0 and lower than 100.\n");
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "INSERT_CREDIT_WINDOW") == 0) {
+			res = csmgrd_config_value_get (option, value);
+			if ((res < 0) || (res > CsmgrdC_Credit_Window_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"INSERT_CREDIT_WINDOW must be higher than or equal to 0 and "
+					"lower than or equal to %d.\n", CsmgrdC_Credit_Window_Max);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->credit_window = (uint32_t) res;
+		} else if (strcmp (option, "REQUEST_THREADS") == 0) {
+			res = csmgrd_config_value_get (option, value);
+			if ((res < 0) || (res > CsmgrdC_Req_Thread_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"REQUEST_THREADS must be higher than or equal to 0 and "
+					"lower than or equal to %d.\n", CsmgrdC_Req_Thread_Max);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->req_threads = (int) res;
 		} else {
 			continue;
 		}
@@ -1806,6 +2054,17 @@ csmgrd_plugin_load (
 		return (-1);
 	}
 
+	/* The shared-memory transport is not used if the library lacks it 	*/
+	hdl->shm_attach = (int (*)(int, int)) dlsym (hdl->mod_lib, "csmgrd_plugin_shm_attach");
+	hdl->shm_detach = (void (*)(int)) dlsym (hdl->mod_lib, "csmgrd_plugin_shm_detach");
+
+	/* The request threads are not used if the library lacks the socket locks 	*/
+	csmgrd_sock_lock = (void (*)(int)) dlsym (hdl->mod_lib, "csmgrd_plugin_sock_lock");
+	csmgrd_sock_unlock = (void (*)(int)) dlsym (hdl->mod_lib, "csmgrd_plugin_sock_unlock");
+
+	/* The reads in flight in the plugin drop the cobs to the closed sockets 	*/
+	csmgrd_sock_close = (void (*)(int)) dlsym (hdl->mod_lib, "csmgrd_plugin_sock_close");
+
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -2059,6 +2318,10 @@ csmgrd_tcp_connect_accept (
 			(strcmp (hdl->peer_sv_str[i], port_str) == 0)) {
 			cef_log_write (CefC_Log_Info, "Close TCP peer: [%d] %s:%s\n",
 				i, hdl->peer_id_str[i], hdl->peer_sv_str[i]);
+			__atomic_add_fetch (&hdl->peer_gen[i], 1, __ATOMIC_RELEASE);
+			if (csmgrd_sock_close) {
+				(*csmgrd_sock_close)(hdl->tcp_fds[i]);
+			}
 			close (hdl->tcp_fds[i]);
 			hdl->tcp_fds[i] 	= -1;
 			hdl->tcp_index[i] 	= 0;
@@ -2079,8 +2342,9 @@ csmgrd_tcp_connect_accept (
 			hdl->peer_num++;
 			hdl->tcp_fds[i] 	= cs;
 			hdl->tcp_index[i] 	= 0;
+			hdl->credit_fd[i] 	= -1;
 
-			cef_csmgr_send_msg (hdl->tcp_fds[i],
+			csmgrd_msg_send (hdl->tcp_fds[i],
 				(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
 		} else {
 			cef_log_write (CefC_Log_Warn,
@@ -2093,7 +2357,7 @@ csmgrd_tcp_connect_accept (
 		hdl->tcp_fds[i] 	= cs;
 		hdl->tcp_index[i] 	= 0;
 
-		cef_csmgr_send_msg (hdl->tcp_fds[i],
+		csmgrd_msg_send (hdl->tcp_fds[i],
 			(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
 	}
 	return;
@@ -2155,6 +2419,13 @@ csmgrd_input_message_process (
 			csmgrd_incoming_interest (hdl, sock, msg, msg_len, type);
 			break;
 		}
+		case CefC_Csmgr_Msg_Type_Bulk_Interest: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Bulk Interest Message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_bulk_interest (hdl, sock, msg, msg_len);
+			break;
+		}
 
 		case CefC_Csmgr_Msg_Type_Ccninfo: {
 #ifdef CefC_Debug
@@ -2259,6 +2530,29 @@ csmgrd_input_message_process (
 			csmgrd_incoming_continfo_msg (hdl, sock, msg, msg_len);
 			break;
 		}
+		case CefC_Csmgr_Msg_Type_Shm: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Attach Shared Memory message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_shm_msg (hdl, sock);
+			break;
+		}
+		case CefC_Csmgr_Msg_Type_Credit: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Subscribe Insert Credit message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_credit_msg (hdl, sock);
+			break;
+		}
+#ifndef CefC_DB_INDEX
+		case CefC_Csmgr_Msg_Type_Presence: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Subscribe Presence Filter message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_presence_msg (hdl, sock);
+			break;
+		}
+#endif // CefC_DB_INDEX
 		default: {
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Finest, "Receive the Unknown Message\n");
@@ -2289,10 +2583,12 @@ csmgrd_incoming_interest (
 	uint16_t op_data_len = 0;
 	unsigned char ver[CefC_Max_Msg_Size] = {0};
 	uint16_t ver_len = 0;
+	int faceid = -1;
 
 	/* Parses the csmgr Interest message */
 	res = cef_csmgr_interest_msg_parse (
-			buff, buff_len, &int_type, name, &name_len, &chunk_num, op_data, &op_data_len, ver, &ver_len);
+			buff, buff_len, &int_type, name, &name_len, &chunk_num, op_data, &op_data_len,
+			ver, &ver_len, &faceid);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -2309,8 +2605,16 @@ csmgrd_incoming_interest (
 #endif // CefC_Debug
 			csmgrd_stat_request_count_update (stat_hdl, name, name_len);
 
+			/* Passes it to the request thread, or serves it here if the queue is full 	*/
+			if ((hdl->req_workers != NULL) &&
+				(csmgrd_req_dispatch (
+					hdl, sock, faceid, name, name_len, chunk_num, ver, ver_len) == 0)) {
+				break;
+			}
+
 			/* Searches and sends a Cob */
-			hdl->cs_mod_int->cache_item_get (name, name_len, chunk_num, sock, ver, ver_len);
+			hdl->cs_mod_int->cache_item_get (
+				name, name_len, chunk_num, sock, faceid, ver, ver_len);
 			break;
 		}
 		default: {
@@ -2320,6 +2624,232 @@ csmgrd_incoming_interest (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Incoming Bulk Interest Message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_interest (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+) {
+	int index = 0;
+	uint16_t rec_len;
+	uint16_t value16;
+
+	/* Each record is the length and the body of one csmgr Interest message 	*/
+	while (index + CefC_S_Length <= buff_len) {
+		memcpy (&value16, &buff[index], CefC_S_Length);
+		rec_len = ntohs (value16);
+		index += CefC_S_Length;
+
+		if ((rec_len == 0) || (index + rec_len > buff_len)) {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Fine, "Parse message error (bulk interest)\n");
+#endif // CefC_Debug
+			break;
+		}
+		csmgrd_incoming_interest (
+			hdl, sock, &buff[index], rec_len, CefC_Csmgr_Msg_Type_Interest);
+		index += rec_len;
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Starts the threads which serve the Interests
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_req_workers_start (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	CsmgrdT_Req_Worker* wp;
+	int i;
+
+	if (hdl->req_worker_num == 0) {
+		return (0);
+	}
+	hdl->req_workers = (CsmgrdT_Req_Worker*)
+					calloc (hdl->req_worker_num, sizeof (CsmgrdT_Req_Worker));
+	if (hdl->req_workers == NULL) {
+		cef_log_write (CefC_Log_Error, "Failed to allocate the request threads\n");
+		return (-1);
+	}
+	for (i = 0 ; i < hdl->req_worker_num ; i++) {
+		wp = &hdl->req_workers[i];
+		pthread_mutex_init (&wp->mutex, NULL);
+		pthread_cond_init (&wp->cond, NULL);
+		wp->cs_mod_int = hdl->cs_mod_int;
+		wp->peer_gen   = hdl->peer_gen;
+
+		if (pthread_create (&wp->th, NULL, csmgrd_req_thread, wp) != 0) {
+			cef_log_write (CefC_Log_Error,
+							"Failed to create the new thread(csmgrd_req_thread)\n");
+			pthread_mutex_destroy (&wp->mutex);
+			pthread_cond_destroy (&wp->cond);
+			hdl->req_worker_num = i;
+			csmgrd_req_workers_stop (hdl);
+			return (-1);
+		}
+	}
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Stops the threads which serve the Interests
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_req_workers_stop (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	CsmgrdT_Req_Worker* wp;
+	CsmgrdT_Req_Job* job;
+	void* status;
+	int i;
+
+	if (hdl->req_workers == NULL) {
+		return;
+	}
+	for (i = 0 ; i < hdl->req_worker_num ; i++) {
+		wp = &hdl->req_workers[i];
+
+		/* The thread returns after it serves the queued Interests 	*/
+		pthread_mutex_lock (&wp->mutex);
+		wp->stop_f = 1;
+		pthread_cond_signal (&wp->cond);
+		pthread_mutex_unlock (&wp->mutex);
+		pthread_join (wp->th, &status);
+
+		while (wp->head) {
+			job = wp->head;
+			wp->head = job->next;
+			free (job);
+		}
+		pthread_mutex_destroy (&wp->mutex);
+		pthread_cond_destroy (&wp->cond);
+	}
+	free (hdl->req_workers);
+	hdl->req_workers 	= NULL;
+	hdl->req_worker_num = 0;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Queues the Interest to the thread of its flow
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is not queued	*/
+csmgrd_req_dispatch (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	int faceid,									/* Face-ID which received the Interest	*/
+	unsigned char* name,						/* content name							*/
+	uint16_t name_len,							/* length of content name				*/
+	uint32_t chunk_num,							/* chunk number							*/
+	unsigned char* ver,							/* version								*/
+	uint16_t ver_len							/* length of version					*/
+) {
+	CsmgrdT_Req_Worker* wp;
+	CsmgrdT_Req_Job* job;
+	uint32_t hash;
+	int peer_idx;
+	int i;
+
+	/* FNV-1a of the name, the socket and the face, so the chunks of a flow are 	*/
+	/* served in order 																*/
+	hash = 2166136261u;
+	for (i = 0 ; i < name_len ; i++) {
+		hash ^= name[i];
+		hash *= 16777619u;
+	}
+	hash ^= (uint32_t) sock;
+	hash *= 16777619u;
+	hash ^= (uint32_t) faceid;
+	hash *= 16777619u;
+	wp = &hdl->req_workers[hash % hdl->req_worker_num];
+
+	if (__atomic_load_n (&wp->num, __ATOMIC_RELAXED) >= CsmgrdC_Req_Que_Max) {
+		return (-1);
+	}
+	peer_idx = csmgrd_peer_index_get (hdl, sock);
+	if (peer_idx < 0) {
+		return (-1);
+	}
+	job = (CsmgrdT_Req_Job*) malloc (sizeof (CsmgrdT_Req_Job) + name_len + ver_len);
+	if (job == NULL) {
+		return (-1);
+	}
+	job->next 		= NULL;
+	job->sock 		= sock;
+	job->faceid 	= faceid;
+	job->peer_idx 	= peer_idx;
+	job->peer_gen 	= __atomic_load_n (&hdl->peer_gen[peer_idx], __ATOMIC_ACQUIRE);
+	job->chunk_num 	= chunk_num;
+	job->name_len 	= name_len;
+	job->ver_len 	= ver_len;
+	memcpy (&job->data[0], name, name_len);
+	if (ver_len) {
+		memcpy (&job->data[name_len], ver, ver_len);
+	}
+
+	pthread_mutex_lock (&wp->mutex);
+	if (wp->tail) {
+		wp->tail->next = job;
+	} else {
+		wp->head = job;
+	}
+	wp->tail = job;
+	__atomic_add_fetch (&wp->num, 1, __ATOMIC_RELAXED);
+	pthread_cond_signal (&wp->cond);
+	pthread_mutex_unlock (&wp->mutex);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Thread which serves the queued Interests
+----------------------------------------------------------------------------------------*/
+static void*
+csmgrd_req_thread (
+	void* arg
+) {
+	CsmgrdT_Req_Worker* wp = (CsmgrdT_Req_Worker*) arg;
+	CsmgrdT_Req_Job* job;
+	CsmgrdT_Req_Job* next;
+	int num;
+
+	while (1) {
+		pthread_mutex_lock (&wp->mutex);
+		while ((wp->head == NULL) && (wp->stop_f == 0)) {
+			pthread_cond_wait (&wp->cond, &wp->mutex);
+		}
+		/* Takes all the queued Interests at once 	*/
+		job = wp->head;
+		wp->head = NULL;
+		wp->tail = NULL;
+		pthread_mutex_unlock (&wp->mutex);
+
+		if (job == NULL) {
+			break;
+		}
+		for (num = 0 ; job != NULL ; num++) {
+			next = job->next;
+			/* The Interest of the closed peer is dropped, its fd may be reused 	*/
+			if (__atomic_load_n (&wp->peer_gen[job->peer_idx], __ATOMIC_ACQUIRE)
+					== job->peer_gen) {
+				wp->cs_mod_int->cache_item_get (
+					&job->data[0], job->name_len, job->chunk_num, job->sock, job->faceid,
+					&job->data[job->name_len], job->ver_len);
+			}
+			free (job);
+			job = next;
+		}
+		__atomic_sub_fetch (&wp->num, num, __ATOMIC_RELAXED);
+	}
+
+	pthread_exit (NULL);
+
+	return ((void*) NULL);
+}
 /*--------------------------------------------------------------------------------------
 	Parse Interest message
 ----------------------------------------------------------------------------------------*/
@@ -2334,7 +2864,8 @@ cef_csmgr_interest_msg_parse (
 	unsigned char op_data[],					/* Optional Data Field					*/
 	uint16_t* op_data_len,						/* Length of Optional Data Field		*/
 	unsigned char ver[],						/* Content Version						*/
-	uint16_t* ver_len							/* Length of content version			*/
+	uint16_t* ver_len,							/* Length of content version			*/
+	int* faceid									/* Face-ID which received the Interest	*/
 ) {
 	int res;
 	uint16_t index = 0;
@@ -2395,6 +2926,14 @@ cef_csmgr_interest_msg_parse (
 		index += *ver_len;
 	}
 
+	/* get Face-ID, which the older cefnetd does not send */
+	*faceid = -1;
+	if (buff_len - index >= CefC_Csmgr_Interest_S_Faceid) {
+		memcpy (&value32, buff + index, CefC_Csmgr_Interest_S_Faceid);
+		*faceid = (int) ntohl (value32);
+		index += CefC_Csmgr_Interest_S_Faceid;
+	}
+
 	return (0);
 }
 
@@ -2421,6 +2960,7 @@ csmgrd_incoming_status_msg (
 	uint64_t value64;
 	struct CefT_Csmgr_Status_Hdr stat_hdr;
 	struct CefT_Csmgr_Status_Rep stat_rep;
+	CsmgrdT_Comp_Stat comp;
 	uint32_t value32;
 	struct pollfd fds[1];
 	uint32_t 		con_num = 0;
@@ -2531,6 +3071,19 @@ csmgrd_incoming_status_msg (
 SKIP_RESPONSE:;
 	stat_hdr.node_num = htons ((uint16_t) hdl->peer_num);
 	stat_hdr.con_num  = htonl (con_num);
+	stat_hdr.insert_rcv   = cef_client_htonb (hdl->insert_rcv);
+	stat_hdr.insert_drop  = cef_client_htonb (hdl->insert_drop);
+	stat_hdr.insert_grant = cef_client_htonb (hdl->insert_grant);
+	memset (&comp, 0, sizeof (CsmgrdT_Comp_Stat));
+	if (hdl->cs_mod_int->comp_stat_get) {
+		hdl->cs_mod_int->comp_stat_get (&comp);
+	}
+	stat_hdr.comp_raw 		= cef_client_htonb (comp.raw_bytes);
+	stat_hdr.comp_stored 	= cef_client_htonb (comp.comp_bytes);
+	stat_hdr.comp_skip 		= cef_client_htonb (comp.skip_cobs);
+	stat_hdr.comp_ns 		= cef_client_htonb (comp.comp_ns);
+	stat_hdr.decomp_cobs 	= cef_client_htonb (comp.decomp_cobs);
+	stat_hdr.decomp_ns 		= cef_client_htonb (comp.decomp_ns);
 	memcpy (&wbuf[CefC_Csmgr_Msg_HeaderLen+2/* To extend length from 2 bytes to 4 bytes */], &stat_hdr, sizeof (struct CefT_Csmgr_Status_Hdr));
 
 	value32 = htonl (index);
@@ -2566,7 +3119,7 @@ SKIP_RESPONSE:;
 #ifdef	__DB_IDX_DEB_STATUS
 			fprintf( stderr, "[%s] OUT Send status response(len = %u).\n", __func__, CefC_Csmgr_Stat_Mtu );
 #endif
-			res = cef_csmgr_send_msg (sock, &wbuf[counter*CefC_Csmgr_Stat_Mtu], CefC_Csmgr_Stat_Mtu);
+			res = csmgrd_msg_send (sock, &wbuf[counter*CefC_Csmgr_Stat_Mtu], CefC_Csmgr_Stat_Mtu);
 #ifdef CefC_Debug
 			if (res < 0) {
 				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
@@ -2591,7 +3144,7 @@ SKIP_RESPONSE:;
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", rem_size);
 #endif // CefC_Debug
-			res = cef_csmgr_send_msg (sock, &wbuf[fblocks*CefC_Csmgr_Stat_Mtu], rem_size);
+			res = csmgrd_msg_send (sock, &wbuf[fblocks*CefC_Csmgr_Stat_Mtu], rem_size);
 #ifdef CefC_Debug
 			if (res < 0) {
 				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
@@ -2620,6 +3173,7 @@ SKIP_RESPONSE:;
 	uint64_t value64;
 	struct CefT_Csmgr_Status_Hdr stat_hdr;
 	struct CefT_Csmgr_Status_Rep stat_rep;
+	CsmgrdT_Comp_Stat comp;
 	uint32_t value32;
 	struct pollfd fds[1];
 	uint32_t 		con_num = 0;
@@ -2738,6 +3292,19 @@ SKIP_RESPONSE:;
 SKIP_RESPONSE:;
 	stat_hdr.node_num = htons ((uint16_t) hdl->peer_num);
 	stat_hdr.con_num  = htonl (con_num);
+	stat_hdr.insert_rcv   = cef_client_htonb (hdl->insert_rcv);
+	stat_hdr.insert_drop  = cef_client_htonb (hdl->insert_drop);
+	stat_hdr.insert_grant = cef_client_htonb (hdl->insert_grant);
+	memset (&comp, 0, sizeof (CsmgrdT_Comp_Stat));
+	if (hdl->cs_mod_int->comp_stat_get) {
+		hdl->cs_mod_int->comp_stat_get (&comp);
+	}
+	stat_hdr.comp_raw 		= cef_client_htonb (comp.raw_bytes);
+	stat_hdr.comp_stored 	= cef_client_htonb (comp.comp_bytes);
+	stat_hdr.comp_skip 		= cef_client_htonb (comp.skip_cobs);
+	stat_hdr.comp_ns 		= cef_client_htonb (comp.comp_ns);
+	stat_hdr.decomp_cobs 	= cef_client_htonb (comp.decomp_cobs);
+	stat_hdr.decomp_ns 		= cef_client_htonb (comp.decomp_ns);
 	memcpy (&wbuf[CefC_Csmgr_Msg_HeaderLen+2/* To extend length from 2 bytes to 4 bytes */], &stat_hdr, sizeof (struct CefT_Csmgr_Status_Hdr));
 
 	value32 = htonl (index);
@@ -2767,7 +3334,7 @@ SKIP_RESPONSE:;
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", CefC_Csmgr_Stat_Mtu);
 #endif // CefC_Debug
-			res = cef_csmgr_send_msg (sock, &wbuf[counter*CefC_Csmgr_Stat_Mtu], CefC_Csmgr_Stat_Mtu);
+			res = csmgrd_msg_send (sock, &wbuf[counter*CefC_Csmgr_Stat_Mtu], CefC_Csmgr_Stat_Mtu);
 #ifdef CefC_Debug
 			if (res < 0) {
 				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
@@ -2789,7 +3356,7 @@ SKIP_RESPONSE:;
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", rem_size);
 #endif // CefC_Debug
-			res = cef_csmgr_send_msg (sock, &wbuf[fblocks*CefC_Csmgr_Stat_Mtu], rem_size);
+			res = csmgrd_msg_send (sock, &wbuf[fblocks*CefC_Csmgr_Stat_Mtu], rem_size);
 #ifdef CefC_Debug
 			if (res < 0) {
 				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
@@ -3012,7 +3579,7 @@ NO_RESP:;
 		cef_dbg_write (CefC_Dbg_Fine, "Send the ccninfo response (len = %u).\n", index);
 		cef_dbg_buff_write (CefC_Dbg_Finest, msg, index);
 #endif // CefC_Debug
-		res = cef_csmgr_send_msg (sock, msg, index);
+		res = csmgrd_msg_send (sock, msg, index);
 		if (res < 0) {
 			/* send error */
 #ifdef CefC_Debug
@@ -3020,7 +3587,7 @@ NO_RESP:;
 #endif // CefC_Debug
 		}
 	} else {
-		cef_csmgr_send_msg (sock, msg, CefC_S_TLF);
+		csmgrd_msg_send (sock, msg, CefC_S_TLF);
 	}
 
 	return;
@@ -3187,7 +3754,7 @@ NO_RESP:;
 		cef_dbg_write (CefC_Dbg_Fine, "Send the ccninfo response (len = %u).\n", index);
 		cef_dbg_buff_write (CefC_Dbg_Finest, msg, index);
 #endif // CefC_Debug
-		res = cef_csmgr_send_msg (sock, msg, index);
+		res = csmgrd_msg_send (sock, msg, index);
 		if (res < 0) {
 			/* send error */
 #ifdef CefC_Debug
@@ -3195,7 +3762,7 @@ NO_RESP:;
 #endif // CefC_Debug
 		}
 	} else {
-		cef_csmgr_send_msg (sock, msg, CefC_S_TLF);
+		csmgrd_msg_send (sock, msg, CefC_S_TLF);
 	}
 
 	return;
@@ -3293,7 +3860,7 @@ csmgrd_pre_ccninfo_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -3358,6 +3925,467 @@ csmgrd_incoming_increment_msg (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Receive Attach Shared Memory message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_shm_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+) {
+	if ((sock != hdl->local_peer_sock) || (hdl->local_shm_fd == -1)) {
+		cef_log_write (CefC_Log_Warn, "Shared memory is not received with the message\n");
+		return;
+	}
+
+	/* Cobs to the local peer are written to the ring from now on 	*/
+	if ((hdl->shm_attach == NULL) || (hdl->shm_detach == NULL) ||
+		((*hdl->shm_attach) (sock, hdl->local_shm_fd) < 0)) {
+		cef_log_write (CefC_Log_Warn, "Failed to attach the shared memory of cefnetd\n");
+	} else {
+		cef_log_write (CefC_Log_Info, "Shared-memory transport to cefnetd is enabled\n");
+	}
+	close (hdl->local_shm_fd);
+	hdl->local_shm_fd = -1;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Receives the message(s) and the memfd from the local peer
+----------------------------------------------------------------------------------------*/
+static int
+csmgrd_local_peer_recv (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* buff,						/* receive buffer						*/
+	int buff_len								/* size of receive buffer				*/
+) {
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	union {
+		char			buf[CMSG_SPACE (sizeof (int))];
+		struct cmsghdr	align;
+	} ctrl;
+	int len;
+	int fd;
+
+	memset (&mh, 0, sizeof (mh));
+	iov.iov_base 		= buff;
+	iov.iov_len 		= buff_len;
+	mh.msg_iov 			= &iov;
+	mh.msg_iovlen 		= 1;
+	mh.msg_control 		= ctrl.buf;
+	mh.msg_controllen 	= sizeof (ctrl.buf);
+
+	len = (int) recvmsg (hdl->local_peer_sock, &mh, 0);
+	if (len <= 0) {
+		return (len);
+	}
+
+	/* Keeps the memfd until the Attach Shared Memory message is handled 	*/
+	for (cmsg = CMSG_FIRSTHDR (&mh) ; cmsg != NULL ; cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+		if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS) &&
+			(cmsg->cmsg_len == CMSG_LEN (sizeof (int)))) {
+			memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+			if (hdl->local_shm_fd != -1) {
+				close (hdl->local_shm_fd);
+			}
+			hdl->local_shm_fd = fd;
+		}
+	}
+
+	return (len);
+}
+/*--------------------------------------------------------------------------------------
+	Closes the local peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_local_peer_close (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	if (hdl->shm_detach != NULL) {
+		(*hdl->shm_detach) (hdl->local_peer_sock);
+	}
+	/* The fd may be reused by the next peer before the queued jobs are served 	*/
+	__atomic_add_fetch (&hdl->peer_gen[0], 1, __ATOMIC_RELEASE);
+	if (csmgrd_sock_close) {
+		(*csmgrd_sock_close)(hdl->local_peer_sock);
+	}
+	close (hdl->local_peer_sock);
+	hdl->local_peer_sock = -1;
+	hdl->presence_fd[0]  = -1;
+	hdl->credit_fd[0] 	 = -1;
+
+	if (hdl->local_shm_fd != -1) {
+		close (hdl->local_shm_fd);
+		hdl->local_shm_fd = -1;
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Closes the TCP peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_tcp_peer_close (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int idx										/* index of the peer					*/
+) {
+	if (hdl->tcp_fds[idx] != -1) {
+		__atomic_add_fetch (&hdl->peer_gen[idx], 1, __ATOMIC_RELEASE);
+		if (csmgrd_sock_close) {
+			(*csmgrd_sock_close)(hdl->tcp_fds[idx]);
+		}
+		close (hdl->tcp_fds[idx]);
+		hdl->tcp_fds[idx] 		= -1;
+		hdl->presence_fd[idx] 	= -1;
+		hdl->credit_fd[idx] 	= -1;
+		hdl->peer_num--;
+	}
+	/* Reset buffer */
+	hdl->tcp_index[idx] = 0;
+
+	return;
+}
+#ifndef CefC_DB_INDEX
+/*--------------------------------------------------------------------------------------
+	Receive Subscribe Presence Filter message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_presence_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+) {
+	int i;
+
+	/* Nothing is returned if the filter is disabled, cefnetd then looks up all 	*/
+	if (!hdl->presence_f) {
+		return;
+	}
+	i = csmgrd_peer_index_get (hdl, sock);
+	if (i < 0) {
+		return;
+	}
+
+	if (csmgrd_presence_snapshot_send (sock, hdl->presence_seq) < 0) {
+		/* The poll closes it, and cefnetd subscribes again on the next connection 	*/
+		cef_log_write (CefC_Log_Warn, "Failed to send the presence filter.\n");
+		hdl->presence_fd[i] = -1;
+		shutdown (sock, SHUT_RDWR);
+		return;
+	}
+	hdl->presence_fd[i] = sock;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the whole bitmap of the presence filter
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_presence_snapshot_send (
+	int sock,									/* send socket							*/
+	uint32_t seq								/* sequence number of the next changes	*/
+) {
+	unsigned char buff[CefC_S_Fix_Header + 14 + CefC_Csmgr_Presence_Chunk_Max];
+	uint32_t offset = 0;
+	uint32_t len;
+	uint32_t bit_num;
+	uint32_t value32;
+	int hash_num;
+
+	/* [type][seq(4)][bit num(4)][hash num(1)][offset(4)][bitmap] 	*/
+	do {
+		len = csmgr_stat_presence_bitmap_read (stat_hdl, offset,
+				&buff[CefC_S_Fix_Header + 14], CefC_Csmgr_Presence_Chunk_Max,
+				&bit_num, &hash_num);
+		if (len == 0) {
+			return (-1);
+		}
+		buff[CefC_S_Fix_Header] = CefC_Csmgr_Presence_Snapshot;
+		value32 = htonl (seq);
+		memcpy (&buff[CefC_S_Fix_Header + 1], &value32, sizeof (uint32_t));
+		value32 = htonl (bit_num);
+		memcpy (&buff[CefC_S_Fix_Header + 5], &value32, sizeof (uint32_t));
+		buff[CefC_S_Fix_Header + 9] = (uint8_t) hash_num;
+		value32 = htonl (offset);
+		memcpy (&buff[CefC_S_Fix_Header + 10], &value32, sizeof (uint32_t));
+
+		if (csmgrd_pkt_send (sock, CefC_Csmgr_PT_Presence,
+				buff, CefC_S_Fix_Header + 14 + len) < 0) {
+			return (-1);
+		}
+		offset += len;
+	} while (offset < bit_num / 8);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the bit changes of the presence filter to the subscribers
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_presence_push (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	unsigned char buff[CefC_S_Fix_Header + 5 + CefC_Csmgr_Presence_Delta_Num * sizeof (uint32_t)];
+	uint32_t delta[CefC_Csmgr_Presence_Delta_Num];
+	uint32_t value32;
+	uint64_t nowt;
+	int num;
+	int sock;
+	int res;
+	int i, n;
+
+	nowt = cef_client_present_timeus_calc ();
+	if (nowt < hdl->presence_time) {
+		return;
+	}
+	hdl->presence_time = nowt + CefC_Csmgr_Presence_Interval;
+
+	do {
+		num = csmgr_stat_presence_delta_get (stat_hdl, delta, CefC_Csmgr_Presence_Delta_Num);
+		if (num == 0) {
+			break;
+		}
+		if (num > 0) {
+			/* [type][seq(4)][bit change(4)]... 	*/
+			buff[CefC_S_Fix_Header] = CefC_Csmgr_Presence_Delta;
+			value32 = htonl (hdl->presence_seq);
+			memcpy (&buff[CefC_S_Fix_Header + 1], &value32, sizeof (uint32_t));
+			for (n = 0 ; n < num ; n++) {
+				value32 = htonl (delta[n]);
+				memcpy (&buff[CefC_S_Fix_Header + 5 + n * sizeof (uint32_t)],
+					&value32, sizeof (uint32_t));
+			}
+		}
+
+		for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
+			sock = (i == 0) ? hdl->local_peer_sock : hdl->tcp_fds[i];
+			if ((sock == -1) || (hdl->presence_fd[i] != sock)) {
+				continue;
+			}
+			/* The changes have been lost, so the whole bitmap is sent again 	*/
+			if (num < 0) {
+				res = csmgrd_presence_snapshot_send (sock, hdl->presence_seq);
+			} else {
+				res = csmgrd_pkt_send (sock, CefC_Csmgr_PT_Presence,
+						buff, CefC_S_Fix_Header + 5 + num * sizeof (uint32_t));
+			}
+			/* A part of the message may have been sent, or cefnetd misses the 	*/
+			/* changes, so the peer is closed by the poll and subscribes again 	*/
+			if (res < 0) {
+				cef_log_write (CefC_Log_Warn, "Failed to send the presence filter.\n");
+				hdl->presence_fd[i] = -1;
+				shutdown (sock, SHUT_RDWR);
+			}
+		}
+		if (num > 0) {
+			hdl->presence_seq++;
+		}
+	} while (num != 0);
+
+	return;
+}
+#endif // CefC_DB_INDEX
+/*--------------------------------------------------------------------------------------
+	Obtains the index of the peer connected with the socket
+----------------------------------------------------------------------------------------*/
+static int							/* 0: local peer, -1: unknown socket				*/
+csmgrd_peer_index_get (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* peer socket							*/
+) {
+	int i;
+
+	if (sock == -1) {
+		return (-1);
+	}
+	if (sock == hdl->local_peer_sock) {
+		return (0);
+	}
+	for (i = 1 ; i < CsmgrdC_Max_Sock_Num ; i++) {
+		if (hdl->tcp_fds[i] == sock) {
+			return (i);
+		}
+	}
+
+	return (-1);
+}
+/*--------------------------------------------------------------------------------------
+	Receive Subscribe Insert Credit message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_credit_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock									/* recv socket							*/
+) {
+	int i;
+
+	/* Nothing is returned if the credits are disabled, cefnetd then sends freely 	*/
+	if (hdl->credit_window == 0) {
+		return;
+	}
+	i = csmgrd_peer_index_get (hdl, sock);
+	if (i < 0) {
+		return;
+	}
+
+	hdl->credit_fd[i] 	= -1;
+	hdl->credit_used[i] = 0;
+	if (csmgrd_credit_msg_send (sock, hdl->credit_window) < 0) {
+		/* The poll closes it, and cefnetd subscribes again on the next connection 	*/
+		cef_log_write (CefC_Log_Warn, "Failed to send the insert credits.\n");
+		shutdown (sock, SHUT_RDWR);
+		return;
+	}
+	hdl->credit_fd[i] = sock;
+	hdl->insert_grant += hdl->credit_window;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Grants the credits for the Upload Requests handed to the plugin
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_credit_push (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+	uint64_t nowt;
+	uint64_t grant;
+	int pending;
+	int sock;
+	int i;
+
+	nowt = cef_client_present_timeus_calc ();
+	if (nowt < hdl->credit_time) {
+		return;
+	}
+	hdl->credit_time = nowt + CefC_Csmgr_Credit_Interval;
+
+	/* The credits are held back while the plugin has not taken the previous 	*/
+	/* batch or the resources are short, so cefnetd keeps the rest in its queue	*/
+	if (pthread_mutex_trylock (&csmgr_comn_buff_mutex) != 0) {
+		return;
+	}
+	pending = csmgr_comn_cob_buff_idx;
+	pthread_mutex_unlock (&csmgr_comn_buff_mutex);
+	if (pending > 0) {
+		return;
+	}
+	pthread_mutex_lock (&csmgr_Lack_of_resources_mutex);
+	pending = Lack_of_F_resources | Lack_of_M_resources;
+	pthread_mutex_unlock (&csmgr_Lack_of_resources_mutex);
+	if (pending) {
+		return;
+	}
+
+	for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
+		sock = (i == 0) ? hdl->local_peer_sock : hdl->tcp_fds[i];
+		if ((sock == -1) || (hdl->credit_fd[i] != sock) || (hdl->credit_used[i] == 0)) {
+			continue;
+		}
+		grant = hdl->credit_used[i];
+		if (grant > UINT32_MAX) {
+			grant = UINT32_MAX;
+		}
+		if (csmgrd_credit_msg_send (sock, (uint32_t) grant) < 0) {
+			/* A part of the message may have been sent, so the peer is closed by	*/
+			/* the poll and cefnetd subscribes again on the next connection 		*/
+			cef_log_write (CefC_Log_Warn, "Failed to send the insert credits.\n");
+			hdl->credit_fd[i] = -1;
+			shutdown (sock, SHUT_RDWR);
+			continue;
+		}
+		hdl->credit_used[i] -= grant;
+		hdl->insert_grant 	+= grant;
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the credit message
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_credit_msg_send (
+	int sock,									/* send socket							*/
+	uint32_t credit								/* granted bytes						*/
+) {
+	unsigned char buff[CefC_S_Fix_Header + sizeof (uint32_t)];
+	uint32_t value32;
+
+	/* [granted bytes(4)] 	*/
+	value32 = htonl (credit);
+	memcpy (&buff[CefC_S_Fix_Header], &value32, sizeof (uint32_t));
+
+	return (csmgrd_pkt_send (sock, CefC_Csmgr_PT_Credit, buff, sizeof (buff)));
+}
+/*--------------------------------------------------------------------------------------
+	Sends the packet which cefnetd receives from csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_pkt_send (
+	int sock,									/* send socket							*/
+	uint8_t type,								/* CefC_Csmgr_PT_XXX					*/
+	unsigned char* buff,						/* message								*/
+	uint16_t len								/* message length						*/
+) {
+	struct pollfd fds[1];
+	uint16_t value16;
+	int index = 0;
+	int res;
+
+	/* Sets the fixed header, cefnetd receives it as a packet from csmgrd 	*/
+	memset (buff, 0, CefC_S_Fix_Header);
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = type;
+	value16 = htons (len);
+	memcpy (&buff[CefC_O_Fix_PacketLength], &value16, sizeof (uint16_t));
+	buff[CefC_O_Fix_HeaderLength] = CefC_S_Fix_Header;
+
+	/* A partial message would break the stream, so the rest is always sent 	*/
+	if (csmgrd_sock_lock) {
+		(*csmgrd_sock_lock)(sock);
+	}
+	while (index < len) {
+		fds[0].fd = sock;
+		fds[0].events = POLLOUT | POLLERR;
+		if (poll (fds, 1, 1000) < 1) {
+			break;
+		}
+		res = send (sock, &buff[index], len - index, MSG_DONTWAIT);
+		if (res < 0) {
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+				continue;
+			}
+			break;
+		}
+		index += res;
+	}
+	if (csmgrd_sock_unlock) {
+		(*csmgrd_sock_unlock)(sock);
+	}
+
+	return ((index < len) ? -1 : 0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the message without splitting the Cobs sent by the request threads
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_msg_send (
+	int sock,									/* send socket							*/
+	unsigned char* msg,							/* message								*/
+	uint16_t msg_len							/* message length						*/
+) {
+	int res;
+
+	if (csmgrd_sock_lock == NULL) {
+		return (cef_csmgr_send_msg (sock, msg, msg_len));
+	}
+	(*csmgrd_sock_lock)(sock);
+	res = cef_csmgr_send_msg (sock, msg, msg_len);
+	(*csmgrd_sock_unlock)(sock);
+
+	return (res);
+}
 /*--------------------------------------------------------------------------------------
 	Receive Echo message
 ----------------------------------------------------------------------------------------*/
@@ -3390,7 +4418,7 @@ csmgrd_incoming_echo_msg (
 	cef_dbg_buff_write (CefC_Dbg_Finest, ret_buff, index);
 #endif // CefC_Debug
 	/* Send response */
-	cef_csmgr_send_msg (sock, ret_buff, index);
+	csmgrd_msg_send (sock, ret_buff, index);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -3773,7 +4801,7 @@ csmgrd_rcap_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -3864,7 +4892,7 @@ csmgrd_scap_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -3961,7 +4989,7 @@ csmgrd_rclt_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -4074,7 +5102,7 @@ csmgrd_sclt_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -4547,7 +5575,7 @@ csmgrd_rcch_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -4714,6 +5742,9 @@ csmgrd_incoming_scdl_msg (
 	unsigned char range[1024] = {0};
 	uint16_t range_len;
 	int s_val, e_val, i;
+	uint64_t* cob_map;
+	uint32_t map_num, w;
+	uint64_t word;
 
 	if (hdl->cs_mod_int->content_cache_del == NULL) {
 #ifdef CefC_Debug
@@ -4803,16 +5834,27 @@ csmgrd_incoming_scdl_msg (
 			e_val = rcd->max_seq;
 		}
 
-		for (i = s_val; i <= e_val; i++) {
-
-			if (hdl->cs_mod_int->content_cache_del (name, name_len, i) < 0) {
+		/* Visits only the chunks which are cached in the range 	*/
+		map_num = csmgrd_stat_cob_map_get (stat_hdl, name, name_len, &cob_map);
+		for (w = s_val / 64 ; (w < map_num) && (w <= e_val / 64) ; w++) {
+			word = cob_map[w];
+			while (word) {
+				i = w * 64 + __builtin_ctzll (word);
+				word &= word - 1;
+				if ((i < s_val) || (i > e_val)) {
+					continue;
+				}
+				if (hdl->cs_mod_int->content_cache_del (name, name_len, i) < 0) {
 #ifdef CefC_Debug
-				cef_dbg_write (CefC_Dbg_Finest, "Delete Content Cache error.\n");
+					cef_dbg_write (CefC_Dbg_Finest, "Delete Content Cache error.\n");
 #endif // CefC_Debug
-				csmgrd_scdl_response_send (sock, CcoreC_Failed);
-				return;
+					csmgrd_scdl_response_send (sock, CcoreC_Failed);
+					free (cob_map);
+					return;
+				}
 			}
 		}
+		free (cob_map);
 	} else {
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine, "No entry.\n");
@@ -4861,7 +5903,7 @@ csmgrd_scdl_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -5685,7 +6727,7 @@ RESPSEND:;
 	cef_dbg_buff_write (CefC_Dbg_Finest, snd_buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	if (cef_csmgr_send_msg (sock, snd_buff, index) < 0) {
+	if (csmgrd_msg_send (sock, snd_buff, index) < 0) {
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine,
 			"Failed to send the Contents Information response\n");
@@ -5900,7 +6942,7 @@ RESPSEND:;
 	cef_dbg_buff_write (CefC_Dbg_Finest, snd_buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	if (cef_csmgr_send_msg (sock, snd_buff, index) < 0) {
+	if (csmgrd_msg_send (sock, snd_buff, index) < 0) {
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine,
 			"Failed to send the Contents Information response\n");
@@ -39,6 +39,7 @@
 #include <netinet/in.h>
 #include <netdb.h>
 #include <poll.h>
+#include <pthread.h>
 #include <sys/socket.h>
 
 #include <cefore/cef_define.h>
@@ -54,6 +55,11 @@
 /* Macros for csmgrd status										*/
 /*------------------------------------------------------------------*/
 #define CsmgrdC_Max_Sock_Num		32					/* Max number of TCP peer		*/
+#define CsmgrdC_Credit_Window_Default	4096			/* INSERT_CREDIT_WINDOW (KB)	*/
+#define CsmgrdC_Credit_Window_Max	8192				/* below the input buffer size	*/
+#define CsmgrdC_Req_Thread_Default	0					/* REQUEST_THREADS				*/
+#define CsmgrdC_Req_Thread_Max		32
+#define CsmgrdC_Req_Que_Max			65536				/* requests queued per thread	*/
 
 /* Library name				*/
 #ifdef __APPLE__
@@ -75,9 +81,43 @@ typedef struct {
 	char			fsc_cache_path[CefC_Csmgr_File_Path_Length]; /* FSC cache path		*/
 	uint16_t 		port_num;					/* PORT_NUM in csmgrd.conf 				*/
 	char 			local_sock_id[1024];
+	uint32_t		presence_capacity;			/* PRESENCE_FILTER_CAPACITY 			*/
+	double			presence_fp_rate;			/* PRESENCE_FILTER_FP_RATE (%)			*/
+	uint32_t		credit_window;				/* INSERT_CREDIT_WINDOW (KB)			*/
+	int				req_threads;				/* REQUEST_THREADS						*/
 	
 } CsmgrT_Config_Param;
 
+typedef struct CsmgrdT_Req_Job {
+
+	/********** Interest served by the request thread	***********/
+	struct CsmgrdT_Req_Job*	next;
+	int				sock;						/* received socket						*/
+	int				faceid;						/* Face-ID which received the Interest	*/
+	int				peer_idx;					/* index of the peer of the socket		*/
+	uint32_t		peer_gen;					/* generation of the peer when queued	*/
+	uint32_t		chunk_num;					/* chunk number							*/
+	uint16_t		name_len;					/* length of content name				*/
+	uint16_t		ver_len;					/* length of version					*/
+	unsigned char	data[];						/* content name and version				*/
+	
+} CsmgrdT_Req_Job;
+
+typedef struct {
+
+	/********** Request thread	***********/
+	pthread_t		th;
+	pthread_mutex_t	mutex;						/* held while changing the queue		*/
+	pthread_cond_t	cond;						/* signaled when a job is queued		*/
+	CsmgrdT_Req_Job* head;
+	CsmgrdT_Req_Job* tail;
+	int				num;						/* queued jobs							*/
+	int				stop_f;						/* 1: returns when the queue is empty	*/
+	CsmgrdT_Plugin_Interface* cs_mod_int;		/* plugin interface						*/
+	uint32_t*		peer_gen;					/* generations of the peers				*/
+	
+} CsmgrdT_Req_Worker;
+
 typedef struct CsmgrT_White_List {
 
 	/********** White list	***********/
@@ -107,22 +147,50 @@ typedef struct {
 	char				peer_id_str[CsmgrdC_Max_Sock_Num][NI_MAXHOST];
 	char				peer_sv_str[CsmgrdC_Max_Sock_Num][NI_MAXSERV];
 	int 				peer_num;
+	uint32_t			peer_gen[CsmgrdC_Max_Sock_Num];
+												/* incremented when the peer is closed,	*/
+												/* the jobs of the old peer are dropped	*/
 	
 	/********** Local listen socket 	***********/
 	int 				local_listen_fd;
 	char 				local_sock_name[1024];
 	int					local_peer_sock;
+	int					local_shm_fd;				/* memfd received from cefnetd			*/
 	
 	/********** load functions			***********/
 	CsmgrdT_Plugin_Interface* cs_mod_int;		/* plugin interface						*/
 	char			cs_mod_name[CsmgrdC_Max_Plugin_Name_Len];
 												/* plugin library name					*/
 	void*			mod_lib;					/* plugin library						*/
+	int (*shm_attach)(int, int);				/* csmgrd_plugin_shm_attach				*/
+	void (*shm_detach)(int);					/* csmgrd_plugin_shm_detach				*/
 	char			fsc_cache_path[CefC_Csmgr_File_Path_Length]; /* FSC cache path		*/
 	
 	/********** excache Status			***********/
 	uint32_t		interval;					/* Interval that to check cache			*/
 	
+	/********** Presence filter			***********/
+	int				presence_f;					/* 1: the filter is enabled				*/
+	int				presence_fd[CsmgrdC_Max_Sock_Num];
+												/* subscribed socket (0: local peer)	*/
+	uint64_t		presence_time;				/* time to send the bit changes			*/
+	uint32_t		presence_seq;				/* sequence number of the next changes	*/
+	
+	/********** Insert credits			***********/
+	uint32_t		credit_window;				/* initial credits (bytes), 0: not used	*/
+	int				credit_fd[CsmgrdC_Max_Sock_Num];
+												/* subscribed socket (0: local peer)	*/
+	uint64_t		credit_used[CsmgrdC_Max_Sock_Num];
+												/* bytes received since the last grant	*/
+	uint64_t		credit_time;				/* time to grant the credits			*/
+	uint64_t		insert_rcv;					/* bytes of Upload Requests received	*/
+	uint64_t		insert_drop;				/* bytes of Upload Requests dropped		*/
+	uint64_t		insert_grant;				/* bytes granted to cefnetd(s)			*/
+	
+	/********** Request threads			***********/
+	int				req_worker_num;				/* 0: served by the receiving thread	*/
+	CsmgrdT_Req_Worker* req_workers;
+	
 	/********** NodeID (IP Address) 0.8.3c ***********/
 	unsigned char 		top_nodeid[16];
 	uint16_t 			top_nodeid_len;
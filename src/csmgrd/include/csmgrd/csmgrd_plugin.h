@@ -59,6 +59,13 @@
 #define CsmgrC_Buff_Max 				100000000
 #define CsmgrC_Buff_Num 				65536
 
+/*----- Read-ahead of the sequential requests -----*/
+#define CsmgrdC_Readahead_Flow_Num 		4096		/* flows tracked at once 			*/
+#define CsmgrdC_Readahead_Win_Min 		16			/* chunks pushed to a new flow 		*/
+#define CsmgrdC_Readahead_Win_Max 		512			/* limit of the push-ahead window 	*/
+#define CsmgrdC_Readahead_Idle 			1000000		/* idle time to forget a flow (us) 	*/
+#define CsmgrdC_Readahead_Inflight 		50000		/* time the pushed chunks travel (us)*/
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
@@ -81,6 +88,16 @@ typedef struct {
 	uint16_t		ver_len;					/* Length of version					*/
 } CsmgrdT_Content_Entry;
 
+/***** Statistics of the compression of the cached cobs 		*****/
+typedef struct {
+	uint64_t		raw_bytes;					/* bytes of the cobs to be stored		*/
+	uint64_t		comp_bytes;					/* bytes stored for them				*/
+	uint64_t		skip_cobs;					/* cobs stored raw						*/
+	uint64_t		comp_ns;					/* time (ns) spent to compress			*/
+	uint64_t		decomp_cobs;				/* cobs decompressed on the hits		*/
+	uint64_t		decomp_ns;					/* time (ns) spent to decompress		*/
+} CsmgrdT_Comp_Stat;
+
 typedef struct CsmgrdT_Plugin_Interface {
 	/* Initialize process */
 	int (*init)(CsmgrT_Stat_Handle, int);		//0.8.3c
@@ -93,7 +110,7 @@ typedef struct CsmgrdT_Plugin_Interface {
 	void (*expire_check)(void);
 
 	/* Get Cob Entry */
-	int (*cache_item_get)(unsigned char*, uint16_t, uint32_t, int, unsigned char*, uint16_t);
+	int (*cache_item_get)(unsigned char*, uint16_t, uint32_t, int, int, unsigned char*, uint16_t);
 
 	/* Put contents */
 	int (*cache_item_puts)(unsigned char*, int);
@@ -114,6 +131,12 @@ typedef struct CsmgrdT_Plugin_Interface {
 
 	int (*content_lifetime_get) (unsigned char*, uint16_t, uint32_t*, uint32_t*, uint8_t);
 
+	/* 1 if cache_item_get may be called from several threads at once */
+	int item_get_mt;
+
+	/* Get the statistics of the compression (optional) */
+	void (*comp_stat_get) (CsmgrdT_Comp_Stat*);
+
 } CsmgrdT_Plugin_Interface;
 
 typedef struct CsmgrdT_Lib_Interface {
@@ -165,6 +188,13 @@ typedef struct CsmgrdT_Lib_Interface {
 		void*
 	);
 
+	/* Victim API (optional, used by the admission and the byte budget) 	*/
+	int
+	(*victim) (
+		unsigned char*,
+		int
+	);
+
 } CsmgrdT_Lib_Interface;
 
 /****************************************************************************************
@@ -194,6 +224,49 @@ csmgrd_plugin_cob_msg_send (
 	unsigned char* msg,						/* send message								*/
 	uint16_t msg_len						/* message length							*/
 );
+/*--------------------------------------------------------------------------------------
+	Locks the socket to send a whole message
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_lock (
+	int fd									/* socket fd								*/
+);
+/*--------------------------------------------------------------------------------------
+	Unlocks the socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_unlock (
+	int fd									/* socket fd								*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the socket
+----------------------------------------------------------------------------------------*/
+uint32_t
+csmgrd_plugin_sock_gen_get (
+	int fd									/* socket fd								*/
+);
+/*--------------------------------------------------------------------------------------
+	Changes the generation of the socket which csmgrd closes
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_close (
+	int fd									/* socket fd								*/
+);
+/*--------------------------------------------------------------------------------------
+	Attaches the shared ring of cefnetd to the socket
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_plugin_shm_attach (
+	int fd,									/* socket fd								*/
+	int shm_fd								/* memfd received from cefnetd				*/
+);
+/*--------------------------------------------------------------------------------------
+	Detaches the shared ring from the socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_shm_detach (
+	int fd									/* socket fd								*/
+);
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
 ----------------------------------------------------------------------------------------*/
@@ -203,6 +276,29 @@ csmgrd_lib_api_get (
 	void** 	algo_lib,
 	CsmgrdT_Lib_Interface* algo_apis
 );
+/*--------------------------------------------------------------------------------------
+	Decides whether the content may replace the victim of cache algorithm library
+----------------------------------------------------------------------------------------*/
+int												/* 1 if the content is admitted 		*/
+csmgrd_lib_admission_check (
+	CsmgrdT_Lib_Interface* algo_apis,
+	CefT_Hash_Sketch_Handle sketch,
+	unsigned char* key,
+	int key_len,
+	int full_f
+);
+/*--------------------------------------------------------------------------------------
+	Decides how many chunks are pushed ahead to the flow of the requesting face
+----------------------------------------------------------------------------------------*/
+uint32_t										/* chunks to send from seqno (>= 1) 	*/
+csmgrd_plugin_readahead_get (
+	const unsigned char* name,					/* name without the chunk number 		*/
+	uint16_t name_len,
+	int sock,									/* socket of the cefnetd 				*/
+	int faceid,									/* face which requested the content 	*/
+	uint32_t seqno,								/* requested chunk number 				*/
+	uint32_t* prefetch							/* chunks worth prefetching after them 	*/
+);
 /*--------------------------------------------------------------------------------------
 	Creates tye key from name and chunk number
 ----------------------------------------------------------------------------------------*/
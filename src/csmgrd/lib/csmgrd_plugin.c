@@ -43,6 +43,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <time.h>
@@ -58,11 +59,25 @@
 #define ALGO_MAX_MEM_USAGE				55
 
 #define	DEMO_RETRY_NUM	10
+#define CsmgrdC_Sock_Lock_Num			64		/* stripes of the socket locks 		*/
+#define CsmgrdC_Sock_Gen_Num			1024	/* slots of the socket generations 	*/
 
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
+/*** consumer flow followed by the read-ahead ***/
+typedef struct CsmgrdT_Readahead_Flow {
+	uint64_t		hash;					/* hash of the content name (0: unused)		*/
+	int				sock;					/* cefnetd which requests the content 		*/
+	int				faceid;					/* face of the cefnetd which requests it 	*/
+	uint32_t		win;					/* chunks pushed at once 					*/
+	uint32_t		sent_from;				/* chunks pushed last are [from, to) 		*/
+	uint32_t		sent_to;
+	uint64_t		sent_time;				/* time when they were pushed (us) 			*/
+	uint64_t		last_time;				/* time of the last request (us) 			*/
+} CsmgrdT_Readahead_Flow;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -75,6 +90,23 @@ static char dbg_proc[256] = {0};
 static int 	dbg_lv = CefC_Dbg_None;
 #endif // CefC_Debug
 
+/* Shared ring of cefnetd, only the local peer uses it 	*/
+static pthread_mutex_t 	shm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CefT_Csmgr_Shm* 	shm_ring = NULL;
+static int 				shm_sock = -1;
+
+/* Flows of the read-ahead, direct-mapped by the name and the face 	*/
+static pthread_mutex_t 	ra_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CsmgrdT_Readahead_Flow ra_flows[CsmgrdC_Readahead_Flow_Num];
+
+/* Keeps the messages sent to a socket from several threads from being interleaved 	*/
+static pthread_mutex_t 	sock_mutex[CsmgrdC_Sock_Lock_Num] = {
+	[0 ... CsmgrdC_Sock_Lock_Num - 1] = PTHREAD_MUTEX_INITIALIZER
+};
+
+/* Incremented when csmgrd closes the socket, the fd may be reused by the next peer 	*/
+static uint32_t 		sock_gen[CsmgrdC_Sock_Gen_Num];
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -85,6 +117,15 @@ csmgrd_log_trim_line_string (
 	char* p2,									/* name string after trimming			*/
 	char* p3									/* value string after trimming			*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the message to the socket, the caller holds the lock of the socket
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_plugin_sock_send (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message								*/
+	uint16_t msg_len						/* message length							*/
+);
 
 #ifdef CefC_Debug
 static int
@@ -107,7 +148,37 @@ csmgrd_plugin_cob_msg_send (
 	unsigned char* msg,						/* send message								*/
 	uint16_t msg_len						/* message length							*/
 ) {
+	int res = 0;
 
+	/* Writes the Cob to the shared ring, the socket is used only when it is full 	*/
+	if (__atomic_load_n (&shm_ring, __ATOMIC_RELAXED) != NULL) {
+		pthread_mutex_lock (&shm_mutex);
+		if ((shm_ring != NULL) && (fd == shm_sock)) {
+			res = cef_csmgr_shm_put (shm_ring, msg, msg_len);
+			pthread_mutex_unlock (&shm_mutex);
+			if (res == 0) {
+				return (0);
+			}
+		} else {
+			pthread_mutex_unlock (&shm_mutex);
+		}
+	}
+
+	csmgrd_plugin_sock_lock (fd);
+	csmgrd_plugin_sock_send (fd, msg, msg_len);
+	csmgrd_plugin_sock_unlock (fd);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the message to the socket, the caller holds the lock of the socket
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_plugin_sock_send (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message								*/
+	uint16_t msg_len						/* message length							*/
+) {
    	unsigned char* p = msg;
    	int len = msg_len;
 	fd_set fds, writefds;
@@ -116,13 +187,12 @@ csmgrd_plugin_cob_msg_send (
 	int res = 0;
 	int send_count = 0;
 
-
    	res = send (fd, p, len,  MSG_DONTWAIT);
 	if ( res <= 0 ) {
 #ifdef	__CSMGRD_PLUGIN_SEND_ERROR__
 		fprintf(stderr, "[%s](res <=0): ########### ERROR=%s send_count:%d\n", __FUNCTION__, strerror (errno), send_count);
 #endif
-		return( 0 );
+		return;
 	}
 	len -= res;  
 	p += res;
@@ -174,9 +244,98 @@ csmgrd_plugin_cob_msg_send (
 			}
 		}
 	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Locks the socket to send a whole message
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_lock (
+	int fd									/* socket fd								*/
+) {
+	pthread_mutex_lock (&sock_mutex[(unsigned int) fd % CsmgrdC_Sock_Lock_Num]);
+}
+/*--------------------------------------------------------------------------------------
+	Unlocks the socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_unlock (
+	int fd									/* socket fd								*/
+) {
+	pthread_mutex_unlock (&sock_mutex[(unsigned int) fd % CsmgrdC_Sock_Lock_Num]);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the socket
+----------------------------------------------------------------------------------------*/
+uint32_t
+csmgrd_plugin_sock_gen_get (
+	int fd									/* socket fd								*/
+) {
+	return (__atomic_load_n (
+		&sock_gen[(unsigned int) fd % CsmgrdC_Sock_Gen_Num], __ATOMIC_ACQUIRE));
+}
+/*--------------------------------------------------------------------------------------
+	Changes the generation of the socket which csmgrd closes
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_sock_close (
+	int fd									/* socket fd								*/
+) {
+	__atomic_add_fetch (
+		&sock_gen[(unsigned int) fd % CsmgrdC_Sock_Gen_Num], 1, __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------------------------
+	Attaches the shared ring of cefnetd to the socket
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_plugin_shm_attach (
+	int fd,									/* socket fd								*/
+	int shm_fd								/* memfd received from cefnetd				*/
+) {
+	CefT_Csmgr_Shm* shm;
+	CefT_Csmgr_Shm* old_shm;
+
+	shm = cef_csmgr_shm_attach (shm_fd);
+	if (shm == NULL) {
+		return (-1);
+	}
+	if (shm->hdr->magic != CefC_Csmgr_Shm_Magic) {
+		cef_csmgr_shm_destroy (shm);
+		return (-1);
+	}
+
+	pthread_mutex_lock (&shm_mutex);
+	old_shm  = shm_ring;
+	shm_ring = shm;
+	shm_sock = fd;
+	pthread_mutex_unlock (&shm_mutex);
+
+	cef_csmgr_shm_destroy (old_shm);
+
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Detaches the shared ring from the socket
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_shm_detach (
+	int fd									/* socket fd								*/
+) {
+	CefT_Csmgr_Shm* old_shm = NULL;
+
+	pthread_mutex_lock (&shm_mutex);
+	if ((shm_ring != NULL) && (fd == shm_sock)) {
+		old_shm  = shm_ring;
+		shm_ring = NULL;
+		shm_sock = -1;
+	}
+	pthread_mutex_unlock (&shm_mutex);
+
+	cef_csmgr_shm_destroy (old_shm);
 
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
 ----------------------------------------------------------------------------------------*/
@@ -200,9 +359,115 @@ csmgrd_lib_api_get (
 	algo_apis->hit = dlsym (*algo_lib, "hit");
 	algo_apis->miss = dlsym (*algo_lib, "miss");
 	algo_apis->status = dlsym (*algo_lib, "status");
+	algo_apis->victim = dlsym (*algo_lib, "victim");
 
 	return (1);
 }
+/*--------------------------------------------------------------------------------------
+	Decides whether the content may replace the victim of cache algorithm library
+----------------------------------------------------------------------------------------*/
+int												/* 1 if the content is admitted 		*/
+csmgrd_lib_admission_check (
+	CsmgrdT_Lib_Interface* algo_apis,
+	CefT_Hash_Sketch_Handle sketch,				/* access frequency (NULL: admit all) 	*/
+	unsigned char* key,							/* key of the content to be inserted 	*/
+	int key_len,
+	int full_f									/* 1 if the cache is full in bytes 		*/
+) {
+	unsigned char vkey[CsmgrdC_Key_Max];
+	int vkey_len;
+
+	/* The library which does not tell the victim admits everything 	*/
+	if ((sketch == (CefT_Hash_Sketch_Handle) NULL) || (algo_apis->victim == NULL)) {
+		return (1);
+	}
+	vkey_len = (*(algo_apis->victim))(vkey, full_f);
+	if (vkey_len <= 0) {
+		return (1);
+	}
+	return (cef_hash_sketch_admit (sketch, key, key_len, vkey, vkey_len));
+}
+/*--------------------------------------------------------------------------------------
+	Decides how many chunks are pushed ahead to the flow of the requesting face
+----------------------------------------------------------------------------------------*/
+uint32_t										/* chunks to send from seqno (>= 1) 	*/
+csmgrd_plugin_readahead_get (
+	const unsigned char* name,					/* name without the chunk number 		*/
+	uint16_t name_len,
+	int sock,									/* socket of the cefnetd 				*/
+	int faceid,									/* face which requested the content 	*/
+	uint32_t seqno,								/* requested chunk number 				*/
+	uint32_t* prefetch							/* chunks worth prefetching after them 	*/
+) {
+	CsmgrdT_Readahead_Flow* fp;
+	struct timeval tv;
+	uint64_t nowt;
+	uint64_t hash;
+	uint32_t num;
+	int i;
+
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	/* FNV-1a of the name, the cefnetd and its face only select the slot 	*/
+	hash = 0xcbf29ce484222325ULL;
+	for (i = 0 ; i < name_len ; i++) {
+		hash ^= name[i];
+		hash *= 0x100000001b3ULL;
+	}
+	if (hash == 0) {
+		hash = 1;
+	}
+	fp = &ra_flows[(hash ^ ((uint64_t) sock * 0x9e3779b97f4a7c15ULL)
+						^ ((uint64_t) faceid * 0xc2b2ae3d27d4eb4fULL))
+												% CsmgrdC_Readahead_Flow_Num];
+
+	pthread_mutex_lock (&ra_mutex);
+	if ((fp->hash != hash) || (fp->sock != sock) || (fp->faceid != faceid) ||
+		(nowt - fp->last_time > CsmgrdC_Readahead_Idle)) {
+		/* New flow, or the slot is taken over from the other flow 	*/
+		fp->hash   = hash;
+		fp->sock   = sock;
+		fp->faceid = faceid;
+		fp->win  = CsmgrdC_Readahead_Win_Min;
+		num = fp->win;
+	} else if (seqno >= fp->sent_to) {
+		/* The consumer caught up with the pushed chunks, so grows the window 	*/
+		if ((seqno == fp->sent_to) && (fp->win < CsmgrdC_Readahead_Win_Max)) {
+			fp->win *= 2;
+		}
+		num = fp->win;
+	} else if (seqno >= fp->sent_from) {
+		/* Requested before the pushed chunk arrived, or it was lost on the way. 	*/
+		/* Only resends it, and shrinks the window in the latter case 				*/
+		if (nowt - fp->sent_time > CsmgrdC_Readahead_Inflight) {
+			fp->win /= 2;
+			if (fp->win < CsmgrdC_Readahead_Win_Min) {
+				fp->win = CsmgrdC_Readahead_Win_Min;
+			}
+		}
+		num = 1;
+	} else {
+		/* Sought backward, restarts from the minimum 	*/
+		fp->win = CsmgrdC_Readahead_Win_Min;
+		num = fp->win;
+	}
+	if (seqno > UINT32_MAX - num) {
+		num = 1;
+	}
+	if (num > 1) {
+		fp->sent_from = seqno;
+		fp->sent_to   = seqno + num;
+		fp->sent_time = nowt;
+	}
+	fp->last_time = nowt;
+
+	/* Next request at the end of the window will likely double it 	*/
+	*prefetch = (fp->win < CsmgrdC_Readahead_Win_Max) ? fp->win * 2 : fp->win;
+	pthread_mutex_unlock (&ra_mutex);
+
+	return (num);
+}
 /*--------------------------------------------------------------------------------------
 	Creates tye key from name and chunk number
 ----------------------------------------------------------------------------------------*/
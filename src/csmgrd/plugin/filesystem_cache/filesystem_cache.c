@@ -61,6 +61,8 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <sched.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 
 #include "filesystem_cache.h"
 #include <cefore/cef_client.h>
@@ -81,25 +83,178 @@
 #define FscC_Max_Buff 			16
 #define FscC_Min_Buff			16
 
-#define FscC_Tx_Cob_Num 		256
-#define FscC_Sent_Reset_Time	50000			/* Reset sent info (50msec)			*/
-
-#define FscC_File_Head_Area			(sizeof (FscT_File_Head_Element) * FscC_Page_Cob_Num)
 
 #define FcsC_SEMNAME			"/ceffscsem"
 
-#define FscC_Page_File_Num_in_Dir	1000
+#define FscC_Seg_Size			(64 * 1024 * 1024)	/* Size of a segment file 					*/
+#define FscC_Seg_Max			1024				/* Max segment files 						*/
+#define FscC_Seg_Compact_Rate	50					/* Sealed segments holding less live 		*/
+													/* bytes (%) are compacted 					*/
+#define FscC_Rec_Max			(sizeof (FscT_Rec_Head) + UINT16_MAX)
+#define FscC_Loc_Add			1024				/* Cob locations added at once 				*/
+#define FscC_Compact_Buff		(1024 * 1024)		/* Bytes read at once by the compaction 	*/
+
+#define FscC_Seg_Free			0x00				/* not used 								*/
+#define FscC_Seg_Active			0x01				/* cobs are appended to it 					*/
+#define FscC_Seg_Sealed			0x02				/* full, only read 							*/
+#define FscC_Seg_Dead			0x03				/* freed when the I/O in flight completes 	*/
+
+#define FscC_Blk_Size			(256 * 1024)		/* Bytes read at once into the page cache	*/
+#define FscC_Blk_Hash_Num		4096				/* Buckets of the page cache				*/
+#define FscC_Job_Rec_Max		64					/* Cobs sent when a read completes			*/
+#define FscC_Read_Inflight_Max	1024				/* Max reads of the blocks in flight		*/
+#define FscC_Aio_Thread_Num		4					/* I/O threads if io_uring is not used		*/
+
+#define FscC_Wb_Rec_Max			512					/* Records written at once (2 iovecs each)	*/
+#define FscC_Ing_Report_Intv	60000000			/* Interval (us) to log the ingest rate 	*/
 
+#define FscC_Sync_None			0x00				/* the kernel writes back the segments 		*/
+#define FscC_Sync_Periodic		0x01				/* fdatasync at CACHE_WRITE_SYNC_INTERVAL	*/
+#define FscC_Sync_Close			0x02				/* fdatasync when the segment is sealed 	*/
 
-#define FscC_Page_Cob_Num		4096
-#define FscC_File_Page_Num		1000
+#define FscC_Warm_Dir_Name		"csmgr_fsc_warm"	/* Cache directory kept over the restarts 	*/
+#define FscC_Index_Magic		"CEFFSCIX"			/* Head of the index and journal files 		*/
+#define FscC_Index_Version		2
+#define FscC_Ckpt_Scan			65536				/* Contents scanned by a checkpoint step 	*/
+#define FscC_Ckpt_Entry_Max		65536				/* Entries written by a checkpoint step 	*/
+#define FscC_Jnl_Write_Intv		1000000				/* Max interval (us) to write the journal 	*/
 
-#define FSC_RECORD_CORRECT_SIZE		CefC_Max_Header_Size
+#define FscC_Jnl_Cont			0x01				/* name of the index, with the metadata		*/
+#define FscC_Jnl_Put			0x02				/* cob written, with the metadata 			*/
+#define FscC_Jnl_Loc			0x03				/* cob moved or checkpointed 				*/
+#define FscC_Jnl_Del			0x04				/* cob removed 								*/
+#define FscC_Jnl_Clear			0x05				/* all cobs of the index removed 			*/
+#define FscC_Jnl_Reset			0x06				/* all cobs removed 						*/
+
+#define FscC_Rec_Lz				0x0001				/* the msg is compressed 					*/
+#define FscC_Comp_Min_Len		128					/* Shorter cobs are stored raw 				*/
+#define FscC_Comp_Rate			88					/* Cobs compressed to more than this rate	*/
+													/* (%) are stored raw 						*/
+#define FscC_Comp_Fail_Max		32					/* Cobs stored raw in a row before the 		*/
+													/* compression is tried only sometimes 		*/
+#define FscC_Comp_Probe			64					/* Interval (cobs) of the tries then 		*/
 
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
+/***** Block of a segment file read into the page cache 		*****/
+typedef struct FscT_Page_Blk {
+	struct FscT_Page_Blk*	next;				/* next block in the same bucket		*/
+	struct FscT_Page_Blk*	lru_prev;			/* more recently used block				*/
+	struct FscT_Page_Blk*	lru_next;			/* less recently used block				*/
+	uint32_t				seg;				/* number of the segment file 			*/
+	uint32_t				blk_no;				/* number of the block in the segment 	*/
+	uint32_t				valid;				/* bytes read from the segment 			*/
+	uint32_t				size;				/* size of buf 							*/
+	unsigned char*			buf;				/* records from blk_no * FscC_Blk_Size 	*/
+} FscT_Page_Blk;
+
+/***** Segment file which the cob records are appended to 		*****/
+typedef struct {
+	int						fd;					/* -1 if the file is not created 		*/
+	int						state;				/* FscC_Seg_XXX 						*/
+	uint32_t				wpos;				/* end of the reserved records 			*/
+	uint32_t				wend;				/* end of the written records 			*/
+	uint64_t				live;				/* bytes of the records in the index 	*/
+	int						ref;				/* reads and writes in flight 			*/
+	int						close_f;			/* 1: closed when freed 				*/
+	int						compact_f;			/* 1: queued for the compaction 		*/
+	int						dirty_f;			/* 1: written after the last fdatasync 	*/
+} FscT_Seg;
+
+/***** Location of a cob record 		*****/
+typedef struct {
+	uint32_t				seg;				/* number of the segment file 			*/
+	uint32_t				off;				/* offset in the segment 				*/
+	uint32_t				len;				/* length of the record, 0 if not stored*/
+} FscT_Loc;
+
+/***** Index of the cobs of a content 		*****/
+typedef struct {
+	FscT_Loc*				loc;				/* locations indexed by chunk number 	*/
+	uint32_t				loc_max;			/* number of entries in loc 			*/
+	uint32_t				gen;				/* changes when the content is removed 	*/
+	unsigned char*			name;				/* name journaled for the warm restart 	*/
+	uint16_t				name_len;			/* length of the name 					*/
+	uint32_t				jnl_epoch;			/* journal which has the name 			*/
+} FscT_Cont;
+
+/***** Head of an entry of the index and the journal 		*****/
+typedef struct {
+	uint16_t				type;				/* FscC_Jnl_XXX 						*/
+	uint16_t				name_len;			/* FscC_Jnl_Cont: length of the name 	*/
+	uint16_t				ver_len;			/* FscC_Jnl_Cont: length of the version	*/
+	uint16_t				rsv;
+	uint32_t				index;				/* index of the content 				*/
+	uint32_t				chunk_num;			/* chunk number 						*/
+} FscT_Jnl_Head;
+
+/***** Metadata of the cobs in FscC_Jnl_Cont and FscC_Jnl_Put 		*****/
+typedef struct {
+	uint64_t				expiry;				/* expiry of the content 				*/
+	uint64_t				cached_time;		/* time when the cob was cached 		*/
+	uint32_t				pay_len;			/* payload length 						*/
+	uint32_t				node;				/* address of the node sent the cob 	*/
+} FscT_Jnl_Meta;
+
+/***** Body of FscC_Jnl_Put 		*****/
+typedef struct {
+	FscT_Jnl_Meta			meta;				/* metadata of the cob 					*/
+	FscT_Loc				loc;				/* location of the record 				*/
+} FscT_Jnl_Put;
+
+/***** Head of the index and journal files 		*****/
+typedef struct {
+	char					magic[8];			/* FscC_Index_Magic 					*/
+	uint32_t				version;			/* FscC_Index_Version 					*/
+	uint32_t				seq;				/* index: first journal to be replayed	*/
+												/* journal: number of the journal 		*/
+} FscT_Index_File_Head;
+
+/***** Buffer of the entries to be written 		*****/
+typedef struct {
+	unsigned char*			buf;
+	uint32_t				len;
+	uint32_t				size;
+} FscT_Jnl_Buff;
+
+/***** Content rebuilt from the index and the journal 		*****/
+typedef struct {
+	FscT_Jnl_Meta			meta;				/* metadata of the content 				*/
+	unsigned char*			ver;				/* version 								*/
+	uint16_t				ver_len;			/* length of the version 				*/
+} FscT_Load_Cont;
+
+/***** Record held in the write-behind buffer 		*****/
+typedef struct {
+	uint32_t				index;				/* index of the content 				*/
+	uint32_t				chunk_num;			/* chunk number 						*/
+	uint32_t				gen;				/* gen of the content when buffered 	*/
+	unsigned char*			name;				/* name taken from the received cob 	*/
+	uint16_t				name_len;			/* length of the name 					*/
+	unsigned char*			msg;				/* message taken from the received cob	*/
+	uint16_t				pay_len;			/* payload length 						*/
+	uint64_t				expiry;				/* expiry 								*/
+	struct in_addr			node;				/* address of the node sent the cob 	*/
+} FscT_Wb_Rec;
+
+/***** Read of a block which sends the cobs when it completes 		*****/
+typedef struct FscT_Read_Job {
+	CefT_Csmgr_Aio_Req		req;
+	struct FscT_Read_Job*	next;				/* next read in flight 					*/
+	struct FscT_Read_Job*	submit_next;		/* next read to be submitted 			*/
+	FscT_Page_Blk*			blk;				/* block being read, not cached yet 	*/
+	int						sock;				/* socket to send the cobs 				*/
+	uint32_t				sock_gen;			/* generation of the socket when read 	*/
+	int						rec_num;			/* number of the records to be sent 	*/
+	FscT_Loc				rec[FscC_Job_Rec_Max];
+	uint32_t				rec_hash[FscC_Job_Rec_Max];
+												/* name hashes of the requested cobs 	*/
+	uint32_t				rec_chunk[FscC_Job_Rec_Max];
+												/* chunk numbers of the requested cobs 	*/
+} FscT_Read_Job;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -118,6 +273,92 @@ static int 						fsc_proc_cob_buff_idx[FscC_Max_Buff] 	= {0};
 static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 static pthread_mutex_t 			fsc_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* The cobs are appended to the segment files by the cob put thread, and located 	*/
+/* by the index of each content. The records of a segment never change until it 	*/
+/* is freed, so the blocks read from it are cached without invalidation.			*/
+static FscT_Seg					fsc_seg[FscC_Seg_Max];
+static int						fsc_seg_active		= -1;
+static int						fsc_seg_full_f		= 0;
+static int						fsc_seg_limit		= FscC_Seg_Max;
+static int						fsc_seg_need_f		= 0;
+static uint32_t					fsc_seg_reset_cnt	= 0;
+static FscT_Cont*				fsc_cont_tbl		= NULL;
+static uint32_t					fsc_cmp_que[FscC_Seg_Max];
+static int						fsc_cmp_head		= 0;
+static int						fsc_cmp_num			= 0;
+
+/* The page cache is shared by all flows under fsc_cs_mutex 	*/
+static FscT_Page_Blk*			fsc_blk_tbl[FscC_Blk_Hash_Num]			= {0};
+static FscT_Page_Blk*			fsc_blk_lru_head	= NULL;
+static FscT_Page_Blk*			fsc_blk_lru_tail	= NULL;
+static uint64_t					fsc_blk_mem			= 0;
+static uint64_t					fsc_blk_mem_max		= 0;
+static uint64_t					fsc_blk_hit			= 0;
+static uint64_t					fsc_blk_miss		= 0;
+
+/* Disk reads complete in the I/O engine, so lookups never wait for the disk 		*/
+/* with fsc_cs_mutex. A segment is not freed while it is read.						*/
+static CefT_Csmgr_Aio*			fsc_aio				= NULL;
+static FscT_Read_Job*			fsc_rd_pend			= NULL;
+static int						fsc_rd_num			= 0;
+
+/* The records reserved contiguously in the active segment are held by the cob put	*/
+/* thread, and written at once when the buffer fills, the segment changes or the 	*/
+/* delay expires. They are located by the lookups after the write completes.		*/
+static FscT_Wb_Rec				fsc_wb_rec[FscC_Wb_Rec_Max];
+static FscT_Rec_Head			fsc_wb_head[FscC_Wb_Rec_Max];
+static struct iovec				fsc_wb_iov[FscC_Wb_Rec_Max * 2];
+static int						fsc_wb_num			= 0;
+static int						fsc_wb_seg			= -1;
+static int						fsc_wb_fd			= -1;
+static uint32_t					fsc_wb_off			= 0;
+static uint32_t					fsc_wb_len			= 0;
+static uint64_t					fsc_wb_time			= 0;
+static uint32_t					fsc_wb_size			= 0;
+static uint64_t					fsc_wb_delay		= 0;
+static int						fsc_sync_mode		= FscC_Sync_None;
+static uint64_t					fsc_sync_intv		= 0;
+static uint64_t					fsc_sync_time		= 0;
+static int						fsc_sync_num		= 0;
+static uint64_t					fsc_ing_time		= 0;
+static uint64_t					fsc_ing_bytes		= 0;
+static uint64_t					fsc_ing_cobs		= 0;
+static uint64_t					fsc_ing_writes		= 0;
+static uint64_t					fsc_ing_total_bytes	= 0;
+static uint64_t					fsc_ing_total_cobs	= 0;
+static uint64_t					fsc_ing_total_writes= 0;
+
+/* Changes of the index are journaled for the warm restart. The journal since the 	*/
+/* last checkpoint is replayed over the index when the plugin starts. The entries	*/
+/* are buffered under fsc_cs_mutex and written by the cob put thread without it.	*/
+static int						fsc_warm_f			= 0;
+static int						fsc_jnl_on			= 0;
+static int						fsc_jnl_fd			= -1;
+static uint32_t					fsc_jnl_seq			= 1;
+static uint32_t					fsc_jnl_first		= 1;
+static uint32_t					fsc_jnl_epoch		= 1;
+static FscT_Jnl_Buff			fsc_jnl_buff		= {0};
+static FscT_Jnl_Buff			fsc_jnl_spare		= {0};
+static FscT_Jnl_Buff			fsc_ckpt_buff		= {0};
+static FILE*					fsc_ckpt_fp			= NULL;
+static uint32_t					fsc_ckpt_pos		= 0;
+static uint32_t					fsc_ckpt_chunk		= 0;
+static int						fsc_jnl_reuse_f		= 0;
+static uint32_t					fsc_ckpt_seq		= 0;
+static uint64_t					fsc_ckpt_intv		= 0;
+static uint64_t					fsc_ckpt_time		= 0;
+static uint64_t					fsc_ckpt_cobs		= 0;
+
+/* The cobs are compressed by the cob put thread before they are reserved, and		*/
+/* decompressed when they are sent, so only the hits pay for it. The cobs which 	*/
+/* did not shrink make the following ones be tried less often.						*/
+static int						fsc_comp_f			= 0;
+static int						fsc_comp_fail		= 0;
+static uint32_t					fsc_comp_cnt		= 0;
+static unsigned char			fsc_comp_name[CsmgrT_Name_Max];
+static uint16_t					fsc_comp_name_len	= 0;
+static CsmgrdT_Comp_Stat		fsc_comp_stat		= {0};
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -153,9 +394,408 @@ fsc_cache_item_get (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seqno,								/* chunk num							*/
 	int sock,									/* received socket						*/
+	int faceid,									/* Face-ID which received the Interest	*/
 	unsigned char* version,						/* version								*/
 	uint16_t ver_len							/* length of version					*/
 );
+/*--------------------------------------------------------------------------------------
+	Advises the kernel to read the cobs which will be requested soon
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cache_readahead (
+	uint32_t index,
+	uint32_t seqno,
+	uint32_t num
+);
+/*--------------------------------------------------------------------------------------
+	Inits the segment store and the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_store_init (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Drops all cobs, the segment files and the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_store_reset (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Drops the cached blocks of the segment
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_cache_purge (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Looks up the block in the page cache
+----------------------------------------------------------------------------------------*/
+static FscT_Page_Blk*
+fsc_page_blk_lookup (
+	uint32_t seg,
+	uint32_t blk_no
+);
+/*--------------------------------------------------------------------------------------
+	Moves the block to the head of the LRU list
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_blk_touch (
+	FscT_Page_Blk* blk
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the location of the cob
+----------------------------------------------------------------------------------------*/
+static FscT_Loc*
+fsc_loc_get (
+	uint32_t index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Sets the location of the cob
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_loc_set (
+	uint32_t index,
+	uint32_t chunk_num,
+	uint32_t seg,
+	uint32_t off,
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Removes the location of the cob
+----------------------------------------------------------------------------------------*/
+static void
+fsc_loc_del (
+	uint32_t index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Removes the locations of all cobs of the content
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_clear (
+	uint32_t index
+);
+/*--------------------------------------------------------------------------------------
+	Frees the segment, or marks it to be freed when the I/O in flight completes
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_free (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Frees the sealed segment without live records, or queues it for the compaction
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_check (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Creates the segment file (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* file descriptor, negative if an error occurs		*/
+fsc_seg_create (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Sets the number of the segment files from the capacity
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_limit_set (
+	uint64_t cap
+);
+/*--------------------------------------------------------------------------------------
+	Prepares the next free segment, or evicts a segment if the files reach the limit
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_prepare (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Removes the live records of the segment from the index
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_evict (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Reserves the space of the record in the active segment
+----------------------------------------------------------------------------------------*/
+static int							/* number of the segment, negative if no space		*/
+fsc_seg_reserve (
+	uint32_t len,
+	uint32_t* off
+);
+/*--------------------------------------------------------------------------------------
+	Reads or writes the segment file (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_seg_pio (
+	int fd,
+	unsigned char* buf,
+	uint32_t len,
+	uint32_t off,
+	int write_f
+);
+/*--------------------------------------------------------------------------------------
+	Writes the records gathered in the iovecs (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_seg_pwritev (
+	int fd,
+	struct iovec* iov,
+	int iov_num,
+	uint32_t off
+);
+/*--------------------------------------------------------------------------------------
+	Completes the write of the record reserved by fsc_seg_reserve
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_commit (
+	uint32_t seg,
+	uint32_t off,
+	uint32_t len,
+	int ok_f
+);
+/*--------------------------------------------------------------------------------------
+	Releases the segment after the read or the write completed
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_release (
+	uint32_t seg
+);
+/*--------------------------------------------------------------------------------------
+	Compacts the segment queued by the eviction (called on the cob put thread)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_compact_run (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Checks whether the buffered records are written before the record is reserved
+----------------------------------------------------------------------------------------*/
+static int							/* 1: the buffer must be flushed					*/
+fsc_wb_check (
+	uint32_t len								/* length of the next record 			*/
+);
+/*--------------------------------------------------------------------------------------
+	Adds the record reserved by fsc_seg_reserve to the write-behind buffer
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_add (
+	uint32_t seg,								/* number of the segment 				*/
+	uint32_t off,								/* offset of the record 				*/
+	uint32_t index,								/* index of the content 				*/
+	CsmgrdT_Content_Entry* entry,				/* cob, whose name and msg are taken 	*/
+	uint16_t flags								/* flags of the record 					*/
+);
+/*--------------------------------------------------------------------------------------
+	Writes the buffered records (called on the cob put thread without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_flush (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Flushes the segment files to the disk according to the durability policy
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_sync (
+	int all_f									/* 1: all written segments are flushed 	*/
+);
+/*--------------------------------------------------------------------------------------
+	Logs the ingest rate of the cobs written to the segments
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ingest_report (
+	uint64_t nowt								/* current time (us) 					*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the monotonic time (ns) to measure the compression
+----------------------------------------------------------------------------------------*/
+static uint64_t
+fsc_comp_time_get (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Compresses the msg of the cob before it is written
+----------------------------------------------------------------------------------------*/
+static uint16_t						/* flags of the record 								*/
+fsc_rec_compress (
+	CsmgrdT_Content_Entry* entry				/* cob, whose msg may be replaced 		*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the compression
+----------------------------------------------------------------------------------------*/
+static void
+fsc_comp_stat_get (
+	CsmgrdT_Comp_Stat* stat
+);
+/*--------------------------------------------------------------------------------------
+	Removes the locations of all cobs of the content without journaling
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cont_free (
+	FscT_Cont* cont
+);
+/*--------------------------------------------------------------------------------------
+	Writes the buffer to the file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_file_write (
+	int fd,
+	const unsigned char* buf,
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Flushes the written data of the file to the disk
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_file_sync (
+	int fd
+);
+/*--------------------------------------------------------------------------------------
+	Adds the entry of the index or the journal to the buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_buff_add (
+	FscT_Jnl_Buff* jb,
+	uint16_t type,
+	uint32_t index,
+	uint32_t chunk_num,
+	const void* body,
+	uint32_t body_len,
+	const unsigned char* name,
+	uint16_t name_len,
+	const unsigned char* ver,
+	uint16_t ver_len
+);
+/*--------------------------------------------------------------------------------------
+	Adds the name and the metadata of the content to the buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_buff_cont_add (
+	FscT_Jnl_Buff* jb,
+	uint32_t index,
+	CsmgrT_Stat* rcd
+);
+/*--------------------------------------------------------------------------------------
+	Journals the change of the index (called with fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_add (
+	uint16_t type,
+	uint32_t index,
+	uint32_t chunk_num,
+	const void* body,
+	uint32_t body_len
+);
+/*--------------------------------------------------------------------------------------
+	Journals the name of the content before its cobs (called with fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_bind (
+	uint32_t index,
+	CsmgrT_Stat* rcd
+);
+/*--------------------------------------------------------------------------------------
+	Creates the journal file
+----------------------------------------------------------------------------------------*/
+static int							/* file descriptor, negative if an error occurs		*/
+fsc_jnl_open (
+	uint32_t seq
+);
+/*--------------------------------------------------------------------------------------
+	Writes the journaled entries (called on the cob put thread without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_write (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Starts the checkpoint, the journals before it are not replayed when it completes
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ckpt_start (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Writes the next contents to the checkpoint
+----------------------------------------------------------------------------------------*/
+static int							/* 1: completed, negative if an error occurs		*/
+fsc_ckpt_step (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Writes the whole checkpoint at once
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ckpt_run (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Replays the index or the journal file into the index of the cobs
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is not found	*/
+fsc_index_file_read (
+	const char* file_path,
+	uint32_t* seq,
+	FscT_Load_Cont** lc
+);
+/*--------------------------------------------------------------------------------------
+	Rebuilds the cached contents from the index and the journals
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_index_load (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the hash of the content name kept in the records
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_name_hash (
+	const unsigned char* name,
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Checks that the located record is the cob of the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is another	*/
+fsc_rec_check (
+	FscT_Loc* loc,
+	uint32_t name_hash,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Sends the cob in the record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_send (
+	int sock,
+	unsigned char* rec,
+	uint32_t len,
+	uint32_t name_hash,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the read of the block which sends the cob to the socket
+----------------------------------------------------------------------------------------*/
+static FscT_Read_Job*				/* NULL if the block cannot be read now				*/
+fsc_read_job_get (
+	FscT_Loc* loc,
+	uint32_t name_hash,
+	uint32_t chunk_num,
+	int sock,
+	FscT_Read_Job** new_jobs
+);
+/*--------------------------------------------------------------------------------------
+	Sends the cobs of the block read from the segment file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_read_done (
+	CefT_Csmgr_Aio_Req* req
+);
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
 ----------------------------------------------------------------------------------------*/
@@ -186,6 +826,13 @@ static void*
 fsc_cob_process_thread (
 	void* arg
 );
+/*--------------------------------------------------------------------------------------
+	Waits for the received cobs, or for the delay of the buffered records
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cob_process_wait (
+	void
+);
 /*--------------------------------------------------------------------------------------
 	writes the cobs to filesystem cache
 ----------------------------------------------------------------------------------------*/
@@ -309,6 +956,7 @@ csmgrd_filesystem_plugin_load (
 	cs_in->content_lifetime_set = fsc_cache_set_lifetime;
 	cs_in->content_cache_del	= fsc_cache_del;
 #endif // CefC_Ccore
+	cs_in->comp_stat_get		= fsc_comp_stat_get;
 	
 	if (config_dir) {
 		strcpy (csmgr_conf_dir, config_dir);
@@ -324,6 +972,7 @@ fsc_cs_create (
 	CsmgrT_Stat_Handle stat_hdl, int first_node_f			//0.8.3c
 ) {
 	FscT_Config_Param conf_param;
+	struct timeval tv;
 	int i;
 	int res;
 	
@@ -347,6 +996,7 @@ fsc_cs_create (
 		return (-1);
 	}
 	memset (hdl, 0, sizeof (FscT_Cache_Handle));
+	fsc_store_init ();
 	
 	/* Read config */
 	if (fsc_config_read (&conf_param) < 0) {
@@ -359,6 +1009,7 @@ fsc_cs_create (
 	hdl->algo_cob_size = conf_param.algo_cob_size;
 	hdl->cache_cobs = 0;
 	strcpy (hdl->fsc_root_path, conf_param.fsc_root_path);
+	fsc_warm_f = conf_param.warm_restart;
 	
 	/* Check for excessive or insufficient memory resources for cache algorithm library */
 	if (strcmp (hdl->algo_name, "None") != 0) {
@@ -385,6 +1036,55 @@ fsc_cs_create (
 	}
 	csmgrd_log_write (CefC_Log_Info, 
 		"Creation the cache directory (%s) ... OK\n", hdl->fsc_cache_path);
+	fsc_blk_mem_max = conf_param.page_cache_mem * 1024 * 1024;
+	csmgrd_log_write (CefC_Log_Info, 
+		"Page cache : "FMTU64" MB\n", conf_param.page_cache_mem);
+	
+	/* Creates the index of the cobs in the segments 		*/
+	fsc_cont_tbl = (FscT_Cont*) calloc (CsmgrT_Stat_Max, sizeof (FscT_Cont));
+	if (fsc_cont_tbl == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory required for startup.\n");
+		return (-1);
+	}
+	fsc_seg_limit_set (hdl->cache_capacity);
+	fsc_wb_size 	= (uint32_t) conf_param.write_buff * 1024;
+	fsc_wb_delay 	= (uint64_t) conf_param.write_delay * 1000;
+	fsc_sync_mode 	= conf_param.write_sync;
+	fsc_sync_intv 	= (uint64_t) conf_param.write_sync_intv * 1000;
+	fsc_ckpt_intv 	= (uint64_t) conf_param.ckpt_intv * 1000000;
+	fsc_comp_f 		= conf_param.compression;
+	fsc_comp_fail 	= 0;
+	fsc_comp_cnt 	= 0;
+	fsc_comp_name_len = 0;
+	memset (&fsc_comp_stat, 0, sizeof (CsmgrdT_Comp_Stat));
+	fsc_sync_time 	= 0;
+	fsc_ing_time 	= 0;
+	fsc_ing_bytes 	= 0;
+	fsc_ing_cobs 	= 0;
+	fsc_ing_writes 	= 0;
+	fsc_ing_total_bytes 	= 0;
+	fsc_ing_total_cobs 		= 0;
+	fsc_ing_total_writes 	= 0;
+	csmgrd_log_write (CefC_Log_Info, 
+		"Write buffer : %d KB, %d ms, sync %s\n", conf_param.write_buff, conf_param.write_delay, 
+		(fsc_sync_mode == FscC_Sync_Periodic) ? "periodic" : 
+		(fsc_sync_mode == FscC_Sync_Close) ? "on close" : "none");
+	if (fsc_warm_f) {
+		csmgrd_log_write (CefC_Log_Info, 
+			"Warm restart : checkpoint every %d sec\n", conf_param.ckpt_intv);
+	}
+	if (fsc_comp_f) {
+		csmgrd_log_write (CefC_Log_Info, "Compression : lz\n");
+	}
+	
+	/* Creates the I/O engine which reads the page files 		*/
+	fsc_aio = cef_csmgr_aio_create (FscC_Aio_Thread_Num);
+	if (fsc_aio == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to create the I/O engine\n");
+		return (-1);
+	}
+	csmgrd_log_write (CefC_Log_Info, "I/O engine : %s\n", 
+		(fsc_aio->type == CefC_Csmgr_Aio_Type_Uring) ? "io_uring" : "threads");
 	
 	/* Loads the library for cache algorithm 		*/
 	if (strcmp (conf_param.algo_name, "None")) {
@@ -402,10 +1102,36 @@ fsc_cs_create (
 		if (hdl->algo_apis.init) {
 			(*(hdl->algo_apis.init))(hdl->cache_capacity, fsc_cs_store, fsc_cs_remove);
 		}
+
+		/* A new Cob replaces the victim of the library only if it is requested more often */
+		if (conf_param.admission) {
+			hdl->admit_sketch = cef_hash_sketch_create ((uint32_t) hdl->cache_capacity);
+			if (hdl->admit_sketch == (CefT_Hash_Sketch_Handle) NULL) {
+				csmgrd_log_write (CefC_Log_Error, "Unable to create the admission sketch\n");
+				return (-1);
+			}
+			csmgrd_log_write (CefC_Log_Info, "Admission : TinyLFU\n");
+		}
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library : Not Specified\n");
 	}
 	
+	/* Reloads the cobs cached before the restart, and checkpoints them so that 	*/
+	/* the journal of this run starts from them 									*/
+	csmgr_stat_hdl = stat_hdl;
+	if (fsc_warm_f) {
+		if (fsc_index_load () < 0) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to reload the cache index\n");
+			return (-1);
+		}
+		fsc_jnl_on = 1;
+		if (fsc_ckpt_run () < 0) {
+			return (-1);
+		}
+		gettimeofday (&tv, NULL);
+		fsc_ckpt_time = tv.tv_sec * 1000000llu + tv.tv_usec + fsc_ckpt_intv;
+	}
+	
 	/* Creates the process buffer 		*/
 	for (i = 0 ; i < FscC_Max_Buff ; i++) {
 		if (i < FscC_Min_Buff) {
@@ -441,6 +1167,9 @@ fsc_cs_create (
 	}
 
 	fsc_thread_f = 1;
+	if (fsc_cmp_num > 0) {
+		sem_post (fsc_comn_buff_sem);
+	}
 	csmgrd_log_write (CefC_Log_Info, "Inits rx thread ... OK\n");
 	
 	csmgrd_log_write (CefC_Log_Info, "Start\n");
@@ -450,21 +1179,89 @@ fsc_cs_create (
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library  : Not Specified\n");
 	}
-	csmgr_stat_hdl = stat_hdl;
 	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
-	function for processing the received message
+	Waits for the received cobs, or for the delay of the buffered records
 ----------------------------------------------------------------------------------------*/
-static void* 
-fsc_cob_process_thread (
-	void* arg
+static void
+fsc_cob_process_wait (
+	void
 ) {
-	int i;
-	
-	while (fsc_thread_f) {
+	struct timeval tv;
+	uint64_t nowt;
+	uint64_t wake = UINT64_MAX;
+#ifndef __APPLE__
+	struct timespec ts;
+#endif // __APPLE__
+	
+	if (fsc_wb_num > 0) {
+		wake = fsc_wb_time + fsc_wb_delay;
+	}
+	if ((fsc_sync_mode == FscC_Sync_Periodic) && (fsc_sync_num > 0) && 
+		(fsc_sync_time < wake)) {
+		wake = fsc_sync_time;
+	}
+	if (fsc_warm_f) {
+		/* The checkpoint in progress continues at once, and the entries journaled	*/
+		/* by the other threads are written within FscC_Jnl_Write_Intv 			*/
+		if (fsc_ckpt_fp) {
+			return;
+		}
+		if (fsc_ckpt_time < wake) {
+			wake = fsc_ckpt_time;
+		}
+		gettimeofday (&tv, NULL);
+		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+		if (nowt + FscC_Jnl_Write_Intv < wake) {
+			wake = nowt + FscC_Jnl_Write_Intv;
+		}
+	}
+	if (wake == UINT64_MAX) {
 		sem_wait (fsc_comn_buff_sem);
+		return;
+	}
+	
+#ifdef __APPLE__
+	/* sem_timedwait is not available 		*/
+	while (sem_trywait (fsc_comn_buff_sem) != 0) {
+		gettimeofday (&tv, NULL);
+		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+		if ((nowt >= wake) || (!fsc_thread_f)) {
+			break;
+		}
+		usleep (1000);
+	}
+#else // __APPLE__
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	if (nowt >= wake) {
+		return;
+	}
+	ts.tv_sec 	= (time_t)(wake / 1000000);
+	ts.tv_nsec 	= (long)(wake % 1000000) * 1000;
+	while ((sem_timedwait (fsc_comn_buff_sem, &ts) != 0) && (errno == EINTR)) {
+		continue;
+	}
+#endif // __APPLE__
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	function for processing the received message
+----------------------------------------------------------------------------------------*/
+static void* 
+fsc_cob_process_thread (
+	void* arg
+) {
+	struct timeval tv;
+	uint64_t nowt;
+	int jnl_fd;
+	int i;
+	
+	while (fsc_thread_f) {
+		fsc_cob_process_wait ();
 		if (!fsc_thread_f)
 			break;
 		for (i = 0 ; i < FscC_Max_Buff ; i++) {
@@ -489,6 +1286,59 @@ fsc_cob_process_thread (
 			}
 			pthread_mutex_unlock (&fsc_comn_buff_mutex[i]);
 		}
+		
+		/* Writes the buffered records when the delay expires 		*/
+		gettimeofday (&tv, NULL);
+		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+		if ((fsc_wb_num > 0) && (nowt >= fsc_wb_time + fsc_wb_delay)) {
+			fsc_wb_flush ();
+		}
+		if (fsc_sync_mode == FscC_Sync_Periodic) {
+			if (nowt >= fsc_sync_time) {
+				fsc_wb_sync (0);
+				fsc_sync_time = nowt + fsc_sync_intv;
+			}
+		} else {
+			fsc_wb_sync (0);
+		}
+		fsc_ingest_report (nowt);
+		
+		/* Reclaims the space of the evicted cobs 		*/
+		fsc_seg_compact_run ();
+		fsc_seg_prepare ();
+		
+		/* Checkpoints the index a part at a time, between the writes of the cobs	*/
+		if (fsc_warm_f) {
+			fsc_jnl_write ();
+			if ((fsc_ckpt_fp == NULL) && (nowt >= fsc_ckpt_time)) {
+				fsc_ckpt_start ();
+				fsc_ckpt_time = nowt + fsc_ckpt_intv;
+			}
+			if ((fsc_ckpt_fp) && (fsc_ckpt_step () < 0)) {
+				fsc_ckpt_time = nowt + fsc_ckpt_intv;
+			}
+		}
+	}
+	
+	/* The cobs received already reach the segments before the thread exits 	*/
+	fsc_wb_flush ();
+	fsc_jnl_write ();
+	if ((fsc_sync_mode != FscC_Sync_None) || (fsc_warm_f)) {
+		fsc_wb_sync (1);
+	}
+	
+	/* The index is checkpointed, so that the next start replays little journal	*/
+	if (fsc_warm_f) {
+		fsc_ckpt_run ();
+		pthread_mutex_lock (&fsc_cs_mutex);
+		fsc_jnl_on = 0;
+		fsc_jnl_buff.len = 0;
+		jnl_fd = fsc_jnl_fd;
+		fsc_jnl_fd = -1;
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		if (jnl_fd >= 0) {
+			close (jnl_fd);
+		}
 	}
 	
 	pthread_exit (NULL);
@@ -575,9 +1425,9 @@ fsc_cs_remove (
 				mask <<= n;
 				if (rcd->cob_map[x] & mask) {
 					if (rcd->cob_num == 1) {
-						char file_path[PATH_MAX];
-						sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-						fsc_recursive_dir_clear (file_path);
+						fsc_content_clear (rcd->index);
+					} else {
+						fsc_loc_del (rcd->index, chunk_num);
 					}
 					csmgrd_stat_cob_remove (
 						csmgr_stat_hdl, &key[0], key_len - 8, chunk_num, 0);
@@ -601,14 +1451,19 @@ fsc_cs_destroy (
 	int i = 0;
 	void* status;
 	
-	pthread_mutex_destroy (&fsc_cs_mutex);
+	/* Waits for the reads in flight, they complete under fsc_cs_mutex 	*/
+	if (fsc_aio) {
+		cef_csmgr_aio_destroy (fsc_aio);
+		fsc_aio = NULL;
+	}
 	
-	/* Destory the threads 		*/
+	/* Destory the threads, which writes the buffered records before exiting 	*/
 	if (fsc_thread_f) {
 		fsc_thread_f = 0;
 		sem_post (fsc_comn_buff_sem);	/* To avoid deadlock */
 		pthread_join (fsc_rcv_thread, &status);
 	}
+	pthread_mutex_destroy (&fsc_cs_mutex);
 	sem_close (fsc_comn_buff_sem);
 	sem_unlink (FcsC_SEMNAME);
 
@@ -625,7 +1480,35 @@ fsc_cs_destroy (
 		return;
 	}
 	
-	if (hdl->fsc_cache_path[0] != 0x00) {
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, 
+		"page cache hit = "FMTU64", miss = "FMTU64"\n", fsc_blk_hit, fsc_blk_miss);
+#endif // CefC_Debug
+	fsc_ing_total_bytes 	+= fsc_ing_bytes;
+	fsc_ing_total_cobs 		+= fsc_ing_cobs;
+	fsc_ing_total_writes 	+= fsc_ing_writes;
+	csmgrd_log_write (CefC_Log_Info, 
+		"Ingest total : "FMTU64" cobs, "FMTU64" bytes, "FMTU64" writes\n", 
+		fsc_ing_total_cobs, fsc_ing_total_bytes, fsc_ing_total_writes);
+	if (fsc_comp_stat.raw_bytes > 0) {
+		csmgrd_log_write (CefC_Log_Info, 
+			"Compression total : "FMTU64" -> "FMTU64" bytes (%.1f%%), "FMTU64" raw cobs\n", 
+			fsc_comp_stat.raw_bytes, fsc_comp_stat.comp_bytes, 
+			(double) fsc_comp_stat.comp_bytes * 100.0 / (double) fsc_comp_stat.raw_bytes, 
+			fsc_comp_stat.skip_cobs);
+	}
+	fsc_store_reset ();
+	free (fsc_cont_tbl);
+	fsc_cont_tbl = NULL;
+	free (fsc_jnl_buff.buf);
+	free (fsc_jnl_spare.buf);
+	free (fsc_ckpt_buff.buf);
+	memset (&fsc_jnl_buff, 0, sizeof (FscT_Jnl_Buff));
+	memset (&fsc_jnl_spare, 0, sizeof (FscT_Jnl_Buff));
+	memset (&fsc_ckpt_buff, 0, sizeof (FscT_Jnl_Buff));
+	
+	/* The directory is kept for the warm restart 		*/
+	if ((hdl->fsc_cache_path[0] != 0x00) && (fsc_warm_f == 0)) {
 		fsc_recursive_dir_clear (hdl->fsc_cache_path);
 	}
 	
@@ -636,6 +1519,7 @@ fsc_cs_destroy (
 		}
 		dlclose (hdl->algo_lib);
 	}
+	cef_hash_sketch_destroy (hdl->admit_sketch);
 	
 	/* Destroy handle */
 	free (hdl);
@@ -654,7 +1538,6 @@ fsc_cs_expire_check (
 ) {
 	int 			index = 0;
 	CsmgrT_Stat* 	rcd = NULL;
-	char			file_path[PATH_MAX];
 	uint32_t 		i, n;
 	uint64_t 		mask;
 	uint32_t 		chunk_num, net_chunk_num;
@@ -673,8 +1556,7 @@ fsc_cs_expire_check (
 			break;
 		}
 		
-		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-		fsc_recursive_dir_clear (file_path);
+		fsc_content_clear (rcd->index);
 
 		cob_cnt = rcd->cob_num;
 		if (hdl->algo_apis.erase) {
@@ -734,35 +1616,25 @@ fsc_cache_item_get (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seqno,								/* chunk num							*/
 	int sock,									/* received socket						*/
+	int faceid,									/* Face-ID which received the Interest	*/
 	unsigned char* version,						/* version								*/
 	uint16_t ver_len							/* length of version					*/
 ) {
 	CsmgrT_Stat* rcd = NULL;
-	uint32_t	file_msglen;
 	uint64_t 	mask;
 	uint32_t 	x;
-	char		file_path[PATH_MAX];
-	static char	red_file_path[PATH_MAX] = {0};
-	int 		cob_block_index;
-	static int  red_cob_block_index = -1;
-	int			rtc;
-	int 		page_index;
-	int 		pos_index;
-	FILE*		fp = NULL;
-	int 		i;
-	int 		tx_cnt = 0;
-	int			resend_1cob_f = 0;
-	int			send_cob_f = 0;
+	uint32_t 	blk_no;
+	FscT_Loc* 	loc;
+	FscT_Page_Blk* blk;
+	FscT_Read_Job* job;
+	FscT_Read_Job* new_jobs = NULL;
+	uint32_t 	name_hash;
+	uint32_t 	tx_cnt;
+	uint32_t 	tx_num;
+	uint32_t 	prefetch;
 	unsigned char 	trg_key[CsmgrdC_Key_Max];
 	int 			trg_key_len;
-	uint64_t nowt;
-	struct timeval tv;
-	static unsigned char*	page_cob_buf = NULL;
-	int				rcdsize;
 	int			rc = CefC_CV_Inconsistent;
-	int			update_ver = 1;
-	static uint16_t red_ver_len = 0;
-	static unsigned char red_version[PATH_MAX] = {0};
 	
 #ifdef __FSCACHE_VERSION__
 	fprintf (stderr, "--- fsc_cache_item_get()\n");
@@ -771,6 +1643,9 @@ fsc_cache_item_get (
 #ifdef CefC_Debug
 	csmgrd_dbg_write (CefC_Dbg_Finest, "Incoming Interest : seqno = %u\n", seqno);
 #endif // CefC_Debug
+	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+	cef_hash_sketch_increment (hdl->admit_sketch, trg_key, trg_key_len);
+
 	pthread_mutex_lock (&fsc_cs_mutex);
 	/* Obtain the information of the specified content 		*/
 	rcd = csmgrd_stat_content_info_access (csmgr_stat_hdl, key, key_size);
@@ -779,13 +1654,13 @@ fsc_cache_item_get (
 		return (CefC_Csmgr_Cob_NotExist);
 	}
 	if (rcd->expire_f) {
-		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
 #ifdef CefC_Debug
-		csmgrd_dbg_write (CefC_Dbg_Fine, "Delete the expired content = %s\n", file_path);
+		csmgrd_dbg_write (CefC_Dbg_Fine, 
+			"Delete the expired content = %s/%d\n", hdl->fsc_cache_path, (int) rcd->index);
 #endif // CefC_Debug
-		fsc_recursive_dir_clear (file_path);
-		csmgrd_stat_content_info_delete (csmgr_stat_hdl, key, key_size);
+		fsc_content_clear (rcd->index);
 		hdl->cache_cobs -= rcd->cob_num;
+		csmgrd_stat_content_info_delete (csmgr_stat_hdl, key, key_size);
 		pthread_mutex_unlock (&fsc_cs_mutex);
 		return (CefC_Csmgr_Cob_NotExist);
 	}
@@ -795,190 +1670,2570 @@ fsc_cache_item_get (
 		if (isprint (rcd->version[i])) fprintf (stderr, "%c ", rcd->version[i]);
 		else fprintf (stderr, "%02x ", rcd->version[i]);
 	}
-	fprintf (stderr, "(%d)\n", rcd->ver_len);
-	fprintf (stderr, "  cob: ");
-	for (int i = 0; i < ver_len; i++) {
-		if (isprint (version[i])) fprintf (stderr, "%c ", version[i]);
-		else fprintf (stderr, "%02x ", version[i]);
+	fprintf (stderr, "(%d)\n", rcd->ver_len);
+	fprintf (stderr, "  cob: ");
+	for (int i = 0; i < ver_len; i++) {
+		if (isprint (version[i])) fprintf (stderr, "%c ", version[i]);
+		else fprintf (stderr, "%02x ", version[i]);
+	}
+	fprintf (stderr, "(%d)\n", ver_len);
+#endif //__FSCACHE_VERSION__
+	rc = cef_csmgr_cache_version_compare (version, ver_len, rcd->version, rcd->ver_len);
+	if (rc == CefC_CV_Inconsistent) {
+		if (ver_len == 0 && rcd->ver_len != 0) {
+			/* Request is "None", so any version is OK */
+#ifdef __FSCACHE_VERSION__
+			fprintf (stderr, "    => Request is \"None\", so any version is OK\n");
+#endif //__FSCACHE_VERSION__
+			;
+		} else {
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			return (CefC_Csmgr_Cob_NotExist);
+		}
+	} else if (rc != CefC_CV_Same) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	
+	/* Check the work cob is cached or not 		*/
+	mask = 1;
+	x = seqno / 64;
+	mask <<= (seqno % 64);
+	
+	if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+#ifdef CefC_Debug
+		csmgrd_dbg_write (CefC_Dbg_Finest, "seqno = %u is not cached\n", seqno);
+#endif // CefC_Debug
+		if (hdl->algo_apis.miss) {
+			(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
+		}
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (CefC_Csmgr_Cob_NotExist);
+	}
+	if (hdl->algo_apis.hit) {
+		(*(hdl->algo_apis.hit))(trg_key, trg_key_len);
+	}
+	csmgrd_stat_access_count_update (
+			csmgr_stat_hdl, key, key_size);
+	
+	/* Decides the chunks pushed ahead from the progress of this consumer flow 	*/
+	tx_num = csmgrd_plugin_readahead_get (
+						key, key_size, sock, faceid, seqno, &prefetch);
+	name_hash = fsc_name_hash (key, key_size);
+	
+	for (tx_cnt = 0 ; tx_cnt < tx_num ; tx_cnt++, seqno++) {
+		/* The requested cob was checked above, so skips only the following ones 	*/
+		if (tx_cnt > 0) {
+			mask = 1;
+			x = seqno / 64;
+			mask <<= (seqno % 64);
+			
+			if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+				continue;
+			}
+		}
+		
+		/* The record being written is not located until the write completes 	*/
+		loc = fsc_loc_get (rcd->index, seqno);
+		if (loc == NULL) {
+			continue;
+		}
+		
+		/* Sends the cob in the cached block, or reads the block in background 	*/
+		blk_no 	= loc->off / FscC_Blk_Size;
+		blk 	= fsc_page_blk_lookup (loc->seg, blk_no);
+		if ((blk == NULL) || 
+			(loc->off + loc->len > blk_no * FscC_Blk_Size + blk->valid)) {
+			fsc_blk_miss++;
+			job = fsc_read_job_get (loc, name_hash, seqno, sock, &new_jobs);
+			if (job == NULL) {
+				break;
+			}
+			continue;
+		}
+		fsc_blk_hit++;
+		fsc_page_blk_touch (blk);
+		
+		/* Send Cob to cefnetd */
+		fsc_rec_send (sock, &blk->buf[loc->off - blk_no * FscC_Blk_Size], loc->len, 
+			name_hash, seqno);
+	}
+	
+	/* Lets the kernel read the cobs of the next window in background 	*/
+	if ((tx_cnt == tx_num) && (tx_num > 1)) {
+		fsc_cache_readahead (rcd->index, seqno, prefetch);
+	}
+	
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	/* The cobs are sent when the reads complete 		*/
+	while (new_jobs != NULL) {
+		job = new_jobs;
+		new_jobs = job->submit_next;
+		cef_csmgr_aio_submit (fsc_aio, &job->req);
+	}
+	return (CefC_Csmgr_Cob_Exist);
+}
+/*--------------------------------------------------------------------------------------
+	Advises the kernel to read the cobs which will be requested soon
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cache_readahead (
+	uint32_t index,								/* index of the content 				*/
+	uint32_t seqno,								/* first chunk number to prefetch 		*/
+	uint32_t num								/* number of chunks to prefetch 		*/
+) {
+#ifndef __APPLE__
+	FscT_Loc* 	loc;
+	uint32_t 	seg = UINT32_MAX;
+	uint32_t 	start = 0;
+	uint32_t 	end = 0;
+	uint32_t 	i;
+	
+	/* The cobs written in sequence are adjacent in the segment, so they are 	*/
+	/* advised as a range														*/
+	for (i = 0 ; i < num ; i++) {
+		loc = fsc_loc_get (index, seqno);
+		if (loc != NULL) {
+			if ((loc->seg != seg) || (loc->off != end)) {
+				if (seg != UINT32_MAX) {
+					posix_fadvise (fsc_seg[seg].fd, 
+						(off_t) start, (off_t)(end - start), POSIX_FADV_WILLNEED);
+				}
+				seg 	= loc->seg;
+				start 	= loc->off;
+			}
+			end = loc->off + loc->len;
+		}
+		if (seqno == UINT32_MAX) {
+			break;
+		}
+		seqno++;
+	}
+	if (seg != UINT32_MAX) {
+		posix_fadvise (fsc_seg[seg].fd, 
+			(off_t) start, (off_t)(end - start), POSIX_FADV_WILLNEED);
+	}
+#endif // __APPLE__
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Inits the segment store and the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_store_init (
+	void
+) {
+	int i;
+	
+	memset (fsc_blk_tbl, 0, sizeof (fsc_blk_tbl));
+	fsc_blk_lru_head 	= NULL;
+	fsc_blk_lru_tail 	= NULL;
+	fsc_blk_mem 		= 0;
+	fsc_blk_mem_max 	= 0;
+	fsc_blk_hit 		= 0;
+	fsc_blk_miss 		= 0;
+	
+	memset (fsc_seg, 0, sizeof (fsc_seg));
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		fsc_seg[i].fd = -1;
+	}
+	fsc_seg_active 	= -1;
+	fsc_seg_full_f 	= 0;
+	fsc_seg_need_f 	= 1;
+	fsc_cont_tbl 	= NULL;
+	fsc_cmp_head 	= 0;
+	fsc_cmp_num 	= 0;
+	
+	fsc_rd_pend 	= NULL;
+	fsc_rd_num 		= 0;
+	
+	fsc_wb_num 		= 0;
+	fsc_wb_seg 		= -1;
+	fsc_wb_fd 		= -1;
+	fsc_sync_num 	= 0;
+	
+	fsc_jnl_on 		= 0;
+	fsc_jnl_fd 		= -1;
+	fsc_jnl_seq 	= 1;
+	fsc_jnl_first 	= 1;
+	fsc_jnl_epoch 	= 1;
+	fsc_ckpt_fp 	= NULL;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Drops all cobs, the segment files and the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_store_reset (
+	void
+) {
+	int i;
+	
+	if (fsc_cont_tbl) {
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			if (fsc_cont_tbl[i].loc) {
+				free (fsc_cont_tbl[i].loc);
+				fsc_cont_tbl[i].loc 	= NULL;
+				fsc_cont_tbl[i].loc_max = 0;
+			}
+			if (fsc_cont_tbl[i].name) {
+				free (fsc_cont_tbl[i].name);
+				fsc_cont_tbl[i].name 		= NULL;
+				fsc_cont_tbl[i].name_len 	= 0;
+			}
+			fsc_cont_tbl[i].gen++;
+		}
+	}
+	fsc_page_cache_purge (UINT32_MAX);
+	
+	/* The files being read or written are closed when the I/O completes 	*/
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		fsc_seg[i].compact_f = 0;
+		if (fsc_seg[i].fd == -1) {
+			continue;
+		}
+		fsc_seg[i].live 	= 0;
+		fsc_seg[i].close_f 	= 1;
+		fsc_seg_free (i);
+	}
+	fsc_seg_active 	= -1;
+	fsc_seg_need_f 	= 1;
+	fsc_seg_reset_cnt++;
+	fsc_cmp_head 	= 0;
+	fsc_cmp_num 	= 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the bucket of the page cache for the block
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_page_blk_hash (
+	uint32_t seg,
+	uint32_t blk_no
+) {
+	uint32_t hash;
+	
+	hash = seg * 2654435761u;
+	hash ^= blk_no * 40503u;
+	hash ^= hash >> 15;
+	
+	return (hash % FscC_Blk_Hash_Num);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the block from the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_blk_free (
+	FscT_Page_Blk* blk
+) {
+	FscT_Page_Blk** pp;
+	
+	pp = &fsc_blk_tbl[fsc_page_blk_hash (blk->seg, blk->blk_no)];
+	while (*pp != NULL) {
+		if (*pp == blk) {
+			*pp = blk->next;
+			break;
+		}
+		pp = &(*pp)->next;
+	}
+	
+	if (blk->lru_prev) {
+		blk->lru_prev->lru_next = blk->lru_next;
+	} else {
+		fsc_blk_lru_head = blk->lru_next;
+	}
+	if (blk->lru_next) {
+		blk->lru_next->lru_prev = blk->lru_prev;
+	} else {
+		fsc_blk_lru_tail = blk->lru_prev;
+	}
+	
+	fsc_blk_mem -= sizeof (FscT_Page_Blk) + blk->size;
+	free (blk);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the block in the page cache
+----------------------------------------------------------------------------------------*/
+static FscT_Page_Blk*
+fsc_page_blk_lookup (
+	uint32_t seg,
+	uint32_t blk_no
+) {
+	FscT_Page_Blk* blk;
+	
+	blk = fsc_blk_tbl[fsc_page_blk_hash (seg, blk_no)];
+	while (blk != NULL) {
+		if ((blk->seg == seg) && (blk->blk_no == blk_no)) {
+			return (blk);
+		}
+		blk = blk->next;
+	}
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Moves the block to the head of the LRU list
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_blk_touch (
+	FscT_Page_Blk* blk
+) {
+	if (blk->lru_prev == NULL) {
+		return;
+	}
+	blk->lru_prev->lru_next = blk->lru_next;
+	if (blk->lru_next) {
+		blk->lru_next->lru_prev = blk->lru_prev;
+	} else {
+		fsc_blk_lru_tail = blk->lru_prev;
+	}
+	blk->lru_prev = NULL;
+	blk->lru_next = fsc_blk_lru_head;
+	fsc_blk_lru_head->lru_prev = blk;
+	fsc_blk_lru_head = blk;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Puts the block read from the segment file into the page cache
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_blk_insert (
+	FscT_Page_Blk* blk
+) {
+	uint64_t blk_mem;
+	uint32_t y;
+	
+	/* Evicts the blocks used least recently, leaving room for the new one 	*/
+	blk_mem = sizeof (FscT_Page_Blk) + blk->size;
+	while ((fsc_blk_lru_tail != NULL) && (fsc_blk_mem + blk_mem > fsc_blk_mem_max)) {
+		fsc_page_blk_free (fsc_blk_lru_tail);
+	}
+	
+	y = fsc_page_blk_hash (blk->seg, blk->blk_no);
+	blk->next 		= fsc_blk_tbl[y];
+	fsc_blk_tbl[y] 	= blk;
+	blk->lru_prev 	= NULL;
+	blk->lru_next 	= fsc_blk_lru_head;
+	if (fsc_blk_lru_head) {
+		fsc_blk_lru_head->lru_prev = blk;
+	} else {
+		fsc_blk_lru_tail = blk;
+	}
+	fsc_blk_lru_head = blk;
+	fsc_blk_mem += blk_mem;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Drops the cached blocks of the segment
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_cache_purge (
+	uint32_t seg								/* number of the segment, or 			*/
+												/* UINT32_MAX to drop everything 		*/
+) {
+	FscT_Page_Blk* blk;
+	FscT_Page_Blk* next;
+	
+	blk = fsc_blk_lru_head;
+	while (blk != NULL) {
+		next = blk->lru_next;
+		if ((seg == UINT32_MAX) || (blk->seg == seg)) {
+			fsc_page_blk_free (blk);
+		}
+		blk = next;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the location of the cob
+----------------------------------------------------------------------------------------*/
+static FscT_Loc*					/* NULL if the cob is not stored					*/
+fsc_loc_get (
+	uint32_t index,								/* index of the content 				*/
+	uint32_t chunk_num							/* chunk number 						*/
+) {
+	FscT_Cont* cont;
+	
+	if ((fsc_cont_tbl == NULL) || (index >= CsmgrT_Stat_Max)) {
+		return (NULL);
+	}
+	cont = &fsc_cont_tbl[index];
+	if ((chunk_num >= cont->loc_max) || (cont->loc[chunk_num].len == 0)) {
+		return (NULL);
+	}
+	return (&cont->loc[chunk_num]);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the location of the cob
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_loc_set (
+	uint32_t index,								/* index of the content 				*/
+	uint32_t chunk_num,							/* chunk number 						*/
+	uint32_t seg,								/* number of the segment 				*/
+	uint32_t off,								/* offset of the record in the segment 	*/
+	uint32_t len								/* length of the record 				*/
+) {
+	FscT_Cont* cont;
+	FscT_Loc* new_loc;
+	uint64_t new_max;
+	
+	if (index >= CsmgrT_Stat_Max) {
+		return (-1);
+	}
+	cont = &fsc_cont_tbl[index];
+	
+	/* Chunks are mostly stored in order, so the index grows like the cob map 	*/
+	if (chunk_num >= cont->loc_max) {
+		new_max = ((uint64_t) chunk_num / FscC_Loc_Add + 1) * FscC_Loc_Add;
+		if (new_max < (uint64_t) cont->loc_max * 2) {
+			new_max = (uint64_t) cont->loc_max * 2;
+		}
+		if (new_max > (uint64_t) UINT32_MAX + 1) {
+			new_max = (uint64_t) UINT32_MAX + 1;
+		}
+		new_loc = (FscT_Loc*) realloc (cont->loc, (size_t) new_max * sizeof (FscT_Loc));
+		if (new_loc == NULL) {
+			return (-1);
+		}
+		memset (&new_loc[cont->loc_max], 0, 
+			(size_t)(new_max - cont->loc_max) * sizeof (FscT_Loc));
+		cont->loc 		= new_loc;
+		cont->loc_max 	= (new_max > UINT32_MAX) ? UINT32_MAX : (uint32_t) new_max;
+	}
+	
+	/* The record of the old cob is replaced 		*/
+	if (cont->loc[chunk_num].len) {
+		fsc_seg[cont->loc[chunk_num].seg].live -= cont->loc[chunk_num].len;
+		fsc_seg_check (cont->loc[chunk_num].seg);
+	}
+	cont->loc[chunk_num].seg = seg;
+	cont->loc[chunk_num].off = off;
+	cont->loc[chunk_num].len = len;
+	fsc_seg[seg].live += len;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the location of the cob
+----------------------------------------------------------------------------------------*/
+static void
+fsc_loc_del (
+	uint32_t index,								/* index of the content 				*/
+	uint32_t chunk_num							/* chunk number 						*/
+) {
+	FscT_Loc* loc;
+	
+	loc = fsc_loc_get (index, chunk_num);
+	if (loc == NULL) {
+		return;
+	}
+	fsc_seg[loc->seg].live -= loc->len;
+	loc->len = 0;
+	fsc_seg_check (loc->seg);
+	fsc_jnl_add (FscC_Jnl_Del, index, chunk_num, NULL, 0);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the locations of all cobs of the content
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_clear (
+	uint32_t index								/* index of the content 				*/
+) {
+	FscT_Cont* cont;
+	
+	if ((fsc_cont_tbl == NULL) || (index >= CsmgrT_Stat_Max)) {
+		return;
+	}
+	
+	cont = &fsc_cont_tbl[index];
+	if (cont->name) {
+		fsc_jnl_add (FscC_Jnl_Clear, index, 0, NULL, 0);
+	}
+	fsc_cont_free (cont);
+	cont->gen++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the locations of all cobs of the content without journaling
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cont_free (
+	FscT_Cont* cont								/* index of the cobs of the content 	*/
+) {
+	uint32_t i;
+	
+	/* Only the index is changed, the space is reclaimed by the compaction 	*/
+	for (i = 0 ; i < cont->loc_max ; i++) {
+		if (cont->loc[i].len) {
+			fsc_seg[cont->loc[i].seg].live -= cont->loc[i].len;
+			fsc_seg_check (cont->loc[i].seg);
+		}
+	}
+	free (cont->loc);
+	free (cont->name);
+	cont->loc 		= NULL;
+	cont->loc_max 	= 0;
+	cont->name 		= NULL;
+	cont->name_len 	= 0;
+	cont->jnl_epoch = 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Frees the segment, or marks it to be freed when the I/O in flight completes
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_free (
+	uint32_t seg								/* number of the segment 				*/
+) {
+	FscT_Seg* sp = &fsc_seg[seg];
+	
+	if (sp->ref > 0) {
+		sp->state = FscC_Seg_Dead;
+		return;
+	}
+	fsc_page_cache_purge (seg);
+	if ((int) seg == fsc_seg_active) {
+		fsc_seg_active = -1;
+	}
+	
+	/* The file is kept to be reused as it is allocated already 	*/
+	sp->state 	= FscC_Seg_Free;
+	sp->wpos 	= 0;
+	sp->wend 	= 0;
+	sp->live 	= 0;
+	if (sp->dirty_f) {
+		/* The records of the freed segment need not reach the disk 	*/
+		sp->dirty_f = 0;
+		fsc_sync_num--;
+	}
+	if (sp->close_f) {
+		close (sp->fd);
+		sp->fd 		= -1;
+		sp->close_f = 0;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Frees the sealed segment without live records, or queues it for the compaction
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_check (
+	uint32_t seg								/* number of the segment 				*/
+) {
+	FscT_Seg* sp = &fsc_seg[seg];
+	
+	if (sp->state != FscC_Seg_Sealed) {
+		return;
+	}
+	if (sp->live == 0) {
+		fsc_seg_free (seg);
+		return;
+	}
+	if ((sp->compact_f == 0) && 
+		(sp->live * 100 < (uint64_t) sp->wend * FscC_Seg_Compact_Rate)) {
+		sp->compact_f = 1;
+		fsc_cmp_que[(fsc_cmp_head + fsc_cmp_num) % FscC_Seg_Max] = seg;
+		fsc_cmp_num++;
+		if (fsc_thread_f) {
+			sem_post (fsc_comn_buff_sem);
+		}
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the segment file (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* file descriptor, negative if an error occurs		*/
+fsc_seg_create (
+	uint32_t seg								/* number of the segment 				*/
+) {
+	char file_path[PATH_MAX];
+	int fd;
+	
+	/* The file left by the lost segment is reused, its records are not referred 	*/
+	sprintf (file_path, "%s/seg_%d", hdl->fsc_cache_path, (int) seg);
+	fd = open (file_path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to create the segment file (%s) - %s\n", file_path, strerror (errno));
+		return (-1);
+	}
+#ifndef __APPLE__
+	/* Allocates the blocks at once, so that the appends do not extend the file 	*/
+	if (posix_fallocate (fd, 0, FscC_Seg_Size) != 0) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to allocate the segment file (%s)\n", file_path);
+		close (fd);
+		unlink (file_path);
+		return (-1);
+	}
+#endif // __APPLE__
+	
+	return (fd);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the number of the segment files from the capacity
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_limit_set (
+	uint64_t cap								/* capacity (cobs) 						*/
+) {
+	uint64_t bytes;
+	uint64_t num;
+	
+	/* The sealed segments keep more live bytes than the compaction rate, and 	*/
+	/* the active one and the next one are added 								*/
+	bytes = cap * (uint64_t)(sizeof (FscT_Rec_Head) + hdl->algo_cob_size);
+	num = (bytes * 100 / FscC_Seg_Compact_Rate + FscC_Seg_Size - 1) / FscC_Seg_Size + 2;
+	if (num > FscC_Seg_Max) {
+		num = FscC_Seg_Max;
+	}
+	fsc_seg_limit = (int) num;
+	fsc_seg_need_f = 1;
+	
+	csmgrd_log_write (CefC_Log_Info, 
+		"Segment : %d MB x %d\n", FscC_Seg_Size / (1024 * 1024), fsc_seg_limit);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Prepares the next free segment, or evicts a segment if the files reach the limit
+	(called on the cob put thread)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_prepare (
+	void
+) {
+	char file_path[PATH_MAX];
+	uint32_t reset_cnt;
+	int files = 0;
+	int spare = -1;
+	int empty = -1;
+	int victim = -1;
+	int fd;
+	int i;
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	if (!fsc_seg_need_f) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	fsc_seg_need_f = 0;
+	
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		if (fsc_seg[i].fd == -1) {
+			if ((empty < 0) && (fsc_seg[i].state == FscC_Seg_Free)) {
+				empty = i;
+			}
+			continue;
+		}
+		files++;
+		if (fsc_seg[i].state == FscC_Seg_Free) {
+			if (spare < 0) {
+				spare = i;
+			}
+		} else if ((fsc_seg[i].state == FscC_Seg_Sealed) && (fsc_seg[i].ref == 0)) {
+			/* The segment with the fewest live records loses the fewest cobs 	*/
+			if ((victim < 0) || (fsc_seg[i].live < fsc_seg[victim].live)) {
+				victim = i;
+			}
+		}
+	}
+	reset_cnt = fsc_seg_reset_cnt;
+	
+	/* The free files over the limit are removed after the capacity is reduced 	*/
+	if ((files > fsc_seg_limit) && (spare >= 0)) {
+		fd = fsc_seg[spare].fd;
+		fsc_seg[spare].fd = -1;
+		fsc_seg_need_f = 1;
+		sprintf (file_path, "%s/seg_%d", hdl->fsc_cache_path, spare);
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		close (fd);
+		unlink (file_path);
+		return;
+	}
+	if (spare >= 0) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	
+	/* Creates the next segment out of the lock, reserve only takes the files 	*/
+	/* which are created already 												*/
+	if ((files < fsc_seg_limit) && (empty >= 0)) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		fd = fsc_seg_create ((uint32_t) empty);
+		if (fd < 0) {
+			return;
+		}
+		pthread_mutex_lock (&fsc_cs_mutex);
+		if ((reset_cnt != fsc_seg_reset_cnt) || (fsc_seg[empty].fd != -1)) {
+			/* The directory has been changed while the file was created 	*/
+			fsc_seg_need_f = 1;
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			close (fd);
+			return;
+		}
+		fsc_seg[empty].fd = fd;
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	
+	/* The disk is bounded by the limit, so the records of a segment are evicted 	*/
+	if (victim >= 0) {
+		fsc_seg[victim].ref++;
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		fsc_seg_evict ((uint32_t) victim);
+		return;
+	}
+	if (fsc_seg_full_f == 0) {
+		csmgrd_log_write (CefC_Log_Warn, "No segment is available for the cobs\n");
+		fsc_seg_full_f = 1;
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Removes the live records of the segment from the index, which frees the segment
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_evict (
+	uint32_t seg								/* number of the segment (referred) 	*/
+) {
+	FscT_Rec_Head head;
+	FscT_Loc* loc;
+	FscT_Cont* cont;
+	unsigned char* buff;
+	unsigned char trg_key[CsmgrdC_Key_Max];
+	int trg_key_len;
+	uint32_t buff_size = FscC_Compact_Buff + FscC_Rec_Max;
+	uint32_t pos = 0;
+	uint32_t end;
+	uint32_t len;
+	uint32_t rlen;
+	uint32_t p;
+	int fd;
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fd 	= fsc_seg[seg].fd;
+	end = fsc_seg[seg].wend;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	buff = (unsigned char*) malloc (buff_size);
+	if (buff == NULL) {
+		goto EVICT_END;
+	}
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, "evicts the segment#%u\n", seg);
+#endif // CefC_Debug
+	
+	/* The sealed segment is read without the lock as the compaction does 	*/
+	while ((pos < end) && (fsc_thread_f)) {
+		len = (end - pos < buff_size) ? end - pos : buff_size;
+		if (fsc_seg_pio (fd, buff, len, pos, 0) < 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to read the segment#%u - %s\n", seg, strerror (errno));
+			break;
+		}
+		p = 0;
+		pthread_mutex_lock (&fsc_cs_mutex);
+		while (p + sizeof (FscT_Rec_Head) <= len) {
+			memcpy (&head, &buff[p], sizeof (FscT_Rec_Head));
+			rlen = sizeof (FscT_Rec_Head) + head.msg_len;
+			if (p + rlen > len) {
+				break;
+			}
+			loc = (head.index < CsmgrT_Stat_Max) ? 
+					fsc_loc_get (head.index, head.chunk_num) : NULL;
+			if ((loc != NULL) && (loc->seg == seg) && (loc->off == pos + p)) {
+				cont = &fsc_cont_tbl[head.index];
+				if (hdl->algo_apis.erase) {
+					trg_key_len = csmgrd_name_chunknum_concatenate (
+									cont->name, cont->name_len, head.chunk_num, trg_key);
+					(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+				}
+				hdl->cache_cobs--;
+				fsc_loc_del (head.index, head.chunk_num);
+				if (csmgrd_stat_cob_remove (csmgr_stat_hdl, 
+						cont->name, cont->name_len, head.chunk_num, 0) == 0) {
+					fsc_content_clear (head.index);
+				}
+			}
+			p += rlen;
+		}
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		if (p == 0) {
+			csmgrd_log_write (CefC_Log_Error, "The segment#%u is broken\n", seg);
+			break;
+		}
+		pos += p;
+	}
+	
+EVICT_END:
+	if (buff) {
+		free (buff);
+	}
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_seg_release (seg);
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Reserves the space of the record in the active segment
+----------------------------------------------------------------------------------------*/
+static int							/* number of the segment, negative if no space		*/
+fsc_seg_reserve (
+	uint32_t len,								/* length of the record 				*/
+	uint32_t* off								/* [out] offset of the record 			*/
+) {
+	FscT_Seg* sp;
+	int seg;
+	int spare_f = 0;
+	int i;
+	
+	if (fsc_seg_active >= 0) {
+		sp = &fsc_seg[fsc_seg_active];
+		if ((uint64_t) sp->wpos + len <= FscC_Seg_Size) {
+			*off = sp->wpos;
+			sp->wpos += len;
+			return (fsc_seg_active);
+		}
+		/* The full segment is only read from now on 	*/
+		seg = fsc_seg_active;
+		fsc_seg_active = -1;
+		sp->state = FscC_Seg_Sealed;
+		fsc_seg_check (seg);
+	}
+	
+	/* The journal reaches the file before the freed segments are written again,	*/
+	/* which the cob put thread does after it writes the journal out of the lock 	*/
+	fsc_jnl_reuse_f = 1;
+	
+	/* Opens the free segment created by the cob put thread, which prepares the 	*/
+	/* next one when no other is left 												*/
+	seg = -1;
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		if ((fsc_seg[i].state != FscC_Seg_Free) || (fsc_seg[i].fd == -1)) {
+			continue;
+		}
+		if (seg < 0) {
+			seg = i;
+		} else {
+			spare_f = 1;
+			break;
+		}
+	}
+	if (!spare_f) {
+		fsc_seg_need_f = 1;
+	}
+	if (seg < 0) {
+		return (-1);
+	}
+	fsc_seg_full_f = 0;
+	
+	sp = &fsc_seg[seg];
+	sp->state 	= FscC_Seg_Active;
+	sp->wpos 	= len;
+	sp->wend 	= 0;
+	sp->live 	= 0;
+	fsc_seg_active = seg;
+	*off = 0;
+	
+	return (seg);
+}
+/*--------------------------------------------------------------------------------------
+	Reads or writes the segment file (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_seg_pio (
+	int fd,										/* file descriptor of the segment 		*/
+	unsigned char* buf,							/* buffer 								*/
+	uint32_t len,								/* length 								*/
+	uint32_t off,								/* offset in the segment 				*/
+	int write_f									/* 1: write, 0: read 					*/
+) {
+	uint32_t done = 0;
+	ssize_t n;
+	
+	while (done < len) {
+		if (write_f) {
+			n = pwrite (fd, &buf[done], len - done, (off_t) off + done);
+		} else {
+			n = pread (fd, &buf[done], len - done, (off_t) off + done);
+		}
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		if (n == 0) {
+			return (-1);
+		}
+		done += (uint32_t) n;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the records gathered in the iovecs (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_seg_pwritev (
+	int fd,										/* file descriptor of the segment 		*/
+	struct iovec* iov,							/* iovecs, which are consumed 			*/
+	int iov_num,								/* number of the iovecs 				*/
+	uint32_t off								/* offset in the segment 				*/
+) {
+	ssize_t n;
+	
+	while (iov_num > 0) {
+		n = pwritev (fd, iov, iov_num, (off_t) off);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		if (n == 0) {
+			return (-1);
+		}
+		off += (uint32_t) n;
+		
+		/* Skips the iovecs written, and the written part of the last one 	*/
+		while ((iov_num > 0) && ((size_t) n >= iov->iov_len)) {
+			n -= (ssize_t) iov->iov_len;
+			iov++;
+			iov_num--;
+		}
+		if (iov_num > 0) {
+			iov->iov_base = (unsigned char*) iov->iov_base + n;
+			iov->iov_len -= (size_t) n;
+		}
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Completes the write of the record reserved by fsc_seg_reserve
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_commit (
+	uint32_t seg,								/* number of the segment 				*/
+	uint32_t off,								/* offset of the record 				*/
+	uint32_t len,								/* length of the record 				*/
+	int ok_f									/* 1: the record has been written 		*/
+) {
+	FscT_Seg* sp = &fsc_seg[seg];
+	
+	/* The records are written in order by the cob put thread only, so the 		*/
+	/* records up to wend can be read and compacted									*/
+	if (sp->state != FscC_Seg_Dead) {
+		if (ok_f) {
+			sp->wend = off + len;
+			if (sp->dirty_f == 0) {
+				sp->dirty_f = 1;
+				fsc_sync_num++;
+			}
+		} else if (sp->state == FscC_Seg_Active) {
+			/* Nothing is appended after the broken record 	*/
+			sp->wpos = off;
+			fsc_seg_active = -1;
+			sp->state = FscC_Seg_Sealed;
+			fsc_seg_check (seg);
+		}
+	}
+	fsc_seg_release (seg);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Releases the segment after the read or the write completed
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_release (
+	uint32_t seg								/* number of the segment 				*/
+) {
+	fsc_seg[seg].ref--;
+	if ((fsc_seg[seg].ref == 0) && (fsc_seg[seg].state == FscC_Seg_Dead)) {
+		fsc_seg_free (seg);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Moves the live record to the active segment (called without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_seg_rec_move (
+	uint32_t seg,								/* number of the compacted segment 		*/
+	uint32_t off,								/* offset of the record 				*/
+	unsigned char* rec,							/* record 								*/
+	uint32_t len								/* length of the record 				*/
+) {
+	FscT_Rec_Head head;
+	FscT_Loc* loc;
+	uint32_t gen;
+	uint32_t new_off;
+	int new_seg;
+	int fd;
+	int ok_f;
+	
+	memcpy (&head, rec, sizeof (FscT_Rec_Head));
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	loc = fsc_loc_get (head.index, head.chunk_num);
+	if ((loc == NULL) || (loc->seg != seg) || (loc->off != off)) {
+		/* The record has been evicted 		*/
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (0);
+	}
+	gen = fsc_cont_tbl[head.index].gen;
+	new_seg = fsc_seg_reserve (len, &new_off);
+	if (new_seg < 0) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (-1);
+	}
+	fsc_seg[new_seg].ref++;
+	fd = fsc_seg[new_seg].fd;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	if (fsc_jnl_reuse_f) {
+		fsc_jnl_write ();
+	}
+	ok_f = (fsc_seg_pio (fd, rec, len, new_off, 1) == 0);
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_seg_commit ((uint32_t) new_seg, new_off, len, ok_f);
+	if ((ok_f) && (gen == fsc_cont_tbl[head.index].gen)) {
+		loc = fsc_loc_get (head.index, head.chunk_num);
+		if ((loc != NULL) && (loc->seg == seg) && (loc->off == off)) {
+			if (fsc_loc_set (head.index, head.chunk_num, (uint32_t) new_seg, new_off, len) == 0) {
+				fsc_jnl_bind (head.index, NULL);
+				fsc_jnl_add (FscC_Jnl_Loc, head.index, head.chunk_num, 
+					fsc_loc_get (head.index, head.chunk_num), sizeof (FscT_Loc));
+			}
+		}
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return (ok_f ? 0 : -1);
+}
+/*--------------------------------------------------------------------------------------
+	Moves the live records of the segment, which is freed when they are moved
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_compact (
+	uint32_t seg								/* number of the segment (referred) 	*/
+) {
+	FscT_Rec_Head head;
+	unsigned char* buff;
+	uint32_t buff_size = FscC_Compact_Buff + FscC_Rec_Max;
+	uint32_t pos = 0;
+	uint32_t end;
+	uint32_t len;
+	uint32_t rlen;
+	uint32_t p;
+	int fd;
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fd 	= fsc_seg[seg].fd;
+	end = fsc_seg[seg].wend;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	buff = (unsigned char*) malloc (buff_size);
+	if (buff == NULL) {
+		goto COMPACT_END;
+	}
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, "compacts the segment#%u\n", seg);
+#endif // CefC_Debug
+	
+	/* The sealed segment does not change, so it is read without the lock 	*/
+	while ((pos < end) && (fsc_thread_f)) {
+		len = (end - pos < buff_size) ? end - pos : buff_size;
+		if (fsc_seg_pio (fd, buff, len, pos, 0) < 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to read the segment#%u - %s\n", seg, strerror (errno));
+			break;
+		}
+		p = 0;
+		while (p + sizeof (FscT_Rec_Head) <= len) {
+			memcpy (&head, &buff[p], sizeof (FscT_Rec_Head));
+			rlen = sizeof (FscT_Rec_Head) + head.msg_len;
+			if (p + rlen > len) {
+				break;
+			}
+			if (fsc_seg_rec_move (seg, pos + p, &buff[p], rlen) < 0) {
+				goto COMPACT_END;
+			}
+			p += rlen;
+		}
+		if (p == 0) {
+			csmgrd_log_write (CefC_Log_Error, "The segment#%u is broken\n", seg);
+			break;
+		}
+		pos += p;
+	}
+	
+COMPACT_END:
+	if (buff) {
+		free (buff);
+	}
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_seg_release (seg);
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Compacts the segment queued by the eviction (called on the cob put thread)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_compact_run (
+	void
+) {
+	FscT_Seg* sp;
+	uint32_t seg;
+	int run_f = 0;
+	int more_f;
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	if (fsc_cmp_num == 0) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	seg = fsc_cmp_que[fsc_cmp_head];
+	fsc_cmp_head = (fsc_cmp_head + 1) % FscC_Seg_Max;
+	fsc_cmp_num--;
+	sp = &fsc_seg[seg];
+	sp->compact_f = 0;
+	if ((sp->state == FscC_Seg_Sealed) && 
+		(sp->live * 100 < (uint64_t) sp->wend * FscC_Seg_Compact_Rate)) {
+		sp->ref++;
+		run_f = 1;
+	}
+	more_f = fsc_cmp_num;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	if (run_f) {
+		/* The moved records are appended after the buffered ones 	*/
+		fsc_wb_flush ();
+		fsc_seg_compact (seg);
+	}
+	
+	/* One segment is compacted at a time, between the writes of the cobs 	*/
+	if (more_f) {
+		sem_post (fsc_comn_buff_sem);
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the buffered records are written before the record is reserved
+----------------------------------------------------------------------------------------*/
+static int							/* 1: the buffer must be flushed					*/
+fsc_wb_check (
+	uint32_t len								/* length of the next record 			*/
+) {
+	if (fsc_wb_num == 0) {
+		return (0);
+	}
+	if ((fsc_wb_num >= FscC_Wb_Rec_Max) || (fsc_wb_len + len > fsc_wb_size)) {
+		return (1);
+	}
+	
+	/* The buffered records are written before the segment is sealed, and the 	*/
+	/* next record has to follow them in the same segment 							*/
+	if ((fsc_seg_active != fsc_wb_seg) || 
+		((uint64_t) fsc_seg[fsc_wb_seg].wpos + len > FscC_Seg_Size)) {
+		return (1);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the record reserved by fsc_seg_reserve to the write-behind buffer
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_add (
+	uint32_t seg,								/* number of the segment 				*/
+	uint32_t off,								/* offset of the record 				*/
+	uint32_t index,								/* index of the content 				*/
+	CsmgrdT_Content_Entry* entry,				/* cob, whose name and msg are taken 	*/
+	uint16_t flags								/* flags of the record 					*/
+) {
+	FscT_Wb_Rec* rec;
+	FscT_Rec_Head* head;
+	struct timeval tv;
+	
+	if (fsc_wb_num == 0) {
+		gettimeofday (&tv, NULL);
+		fsc_wb_time = tv.tv_sec * 1000000llu + tv.tv_usec;
+		fsc_wb_seg 	= (int) seg;
+		fsc_wb_fd 	= fsc_seg[seg].fd;
+		fsc_wb_off 	= off;
+		fsc_wb_len 	= 0;
+		fsc_seg[seg].ref++;
+	}
+	rec  = &fsc_wb_rec[fsc_wb_num];
+	head = &fsc_wb_head[fsc_wb_num];
+	
+	head->index 	= index;
+	head->chunk_num = entry->chunk_num;
+	head->msg_len 	= entry->msg_len;
+	head->flags 	= flags;
+	head->name_hash = fsc_name_hash (entry->name, entry->name_len);
+	
+	rec->index 		= index;
+	rec->chunk_num 	= entry->chunk_num;
+	rec->gen 		= fsc_cont_tbl[index].gen;
+	rec->name 		= entry->name;
+	rec->name_len 	= entry->name_len;
+	rec->msg 		= entry->msg;
+	rec->pay_len 	= entry->pay_len;
+	rec->expiry 	= entry->expiry;
+	rec->node 		= entry->node;
+	entry->name = NULL;
+	entry->msg 	= NULL;
+	
+	fsc_wb_iov[fsc_wb_num * 2].iov_base 	= head;
+	fsc_wb_iov[fsc_wb_num * 2].iov_len 		= sizeof (FscT_Rec_Head);
+	fsc_wb_iov[fsc_wb_num * 2 + 1].iov_base = rec->msg;
+	fsc_wb_iov[fsc_wb_num * 2 + 1].iov_len 	= head->msg_len;
+	fsc_wb_len += (uint32_t) sizeof (FscT_Rec_Head) + head->msg_len;
+	fsc_wb_num++;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the buffered records (called on the cob put thread without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_flush (
+	void
+) {
+	FscT_Wb_Rec* rec;
+	CsmgrT_Stat* rcd;
+	FscT_Jnl_Put put;
+	struct timeval tv;
+	uint32_t off;
+	uint32_t rlen;
+	uint64_t mask;
+	uint32_t x;
+	int ok_f;
+	int err = 0;
+	int i;
+	
+	if (fsc_wb_num == 0) {
+		return;
+	}
+	gettimeofday (&tv, NULL);
+	memset (&put, 0, sizeof (FscT_Jnl_Put));
+	put.meta.cached_time = tv.tv_sec * 1000000llu + tv.tv_usec;
+	
+	/* The journal removing the old records of the reused segment goes first 	*/
+	if (fsc_jnl_reuse_f) {
+		fsc_jnl_write ();
+	}
+	
+	/* The records are written at once, the segment is kept by the reference 	*/
+	ok_f = (fsc_seg_pwritev (fsc_wb_fd, fsc_wb_iov, fsc_wb_num * 2, fsc_wb_off) == 0);
+	if (!ok_f) {
+		err = errno;
+	}
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_seg_commit ((uint32_t) fsc_wb_seg, fsc_wb_off, fsc_wb_len, ok_f);
+	if (!ok_f) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to write the segment#%d - %s\n", fsc_wb_seg, strerror (err));
+	}
+	off = fsc_wb_off;
+	for (i = 0 ; i < fsc_wb_num ; i++) {
+		rec  = &fsc_wb_rec[i];
+		rlen = (uint32_t) sizeof (FscT_Rec_Head) + fsc_wb_head[i].msg_len;
+		
+		/* Skips the cobs removed while they were buffered 		*/
+		if (rec->gen != fsc_cont_tbl[rec->index].gen) {
+			goto NEXTREC;
+		}
+		rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, rec->name, rec->name_len);
+		if ((rcd == NULL) || (rcd->index != rec->index)) {
+			goto NEXTREC;
+		}
+		mask = 1;
+		x = rec->chunk_num / 64;
+		mask <<= (rec->chunk_num % 64);
+		if (((rcd->map_max-1) < x) || ((rcd->cob_map[x] & mask) == 0)) {
+			goto NEXTREC;
+		}
+		
+		if ((ok_f) && 
+			(fsc_loc_set (rec->index, rec->chunk_num, 
+					(uint32_t) fsc_wb_seg, off, rlen) == 0)) {
+			if (fsc_jnl_on) {
+				fsc_jnl_bind (rec->index, rcd);
+				put.meta.expiry 	= rec->expiry;
+				put.meta.pay_len 	= rec->pay_len;
+				put.meta.node 		= rec->node.s_addr;
+				put.loc = fsc_cont_tbl[rec->index].loc[rec->chunk_num];
+				fsc_jnl_add (FscC_Jnl_Put, rec->index, rec->chunk_num, 
+					&put, sizeof (FscT_Jnl_Put));
+			}
+		} else {
+			if (hdl->algo_apis.erase) {
+				unsigned char 	trg_key[CsmgrdC_Key_Max];
+				int 			trg_key_len;
+				trg_key_len = csmgrd_name_chunknum_concatenate (
+								rec->name, rec->name_len, rec->chunk_num, trg_key);
+				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+			}
+			hdl->cache_cobs--;
+			csmgrd_stat_cob_remove (
+				csmgr_stat_hdl, rec->name, rec->name_len, rec->chunk_num, 0);
+		}
+NEXTREC:
+		off += rlen;
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	for (i = 0 ; i < fsc_wb_num ; i++) {
+		free (fsc_wb_rec[i].msg);
+		free (fsc_wb_rec[i].name);
+	}
+	if (ok_f) {
+		fsc_ing_bytes 	+= fsc_wb_len;
+		fsc_ing_cobs 	+= (uint64_t) fsc_wb_num;
+		fsc_ing_writes++;
+	}
+	fsc_wb_num 	= 0;
+	fsc_wb_seg 	= -1;
+	fsc_wb_fd 	= -1;
+	fsc_wb_len 	= 0;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Flushes the segment files to the disk according to the durability policy
+----------------------------------------------------------------------------------------*/
+static void
+fsc_wb_sync (
+	int all_f									/* 1: all written segments are flushed 	*/
+) {
+	static uint32_t sync_seg[FscC_Seg_Max];
+	FscT_Seg* sp;
+	int sync_num = 0;
+	int i;
+	
+	if ((fsc_sync_mode == FscC_Sync_None) && (all_f == 0)) {
+		return;
+	}
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	if ((fsc_sync_num == 0) && ((all_f == 0) || (fsc_jnl_fd < 0))) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return;
+	}
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		sp = &fsc_seg[i];
+		if ((sp->dirty_f == 0) || (sp->state == FscC_Seg_Dead)) {
+			continue;
+		}
+		/* The active segment is flushed when it is sealed with FscC_Sync_Close 	*/
+		if ((all_f == 0) && 
+			(fsc_sync_mode == FscC_Sync_Close) && (sp->state == FscC_Seg_Active)) {
+			continue;
+		}
+		sp->dirty_f = 0;
+		sp->ref++;
+		fsc_sync_num--;
+		sync_seg[sync_num] = (uint32_t) i;
+		sync_num++;
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	/* fdatasync is called out of the lock, the segments are kept by the references	*/
+	for (i = 0 ; i < sync_num ; i++) {
+		if (fsc_file_sync (fsc_seg[sync_seg[i]].fd) < 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to flush the segment#%u - %s\n", sync_seg[i], strerror (errno));
+		}
+	}
+	
+	/* The journal is flushed after the records which it locates 	*/
+	if ((fsc_jnl_fd >= 0) && ((sync_num > 0) || (all_f)) && 
+		(fsc_file_sync (fsc_jnl_fd) < 0)) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to flush the journal - %s\n", strerror (errno));
+	}
+	
+	pthread_mutex_lock (&fsc_cs_mutex);
+	for (i = 0 ; i < sync_num ; i++) {
+		fsc_seg_release (sync_seg[i]);
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Logs the ingest rate of the cobs written to the segments
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ingest_report (
+	uint64_t nowt								/* current time (us) 					*/
+) {
+	uint64_t elapsed;
+	
+	if (fsc_ing_time == 0) {
+		fsc_ing_time = nowt;
+		return;
+	}
+	if (nowt < fsc_ing_time + FscC_Ing_Report_Intv) {
+		return;
+	}
+	elapsed = nowt - fsc_ing_time;
+	if (fsc_ing_writes > 0) {
+		csmgrd_log_write (CefC_Log_Info, 
+			"Ingest : %.2f MB/s, %.0f cobs/s, %.1f cobs/write\n", 
+			(double) fsc_ing_bytes / (double) elapsed, 
+			(double) fsc_ing_cobs * 1000000.0 / (double) elapsed, 
+			(double) fsc_ing_cobs / (double) fsc_ing_writes);
+	}
+	fsc_ing_total_bytes 	+= fsc_ing_bytes;
+	fsc_ing_total_cobs 		+= fsc_ing_cobs;
+	fsc_ing_total_writes 	+= fsc_ing_writes;
+	fsc_ing_bytes 	= 0;
+	fsc_ing_cobs 	= 0;
+	fsc_ing_writes 	= 0;
+	fsc_ing_time 	= nowt;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the monotonic time (ns) to measure the compression
+----------------------------------------------------------------------------------------*/
+static uint64_t
+fsc_comp_time_get (
+	void
+) {
+	struct timespec ts;
+	
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ((uint64_t) ts.tv_sec * 1000000000llu + (uint64_t) ts.tv_nsec);
+}
+/*--------------------------------------------------------------------------------------
+	Compresses the msg of the cob before it is written
+----------------------------------------------------------------------------------------*/
+static uint16_t						/* flags of the record 								*/
+fsc_rec_compress (
+	CsmgrdT_Content_Entry* entry				/* cob, whose msg may be replaced 		*/
+) {
+	static unsigned char buff[UINT16_MAX];
+	unsigned char* msg = NULL;
+	uint16_t raw_len = entry->msg_len;
+	uint64_t elapsed = 0;
+	uint64_t start;
+	int len = 0;
+	
+	/* After the cobs which did not shrink, the others of the content are 		*/
+	/* stored raw without the compression except the probes 					*/
+	if ((entry->name_len != fsc_comp_name_len) || 
+		(memcmp (entry->name, fsc_comp_name, entry->name_len))) {
+		memcpy (fsc_comp_name, entry->name, entry->name_len);
+		fsc_comp_name_len = entry->name_len;
+		fsc_comp_fail = 0;
+	}
+	fsc_comp_cnt++;
+	
+	/* The compressed msg has to be smaller than the rate of the raw one 	*/
+	if ((raw_len >= FscC_Comp_Min_Len) && 
+		((fsc_comp_fail < FscC_Comp_Fail_Max) || ((fsc_comp_cnt % FscC_Comp_Probe) == 0))) {
+		start = fsc_comp_time_get ();
+		len = cef_csmgr_lz_compress (entry->msg, raw_len, buff, 
+				(int)((uint32_t) raw_len * FscC_Comp_Rate / 100));
+		elapsed = fsc_comp_time_get () - start;
+		if (len > 0) {
+			msg = (unsigned char*) malloc (len);
+			fsc_comp_fail = 0;
+		} else if (fsc_comp_fail < FscC_Comp_Fail_Max) {
+			fsc_comp_fail++;
+		}
+	}
+	
+	/* Every cob is counted, so the ratio is that of the bytes on the disk 	*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_comp_stat.raw_bytes += raw_len;
+	fsc_comp_stat.comp_ns 	+= elapsed;
+	if (msg == NULL) {
+		fsc_comp_stat.comp_bytes += raw_len;
+		fsc_comp_stat.skip_cobs++;
+	} else {
+		fsc_comp_stat.comp_bytes += (uint64_t) len;
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	if (msg == NULL) {
+		return (0);
+	}
+	
+	memcpy (msg, buff, len);
+	free (entry->msg);
+	entry->msg 		= msg;
+	entry->msg_len 	= (uint16_t) len;
+	
+	return (FscC_Rec_Lz);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the compression
+----------------------------------------------------------------------------------------*/
+static void
+fsc_comp_stat_get (
+	CsmgrdT_Comp_Stat* stat
+) {
+	pthread_mutex_lock (&fsc_cs_mutex);
+	memcpy (stat, &fsc_comp_stat, sizeof (CsmgrdT_Comp_Stat));
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the buffer to the file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_file_write (
+	int fd,										/* file descriptor 						*/
+	const unsigned char* buf,					/* buffer 								*/
+	uint32_t len								/* length 								*/
+) {
+	uint32_t done = 0;
+	ssize_t n;
+	
+	while (done < len) {
+		n = write (fd, &buf[done], len - done);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		done += (uint32_t) n;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Flushes the written data of the file to the disk
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_file_sync (
+	int fd										/* file descriptor 						*/
+) {
+#ifdef __APPLE__
+	return (fsync (fd));
+#else // __APPLE__
+	return (fdatasync (fd));
+#endif // __APPLE__
+}
+/*--------------------------------------------------------------------------------------
+	Adds the entry of the index or the journal to the buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_buff_add (
+	FscT_Jnl_Buff* jb,							/* buffer 								*/
+	uint16_t type,								/* FscC_Jnl_XXX 						*/
+	uint32_t index,								/* index of the content 				*/
+	uint32_t chunk_num,							/* chunk number 						*/
+	const void* body,							/* body of the entry 					*/
+	uint32_t body_len,							/* length of the body 					*/
+	const unsigned char* name,					/* FscC_Jnl_Cont: name 					*/
+	uint16_t name_len,							/* FscC_Jnl_Cont: length of the name 	*/
+	const unsigned char* ver,					/* FscC_Jnl_Cont: version 				*/
+	uint16_t ver_len							/* FscC_Jnl_Cont: length of the version	*/
+) {
+	FscT_Jnl_Head head;
+	uint32_t len;
+	uint32_t new_size;
+	unsigned char* new_buf;
+	
+	len = sizeof (FscT_Jnl_Head) + body_len + name_len + ver_len;
+	if (jb->len + len > jb->size) {
+		new_size = (jb->size) ? jb->size * 2 : FscC_Compact_Buff;
+		while (new_size < jb->len + len) {
+			new_size *= 2;
+		}
+		new_buf = (unsigned char*) realloc (jb->buf, new_size);
+		if (new_buf == NULL) {
+			return (-1);
+		}
+		jb->buf  = new_buf;
+		jb->size = new_size;
+	}
+	memset (&head, 0, sizeof (FscT_Jnl_Head));
+	head.type 		= type;
+	head.name_len 	= name_len;
+	head.ver_len 	= ver_len;
+	head.index 		= index;
+	head.chunk_num 	= chunk_num;
+	memcpy (&jb->buf[jb->len], &head, sizeof (FscT_Jnl_Head));
+	jb->len += sizeof (FscT_Jnl_Head);
+	if (body_len) {
+		memcpy (&jb->buf[jb->len], body, body_len);
+		jb->len += body_len;
+	}
+	if (name_len) {
+		memcpy (&jb->buf[jb->len], name, name_len);
+		jb->len += name_len;
+	}
+	if (ver_len) {
+		memcpy (&jb->buf[jb->len], ver, ver_len);
+		jb->len += ver_len;
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the name and the metadata of the content to the buffer
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_jnl_buff_cont_add (
+	FscT_Jnl_Buff* jb,							/* buffer 								*/
+	uint32_t index,								/* index of the content 				*/
+	CsmgrT_Stat* rcd							/* content information 					*/
+) {
+	FscT_Jnl_Meta meta;
+	
+	memset (&meta, 0, sizeof (FscT_Jnl_Meta));
+	meta.expiry 		= rcd->expiry;
+	meta.cached_time 	= rcd->cached_time;
+	meta.pay_len 		= rcd->cob_size;
+	meta.node 			= rcd->node.s_addr;
+	
+	return (fsc_jnl_buff_add (jb, FscC_Jnl_Cont, index, 0, &meta, sizeof (FscT_Jnl_Meta), 
+				rcd->name, rcd->name_len, rcd->version, rcd->ver_len));
+}
+/*--------------------------------------------------------------------------------------
+	Journals the change of the index (called with fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_add (
+	uint16_t type,								/* FscC_Jnl_XXX 						*/
+	uint32_t index,								/* index of the content 				*/
+	uint32_t chunk_num,							/* chunk number 						*/
+	const void* body,							/* body of the entry 					*/
+	uint32_t body_len							/* length of the body 					*/
+) {
+	if (fsc_jnl_on == 0) {
+		return;
+	}
+	if (fsc_jnl_buff_add (&fsc_jnl_buff, 
+			type, index, chunk_num, body, body_len, NULL, 0, NULL, 0) < 0) {
+		/* The next checkpoint recovers the index 	*/
+		csmgrd_log_write (CefC_Log_Error, "Failed to journal the cache index\n");
+		fsc_ckpt_time = 0;
+	}
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Journals the name of the content before its cobs (called with fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_bind (
+	uint32_t index,								/* index of the content 				*/
+	CsmgrT_Stat* rcd							/* content information, or NULL 		*/
+) {
+	FscT_Cont* cont = &fsc_cont_tbl[index];
+	
+	if (fsc_jnl_on == 0) {
+		return;
+	}
+	/* The name left by the removed content is replaced 	*/
+	if ((cont->name) && (rcd) && 
+		((cont->name_len != rcd->name_len) || 
+		 (memcmp (cont->name, rcd->name, rcd->name_len) != 0))) {
+		free (cont->name);
+		cont->name = NULL;
+	}
+	if (cont->name == NULL) {
+		if (rcd == NULL) {
+			return;
+		}
+		cont->name = (unsigned char*) malloc (rcd->name_len);
+		if (cont->name == NULL) {
+			return;
+		}
+		memcpy (cont->name, rcd->name, rcd->name_len);
+		cont->name_len 	= rcd->name_len;
+		cont->jnl_epoch = 0;
+	}
+	
+	/* Each journal names the contents of its entries 	*/
+	if (cont->jnl_epoch == fsc_jnl_epoch) {
+		return;
+	}
+	if (rcd == NULL) {
+		rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cont->name, cont->name_len);
+		if (rcd == NULL) {
+			return;
+		}
+	}
+	if (fsc_jnl_buff_cont_add (&fsc_jnl_buff, index, rcd) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to journal the cache index\n");
+		fsc_ckpt_time = 0;
+		return;
+	}
+	cont->jnl_epoch = fsc_jnl_epoch;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the journal file
+----------------------------------------------------------------------------------------*/
+static int							/* file descriptor, negative if an error occurs		*/
+fsc_jnl_open (
+	uint32_t seq								/* number of the journal 				*/
+) {
+	char file_path[PATH_MAX];
+	FscT_Index_File_Head fh;
+	int fd;
+	
+	sprintf (file_path, "%s/journal_%u", hdl->fsc_cache_path, seq);
+	fd = open (file_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (fd < 0) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to create the journal (%s) - %s\n", file_path, strerror (errno));
+		return (-1);
+	}
+	memset (&fh, 0, sizeof (FscT_Index_File_Head));
+	memcpy (fh.magic, FscC_Index_Magic, sizeof (fh.magic));
+	fh.version 	= FscC_Index_Version;
+	fh.seq 		= seq;
+	if (fsc_file_write (fd, (unsigned char*) &fh, sizeof (FscT_Index_File_Head)) < 0) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to write the journal (%s) - %s\n", file_path, strerror (errno));
+		close (fd);
+		return (-1);
+	}
+	
+	return (fd);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the journaled entries (called on the cob put thread without fsc_cs_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+fsc_jnl_write (
+	void
+) {
+	FscT_Jnl_Buff jb;
+	int fd;
+	
+	if (fsc_warm_f == 0) {
+		return;
+	}
+	
+	/* The entries added while writing go to the other buffer 	*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	jb 				= fsc_jnl_buff;
+	fsc_jnl_buff 	= fsc_jnl_spare;
+	fsc_jnl_buff.len = 0;
+	fd = fsc_jnl_fd;
+	fsc_jnl_reuse_f = 0;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	if ((fd >= 0) && (jb.len > 0)) {
+		if (fsc_file_write (fd, jb.buf, jb.len) < 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to write the journal - %s\n", strerror (errno));
+			fsc_ckpt_time = 0;
+		}
+	}
+	jb.len = 0;
+	fsc_jnl_spare = jb;
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Starts the checkpoint, the journals before it are not replayed when it completes
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ckpt_start (
+	void
+) {
+	char file_path[PATH_MAX];
+	FscT_Index_File_Head fh;
+	FscT_Jnl_Buff jb;
+	int old_fd;
+	int fd;
+	
+	/* The index is written while the contents change, the new journal has the 	*/
+	/* changes and is replayed over it. The journals are changed by the cob put 	*/
+	/* thread only, so the new one is created out of the lock.						*/
+	fd = fsc_jnl_open (fsc_jnl_seq);
+	if (fd < 0) {
+		return (-1);
+	}
+	
+	/* The entries of the old journal are taken with its file under the lock, 	*/
+	/* and written and flushed without it 										*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	old_fd 			= fsc_jnl_fd;
+	jb 				= fsc_jnl_buff;
+	fsc_jnl_buff 	= fsc_jnl_spare;
+	fsc_jnl_buff.len = 0;
+	fsc_jnl_reuse_f = 0;
+	fsc_jnl_fd 		= fd;
+	fsc_ckpt_seq 	= fsc_jnl_seq;
+	fsc_jnl_seq++;
+	fsc_jnl_epoch++;
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	
+	if (old_fd >= 0) {
+		if ((jb.len > 0) && (fsc_file_write (old_fd, jb.buf, jb.len) < 0)) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to write the journal - %s\n", strerror (errno));
+		}
+		if (fsc_sync_mode != FscC_Sync_None) {
+			fsc_file_sync (old_fd);
+		}
+		close (old_fd);
+	}
+	jb.len = 0;
+	fsc_jnl_spare = jb;
+	
+	sprintf (file_path, "%s/index.tmp", hdl->fsc_cache_path);
+	fsc_ckpt_fp = fopen (file_path, "w");
+	if (fsc_ckpt_fp == NULL) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to create the index (%s) - %s\n", file_path, strerror (errno));
+		return (-1);
+	}
+	memset (&fh, 0, sizeof (FscT_Index_File_Head));
+	memcpy (fh.magic, FscC_Index_Magic, sizeof (fh.magic));
+	fh.version 	= FscC_Index_Version;
+	fh.seq 		= fsc_ckpt_seq;
+	fwrite (&fh, sizeof (FscT_Index_File_Head), 1, fsc_ckpt_fp);
+	fsc_ckpt_pos 	= 0;
+	fsc_ckpt_chunk 	= 0;
+	fsc_ckpt_cobs 	= 0;
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the next contents to the checkpoint
+----------------------------------------------------------------------------------------*/
+static int							/* 1: completed, negative if an error occurs		*/
+fsc_ckpt_step (
+	void
+) {
+	char file_path[PATH_MAX];
+	char new_path[PATH_MAX];
+	CsmgrT_Stat* rcd;
+	FscT_Cont* cont;
+	uint32_t end;
+	uint32_t entries = 0;
+	uint32_t i, n;
+	int res = 0;
+	
+	end = fsc_ckpt_pos + FscC_Ckpt_Scan;
+	if (end > CsmgrT_Stat_Max) {
+		end = CsmgrT_Stat_Max;
+	}
+	
+	/* A step holds the lock for a bounded number of entries, and the content 	*/
+	/* with more cobs is continued by the next step after naming it again 		*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	i = fsc_ckpt_pos;
+	n = fsc_ckpt_chunk;
+	while ((i < end) && (entries < FscC_Ckpt_Entry_Max) && (res == 0)) {
+		cont = &fsc_cont_tbl[i];
+		if ((cont->name == NULL) || (cont->loc == NULL)) {
+			i++;
+			n = 0;
+			continue;
+		}
+		rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cont->name, cont->name_len);
+		if (rcd == NULL) {
+			i++;
+			n = 0;
+			continue;
+		}
+		res = fsc_jnl_buff_cont_add (&fsc_ckpt_buff, i, rcd);
+		entries++;
+		for ( ; (n < cont->loc_max) && (res == 0) ; n++) {
+			if (cont->loc[n].len == 0) {
+				continue;
+			}
+			if (entries >= FscC_Ckpt_Entry_Max) {
+				break;
+			}
+			res = fsc_jnl_buff_add (&fsc_ckpt_buff, FscC_Jnl_Loc, i, n, 
+					&cont->loc[n], sizeof (FscT_Loc), NULL, 0, NULL, 0);
+			entries++;
+			fsc_ckpt_cobs++;
+		}
+		if (n < cont->loc_max) {
+			break;
+		}
+		i++;
+		n = 0;
+	}
+	pthread_mutex_unlock (&fsc_cs_mutex);
+	fsc_ckpt_pos 	= i;
+	fsc_ckpt_chunk 	= n;
+	
+	if ((res < 0) || 
+		(fwrite (fsc_ckpt_buff.buf, 1, fsc_ckpt_buff.len, fsc_ckpt_fp) != fsc_ckpt_buff.len)) {
+		goto CKPT_ERROR;
+	}
+	fsc_ckpt_buff.len = 0;
+	if (fsc_ckpt_pos < CsmgrT_Stat_Max) {
+		return (0);
+	}
+	
+	/* The new index replaces the old one, and the old journals are not needed 	*/
+	if ((fflush (fsc_ckpt_fp) != 0) || (fsc_file_sync (fileno (fsc_ckpt_fp)) < 0)) {
+		goto CKPT_ERROR;
+	}
+	fclose (fsc_ckpt_fp);
+	fsc_ckpt_fp = NULL;
+	sprintf (file_path, "%s/index.tmp", hdl->fsc_cache_path);
+	sprintf (new_path, "%s/index", hdl->fsc_cache_path);
+	if (rename (file_path, new_path) < 0) {
+		goto CKPT_ERROR;
+	}
+	for ( ; fsc_jnl_first < fsc_ckpt_seq ; fsc_jnl_first++) {
+		sprintf (file_path, "%s/journal_%u", hdl->fsc_cache_path, fsc_jnl_first);
+		unlink (file_path);
+	}
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, 
+		"checkpoint of "FMTU64" cobs, journal#%u\n", fsc_ckpt_cobs, fsc_ckpt_seq);
+#endif // CefC_Debug
+	
+	return (1);
+	
+CKPT_ERROR:
+	csmgrd_log_write (CefC_Log_Error, 
+		"Failed to write the index of the cache - %s\n", strerror (errno));
+	fsc_ckpt_buff.len = 0;
+	if (fsc_ckpt_fp) {
+		fclose (fsc_ckpt_fp);
+		fsc_ckpt_fp = NULL;
+	}
+	sprintf (file_path, "%s/index.tmp", hdl->fsc_cache_path);
+	unlink (file_path);
+	
+	return (-1);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the whole checkpoint at once
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ckpt_run (
+	void
+) {
+	int res;
+	
+	if ((fsc_ckpt_fp == NULL) && (fsc_ckpt_start () < 0)) {
+		return (-1);
+	}
+	while ((res = fsc_ckpt_step ()) == 0) {
+		continue;
+	}
+	
+	return ((res < 0) ? -1 : 0);
+}
+/*--------------------------------------------------------------------------------------
+	Replays the index or the journal file into the index of the cobs
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is not found	*/
+fsc_index_file_read (
+	const char* file_path,						/* path of the file 					*/
+	uint32_t* seq,								/* [out] sequence in the head 			*/
+	FscT_Load_Cont** lc							/* metadata of the contents 			*/
+) {
+	FILE* fp;
+	FscT_Index_File_Head fh;
+	FscT_Jnl_Head head;
+	FscT_Jnl_Meta meta;
+	FscT_Jnl_Put put;
+	FscT_Loc* loc;
+	FscT_Cont* cont;
+	unsigned char* name;
+	FscT_Load_Cont* lcp;
+	uint32_t i;
+	
+	fp = fopen (file_path, "r");
+	if (fp == NULL) {
+		return (-1);
+	}
+	if ((fread (&fh, sizeof (FscT_Index_File_Head), 1, fp) != 1) || 
+		(memcmp (fh.magic, FscC_Index_Magic, sizeof (fh.magic)) != 0) || 
+		(fh.version != FscC_Index_Version)) {
+		csmgrd_log_write (CefC_Log_Warn, "%s is not the cache index\n", file_path);
+		fclose (fp);
+		return (-1);
+	}
+	*seq = fh.seq;
+	
+	/* The entry written partly at the end is ignored 	*/
+	while (fread (&head, sizeof (FscT_Jnl_Head), 1, fp) == 1) {
+		if (head.index >= CsmgrT_Stat_Max) {
+			break;
+		}
+		cont = &fsc_cont_tbl[head.index];
+		
+		if (head.type == FscC_Jnl_Cont) {
+			if ((fread (&meta, sizeof (FscT_Jnl_Meta), 1, fp) != 1) || 
+				(head.name_len == 0)) {
+				break;
+			}
+			name = (unsigned char*) malloc (head.name_len);
+			lcp  = (FscT_Load_Cont*) calloc (1, sizeof (FscT_Load_Cont) + head.ver_len);
+			if ((name == NULL) || (lcp == NULL) || 
+				(fread (name, head.name_len, 1, fp) != 1) || 
+				((head.ver_len) && 
+				 (fread ((unsigned char*)(lcp + 1), head.ver_len, 1, fp) != 1))) {
+				free (name);
+				free (lcp);
+				break;
+			}
+			free (cont->name);
+			cont->name 		= name;
+			cont->name_len 	= head.name_len;
+			free (lc[head.index]);
+			lcp->meta 		= meta;
+			lcp->ver 		= (unsigned char*)(lcp + 1);
+			lcp->ver_len 	= head.ver_len;
+			lc[head.index] 	= lcp;
+		} else if ((head.type == FscC_Jnl_Put) || (head.type == FscC_Jnl_Loc)) {
+			if (head.type == FscC_Jnl_Put) {
+				if (fread (&put, sizeof (FscT_Jnl_Put), 1, fp) != 1) {
+					break;
+				}
+			} else if (fread (&put.loc, sizeof (FscT_Loc), 1, fp) != 1) {
+				break;
+			}
+			loc = &put.loc;
+			if ((loc->seg >= FscC_Seg_Max) || (loc->len <= sizeof (FscT_Rec_Head)) || 
+				(loc->len > FscC_Rec_Max) || ((uint64_t) loc->off + loc->len > FscC_Seg_Size)) {
+				break;
+			}
+			if (fsc_loc_set (head.index, head.chunk_num, loc->seg, loc->off, loc->len) < 0) {
+				break;
+			}
+			lcp = lc[head.index];
+			if ((head.type == FscC_Jnl_Put) && (lcp)) {
+				if (lcp->meta.expiry < put.meta.expiry) {
+					lcp->meta.expiry = put.meta.expiry;
+				}
+				if (lcp->meta.pay_len < put.meta.pay_len) {
+					lcp->meta.pay_len = put.meta.pay_len;
+				}
+			}
+		} else if (head.type == FscC_Jnl_Del) {
+			fsc_loc_del (head.index, head.chunk_num);
+		} else if (head.type == FscC_Jnl_Clear) {
+			fsc_content_clear (head.index);
+			free (lc[head.index]);
+			lc[head.index] = NULL;
+		} else if (head.type == FscC_Jnl_Reset) {
+			for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+				if ((fsc_cont_tbl[i].loc) || (fsc_cont_tbl[i].name)) {
+					fsc_content_clear (i);
+				}
+				free (lc[i]);
+				lc[i] = NULL;
+			}
+		} else {
+			break;
+		}
+	}
+	fclose (fp);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Rebuilds the cached contents from the index and the journals
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_index_load (
+	void
+) {
+	char file_path[PATH_MAX];
+	static unsigned char name[CsmgrT_Name_Max];
+	FscT_Load_Cont** lc;
+	FscT_Cont* old_tbl;
+	FscT_Cont* cont;
+	FscT_Loc* loc;
+	CsmgrT_Stat* rcd;
+	CsmgrT_DB_COB_MAP* cob_map = NULL;
+	CsmgrdT_Content_Entry entry;
+	struct in_addr node;
+	struct timeval tv;
+	uint64_t nowt;
+	uint64_t start;
+	uint64_t con_num = 0;
+	uint64_t cob_num = 0;
+	uint32_t wend[FscC_Seg_Max];
+	uint32_t seq = 1;
+	uint32_t hseq;
+	uint64_t bad_num = 0;
+	uint32_t name_hash;
+	uint32_t i, n;
+	uint16_t name_len;
+	int seg;
+	
+	gettimeofday (&tv, NULL);
+	nowt  = tv.tv_sec * 1000000llu + tv.tv_usec;
+	start = nowt;
+	
+	lc = (FscT_Load_Cont**) calloc (CsmgrT_Stat_Max, sizeof (FscT_Load_Cont*));
+	if (lc == NULL) {
+		return (-1);
+	}
+	
+	/* The journals since the index are replayed over it, with the indexes of 	*/
+	/* the contents at the time, so that the changes are applied in order 		*/
+	sprintf (file_path, "%s/index", hdl->fsc_cache_path);
+	if (fsc_index_file_read (file_path, &seq, lc) < 0) {
+		seq = 1;
+	}
+	fsc_jnl_first = seq;
+	while (1) {
+		sprintf (file_path, "%s/journal_%u", hdl->fsc_cache_path, seq);
+		if (fsc_index_file_read (file_path, &hseq, lc) < 0) {
+			break;
+		}
+		seq++;
+	}
+	fsc_jnl_seq = seq;
+	
+	/* Moves the contents to the indexes given by csmgrd 		*/
+	old_tbl = fsc_cont_tbl;
+	fsc_cont_tbl = (FscT_Cont*) calloc (CsmgrT_Stat_Max, sizeof (FscT_Cont));
+	if (fsc_cont_tbl == NULL) {
+		fsc_cont_tbl = old_tbl;
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			free (lc[i]);
+		}
+		free (lc);
+		return (-1);
+	}
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		cont = &old_tbl[i];
+		if (cont->loc == NULL) {
+			fsc_cont_free (cont);
+			free (lc[i]);
+			continue;
+		}
+		rcd = NULL;
+		if ((cont->name) && (lc[i]) && (lc[i]->meta.expiry > nowt)) {
+			rcd = csmgrd_stat_content_info_init (
+					csmgr_stat_hdl, cont->name, cont->name_len, &cob_map);
+		}
+		if ((rcd == NULL) || (fsc_cont_tbl[rcd->index].loc)) {
+			fsc_cont_free (cont);
+			free (lc[i]);
+			continue;
+		}
+		if ((lc[i]->ver_len) && (rcd->ver_len == 0)) {
+			csmgrd_stat_content_info_version_init (
+				csmgr_stat_hdl, rcd, lc[i]->ver, lc[i]->ver_len);
+		}
+		node.s_addr = lc[i]->meta.node;
+		for (n = 0 ; n < cont->loc_max ; n++) {
+			if (cont->loc[n].len) {
+				csmgrd_stat_cob_update (csmgr_stat_hdl, cont->name, cont->name_len, n, 
+					lc[i]->meta.pay_len, lc[i]->meta.expiry, lc[i]->meta.cached_time, node);
+			}
+		}
+		fsc_cont_tbl[rcd->index] 			= *cont;
+		fsc_cont_tbl[rcd->index].gen 		= 0;
+		fsc_cont_tbl[rcd->index].jnl_epoch 	= 0;
+		memset (cont, 0, sizeof (FscT_Cont));
+		free (lc[i]);
+	}
+	free (old_tbl);
+	free (lc);
+	
+	/* Registers the cobs to the cache algorithm, which may evict some of them 	*/
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		cont = &fsc_cont_tbl[i];
+		if (cont->loc == NULL) {
+			continue;
+		}
+		name_len = cont->name_len;
+		memcpy (name, cont->name, name_len);
+		for (n = 0 ; n < fsc_cont_tbl[i].loc_max ; n++) {
+			if (fsc_loc_get (i, n) == NULL) {
+				continue;
+			}
+			if (hdl->algo_apis.insert) {
+				memset (&entry, 0, sizeof (CsmgrdT_Content_Entry));
+				entry.name 		= name;
+				entry.name_len 	= name_len;
+				entry.chunk_num = n;
+				hdl->cache_cobs++;
+				(*(hdl->algo_apis.insert))(&entry);
+			} else if (hdl->cache_cobs < hdl->cache_capacity) {
+				hdl->cache_cobs++;
+			} else {
+				fsc_loc_del (i, n);
+				if (csmgrd_stat_cob_remove (csmgr_stat_hdl, name, name_len, n, 0) == 0) {
+					fsc_content_clear (i);
+					break;
+				}
+			}
+		}
+	}
+	
+	/* Opens the segments which have the cobs 		*/
+	memset (wend, 0, sizeof (wend));
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		cont = &fsc_cont_tbl[i];
+		for (n = 0 ; n < cont->loc_max ; n++) {
+			loc = &cont->loc[n];
+			if ((loc->len) && (loc->off + loc->len > wend[loc->seg])) {
+				wend[loc->seg] = loc->off + loc->len;
+			}
+		}
+	}
+	for (seg = 0 ; seg < FscC_Seg_Max ; seg++) {
+		if (fsc_seg[seg].live == 0) {
+			continue;
+		}
+		sprintf (file_path, "%s/seg_%d", hdl->fsc_cache_path, seg);
+		fsc_seg[seg].fd = open (file_path, O_RDWR);
+		if (fsc_seg[seg].fd < 0) {
+			csmgrd_log_write (CefC_Log_Warn, 
+				"Failed to open the segment file (%s) - %s\n", file_path, strerror (errno));
+			continue;
+		}
+		fsc_seg[seg].state 	= FscC_Seg_Sealed;
+		fsc_seg[seg].wpos 	= wend[seg];
+		fsc_seg[seg].wend 	= wend[seg];
+	}
+	
+	/* The cobs in the lost segments are dropped. The journal may reach the disk 	*/
+	/* before the records, and the segments are reused after the compaction, so 	*/
+	/* the cobs whose locations refer to the records of others are dropped too 		*/
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		cont = &fsc_cont_tbl[i];
+		if (cont->loc == NULL) {
+			continue;
+		}
+		name_hash = fsc_name_hash (cont->name, cont->name_len);
+		for (n = 0 ; n < cont->loc_max ; n++) {
+			if (cont->loc[n].len == 0) {
+				continue;
+			}
+			if (fsc_seg[cont->loc[n].seg].fd >= 0) {
+				if (fsc_rec_check (&cont->loc[n], name_hash, n) == 0) {
+					continue;
+				}
+				bad_num++;
+			}
+			name_len = cont->name_len;
+			memcpy (name, cont->name, name_len);
+			if (hdl->algo_apis.erase) {
+				unsigned char 	trg_key[CsmgrdC_Key_Max];
+				int 			trg_key_len;
+				trg_key_len = csmgrd_name_chunknum_concatenate (name, name_len, n, trg_key);
+				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+			}
+			hdl->cache_cobs--;
+			fsc_loc_del (i, n);
+			if (csmgrd_stat_cob_remove (csmgr_stat_hdl, name, name_len, n, 0) == 0) {
+				fsc_content_clear (i);
+				break;
+			}
+		}
+	}
+	for (seg = 0 ; seg < FscC_Seg_Max ; seg++) {
+		if (fsc_seg[seg].fd < 0) {
+			fsc_seg[seg].live = 0;
+			continue;
+		}
+		fsc_seg_check ((uint32_t) seg);
 	}
-	fprintf (stderr, "(%d)\n", ver_len);
-#endif //__FSCACHE_VERSION__
-	rc = cef_csmgr_cache_version_compare (version, ver_len, rcd->version, rcd->ver_len);
-	if (rc == CefC_CV_Inconsistent) {
-		if (ver_len == 0 && rcd->ver_len != 0) {
-			/* Request is "None", so any version is OK */
-#ifdef __FSCACHE_VERSION__
-			fprintf (stderr, "    => Request is \"None\", so any version is OK\n");
-#endif //__FSCACHE_VERSION__
-			;
-		} else {
-			pthread_mutex_unlock (&fsc_cs_mutex);
-			return (CefC_Csmgr_Cob_NotExist);
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		cont = &fsc_cont_tbl[i];
+		if (cont->loc == NULL) {
+			continue;
+		}
+		con_num++;
+		for (n = 0 ; n < cont->loc_max ; n++) {
+			if (cont->loc[n].len) {
+				cob_num++;
+			}
 		}
-	} else if (rc != CefC_CV_Same) {
-		pthread_mutex_unlock (&fsc_cs_mutex);
-		return (CefC_Csmgr_Cob_NotExist);
 	}
 	
-	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+	if (bad_num > 0) {
+		csmgrd_log_write (CefC_Log_Warn, 
+			"Warm restart : "FMTU64" cobs are dropped, their records are others\n", bad_num);
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	csmgrd_log_write (CefC_Log_Info, 
+		"Warm restart : "FMTU64" contents, "FMTU64" cobs (journal#%u, "FMTU64" ms)\n", 
+		con_num, cob_num, fsc_jnl_seq - 1, (nowt - start) / 1000);
 	
-	/* Check the work cob is cached or not 		*/
-	mask = 1;
-	x = seqno / 64;
-	mask <<= (seqno % 64);
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the hash of the content name kept in the records
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_name_hash (
+	const unsigned char* name,					/* content name 						*/
+	uint16_t name_len							/* length of the name 					*/
+) {
+	uint32_t hash = 2166136261u;
+	uint16_t i;
 	
-	file_msglen = rcd->file_msglen;
-	rcdsize = sizeof (uint16_t) + file_msglen;
+	for (i = 0 ; i < name_len ; i++) {
+		hash ^= name[i];
+		hash *= 16777619u;
+	}
 	
-	if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+	return (hash);
+}
+/*--------------------------------------------------------------------------------------
+	Checks that the located record is the cob of the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it is another	*/
+fsc_rec_check (
+	FscT_Loc* loc,								/* location of the record 				*/
+	uint32_t name_hash,							/* hash of the content name 			*/
+	uint32_t chunk_num							/* chunk number 						*/
+) {
+	FscT_Rec_Head head;
+	
+	if (fsc_seg_pio (fsc_seg[loc->seg].fd, (unsigned char*) &head, 
+			sizeof (FscT_Rec_Head), loc->off, 0) < 0) {
+		return (-1);
+	}
+	if ((head.name_hash != name_hash) || (head.chunk_num != chunk_num) || 
+		(sizeof (FscT_Rec_Head) + head.msg_len != loc->len)) {
+		return (-1);
+	}
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the cob in the record
+----------------------------------------------------------------------------------------*/
+static void
+fsc_rec_send (
+	int sock,									/* socket to send the cob 				*/
+	unsigned char* rec,							/* record 								*/
+	uint32_t len,								/* length of the record 				*/
+	uint32_t name_hash,							/* hash of the requested name 			*/
+	uint32_t chunk_num							/* requested chunk number 				*/
+) {
+	FscT_Rec_Head head;
+	uint64_t start;
+	int msg_len;
+	unsigned char unz_buf[UINT16_MAX];
+	
+	memcpy (&head, rec, sizeof (FscT_Rec_Head));
 #ifdef CefC_Debug
-		csmgrd_dbg_write (CefC_Dbg_Finest, "seqno = %u is not cached\n", seqno);
+	csmgrd_dbg_write (CefC_Dbg_Finest, 
+		"send seqno = %u (%u bytes)\n", head.chunk_num, head.msg_len);
 #endif // CefC_Debug
-		if (hdl->algo_apis.miss) {
-			(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
-		}
-		pthread_mutex_unlock (&fsc_cs_mutex);
-		return (CefC_Csmgr_Cob_NotExist);
+	if ((head.msg_len == 0) || (sizeof (FscT_Rec_Head) + head.msg_len != len)) {
+		return;
 	}
-	if (hdl->algo_apis.hit) {
-		(*(hdl->algo_apis.hit))(trg_key, trg_key_len);
+	
+	/* The location may refer to the record of another cob after a crash 	*/
+	if ((head.name_hash != name_hash) || (head.chunk_num != chunk_num)) {
+		csmgrd_log_write (CefC_Log_Warn, 
+			"The record of seqno = %u is another cob, so it is not sent\n", chunk_num);
+		return;
 	}
-	gettimeofday (&tv, NULL);
-	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-		
-	if (nowt > rcd->tx_time) {
-		rcd->tx_seq = 0;
-		rcd->tx_num = -1;
+	if ((head.flags & FscC_Rec_Lz) == 0) {
+		csmgrd_plugin_cob_msg_send (sock, &rec[sizeof (FscT_Rec_Head)], head.msg_len);
+		return;
 	}
-	if (rcd->tx_num ==-1) {
-		send_cob_f = 1;
-	} else {
-		if (seqno >= rcd->tx_seq && seqno < (rcd->tx_seq + rcd->tx_num)) {
-			resend_1cob_f = 1;
-		} else {
-			send_cob_f = 1;
+	
+	/* The cached record is kept compressed, and expanded for each send. The read 	*/
+	/* completions call this without fsc_cs_mutex, so the buffer is on the stack 	*/
+	start = fsc_comp_time_get ();
+	msg_len = cef_csmgr_lz_decompress (
+		&rec[sizeof (FscT_Rec_Head)], head.msg_len, unz_buf, sizeof (unz_buf));
+	__atomic_add_fetch (
+		&fsc_comp_stat.decomp_ns, fsc_comp_time_get () - start, __ATOMIC_RELAXED);
+	if (msg_len <= 0) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to decompress the cob (seqno = %u)\n", head.chunk_num);
+		return;
+	}
+	__atomic_add_fetch (&fsc_comp_stat.decomp_cobs, 1, __ATOMIC_RELAXED);
+	csmgrd_plugin_cob_msg_send (sock, unz_buf, (uint16_t) msg_len);
+	
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the read of the block which sends the cob to the socket
+----------------------------------------------------------------------------------------*/
+static FscT_Read_Job*				/* NULL if the block cannot be read now				*/
+fsc_read_job_get (
+	FscT_Loc* loc,								/* location of the cob 					*/
+	uint32_t name_hash,							/* hash of the content name 			*/
+	uint32_t chunk_num,							/* chunk number of the cob 				*/
+	int sock,									/* socket to send the cob 				*/
+	FscT_Read_Job** new_jobs					/* reads to be submitted by the caller 	*/
+) {
+	FscT_Read_Job* job;
+	FscT_Seg* sp = &fsc_seg[loc->seg];
+	uint32_t blk_no = loc->off / FscC_Blk_Size;
+	uint32_t start = blk_no * FscC_Blk_Size;
+	uint32_t len;
+	uint32_t sock_gen = csmgrd_plugin_sock_gen_get (sock);
+	
+	/* Joins the read in flight if the record is in its range 		*/
+	for (job = fsc_rd_pend ; job != NULL ; job = job->next) {
+		if ((job->blk->seg == loc->seg) && (job->blk->blk_no == blk_no) &&
+			(job->sock == sock) && (job->sock_gen == sock_gen) &&
+			(job->rec_num < FscC_Job_Rec_Max) &&
+			(loc->off + loc->len <= start + job->req.len)) {
+			goto JOB_ADD;
 		}
 	}
-	if (send_cob_f == 0 && resend_1cob_f == 0) {
-		pthread_mutex_unlock (&fsc_cs_mutex);
-		return (CefC_Csmgr_Cob_NotExist);
+	if (fsc_rd_num >= FscC_Read_Inflight_Max) {
+		return (NULL);
+	}
+	
+	/* Reads the records starting in the block, and the written ones only 	*/
+	len = FscC_Blk_Size + FscC_Rec_Max;
+	if (len > sp->wend - start) {
+		len = sp->wend - start;
+	}
+	job = (FscT_Read_Job*) calloc (1, sizeof (FscT_Read_Job));
+	if (job == NULL) {
+		return (NULL);
 	}
-	if (send_cob_f == 1) {
-		rcd->tx_seq = seqno;
-		rcd->tx_num = FscC_Tx_Cob_Num;
-		rcd->tx_time = nowt + FscC_Sent_Reset_Time;
+	job->blk = (FscT_Page_Blk*) malloc (sizeof (FscT_Page_Blk) + len);
+	if (job->blk == NULL) {
+		free (job);
+		return (NULL);
 	}
+	job->blk->buf 		= (unsigned char*) job->blk + sizeof (FscT_Page_Blk);
+	job->blk->seg 		= loc->seg;
+	job->blk->blk_no 	= blk_no;
+	job->blk->valid 	= 0;
+	job->blk->size 		= len;
+	job->sock 			= sock;
+	job->sock_gen 		= sock_gen;
+	sp->ref++;
 	
-	/* Open the file that specified cob is cached 		*/
-	cob_block_index = (int)(seqno / FscC_Page_Cob_Num) % FscC_File_Page_Num;
-	page_index = (int)(seqno / FscC_Page_Cob_Num/FscC_File_Page_Num);
-	sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, (int) rcd->index, page_index);
+	job->req.op 	= CefC_Csmgr_Aio_Read;
+	job->req.fd 	= sp->fd;
+	job->req.buf 	= job->blk->buf;
+	job->req.len 	= len;
+	job->req.off 	= (off_t) start;
+	job->req.done 	= fsc_read_done;
+	job->req.arg 	= job;
 	
-	if (ver_len) {
-		if (red_ver_len == ver_len &&
-			memcmp (version, red_version, red_ver_len) == 0) {
-			update_ver = 0;
-		}
-	} else {
-		update_ver = 0;
-	}
+	job->next 		= fsc_rd_pend;
+	fsc_rd_pend 	= job;
+	fsc_rd_num++;
+	job->submit_next = *new_jobs;
+	*new_jobs 		= job;
 	
-	if (strcmp (red_file_path, file_path) != 0 || cob_block_index != red_cob_block_index ||
-		(strcmp (red_file_path, file_path) == 0 && update_ver != 0)) {
-		if (page_cob_buf != NULL) {
-			free (page_cob_buf);
-			page_cob_buf = NULL;
-		}
-
-		fp = fopen (file_path, "rb");
-		if (fp == NULL) {
-			csmgrd_log_write (CefC_Log_Error, "Failed to open the cache file (%s)\n", file_path);
-			goto ItemGetPost;
-		}
-		strcpy (red_file_path, file_path);
-		red_cob_block_index = cob_block_index;
-		page_cob_buf = calloc (FscC_Page_Cob_Num, rcdsize);
-		fseek (fp, (int64_t)cob_block_index * (int64_t)rcdsize * FscC_Page_Cob_Num, SEEK_SET);
-		for (int i=0; i<FscC_Page_Cob_Num; i++) {
-			rtc = fread (&page_cob_buf[i*rcdsize], rcdsize, 1, fp);
-			if (rtc != 1) {
-				break;
-			}
-		}
-		if (red_ver_len) {
-			memset (red_version, 0, PATH_MAX);
-		}
-		red_ver_len = ver_len;
-		if (ver_len) {
-			memcpy (red_version, version, ver_len);
+JOB_ADD:
+	job->rec[job->rec_num] 			= *loc;
+	job->rec_hash[job->rec_num] 	= name_hash;
+	job->rec_chunk[job->rec_num] 	= chunk_num;
+	job->rec_num++;
+	
+	return (job);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the cobs of the block read from the segment file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_read_done (
+	CefT_Csmgr_Aio_Req* req
+) {
+	FscT_Read_Job* job = (FscT_Read_Job*) req->arg;
+	FscT_Read_Job** pp;
+	FscT_Page_Blk* blk = job->blk;
+	FscT_Page_Blk* old;
+	uint32_t seg = blk->seg;
+	uint32_t start = blk->blk_no * FscC_Blk_Size;
+	int i;
+	
+	/* No more records join the job once it leaves the list 	*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	for (pp = &fsc_rd_pend ; *pp != NULL ; pp = &(*pp)->next) {
+		if (*pp == job) {
+			*pp = job->next;
+			break;
 		}
-	} else {
-		fp = NULL;
 	}
+	fsc_rd_num--;
+	pthread_mutex_unlock (&fsc_cs_mutex);
 	
-	/* Send the cobs 		*/
-	pos_index = (int)(seqno % FscC_Page_Cob_Num);
-#ifdef CefC_Debug
-	{
-		uint16_t mlen;
-		memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-		csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
+	if (req->err) {
+		csmgrd_log_write (CefC_Log_Error, 
+			"Failed to read the segment#%u - %s\n", seg, strerror (req->err));
+		pthread_mutex_lock (&fsc_cs_mutex);
+		goto READ_DONE;
 	}
-#endif // CefC_Debug
-	csmgrd_stat_access_count_update (
-			csmgr_stat_hdl, key, key_size);
+	blk->valid = (uint32_t) req->done_len;
 	
-	/* Send Cob to cefnetd */
-	uint16_t mlen;
-	memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-	csmgrd_plugin_cob_msg_send (
-						sock, &page_cob_buf[pos_index*rcdsize+sizeof (uint16_t)], mlen);
-	if (resend_1cob_f == 1) {
-		if (fp != NULL) {
-			fclose (fp);
+	/* The block is not cached yet, so the cobs are sent from it without the lock. 	*/
+	/* They are dropped if csmgrd closed the peer and the fd may be another one 	*/
+	if (csmgrd_plugin_sock_gen_get (job->sock) == job->sock_gen) {
+		for (i = 0 ; i < job->rec_num ; i++) {
+			if (job->rec[i].off + job->rec[i].len <= start + blk->valid) {
+				fsc_rec_send (job->sock, &blk->buf[job->rec[i].off - start], job->rec[i].len, 
+					job->rec_hash[i], job->rec_chunk[i]);
+			}
 		}
-		pthread_mutex_unlock (&fsc_cs_mutex);
-		return (CefC_Csmgr_Cob_Exist);
 	}
-	tx_cnt++;
-	seqno++;
 	
-	for (i = pos_index + 1 ; i < FscC_Page_Cob_Num ; i++) {
-		if (tx_cnt < FscC_Tx_Cob_Num) {
-			mask = 1;
-			x = seqno / 64;
-			mask <<= (seqno % 64);
-			
-			if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
-				seqno++;
-				continue;
-			}
-#ifdef CefC_Debug
-			{
-				uint16_t mlen;
-				memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-				csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
+	/* The block read in the freed segment is not cached 		*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	if (fsc_seg[seg].state != FscC_Seg_Dead) {
+		old = fsc_page_blk_lookup (seg, blk->blk_no);
+		if ((old == NULL) || (old->valid < blk->valid)) {
+			if (old) {
+				fsc_page_blk_free (old);
 			}
-#endif // CefC_Debug
-			uint16_t mlen;
-			memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-			if (mlen != 0) {
-				csmgrd_plugin_cob_msg_send (
-					sock, &page_cob_buf[i*rcdsize+sizeof (uint16_t)], mlen);
-			}
-			tx_cnt++;
-			seqno++;
-		} else {
-			break;
+			fsc_page_blk_insert (blk);
+			blk = NULL;
 		}
 	}
 	
-ItemGetPost:
-	if (fp != NULL) {
-		fclose (fp);
-	}
+READ_DONE:
+	fsc_seg_release (seg);
 	pthread_mutex_unlock (&fsc_cs_mutex);
-	return (CefC_Csmgr_Cob_Exist);
+	if (blk) {
+		free (blk);
+	}
+	free (job);
+	
+	return;
 }
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
@@ -1077,25 +4332,18 @@ fsc_cache_cob_write (
 	unsigned char 	name[CsmgrT_Name_Max];
 	uint16_t 		name_len = 0;
 	int				work_con_index = -1;
-	int 			prev_page_index = -1;
-	int 			work_page_index;
-	char			file_path[PATH_MAX];
-	int  			cob_block_index;
-	int 			rcdsize;
-	char			cont_path[PATH_MAX];
-	FILE*			fp = NULL;
+	uint32_t		rlen;
+	uint32_t		off;
+	int				seg;
+	uint16_t		rflags;
 	uint64_t 		mask;
 	uint32_t 		x;
 	int*			indxs = NULL;
 	int				cnt = 0;
-	int				rbpflag = 0;
-	int				swindx[FscC_Page_Cob_Num];
-	uint32_t		file_msglen;
-	unsigned char 	del_name[CsmgrT_Name_Max];
-	uint16_t 		del_name_len = 0;
-	uint32_t 		del_chunk_num = 0;
 	CsmgrT_DB_COB_MAP*	cob_map = NULL;		//0.8.3c
 	int				rc = CefC_CV_Inconsistent;
+	unsigned char 	adm_key[CsmgrdC_Key_Max];
+	int 			adm_key_len;
 	
 #ifdef __FSCACHE_VERSION__
 	fprintf (stderr, "--- fsc_cache_cob_write()\n");
@@ -1126,10 +4374,36 @@ fsc_cache_cob_write (
 #ifdef COBS_SORT
 		index = indxs[cnt];
 #endif
+		/* Compresses the cob out of the lock 		*/
+		rflags = 0;
+		if ((fsc_comp_f) && (cobs[index].expiry >= nowt)) {
+			rflags = fsc_rec_compress (&cobs[index]);
+		}
 		pthread_mutex_lock (&fsc_cs_mutex);
 		if (!fsc_thread_f) {
 			goto NEXTCOB;
 		}
+		/* The next segment file is created or evicted without the lock 		*/
+		if (fsc_seg_need_f) {
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			fsc_seg_prepare ();
+			pthread_mutex_lock (&fsc_cs_mutex);
+			name_len = 0;
+			if (!fsc_thread_f) {
+				goto NEXTCOB;
+			}
+		}
+		/* Writes the buffered records if this one cannot follow them 		*/
+		rlen = sizeof (FscT_Rec_Head) + cobs[index].msg_len;
+		if (fsc_wb_check (rlen)) {
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			fsc_wb_flush ();
+			pthread_mutex_lock (&fsc_cs_mutex);
+			name_len = 0;
+			if (!fsc_thread_f) {
+				goto NEXTCOB;
+			}
+		}
 		uint32_t chunk_num = cobs[index].chunk_num;
 		if (cobs[index].expiry < nowt) {
 			goto NEXTCOB;
@@ -1139,6 +4413,14 @@ fsc_cache_cob_write (
 				goto NEXTCOB;
 			}
 		}
+		if (hdl->admit_sketch) {
+			adm_key_len = csmgrd_name_chunknum_concatenate (
+							cobs[index].name, cobs[index].name_len, chunk_num, adm_key);
+			if (!csmgrd_lib_admission_check (
+					&hdl->algo_apis, hdl->admit_sketch, adm_key, adm_key_len, 0)) {
+				goto NEXTCOB;
+			}
+		}
 		/* Update the directory to write the received cob 		*/
 		if ((cobs[index].name_len != name_len) ||
 			(memcmp (cobs[index].name, name, cobs[index].name_len))) {
@@ -1151,6 +4433,8 @@ fsc_cache_cob_write (
 				if (!rcd) {
 					goto NEXTCOB;
 				}
+				/* The index may have been used by a content removed by csmgrd 		*/
+				fsc_content_clear (rcd->index);
 				if (csmgrd_stat_content_info_version_init(csmgr_stat_hdl, rcd, cobs[index].version, cobs[index].ver_len) < 0) {
 					goto NEXTCOB;
 				}
@@ -1180,10 +4464,9 @@ fsc_cache_cob_write (
 				rc = cef_csmgr_cache_version_compare (cobs[index].version, cobs[index].ver_len, rcd->version, rcd->ver_len);
 				if (rc != CefC_CV_Inconsistent) {
 					if (rc == CefC_CV_Newest_1stArg) {
-						char file_path[PATH_MAX];
-						/* Delete old files */
-						sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-						fsc_recursive_dir_clear (file_path);
+						/* Delete old cobs */
+						fsc_content_clear (rcd->index);
+						hdl->cache_cobs -= rcd->cob_num;
 						
 						/* Old Stat */
 						csmgrd_stat_content_info_delete (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
@@ -1198,7 +4481,7 @@ fsc_cache_cob_write (
 							goto NEXTCOB;
 						}
 #ifdef __FSCACHE_VERSION__
-						fprintf (stderr, "    => delete %s and init\n", file_path);
+						fprintf (stderr, "    => delete %u and init\n", rcd->index);
 #endif //__FSCACHE_VERSION__
 					} else if (rc == CefC_CV_Same) {
 						/* Check the work cob is cached or not */
@@ -1223,54 +4506,10 @@ fsc_cache_cob_write (
 				}
 			}
 			work_con_index = (int) rcd->index;
-			prev_page_index = -1;
-			sprintf (cont_path, "%s/%d", hdl->fsc_cache_path, work_con_index);
 			memcpy (name, cobs[index].name, cobs[index].name_len);
 			name_len = cobs[index].name_len;
-			
-			if (mkdir (cont_path, 0766) != 0) {
-				if (errno == ENOENT) {
-					csmgrd_log_write (CefC_Log_Error, 
-						"Failed to create the cache directory for the each content\n");
-					goto NEXTCOB;
-				}
-				if (errno == EACCES) {
-					csmgrd_log_write (CefC_Log_Error, 
-						"Please make sure that you have write permission for %s.\n", 
-						hdl->fsc_cache_path);
-					goto NEXTCOB;
-		}
-			}
-		}
-
-		/* Cotrol record size */
-		if (rcd->file_msglen == 0) {
-			rcd->file_msglen 
-					= ((cobs[index].msg_len + FSC_RECORD_CORRECT_SIZE) < CefC_Max_Msg_Size ? 
-						(cobs[index].msg_len + FSC_RECORD_CORRECT_SIZE) : CefC_Max_Msg_Size);
-			rcd->detect_chnkno = chunk_num;
-		} else {
-			if (rcd->cob_num == 1) {
-				if (rcd->detect_chnkno > chunk_num) {
-					int new_file_msglen
-								= ((cobs[index].msg_len + FSC_RECORD_CORRECT_SIZE) < CefC_Max_Msg_Size ? 
-									(cobs[index].msg_len + FSC_RECORD_CORRECT_SIZE) : CefC_Max_Msg_Size);
-					if (rcd->file_msglen < new_file_msglen) {
-						rcd->file_msglen = new_file_msglen;
-						memcpy (del_name, cobs[index].name, cobs[index].name_len);
-						del_name_len = cobs[index].name_len;
-						del_chunk_num = rcd->detect_chnkno;
-						rcd->detect_chnkno = chunk_num;
-					}
-				}
-			}
 		}
-		file_msglen = rcd->file_msglen;
-		rcdsize = sizeof (uint16_t) + file_msglen;
 
-		if ( file_msglen < cobs[index].msg_len ) {
-			goto NEXTCOB;
-		}
 		/* Check the work cob is cached or not 		*/
 		mask = 1;
 		x = chunk_num / 64;
@@ -1278,85 +4517,25 @@ fsc_cache_cob_write (
 		if ((rcd->map_max-1) >= x && rcd->cob_map[x] & mask) {
 			goto NEXTCOB;
 		}
-		/* Update the page to write the received cob 		*/
-		work_page_index = chunk_num / FscC_Page_Cob_Num / FscC_File_Page_Num;
-		cob_block_index = (chunk_num / FscC_Page_Cob_Num) % FscC_File_Page_Num;
-		if (work_page_index != prev_page_index) {
-			if (fp != NULL) {
-#ifdef CefC_Debug
-				csmgrd_dbg_write (CefC_Dbg_Finer, 
-					"cob put thread writes the page: %s\n", cont_path);
-#endif // CefC_Debug
-				if (rbpflag == 1) {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;
-					rbpflag = 0;
-				} else {
-					fflush (fp);
-					fclose (fp);
-					fp = NULL;	
-				}
-			}
-			
-			prev_page_index = work_page_index;
-			struct stat st;
-			sprintf (file_path, 
-				"%s/%d/%d", hdl->fsc_cache_path, work_con_index, work_page_index);
-            if (stat (file_path, &st) != 0) {
-				fp = fopen (file_path, "w");
-            	fclose (fp);
-            	fp = fopen (file_path, "rb+");
-			}
-			else {
-				fp = fopen (file_path, "rb+");
-				if (!fp) {
-					csmgrd_log_write (CefC_Log_Error, 
-						"Failed to open the cache file (%s)\n", file_path);
-					goto NEXTCOB;
-				}
-				memset (swindx, 0 , sizeof (swindx));
-				rbpflag = 1;
-			}
+		/* Reserves the space in the active segment 		*/
+		seg = fsc_seg_reserve (rlen, &off);
+		if (seg < 0) {
+			goto NEXTCOB;
 		}
 		
-		/* Updates the content information 			*/
+		/* Updates the content information, the cob is counted from here as 	*/
+		/* the expiry and the removal take the buffered cobs in the bitmap 		*/
+		hdl->cache_cobs++;
 		if (hdl->algo_apis.insert) {
 			(*(hdl->algo_apis.insert))(&cobs[index]);
 		}
 		csmgrd_stat_cob_update (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len, 
 				chunk_num, cobs[index].pay_len, cobs[index].expiry, 
 				nowt, cobs[index].node);
-		/* Delete invalid starage Cob info */
-		if (del_chunk_num != 0) {
-			if (del_name_len == cobs[index].name_len
-				&& memcmp (del_name, cobs[index].name, del_name_len) == 0) {
-				if (hdl->algo_apis.erase) {
-					unsigned char 	trg_key[CsmgrdC_Key_Max];
-					int 			trg_key_len;
-					trg_key_len = csmgrd_name_chunknum_concatenate (
-									del_name, del_name_len, del_chunk_num, trg_key);
-					(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-				}
-				csmgrd_stat_cob_remove (csmgr_stat_hdl, del_name, del_name_len, del_chunk_num, 0);
-				hdl->cache_cobs--;
-				del_chunk_num = 0;
-			}
-		}
-
-		/* Set to write buffer 							*/
-		unsigned char wbuff[sizeof (uint16_t) + UINT16_MAX];
-		int write_index = chunk_num % FscC_Page_Cob_Num;
-		fseek (fp, (int64_t)cob_block_index * FscC_Page_Cob_Num * (int64_t)rcdsize
-					+ (int64_t)write_index * (int64_t)rcdsize, SEEK_SET);
-		memcpy (wbuff, &cobs[index].msg_len, sizeof (uint16_t));
-		memcpy (&wbuff[sizeof (uint16_t)], cobs[index].msg, cobs[index].msg_len);
-		fwrite (wbuff, sizeof (uint16_t) + file_msglen, 1, fp);
-		fflush (fp);
-
-		if (!(hdl->algo_apis.insert)) {
-			hdl->cache_cobs++;
-		}
+		
+		/* The record is written with the following ones out of the lock, and	*/
+		/* located by the lookups after the write completes						*/
+		fsc_wb_add ((uint32_t) seg, off, (uint32_t) work_con_index, &cobs[index], rflags);
 		
 NEXTCOB:
 		free (cobs[index].msg);
@@ -1372,10 +4551,6 @@ NEXTCOB:
 		pthread_mutex_unlock (&fsc_cs_mutex);
 	}
 	
-	if (fp) {
-		fflush (fp);
-		fclose (fp);
-	}
 #ifdef COBS_SORT
 	free (indxs);
 #endif
@@ -1452,6 +4627,15 @@ fsc_config_read (
 	strcpy (params->algo_name, "None");
 	params->algo_name_size = 256;
 	params->algo_cob_size = 2048;
+	params->admission = 0;
+	params->page_cache_mem = 64;
+	params->write_buff = 1024;
+	params->write_delay = 10;
+	params->write_sync = FscC_Sync_None;
+	params->write_sync_intv = 1000;
+	params->warm_restart = 0;
+	params->ckpt_intv = 300;
+	params->compression = 0;
 	
 	/* Obtains the directory path where the csmgrd's config file is located. */
 #if 0 //+++++ GCC v9 +++++
@@ -1536,6 +4720,87 @@ fsc_config_read (
 				return (-1);
 			}
 			params->algo_cob_size = res;
+		} else if (strcmp (option, "CACHE_ADMISSION") == 0) {
+			res = atoi (value);
+			if ((res != 0) && (res != 1)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_ADMISSION must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->admission = res;
+		} else if (strcmp (option, "CACHE_PAGE_MEMORY") == 0) {
+			res = atoi (value);
+			if (!(1 <= res && res <= 65536)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_PAGE_MEMORY must be between 1 and 65536 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->page_cache_mem = (uint64_t) res;
+		} else if (strcmp (option, "CACHE_WRITE_BUFFER") == 0) {
+			res = atoi (value);
+			if (!(64 <= res && res <= 65536)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_WRITE_BUFFER must be between 64 and 65536 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->write_buff = res;
+		} else if (strcmp (option, "CACHE_WRITE_DELAY") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= 10000)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_WRITE_DELAY must be between 0 and 10000 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->write_delay = res;
+		} else if (strcmp (option, "CACHE_WRITE_SYNC") == 0) {
+			res = atoi (value);
+			if (!(FscC_Sync_None <= res && res <= FscC_Sync_Close)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_WRITE_SYNC must be 0, 1 or 2.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->write_sync = res;
+		} else if (strcmp (option, "CACHE_WRITE_SYNC_INTERVAL") == 0) {
+			res = atoi (value);
+			if (!(10 <= res && res <= 3600000)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_WRITE_SYNC_INTERVAL must be between 10 and 3600000 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->write_sync_intv = res;
+		} else if (strcmp (option, "CACHE_WARM_RESTART") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= 1)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_WARM_RESTART must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->warm_restart = res;
+		} else if (strcmp (option, "CACHE_CHECKPOINT_INTERVAL") == 0) {
+			res = atoi (value);
+			if (!(10 <= res && res <= 86400)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_CHECKPOINT_INTERVAL must be between 10 and 86400 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->ckpt_intv = res;
+		} else if (strcmp (option, "CACHE_COMPRESSION") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= 1)) {
+				csmgrd_log_write (CefC_Log_Error, 
+					"CACHE_COMPRESSION must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->compression = res;
 		} else if (strcmp (option, "CACHE_CAPACITY") == 0) {
 			char *endptr = "";
 			params->cache_capacity = strtoul (value, &endptr, 0);
@@ -1630,8 +4895,19 @@ fsc_change_cap (
 	hdl->cache_capacity = cap;
 	hdl->cache_cobs = 0;
 	
+	/* The segments are recreated in the new directory 		*/
+	pthread_mutex_lock (&fsc_cs_mutex);
+	fsc_store_reset ();
+	fsc_seg_limit_set (cap);
+	if (fsc_warm_f) {
+		/* The directory is kept, and the replay drops the cobs written before 	*/
+		fsc_jnl_add (FscC_Jnl_Reset, 0, 0, NULL, 0);
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (0);
+	}
 	fsc_recursive_dir_clear (hdl->fsc_cache_path);
 	hdl->fsc_id = fsc_cache_id_create (hdl);
+	pthread_mutex_unlock (&fsc_cs_mutex);
 	if (hdl->fsc_id == 0xFFFFFFFF) {
 		csmgrd_log_write (CefC_Log_Error, "FileSystemCache init error\n");
 		return (-1);
@@ -1703,9 +4979,9 @@ fsc_cache_del (
 				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 			}
 			if (rcd->cob_num == 1) {
-				char file_path[PATH_MAX];
-				sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-				fsc_recursive_dir_clear (file_path);
+				fsc_content_clear (rcd->index);
+			} else {
+				fsc_loc_del (rcd->index, chunk_num);
 			}
 			csmgrd_stat_cob_remove (csmgr_stat_hdl, rcd->name, name_len, chunk_num, 0);
 			hdl->cache_cobs--;
@@ -1803,6 +5079,27 @@ fsc_cache_id_create (
 	char cache_path[CefC_Csmgr_File_Path_Length] = {0};
 	uint32_t fsc_id = 0xFFFFFFFF;
 	
+	/* The cobs in the directory are reloaded by the warm restart 		*/
+	if (fsc_warm_f) {
+		int rc = snprintf (cache_path, sizeof (cache_path), 
+					"%s/"FscC_Warm_Dir_Name, hdl->fsc_root_path);
+		if ((rc < 0) || (rc >= (int) sizeof (cache_path))) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to cache_path name create\n");
+			return (0xFFFFFFFF);
+		}
+		cache_dir = opendir (cache_path);
+		if (cache_dir) {
+			closedir (cache_dir);
+		} else if (mkdir (cache_path, 0766) != 0) {
+			csmgrd_log_write (CefC_Log_Error, 
+				"Failed to create the cache directory in %s - %s\n", 
+				hdl->fsc_root_path, strerror (errno));
+			return (0xFFFFFFFF);
+		}
+		strcpy (hdl->fsc_cache_path, cache_path);
+		return (0);
+	}
+	
 	srand ((unsigned int) time (NULL));
 	
 	cache_id = rand () % FscC_Max_Node_Inf_Num;
@@ -74,13 +74,26 @@ typedef struct {
                                   				/* by algorithm							*/
 
 	uint64_t 		cache_capacity;				/* size of cache capacity 				*/
+	int				admission;					/* 1: TinyLFU admission is used 		*/
+	uint64_t		page_cache_mem;				/* memory (MB) for the page cache 		*/
+	int				write_buff;					/* size (KB) of the write-behind buffer	*/
+	int				write_delay;				/* delay (ms) of the buffered records 	*/
+	int				write_sync;					/* durability policy (FscC_Sync_XXX) 	*/
+	int				write_sync_intv;			/* interval (ms) of the periodic sync 	*/
+	int				warm_restart;				/* 1: reloads the cobs at the start 	*/
+	int				ckpt_intv;					/* interval (sec) of the checkpoint 	*/
+	int				compression;				/* 1: the cobs are compressed 			*/
 	
 } FscT_Config_Param;
 
 typedef struct {
-	/********** File Element ***********/
+	/********** Record Element ***********/
+	uint32_t		index;						/* index of the content					*/
+	uint32_t		chunk_num;					/* chunk number							*/
 	uint16_t		msg_len;					/* Message length						*/
-} FscT_File_Head_Element;
+	uint16_t		flags;						/* FscC_Rec_XXX							*/
+	uint32_t		name_hash;					/* hash of the content name				*/
+} FscT_Rec_Head;
 
 typedef struct {
 
@@ -98,6 +111,7 @@ typedef struct {
 	/********** cache algorithm library **********/
 	void* 			algo_lib;					/* records to the loaded library 		*/
 	CsmgrdT_Lib_Interface algo_apis;
+	CefT_Hash_Sketch_Handle admit_sketch;		/* access frequency for the admission	*/
 	char 			algo_name[1024];			/* algorithm to replece cache entries	*/
 	int				algo_name_size;				/* average name size of Cob processed 	*/
 												/* by algorithm							*/
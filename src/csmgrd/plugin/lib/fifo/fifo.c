@@ -223,6 +223,23 @@ miss (
 	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Victim API
+----------------------------------------------------------------------------------------*/
+int 							/* length of the key, 0 if the next insert evicts nothing	*/
+victim (
+	unsigned char* key, 					/* buffer (CsmgrdC_Key_Max) for the key of	*/
+											/* the entry evicted by the next insert 	*/
+	int any_f								/* 1: the entry evicted next even if the 	*/
+											/* library is not full						*/
+) {
+    if ((!any_f && (cache_count < cache_cap)) || (fifo_tail_index < 0)) {
+        return (0);
+    }
+    memcpy (key, cache_entry_list[fifo_tail_index].key, cache_entry_list[fifo_tail_index].key_len);
+    return (cache_entry_list[fifo_tail_index].key_len);
+}
+
 /*--------------------------------------------------------------------------------------
 	Status API
 ----------------------------------------------------------------------------------------*/
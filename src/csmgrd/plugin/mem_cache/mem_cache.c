@@ -64,6 +64,7 @@
 #include <cefore/cef_csmgr.h>
 #include <cefore/cef_frame.h>
 #include <cefore/cef_hash.h>
+#include <cefore/cef_mpool.h>
 #include <csmgrd/csmgrd_plugin.h>
 
 
@@ -79,6 +80,15 @@
 
 #define MemC_Max_KLen 				1024
 #define MemC_Max_Buff 				4
+#define MemC_Expire_Batch			256		/* entries expired per lock			*/
+#define MemC_Expire_Max				65536	/* entries expired per check		*/
+#define MemC_Write_Batch			256		/* cobs written per lock			*/
+#define MemC_Shard_Num				16		/* lock-striped segments of table	*/
+#define MemC_Slab_Max				65536	/* largest size class of the slab	*/
+#define MemC_Slab_Low_Water			50		/* % of the slab in use to trim it	*/
+#define MemC_Hook_Buff_Size			65536	/* bytes of the hit/miss events		*/
+											/* buffered per thread				*/
+#define MemC_Hook_Buff_Max			64		/* threads which buffer the events	*/
 #define MemC_Min_Buff				4
 #define MemC_CID_HexCh_size			(MD5_DIGEST_LENGTH * 2)	/* Size to store binary CID   */
 															/* converted to hex character */
@@ -86,6 +96,9 @@
 
 #define MemC_SEMNAME					"/cefmemsem"
 
+#define MemC_Snapshot_Magic			"CEFMEMSS"	/* head of the snapshot file			*/
+#define MemC_Snapshot_Version		1
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -105,6 +118,7 @@ typedef struct {
 	uint64_t		ins_time;					/* Insert time							*/
 	unsigned char*	version;					/* version								*/
 	uint16_t		ver_len;					/* Length of version					*/
+	unsigned int	exp_pos;					/* Position in the expiry queue			*/
 } CsmgrdT_Content_Mem_Entry;
 
 typedef struct CefT_Mem_Hash_Cell {
@@ -121,16 +135,45 @@ typedef struct CefT_Mem_Hash {
 	uint32_t 				tabl_max;
 	uint64_t 				elem_max;
 	uint64_t 				elem_num;
+	CefT_Expque*			exp_que;			/* entries in the order of expiry		*/
 
 } CefT_Mem_Hash;
 
+typedef struct CefT_Mem_Shard {
+	pthread_mutex_t 		mutex;				/* held while reading or changing tbl	*/
+	CefT_Mem_Hash*			hash_tbl;
+} CefT_Mem_Shard;
+
+/***** hit/miss events of a thread, replayed to the library by the writer 	*****/
+/*     each event is the key length (2 bytes), hit flag (1 byte) and the key 		*/
+typedef struct {
+	pthread_mutex_t 		mutex;				/* held while adding or draining		*/
+	int 					len;				/* bytes of the buffered events			*/
+	uint64_t 				drop_num;			/* events lost because of the full buff	*/
+	unsigned char 			buff[MemC_Hook_Buff_Size];
+} MemT_Hook_Buff;
+
+/***** Cob in the snapshot file, followed by the message, name and version 	*****/
+typedef struct {
+	uint64_t		cache_time;					/* Cache time							*/
+	uint64_t		expiry;						/* Expiry								*/
+	uint64_t		ins_time;					/* Insert time							*/
+	uint32_t		chunk_num;					/* Chunk num							*/
+	uint32_t		node;						/* Node address							*/
+	uint16_t		msg_len;					/* Message length						*/
+	uint16_t		name_len;					/* Content name length					*/
+	uint16_t		pay_len;					/* Payload length						*/
+	uint16_t		ver_len;					/* Length of version					*/
+} MemT_Snapshot_Rec;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
 
 static MemT_Cache_Handle* 		hdl = NULL;
 static char 					csmgr_conf_dir[PATH_MAX] = {"/usr/local/cefore"};
-static CefT_Mem_Hash* 			mem_hash_tbl = NULL;
+static CefT_Mem_Shard 			mem_shards[MemC_Shard_Num];
+static int 						mem_shard_f = 0;
 static uint32_t 				mem_tabl_max = 819200;
 static pthread_mutex_t 			mem_comn_buff_mutex[MemC_Max_Buff];
 static sem_t*					mem_comn_buff_sem;
@@ -141,7 +184,22 @@ static int 						mem_proc_cob_buff_idx[MemC_Max_Buff] 	= {0};
 static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 static pthread_t				mem_cache_delete_th;
 static int						delete_pipe_fd[2];
-
+static char						mem_snapshot_path[CefC_Csmgr_File_Path_Length] = {0};
+
+/* Each entry is stored in one block of the slab with its message, name and version */
+static CefT_Mp_Slab_Handle		mem_slab = 0;
+static uint64_t 				mem_trim_reserved = 0;	/* reserved bytes after the trim */
+
+/* The lookups which do not get mem_cs_mutex leave the hit/miss events in the buffer	*/
+/* of their thread, and the thread which gets mem_cs_mutex replays them 				*/
+static MemT_Hook_Buff*			mem_hook_buffs[MemC_Hook_Buff_Max];
+static int 						mem_hook_buff_num = 0;
+static pthread_mutex_t 			mem_hook_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread MemT_Hook_Buff*	mem_hook_buff = NULL;
+static __thread int 			mem_hook_buff_f = 0;	/* 1: tried to get the buffer	*/
+
+/* Serializes the updates of the cache and the cache algorithm library. The entries 	*/
+/* are read under the mutex of their shard, so the lookups do not wait for the updates	*/
 static pthread_mutex_t 			mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #ifdef CefC_Ccore
@@ -182,6 +240,7 @@ mem_cache_item_get (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seqno,								/* chunk num							*/
 	int sock,									/* received socket						*/
+	int faceid,									/* Face-ID which received the Interest	*/
 	unsigned char* version,						/* version								*/
 	uint16_t ver_len							/* length of version					*/
 );
@@ -208,6 +267,59 @@ mem_cs_remove (
 	unsigned char* key,
 	int key_len
 );
+/*--------------------------------------------------------------------------------------
+	Calls the hit or miss API of the library, or buffers it if the library is busy
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hook_call (
+	const unsigned char* key,
+	int key_len,
+	int hit_f
+);
+/*--------------------------------------------------------------------------------------
+	Replays the buffered hit/miss events, the caller holds mem_cs_mutex
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hook_drain (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Creates the entry of the cob in a block of the slab
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry*
+mem_cs_entry_create (
+	CsmgrdT_Content_Entry* cob
+);
+/*--------------------------------------------------------------------------------------
+	Frees the entry
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_free (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+/*--------------------------------------------------------------------------------------
+	Returns the bytes of the slab which the entry of the cob uses
+----------------------------------------------------------------------------------------*/
+static uint64_t
+mem_cs_entry_bytes (
+	uint16_t msg_len,
+	uint16_t name_len,
+	uint16_t ver_len
+);
+/*--------------------------------------------------------------------------------------
+	Checks whether the cob exceeds the memory budget
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the cob does not fit in the budget			*/
+mem_cs_mem_full (
+	CsmgrdT_Content_Entry* cob
+);
+/*--------------------------------------------------------------------------------------
+	Makes room for the cob within the memory budget
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it does not fit	*/
+mem_cs_mem_reserve (
+	CsmgrdT_Content_Entry* cob
+);
 /*--------------------------------------------------------------------------------------
 	function for processing the received message
 ----------------------------------------------------------------------------------------*/
@@ -274,6 +386,19 @@ static CefT_Mem_Hash*
 cef_mem_hash_tbl_create (
 	uint64_t table_size
 );
+static void
+cef_mem_hash_tbl_destroy (
+	CefT_Mem_Hash* ht
+);
+static void
+cef_mem_hash_exp_pos_set (
+	void* elem,
+	unsigned int pos
+);
+static uint64_t
+cef_mem_hash_exp_time_get (
+	CsmgrdT_Content_Mem_Entry* entry
+);
 static uint32_t
 cef_mem_hash_number_create (
 	const unsigned char* key,
@@ -286,16 +411,69 @@ cef_mem_hash_tbl_item_set (
 	CsmgrdT_Content_Mem_Entry* elem,
 	CsmgrdT_Content_Mem_Entry** old_elem
 );
+static int
+cef_mem_hash_tbl_item_insert (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen,
+	CsmgrdT_Content_Mem_Entry* elem,
+	CsmgrdT_Content_Mem_Entry** old_elem
+);
 static CsmgrdT_Content_Mem_Entry*
 cef_mem_hash_tbl_item_get (
 	const unsigned char* key,
 	uint32_t klen
 );
 static CsmgrdT_Content_Mem_Entry*
+cef_mem_hash_tbl_item_lookup (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen
+);
+static CsmgrdT_Content_Mem_Entry*
 cef_mem_hash_tbl_item_remove (
 	const unsigned char* key,
 	uint32_t klen
 );
+static CsmgrdT_Content_Mem_Entry*
+cef_mem_hash_tbl_item_delete (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen
+);
+static CefT_Mem_Shard*
+cef_mem_hash_shard_get (
+	uint32_t hash
+);
+/*--------------------------------------------------------------------------------------
+	Creates the shards of the memory cache
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+mem_cs_shards_create (
+	uint64_t capacity
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the shards and the cached entries
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shards_destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Sends the cached Cob if it is valid for the request
+----------------------------------------------------------------------------------------*/
+static int							/* 1: sent, 0: not cached, -1: expired				*/
+mem_cache_entry_send (
+	const unsigned char* trg_key,				/* name and chunk number				*/
+	int trg_key_len,
+	int sock,									/* received socket						*/
+	uint64_t nowt,
+	unsigned char* version,						/* requested version					*/
+	uint16_t ver_len
+);
 
 int
 csmgrd_key_create_by_Mem_Entry (
@@ -313,6 +491,25 @@ mem_cache_delete_thread (
 	void *p
 );
 
+static CsmgrT_Stat*
+mem_cache_del_rcd_create (
+	CsmgrT_Stat* rcd
+);
+/*--------------------------------------------------------------------------------------
+	Saves the cached cobs to the snapshot file
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_snapshot_save (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Loads the cobs saved in the snapshot file
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_snapshot_load (
+	void
+);
+
 /*--------------------------------------------------------------------------------------
 	get lifetime for ccninfo
 ----------------------------------------------------------------------------------------*/
@@ -349,6 +546,9 @@ csmgrd_memory_plugin_load (
 	cs_in->content_cache_del	= mem_cache_del;
 #endif // CefC_Ccore
 
+	/* The cache is striped, so the Interests are served by several threads 	*/
+	cs_in->item_get_mt = 1;
+
 	if (config_dir) {
 		strcpy (csmgr_conf_dir, config_dir);
 	}
@@ -395,6 +595,15 @@ mem_cs_create (
 	hdl->algo_name_size = conf_param.algo_name_size;
 	hdl->algo_cob_size = conf_param.algo_cob_size;
 	hdl->cache_cobs = 0;
+	hdl->cache_memory = conf_param.cache_memory;
+	hdl->cache_bytes = 0;
+
+	mem_slab = cef_mpool_slab_init ("CsmgrdMemCacheSlab", MemC_Slab_Max);
+	if (mem_slab == 0) {
+		csmgrd_log_write (CefC_Log_Error, "Unable to create the slab\n");
+		return (-1);
+	}
+	mem_trim_reserved = 0;
 
 	/* Check for excessive or insufficient memory resources for cache algorithm library */
 	if (strcmp (hdl->algo_name, "None") != 0) {
@@ -406,8 +615,7 @@ mem_cs_create (
 	}
 
 	/* Creates the memory cache 		*/
-	mem_hash_tbl = cef_mem_hash_tbl_create (hdl->cache_capacity);
-	if (mem_hash_tbl ==  NULL) {
+	if (mem_cs_shards_create (hdl->cache_capacity) < 0) {
 		csmgrd_log_write (CefC_Log_Error, "Unable to create mem hash table\n");
 		return (-1);
 	}
@@ -430,6 +638,15 @@ mem_cs_create (
 		if (hdl->algo_apis.init) {
 			(*(hdl->algo_apis.init))(hdl->cache_capacity, mem_cs_store, mem_cs_remove);
 		}
+
+		/* A new Cob replaces the victim of the library only if it is requested more often */
+		if (conf_param.admission) {
+			hdl->admit_sketch = cef_hash_sketch_create ((uint32_t) hdl->cache_capacity);
+			if (hdl->admit_sketch == (CefT_Hash_Sketch_Handle) NULL) {
+				csmgrd_log_write (CefC_Log_Error, "Unable to create the admission sketch\n");
+				return (-1);
+			}
+		}
 	}
 
 	for (i = 0 ; i < MemC_Max_Buff ; i++) {
@@ -469,15 +686,28 @@ mem_cs_create (
 
 	csmgrd_log_write (CefC_Log_Info, "Start\n");
 	csmgrd_log_write (CefC_Log_Info, "Cache Capacity : "FMTU64"\n", hdl->cache_capacity);
+	if (hdl->cache_memory) {
+		csmgrd_log_write (CefC_Log_Info,
+			"Cache Memory   : "FMTU64" MB\n", hdl->cache_memory / (1024 * 1024));
+	}
 	if (strcmp (conf_param.algo_name, "None")) {
 		csmgrd_log_write (CefC_Log_Info, "Library  : %s ... OK\n", hdl->algo_name);
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library  : Not Specified\n");
 	}
+	if (hdl->admit_sketch) {
+		csmgrd_log_write (CefC_Log_Info, "Admission : TinyLFU\n");
+	}
 
 	csmgr_stat_hdl = stat_hdl;
 	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
 
+	/* Reloads the cobs saved when the previous csmgrd stopped 		*/
+	strcpy (mem_snapshot_path, conf_param.snapshot);
+	if (mem_snapshot_path[0]) {
+		mem_cache_snapshot_load ();
+	}
+
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -487,7 +717,7 @@ static void*
 mem_cob_process_thread (
 	void* arg
 ) {
-	int i;
+	int i, n, num;
 
 	while (mem_thread_f) {
 		sem_wait (mem_comn_buff_sem);
@@ -502,9 +732,17 @@ mem_cob_process_thread (
 				csmgrd_dbg_write (CefC_Dbg_Fine,
 					"cob put thread starts to write %d cobs\n", mem_proc_cob_buff_idx[i]);
 #endif // CefC_Debug
-				pthread_mutex_lock (&mem_cs_mutex);
-				mem_cache_cob_write (&mem_proc_cob_buff[i][0], mem_proc_cob_buff_idx[i]);
-				pthread_mutex_unlock (&mem_cs_mutex);
+				/* Releases the lock per batch, so the hits can update the library 	*/
+				for (n = 0 ; n < mem_proc_cob_buff_idx[i] ; n += MemC_Write_Batch) {
+					num = mem_proc_cob_buff_idx[i] - n;
+					if (num > MemC_Write_Batch) {
+						num = MemC_Write_Batch;
+					}
+					pthread_mutex_lock (&mem_cs_mutex);
+					mem_cs_hook_drain ();
+					mem_cache_cob_write (&mem_proc_cob_buff[i][n], num);
+					pthread_mutex_unlock (&mem_cs_mutex);
+				}
 				mem_proc_cob_buff_idx[i] = 0;
 				if (i >= MemC_Min_Buff) {
 					free (mem_proc_cob_buff[i]);
@@ -540,34 +778,16 @@ mem_cs_store (
 	/* Creates the key 		*/
 	key_len = csmgrd_key_create (new_entry, key);
 
-	/* Creates the entry 		*/
-	entry =
-		(CsmgrdT_Content_Mem_Entry*) calloc (1, sizeof (CsmgrdT_Content_Mem_Entry));
+	/* Creates the entry, the caller frees the buffers of the cob 	*/
+	entry = mem_cs_entry_create (new_entry);
 	if (entry == NULL) {
 		return (-1);
 	}
 
 	/* Inserts the cache entry 		*/
-	entry->msg 		= new_entry->msg;
-	entry->msg_len	= new_entry->msg_len;
-	entry->name		= new_entry->name;
-	entry->name_len = new_entry->name_len;
-	entry->pay_len		 = new_entry->pay_len;
-	entry->chunk_num		 = new_entry->chunk_num;
-	entry->cache_time	 = new_entry->cache_time;
-	entry->expiry		 = new_entry->expiry;
-	entry->node			 = new_entry->node;
-	entry->ins_time		 = new_entry->ins_time;
-	entry->ver_len		 = new_entry->ver_len;
-	entry->version		 = new_entry->version;
-
 	if (cef_mem_hash_tbl_item_set (
 		key, key_len, entry, &old_entry) < 0) {
-		free (entry->msg);
-		free (entry->name);
-		if (entry->ver_len)
-			free (entry->version);
-		free (entry);
+		mem_cs_entry_free (entry);
 		return (-1);
 	}
 
@@ -585,11 +805,7 @@ mem_cs_store (
 	}
 
 	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
-		if (old_entry->ver_len)
-			free (old_entry->version);
-		free (old_entry);
+		mem_cs_entry_free (old_entry);
 	} else {
 		hdl->cache_cobs++;
 	}
@@ -613,15 +829,240 @@ mem_cs_remove (
 		csmgrd_stat_cob_remove (
 			csmgr_stat_hdl, entry->name, entry->name_len,
 			entry->chunk_num, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
-		free (entry);
+		mem_cs_entry_free (entry);
 		hdl->cache_cobs--;
 	}
 
 	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Calls the hit or miss API of the library, or buffers it if the library is busy
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hook_call (
+	const unsigned char* key,
+	int key_len,
+	int hit_f									/* 1: hit, 0: miss						*/
+) {
+	MemT_Hook_Buff* hb;
+	uint16_t len16;
+
+	if ((hit_f && (hdl->algo_apis.hit == NULL)) ||
+		(!hit_f && (hdl->algo_apis.miss == NULL))) {
+		return;
+	}
+	if (pthread_mutex_trylock (&mem_cs_mutex) == 0) {
+		mem_cs_hook_drain ();
+		if (hit_f) {
+			(*(hdl->algo_apis.hit))((unsigned char*) key, key_len);
+		} else {
+			(*(hdl->algo_apis.miss))((unsigned char*) key, key_len);
+		}
+		pthread_mutex_unlock (&mem_cs_mutex);
+		return;
+	}
+
+	/* Gets the buffer of this thread at the first time 	*/
+	if (mem_hook_buff_f == 0) {
+		mem_hook_buff_f = 1;
+		hb = (MemT_Hook_Buff*) malloc (sizeof (MemT_Hook_Buff));
+		if (hb != NULL) {
+			pthread_mutex_init (&hb->mutex, NULL);
+			hb->len 		= 0;
+			hb->drop_num 	= 0;
+			pthread_mutex_lock (&mem_hook_mutex);
+			if (mem_hook_buff_num < MemC_Hook_Buff_Max) {
+				mem_hook_buffs[mem_hook_buff_num] = hb;
+				__atomic_store_n (&mem_hook_buff_num, mem_hook_buff_num + 1, __ATOMIC_RELEASE);
+				mem_hook_buff = hb;
+			}
+			pthread_mutex_unlock (&mem_hook_mutex);
+			if (mem_hook_buff == NULL) {
+				pthread_mutex_destroy (&hb->mutex);
+				free (hb);
+			}
+		}
+	}
+	hb = mem_hook_buff;
+	if (hb == NULL) {
+		/* No more buffers, waits for the writer 	*/
+		pthread_mutex_lock (&mem_cs_mutex);
+		mem_cs_hook_drain ();
+		if (hit_f) {
+			(*(hdl->algo_apis.hit))((unsigned char*) key, key_len);
+		} else {
+			(*(hdl->algo_apis.miss))((unsigned char*) key, key_len);
+		}
+		pthread_mutex_unlock (&mem_cs_mutex);
+		return;
+	}
+
+	pthread_mutex_lock (&hb->mutex);
+	if (hb->len + 3 + key_len <= MemC_Hook_Buff_Size) {
+		len16 = (uint16_t) key_len;
+		memcpy (&hb->buff[hb->len], &len16, sizeof (uint16_t));
+		hb->buff[hb->len + 2] = (unsigned char) hit_f;
+		memcpy (&hb->buff[hb->len + 3], key, key_len);
+		hb->len += 3 + key_len;
+	} else {
+		hb->drop_num++;
+	}
+	pthread_mutex_unlock (&hb->mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Replays the buffered hit/miss events, the caller holds mem_cs_mutex
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hook_drain (
+	void
+) {
+	MemT_Hook_Buff* hb;
+	uint16_t len16;
+	int num;
+	int i, n;
+
+	num = __atomic_load_n (&mem_hook_buff_num, __ATOMIC_ACQUIRE);
+	for (i = 0 ; i < num ; i++) {
+		hb = mem_hook_buffs[i];
+		if (__atomic_load_n (&hb->len, __ATOMIC_RELAXED) == 0) {
+			continue;
+		}
+		pthread_mutex_lock (&hb->mutex);
+		for (n = 0 ; n < hb->len ; n += 3 + len16) {
+			memcpy (&len16, &hb->buff[n], sizeof (uint16_t));
+			if (hb->buff[n + 2]) {
+				if (hdl->algo_apis.hit) {
+					(*(hdl->algo_apis.hit))(&hb->buff[n + 3], len16);
+				}
+			} else {
+				if (hdl->algo_apis.miss) {
+					(*(hdl->algo_apis.miss))(&hb->buff[n + 3], len16);
+				}
+			}
+		}
+		hb->len = 0;
+		pthread_mutex_unlock (&hb->mutex);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Creates the entry of the cob in a block of the slab
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry*
+mem_cs_entry_create (
+	CsmgrdT_Content_Entry* cob
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	unsigned char* p;
+	size_t size;
+
+	/* The entry, message, name and version are put in one block of the slab 	*/
+	size = sizeof (CsmgrdT_Content_Mem_Entry) + cob->msg_len + cob->name_len + cob->ver_len;
+	entry = (CsmgrdT_Content_Mem_Entry*) cef_mpool_slab_alloc (mem_slab, size);
+	if (entry == NULL) {
+		return (NULL);
+	}
+	memset (entry, 0, sizeof (CsmgrdT_Content_Mem_Entry));
+	p = (unsigned char*) entry + sizeof (CsmgrdT_Content_Mem_Entry);
+
+	entry->msg 			= p;
+	entry->msg_len		= cob->msg_len;
+	memcpy (p, cob->msg, cob->msg_len);
+	p += cob->msg_len;
+	entry->name			= p;
+	entry->name_len		= cob->name_len;
+	memcpy (p, cob->name, cob->name_len);
+	p += cob->name_len;
+	if (cob->ver_len) {
+		entry->version	= p;
+		entry->ver_len	= cob->ver_len;
+		memcpy (p, cob->version, cob->ver_len);
+	}
+	entry->pay_len		= cob->pay_len;
+	entry->chunk_num	= cob->chunk_num;
+	entry->cache_time	= cob->cache_time;
+	entry->expiry		= cob->expiry;
+	entry->node			= cob->node;
+	entry->ins_time		= cob->ins_time;
+
+	hdl->cache_bytes += cef_mpool_slab_block_size (mem_slab, size);
+
+	return (entry);
+}
+/*--------------------------------------------------------------------------------------
+	Frees the entry
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_free (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	size_t size;
+
+	if (entry == NULL) {
+		return;
+	}
+	size = sizeof (CsmgrdT_Content_Mem_Entry)
+				+ entry->msg_len + entry->name_len + entry->ver_len;
+	hdl->cache_bytes -= cef_mpool_slab_block_size (mem_slab, size);
+	cef_mpool_slab_free (mem_slab, entry, size);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the bytes of the slab which the entry of the cob uses
+----------------------------------------------------------------------------------------*/
+static uint64_t
+mem_cs_entry_bytes (
+	uint16_t msg_len,
+	uint16_t name_len,
+	uint16_t ver_len
+) {
+	return ((uint64_t) cef_mpool_slab_block_size (mem_slab,
+				sizeof (CsmgrdT_Content_Mem_Entry) + msg_len + name_len + ver_len));
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the cob exceeds the memory budget
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the cob does not fit in the budget			*/
+mem_cs_mem_full (
+	CsmgrdT_Content_Entry* cob
+) {
+	if (hdl->cache_memory == 0) {
+		return (0);
+	}
+	return (hdl->cache_bytes + mem_cs_entry_bytes (cob->msg_len, cob->name_len, cob->ver_len)
+				> hdl->cache_memory);
+}
+/*--------------------------------------------------------------------------------------
+	Makes room for the cob within the memory budget. The entries are evicted in the
+	order of the cache algorithm library, which tells them through the victim API.
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if it does not fit	*/
+mem_cs_mem_reserve (
+	CsmgrdT_Content_Entry* cob
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	unsigned char 	vkey[CsmgrdC_Key_Max];
+	int 			vkey_len;
+
+	while (mem_cs_mem_full (cob)) {
+		if ((hdl->algo_apis.victim == NULL) || (hdl->algo_apis.erase == NULL)) {
+			return (-1);
+		}
+		vkey_len = (*(hdl->algo_apis.victim))(vkey, 1);
+		if (vkey_len <= 0) {
+			return (-1);
+		}
+		(*(hdl->algo_apis.erase))(vkey, vkey_len);
+		entry = cef_mem_hash_tbl_item_remove (vkey, vkey_len);
+		if (entry) {
+			csmgrd_stat_cob_remove (
+				csmgr_stat_hdl, entry->name, entry->name_len,
+				entry->chunk_num, entry->pay_len);
+			mem_cs_entry_free (entry);
+			hdl->cache_cobs--;
+		}
+	}
+	return (0);
+}
 /*--------------------------------------------------------------------------------------
 	Destroy content store
 ----------------------------------------------------------------------------------------*/
@@ -633,13 +1074,12 @@ mem_cs_destroy (
 	int i;
 	void* status;
 
-	pthread_mutex_destroy (&mem_cs_mutex);
-
 	if (mem_thread_f) {
 		mem_thread_f = 0;
 		sem_post (mem_comn_buff_sem);	/* To avoid deadlock */
 		pthread_join (mem_thread_th, &status);
 	}
+	pthread_mutex_destroy (&mem_cs_mutex);
 	sem_close (mem_comn_buff_sem);
 	sem_unlink (MemC_SEMNAME);
 
@@ -653,20 +1093,15 @@ mem_cs_destroy (
 	if (hdl == NULL) {
 		return;
 	}
-	if (mem_hash_tbl) {
-		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[i];
-			while (cp != NULL) {
-				wcp = cp->next;
-				free (cp->elem);
-				free (cp);
-				cp = wcp;
-			}
+	if (mem_snapshot_path[0]) {
+		mem_cache_snapshot_save ();
+	}
+	mem_cs_shards_destroy ();
+	if (mem_shard_f) {
+		for (i = 0 ; i < MemC_Shard_Num ; i++) {
+			pthread_mutex_destroy (&mem_shards[i].mutex);
 		}
-		free (mem_hash_tbl->tbl);
-		free (mem_hash_tbl);
+		mem_shard_f = 0;
 	}
 
 	if (hdl->algo_lib) {
@@ -675,6 +1110,18 @@ mem_cs_destroy (
 		}
 		dlclose (hdl->algo_lib);
 	}
+	cef_hash_sketch_destroy (hdl->admit_sketch);
+	cef_mpool_slab_destroy (mem_slab);
+	mem_slab = 0;
+
+	pthread_mutex_lock (&mem_hook_mutex);
+	for (i = 0 ; i < mem_hook_buff_num ; i++) {
+		pthread_mutex_destroy (&mem_hook_buffs[i]->mutex);
+		free (mem_hook_buffs[i]);
+		mem_hook_buffs[i] = NULL;
+	}
+	mem_hook_buff_num = 0;
+	pthread_mutex_unlock (&mem_hook_mutex);
 
 	if (hdl) {
 		free (hdl);
@@ -695,48 +1142,58 @@ mem_cs_expire_check (
 	CsmgrdT_Content_Mem_Entry* entry1 = NULL;
 	uint64_t 	nowt;
 	struct timeval tv;
-	int n;
+	int n, done, s;
 	unsigned char trg_key[65535];
 	int trg_key_len;
-
-	if (pthread_mutex_trylock (&mem_cs_mutex) != 0) {
-		return;
-	}
+	CefT_Mp_Slab_Stat slab_stat;
 
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		if (mem_hash_tbl->tbl[n] == NULL) {
+	/* Takes the expired entries in time order. The lock is released after	*/
+	/* each batch, so the incoming cobs are not kept waiting.				*/
+	for (s = 0 ; s < MemC_Shard_Num ; s++) {
+		if (mem_shards[s].hash_tbl == NULL) {
 			continue;
 		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
-					if (hdl->algo_apis.erase) {
-						(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-					}
-					hdl->cache_cobs--;
-					csmgrd_stat_cob_remove (
-						csmgr_stat_hdl, entry->name, entry->name_len,
-						entry->chunk_num, entry->pay_len);
-					free (entry1->msg);
-					free (entry1->name);
-					free (entry1);
+		for (done = 0 ; done < MemC_Expire_Max / MemC_Shard_Num ; done += n) {
+			if (pthread_mutex_trylock (&mem_cs_mutex) != 0) {
+				return;
+			}
+			mem_cs_hook_drain ();
+			for (n = 0 ; n < MemC_Expire_Batch ; n++) {
+				entry = (CsmgrdT_Content_Mem_Entry*)
+							cef_expque_pop_expired (mem_shards[s].hash_tbl->exp_que, nowt);
+				if (entry == NULL) {
+					break;
+				}
+				/* Removes the expiry cache entry 		*/
+				trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
+				entry1 = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+				if (hdl->algo_apis.erase) {
+					(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 				}
+				hdl->cache_cobs--;
+				csmgrd_stat_cob_remove (
+					csmgr_stat_hdl, entry->name, entry->name_len,
+					entry->chunk_num, entry->pay_len);
+				mem_cs_entry_free (entry1);
+			}
+			pthread_mutex_unlock (&mem_cs_mutex);
+			if (n < MemC_Expire_Batch) {
+				break;
 			}
 		}
 	}
-	pthread_mutex_unlock (&mem_cs_mutex);
+
+	/* Returns the free pages of the slab when most of it is no longer used 	*/
+	cef_mpool_slab_stat_get (mem_slab, &slab_stat);
+	if ((slab_stat.used_bytes * 100 < slab_stat.reserved_bytes * MemC_Slab_Low_Water) &&
+		(slab_stat.reserved_bytes != mem_trim_reserved)) {
+		cef_mpool_slab_trim (mem_slab);
+		cef_mpool_slab_stat_get (mem_slab, &slab_stat);
+		mem_trim_reserved = slab_stat.reserved_bytes;
+	}
 
 	return;
 }
@@ -750,17 +1207,22 @@ mem_cache_item_get (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seqno,								/* chunk num							*/
 	int sock,									/* received socket						*/
+	int faceid,									/* Face-ID which received the Interest	*/
 	unsigned char* version,						/* version								*/
 	uint16_t ver_len							/* length of version					*/
 ) {
 	CsmgrdT_Content_Mem_Entry* entry;
 	unsigned char 	trg_key[CsmgrdC_Key_Max];
 	int 			trg_key_len;
+	unsigned char 	ra_key[CsmgrdC_Key_Max];
+	int 			ra_key_len;
 	uint64_t 		nowt;
 	struct timeval 	tv;
-	CsmgrdT_Content_Mem_Entry** entry_p = NULL;
 	int exist_f = CefC_Csmgr_Cob_NotExist;
-	int				rc = CefC_CV_Inconsistent;
+	int				res;
+	uint32_t 		tx_cnt;
+	uint32_t 		tx_num;
+	uint32_t 		prefetch;
 
 #ifdef __MEMCACHE_VERSION__
 	fprintf (stderr, "--- mem_cache_item_get()\n");
@@ -768,64 +1230,31 @@ mem_cache_item_get (
 
 	/* Creates the key 		*/
 	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
+	cef_hash_sketch_increment (hdl->admit_sketch, trg_key, trg_key_len);
 
-	/* Access the specified entry 	*/
-	entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
-
-	if (entry) {
-
-		gettimeofday (&tv, NULL);
-		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-
-		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
-			(nowt < entry->cache_time)) {
-#ifdef __MEMCACHE_VERSION__
-			fprintf (stderr, "  entry: ");
-			for (int i = 0; i < entry->ver_len; i++) {
-				if (isprint (entry->version[i])) fprintf (stderr, "%c ", entry->version[i]);
-				else fprintf (stderr, "%02x ", entry->version[i]);
-			}
-			fprintf (stderr, "(%d)\n", entry->ver_len);
-			fprintf (stderr, "  cob: ");
-			for (int i = 0; i < ver_len; i++) {
-				if (isprint (version[i])) fprintf (stderr, "%c ", version[i]);
-				else fprintf (stderr, "%02x ", version[i]);
-			}
-			fprintf (stderr, "(%d)\n", ver_len);
-#endif //__MEMCACHE_VERSION__
-			rc = cef_csmgr_cache_version_compare (version, ver_len, entry->version, entry->ver_len);
-			if (rc == CefC_CV_Inconsistent) {
-				if (ver_len == 0 && entry->ver_len != 0) {
-					/* Request is "None", so any version is OK */
-#ifdef __MEMCACHE_VERSION__
-			fprintf (stderr, "    => Request is \"None\", so any version is OK\n");
-#endif //__MEMCACHE_VERSION__
-					;
-				} else {
-					goto CobNotExist;
-				}
-			} else if (rc != CefC_CV_Same) {
-				goto CobNotExist;
-			}
-
-			pthread_mutex_lock (&mem_cs_mutex);
-			if (hdl->algo_apis.hit) {
-				(*(hdl->algo_apis.hit))(trg_key, trg_key_len);
-			}
-
-			csmgrd_stat_access_count_update (
-					csmgr_stat_hdl, entry->name, entry->name_len);
-
-			/* Send Cob to cefnetd */
-			csmgrd_plugin_cob_msg_send (sock, entry->msg, entry->msg_len);
-			exist_f = CefC_Csmgr_Cob_Exist;
-			pthread_mutex_unlock (&mem_cs_mutex);
- 		}
-		else {
-			pthread_mutex_lock (&mem_cs_mutex);
-			/* Removes the expiry cache entry 		*/
-			entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
+	/* Access the specified entry 	*/
+	res = mem_cache_entry_send (trg_key, trg_key_len, sock, nowt, version, ver_len);
+
+	if (res > 0) {
+		exist_f = CefC_Csmgr_Cob_Exist;
+		csmgrd_stat_access_count_update (csmgr_stat_hdl, key, key_size);
+
+		/* Pushes the following cobs ahead of the Interests of this flow 	*/
+		tx_num = csmgrd_plugin_readahead_get (
+					key, key_size, sock, faceid, seqno, &prefetch);
+		for (tx_cnt = 1 ; tx_cnt < tx_num ; tx_cnt++) {
+			ra_key_len = csmgrd_name_chunknum_concatenate (
+								key, key_size, seqno + tx_cnt, ra_key);
+			mem_cache_entry_send (ra_key, ra_key_len, sock, nowt, version, ver_len);
+		}
+	} else if (res < 0) {
+		pthread_mutex_lock (&mem_cs_mutex);
+		/* Removes the expiry cache entry, unless the other thread did it 		*/
+		entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+		if (entry) {
 			if (hdl->algo_apis.erase) {
 				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 			}
@@ -835,23 +1264,83 @@ mem_cache_item_get (
 				csmgr_stat_hdl, entry->name, entry->name_len,
 				entry->chunk_num, entry->pay_len);
 
-			free (entry->msg);
-			free (entry->name);
-			free (entry);
-			pthread_mutex_unlock (&mem_cs_mutex);
+			mem_cs_entry_free (entry);
 		}
+		pthread_mutex_unlock (&mem_cs_mutex);
 	}
-CobNotExist:;
 
-	if (entry_p != NULL) {
-		free (entry_p);
+	/* The lookups never wait for the writer to update the library 	*/
+	mem_cs_hook_call (trg_key, trg_key_len, (exist_f == CefC_Csmgr_Cob_Exist));
+
+	return (exist_f);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the cached Cob if it is valid for the request
+----------------------------------------------------------------------------------------*/
+static int							/* 1: sent, 0: not cached, -1: expired				*/
+mem_cache_entry_send (
+	const unsigned char* trg_key,				/* name and chunk number				*/
+	int trg_key_len,
+	int sock,									/* received socket						*/
+	uint64_t nowt,
+	unsigned char* version,						/* requested version					*/
+	uint16_t ver_len
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	CefT_Mem_Shard* shard;
+	uint32_t 		hash;
+	int				rc;
+	int				res = 0;
+	unsigned char	msg[CefC_Max_Length];
+	uint16_t		msg_len = 0;
+
+	hash  = cef_mem_hash_number_create (trg_key, trg_key_len);
+	shard = cef_mem_hash_shard_get (hash);
+
+	/* The entry is not freed while the mutex of its shard is held 	*/
+	pthread_mutex_lock (&shard->mutex);
+	entry = cef_mem_hash_tbl_item_lookup (shard->hash_tbl, hash, trg_key, trg_key_len);
+	if (entry == NULL) {
+		pthread_mutex_unlock (&shard->mutex);
+		return (0);
 	}
-	if (exist_f != CefC_Csmgr_Cob_Exist) {
-		if (hdl->algo_apis.miss) {
-			(*(hdl->algo_apis.miss))(trg_key, trg_key_len);
-		}
+	if (((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+		(nowt >= entry->cache_time)) {
+		pthread_mutex_unlock (&shard->mutex);
+		return (-1);
 	}
-	return (exist_f);
+#ifdef __MEMCACHE_VERSION__
+	fprintf (stderr, "  entry: ");
+	for (int i = 0; i < entry->ver_len; i++) {
+		if (isprint (entry->version[i])) fprintf (stderr, "%c ", entry->version[i]);
+		else fprintf (stderr, "%02x ", entry->version[i]);
+	}
+	fprintf (stderr, "(%d)\n", entry->ver_len);
+	fprintf (stderr, "  cob: ");
+	for (int i = 0; i < ver_len; i++) {
+		if (isprint (version[i])) fprintf (stderr, "%c ", version[i]);
+		else fprintf (stderr, "%02x ", version[i]);
+	}
+	fprintf (stderr, "(%d)\n", ver_len);
+#endif //__MEMCACHE_VERSION__
+
+	/* Any version is OK if the request does not specify it 	*/
+	rc = cef_csmgr_cache_version_compare (version, ver_len, entry->version, entry->ver_len);
+	if ((rc == CefC_CV_Same) ||
+		((rc == CefC_CV_Inconsistent) && (ver_len == 0))) {
+		/* The send may wait for a slow cefnetd, so it is done with the copy 	*/
+		msg_len = entry->msg_len;
+		memcpy (msg, entry->msg, msg_len);
+		res = 1;
+	}
+	pthread_mutex_unlock (&shard->mutex);
+
+	if (res == 1) {
+		/* Send Cob to cefnetd */
+		csmgrd_plugin_cob_msg_send (sock, msg, msg_len);
+	}
+
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Upload content byte steream
@@ -945,6 +1434,7 @@ mem_cache_cob_write (
 	int cob_num
 ) {
 	int index = 0;
+	CsmgrdT_Content_Entry* cob;
 	CsmgrdT_Content_Mem_Entry* entry;
 	CsmgrdT_Content_Mem_Entry* old_entry = NULL;
 	unsigned char 	trg_key[CsmgrdC_Key_Max];
@@ -952,6 +1442,7 @@ mem_cache_cob_write (
 	uint64_t nowt;
 	struct timeval tv;
 	int				rc = CefC_CV_Inconsistent;
+	int				ins_f;
 	CsmgrT_Stat*	rcd = NULL;
 	CsmgrT_Stat*	del_rcd = NULL;
 
@@ -962,345 +1453,182 @@ mem_cache_cob_write (
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
+	/* The entries are copied to the slab, the buffers of the cobs are freed here 	*/
 	while (index < cob_num) {
+		cob = &cobs[index];
 
-		if (cobs[index].expiry < nowt) {
-			free (cobs[index].msg);
-			free (cobs[index].name);
-			if (cobs[index].ver_len) {
-				free (cobs[index].version);
-			}
-			index++;
-			continue;
+		if (cob->expiry < nowt) {
+			goto NEXTCOB;
 		}
 
 		if (hdl->algo_apis.insert) {
-			trg_key_len = csmgrd_key_create (&cobs[index], trg_key);
+			trg_key_len = csmgrd_key_create (cob, trg_key);
 			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
 			if (entry == NULL) {
 #ifdef __MEMCACHE_VERSION__
-				fprintf (stderr, "  * new insert %u\n", cobs[index].chunk_num);
+				fprintf (stderr, "  * new insert %u\n", cob->chunk_num);
 #endif //__MEMCACHE_VERSION__
-				(*(hdl->algo_apis.insert))(&cobs[index]);
-			} else {
-				rc = cef_csmgr_cache_version_compare (cobs[index].version, cobs[index].ver_len, entry->version, entry->ver_len);
-#ifdef __MEMCACHE_VERSION__
-				fprintf (stderr, "  * cache exist %u\n", cobs[index].chunk_num);
-				fprintf (stderr, "  * entry: ");
-				for (int i = 0; i < entry->ver_len; i++) {
-					if (isprint (entry->version[i])) fprintf (stderr, "%c ", entry->version[i]);
-					else fprintf (stderr, "%02x ", entry->version[i]);
+				if (!csmgrd_lib_admission_check (
+						&hdl->algo_apis, hdl->admit_sketch, trg_key, trg_key_len,
+						mem_cs_mem_full (cob))) {
+					goto NEXTCOB;
 				}
-				fprintf (stderr, "(%d)\n", entry->ver_len);
-				fprintf (stderr, "  * cob: ");
-				for (int i = 0; i < cobs[index].ver_len; i++) {
-					if (isprint (cobs[index].version[i])) fprintf (stderr, "%c ", cobs[index].version[i]);
-					else fprintf (stderr, "%02x ", cobs[index].version[i]);
+				if (mem_cs_mem_reserve (cob) < 0) {
+					goto NEXTCOB;
 				}
-				fprintf (stderr, "(%d)\n", cobs[index].ver_len);
-#endif //__MEMCACHE_VERSION__
-				if (rc != CefC_CV_Inconsistent) {
-					if (rc == CefC_CV_Newest_1stArg) {
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---New\n");
-#endif //__MEMCACHE_VERSION__
-						/* Delete older version of data. */
-						entry = cef_mem_hash_tbl_item_remove(trg_key, trg_key_len);
-						if (hdl->algo_apis.erase) {
-							(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-						}
-						hdl->cache_cobs--;
-						if (entry) {
-							free (entry->msg);
-							free (entry->name);
-							if (entry->ver_len) {
-								free (entry->version);
-							}
-						} else {
-							return (-1);
-						}
-
-						rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
-						rc = cef_csmgr_cache_version_compare (cobs[index].version, cobs[index].ver_len, rcd->version, rcd->ver_len);
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * rcd: ");
-						for (int i = 0; i < rcd->ver_len; i++) {
-							if (isprint (rcd->version[i])) fprintf (stderr, "%c ", rcd->version[i]);
-							else fprintf (stderr, "%02x ", rcd->version[i]);
-						}
-						fprintf (stderr, "(%d)\n", rcd->ver_len);
-#endif //__MEMCACHE_VERSION__
-						if (rc == CefC_CV_Newest_1stArg) {
-							/* Delete the stat record only when the first Cob is received after the version is upgraded. */
-
-							/* copy stat record */
-							del_rcd = (CsmgrT_Stat*) malloc (sizeof (CsmgrT_Stat) + rcd->name_len + rcd->ver_len);
-							del_rcd->name = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat);
-							del_rcd->version = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat) + rcd->name_len;
-							del_rcd->cob_num = rcd->cob_num;
-							del_rcd->min_seq = rcd->min_seq;
-							del_rcd->max_seq = rcd->max_seq;
-							del_rcd->name_len = rcd->name_len;
-							del_rcd->ver_len = rcd->ver_len;
-							memcpy (del_rcd->name, rcd->name, rcd->name_len);
-							if (rcd->ver_len) {
-								memcpy (del_rcd->version, rcd->version, rcd->ver_len);
-							}
-							/* delete stat record */
-							csmgrd_stat_content_info_delete (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
-#ifdef __MEMCACHE_VERSION__
-							fprintf (stderr, "  * delete stat\n");
-#endif //__MEMCACHE_VERSION__
-						}
-
-						/* Insert a new version of data. */
-						(*(hdl->algo_apis.insert))(&cobs[index]);
-
-						if (rc == CefC_CV_Newest_1stArg) {
-							/* csmgrd_stat_cob_update is called in store API called in insert API. */
-							rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
+				(*(hdl->algo_apis.insert))(cob);
+				goto NEXTCOB;
+			}
+			rc = cef_csmgr_cache_version_compare (
+					cob->version, cob->ver_len, entry->version, entry->ver_len);
 #ifdef __MEMCACHE_VERSION__
-							fprintf (stderr, "  * get stat\n");
-							fprintf (stderr, "  * rcd: ");
-							for (int i = 0; i < rcd->ver_len; i++) {
-								if (isprint (rcd->version[i])) fprintf (stderr, "%c ", rcd->version[i]);
-								else fprintf (stderr, "%02x ", rcd->version[i]);
-							}
-							fprintf (stderr, "(%d)\n", rcd->ver_len);
+			fprintf (stderr, "  * cache exist %u (%d)\n", cob->chunk_num, rc);
 #endif //__MEMCACHE_VERSION__
-							if (cobs[index].ver_len && !rcd->ver_len) {
-								csmgrd_stat_content_info_version_init (csmgr_stat_hdl, rcd, cobs[index].version, cobs[index].ver_len);
-							}
+			if (rc != CefC_CV_Newest_1stArg) {
+				/* Cached yet, an old version, or an inconsistent version 	*/
+				goto NEXTCOB;
+			}
 
-							/* delete thread */
-							if (write (delete_pipe_fd[0], del_rcd, sizeof (CsmgrT_Stat)) != sizeof(CsmgrT_Stat)) {
-								;	/* NOP */
-							}
-							if (del_rcd) {
-								free (del_rcd);
-							}
-						}
-					} else if (rc == CefC_CV_Same) {
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---Same\n");
-#endif //__MEMCACHE_VERSION__
-						/* cached yet */
-						free (cobs[index].msg);
-						free (cobs[index].name);
-						if (cobs[index].ver_len) {
-							free (cobs[index].version);
-						}
-					} else {
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---Old\n");
-#endif //__MEMCACHE_VERSION__
-						free (cobs[index].msg);
-						free (cobs[index].name);
-						if (cobs[index].ver_len) {
-							free (cobs[index].version);
-						}
-					}
-				} else {
-#ifdef __MEMCACHE_VERSION__
-					fprintf (stderr, "  * ---Inconsistent\n");
-#endif //__MEMCACHE_VERSION__
-					free (cobs[index].msg);
-					free (cobs[index].name);
-					if (cobs[index].ver_len) {
-						free (cobs[index].version);
-					}
-				}
+			/* Delete older version of data. */
+			entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+			if (hdl->algo_apis.erase) {
+				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 			}
-		} else {
-			if (hdl->cache_cobs >= hdl->cache_capacity) {
-				free (cobs[index].msg);
-				free (cobs[index].name);
-				if (cobs[index].ver_len)
-					free (cobs[index].version);
-				index++;
-				continue;
+			if (entry) {
+				hdl->cache_cobs--;
+				mem_cs_entry_free (entry);
 			}
-			/* Caches the content entry without the cache algorithm library 	*/
-			entry =
-				(CsmgrdT_Content_Mem_Entry*) calloc (1, sizeof (CsmgrdT_Content_Mem_Entry));
-			if (entry == NULL) {
-				return (-1);
+
+			rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cob->name, cob->name_len);
+			rc = CefC_CV_Inconsistent;
+			del_rcd = NULL;
+			if (rcd) {
+				rc = cef_csmgr_cache_version_compare (
+						cob->version, cob->ver_len, rcd->version, rcd->ver_len);
 			}
+			if (rc == CefC_CV_Newest_1stArg) {
+				/* Delete the stat record only when the first Cob is received after the version is upgraded. */
 
-			/* Creates the key 				*/
-			trg_key_len = csmgrd_name_chunknum_concatenate (
-							cobs[index].name, cobs[index].name_len,
-							cobs[index].chunk_num, trg_key);
-
-			/* Inserts the cache entry 		*/
-			entry->msg		= cobs[index].msg;
-			entry->msg_len	= cobs[index].msg_len;
-			entry->name		= cobs[index].name;
-			entry->name_len	= cobs[index].name_len;
-			entry->pay_len		 = cobs[index].pay_len;
-			entry->chunk_num		 = cobs[index].chunk_num;
-			entry->cache_time	 = cobs[index].cache_time;
-			entry->expiry		 = cobs[index].expiry;
-			entry->node			 = cobs[index].node;
-			entry->ins_time		 = cobs[index].ins_time;
-			entry->ver_len		 = cobs[index].ver_len;
-			entry->version		 = cobs[index].version;
-
-			old_entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
-			if (old_entry == NULL) {
+				/* copy stat record */
+				del_rcd = mem_cache_del_rcd_create (rcd);
+				/* delete stat record */
+				csmgrd_stat_content_info_delete (csmgr_stat_hdl, cob->name, cob->name_len);
 #ifdef __MEMCACHE_VERSION__
-				fprintf (stderr, "  * new insert %u\n", entry->chunk_num);
+				fprintf (stderr, "  * delete stat\n");
 #endif //__MEMCACHE_VERSION__
-				if (cef_mem_hash_tbl_item_set (
-					trg_key, trg_key_len, entry, &old_entry) < 0) {
-					free (entry->msg);
-					free (entry->name);
-					if (entry->ver_len)
-						free (entry->version);
-					free (entry);
-					return (-1);
-				}
+			}
 
-				/* Updates the content information 			*/
-				csmgrd_stat_cob_update (csmgr_stat_hdl, entry->name, entry->name_len,
-					entry->chunk_num, entry->pay_len, entry->expiry, nowt, entry->node);
-				rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, entry->name, entry->name_len);
-				if (entry->ver_len && !rcd->ver_len) {
-					csmgrd_stat_content_info_version_init (csmgr_stat_hdl, rcd, entry->version, entry->ver_len);
-				}
+			/* Insert a new version of data. */
+			ins_f = (mem_cs_mem_reserve (cob) == 0);
+			if (ins_f) {
+				(*(hdl->algo_apis.insert))(cob);
+			}
 
-				hdl->cache_cobs++;
-			} else {
-				rc = cef_csmgr_cache_version_compare (entry->version, entry->ver_len, old_entry->version, old_entry->ver_len);
-#ifdef __MEMCACHE_VERSION__
-				fprintf (stderr, "  * cache exist %u\n", entry->chunk_num);
-				fprintf (stderr, "  * entry: ");
-				for (int i = 0; i < old_entry->ver_len; i++) {
-					if (isprint (old_entry->version[i])) fprintf (stderr, "%c ", old_entry->version[i]);
-					else fprintf (stderr, "%02x ", old_entry->version[i]);
+			if (rc == CefC_CV_Newest_1stArg) {
+				/* csmgrd_stat_cob_update is called in store API called in insert API. */
+				rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, cob->name, cob->name_len);
+				if (ins_f && rcd && cob->ver_len && !rcd->ver_len) {
+					csmgrd_stat_content_info_version_init (
+						csmgr_stat_hdl, rcd, cob->version, cob->ver_len);
 				}
-				fprintf (stderr, "(%d)\n", old_entry->ver_len);
-				fprintf (stderr, "  * cob: ");
-				for (int i = 0; i < cobs[index].ver_len; i++) {
-					if (isprint (cobs[index].version[i])) fprintf (stderr, "%c ", cobs[index].version[i]);
-					else fprintf (stderr, "%02x ", cobs[index].version[i]);
+
+				/* delete thread, which takes over the copy */
+				if ((del_rcd != NULL) &&
+					(write (delete_pipe_fd[0], &del_rcd, sizeof (del_rcd)) != sizeof (del_rcd))) {
+					free (del_rcd->cob_map);
+					free (del_rcd);
 				}
-				fprintf (stderr, "(%d)\n", cobs[index].ver_len);
-#endif //__MEMCACHE_VERSION__
-				if (rc != CefC_CV_Inconsistent) {
-					if (rc == CefC_CV_Newest_1stArg) {
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---New\n");
-#endif //__MEMCACHE_VERSION__
-						if (cef_mem_hash_tbl_item_set (
-							trg_key, trg_key_len, entry, &old_entry) < 0) {
-							free (entry->msg);
-							free (entry->name);
-							if (entry->ver_len)
-								free (entry->version);
-							free (entry);
-							return (-1);
-						}
+			}
+			goto NEXTCOB;
+		}
 
-						rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, entry->name, entry->name_len);
-						rc = cef_csmgr_cache_version_compare (entry->version, entry->ver_len, rcd->version, rcd->ver_len);
-#ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * rcd: ");
-						for (int i = 0; i < rcd->ver_len; i++) {
-							if (isprint (rcd->version[i])) fprintf (stderr, "%c ", rcd->version[i]);
-							else fprintf (stderr, "%02x ", rcd->version[i]);
-						}
-						fprintf (stderr, "(%d)\n", rcd->ver_len);
-#endif //__MEMCACHE_VERSION__
-						if (rc == CefC_CV_Newest_1stArg) {
-							/* Delete the stat record only when the first Cob is received after the version is upgraded. */
-
-							/* copy stat record */
-							del_rcd = (CsmgrT_Stat*) malloc (sizeof (CsmgrT_Stat) + rcd->name_len + rcd->ver_len);
-							del_rcd->name = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat);
-							del_rcd->version = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat) + rcd->name_len;
-							del_rcd->cob_num = rcd->cob_num;
-							del_rcd->min_seq = rcd->min_seq;
-							del_rcd->max_seq = rcd->max_seq;
-							del_rcd->name_len = rcd->name_len;
-							del_rcd->ver_len = rcd->ver_len;
-							memcpy (del_rcd->name, rcd->name, rcd->name_len);
-							if (rcd->ver_len) {
-								memcpy (del_rcd->version, rcd->version, rcd->ver_len);
-							}
-							/* delete stat record */
-							csmgrd_stat_content_info_delete (csmgr_stat_hdl, old_entry->name, old_entry->name_len);
-#ifdef __MEMCACHE_VERSION__
-							fprintf (stderr, "  * delete stat\n");
-#endif //__MEMCACHE_VERSION__
-						}
-						if (old_entry) {
-							free (old_entry->msg);
-							free (old_entry->name);
-							if (old_entry->ver_len)
-								free (old_entry->version);
-							free (old_entry);
-						}
+		/* Caches the content entry without the cache algorithm library 	*/
+		if (hdl->cache_cobs >= hdl->cache_capacity) {
+			goto NEXTCOB;
+		}
 
-						/* Updates the content information 			*/
-						csmgrd_stat_cob_update (csmgr_stat_hdl, entry->name, entry->name_len,
-							entry->chunk_num, entry->pay_len, entry->expiry, nowt, entry->node);
-						rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, entry->name, entry->name_len);
-						if (entry->ver_len && !rcd->ver_len) {
-							csmgrd_stat_content_info_version_init (csmgr_stat_hdl, rcd, entry->version, entry->ver_len);
-						}
+		/* Creates the key 				*/
+		trg_key_len = csmgrd_name_chunknum_concatenate (
+						cob->name, cob->name_len, cob->chunk_num, trg_key);
 
-						if (rc == CefC_CV_Newest_1stArg) {
-							/* delete thread */
-							if (write (delete_pipe_fd[0], del_rcd, sizeof (CsmgrT_Stat)) != sizeof(CsmgrT_Stat)) {
-								;	/* NOP */
-							}
-							if (del_rcd) {
-								free (del_rcd);
-							}
-						}
-					} else if (rc == CefC_CV_Same) {
+		old_entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+		rc = CefC_CV_Newest_1stArg;
+		if (old_entry) {
+			rc = cef_csmgr_cache_version_compare (
+					cob->version, cob->ver_len, old_entry->version, old_entry->ver_len);
 #ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---Same\n");
+			fprintf (stderr, "  * cache exist %u (%d)\n", cob->chunk_num, rc);
 #endif //__MEMCACHE_VERSION__
-						/* cached yet */
-						if (cef_mem_hash_tbl_item_set (
-							trg_key, trg_key_len, entry, &old_entry) < 0) {
-							free (entry->msg);
-							free (entry->name);
-							if (entry->ver_len)
-								free (entry->version);
-							free (entry);
-							return (-1);
-						}
-						if (old_entry) {
-							free (old_entry->msg);
-							free (old_entry->name);
-							if (old_entry->ver_len)
-								free (old_entry->version);
-							free (old_entry);
-						}
-					} else {
+			if ((rc != CefC_CV_Newest_1stArg) && (rc != CefC_CV_Same)) {
+				/* An old version, or an inconsistent version 	*/
+				goto NEXTCOB;
+			}
+		}
+		if (mem_cs_mem_reserve (cob) < 0) {
+			goto NEXTCOB;
+		}
 #ifdef __MEMCACHE_VERSION__
-						fprintf (stderr, "  * ---Old\n");
+		if (old_entry == NULL) {
+			fprintf (stderr, "  * new insert %u\n", cob->chunk_num);
+		}
 #endif //__MEMCACHE_VERSION__
-						free (cobs[index].msg);
-						free (cobs[index].name);
-						if (cobs[index].ver_len) {
-							free (cobs[index].version);
-						}
-					}
-				} else {
+
+		/* Inserts the cache entry 		*/
+		entry = mem_cs_entry_create (cob);
+		if (entry == NULL) {
+			goto NEXTCOB;
+		}
+		if (cef_mem_hash_tbl_item_set (
+			trg_key, trg_key_len, entry, &old_entry) < 0) {
+			mem_cs_entry_free (entry);
+			goto NEXTCOB;
+		}
+		if (old_entry == NULL) {
+			hdl->cache_cobs++;
+		} else if (rc == CefC_CV_Same) {
+			/* cached yet */
+			mem_cs_entry_free (old_entry);
+			goto NEXTCOB;
+		} else {
+			rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, entry->name, entry->name_len);
+			del_rcd = NULL;
+			if ((rcd) &&
+				(cef_csmgr_cache_version_compare (
+					entry->version, entry->ver_len, rcd->version, rcd->ver_len)
+						== CefC_CV_Newest_1stArg)) {
+				/* Delete the stat record only when the first Cob is received after the version is upgraded. */
+
+				/* copy stat record */
+				del_rcd = mem_cache_del_rcd_create (rcd);
+				/* delete stat record */
+				csmgrd_stat_content_info_delete (csmgr_stat_hdl, old_entry->name, old_entry->name_len);
 #ifdef __MEMCACHE_VERSION__
-					fprintf (stderr, "  * ---Inconsistent\n");
+				fprintf (stderr, "  * delete stat\n");
 #endif //__MEMCACHE_VERSION__
-					free (cobs[index].msg);
-					free (cobs[index].name);
-					if (cobs[index].ver_len) {
-						free (cobs[index].version);
-					}
-				}
 			}
+			mem_cs_entry_free (old_entry);
+
+			/* delete thread, which takes over the copy */
+			if ((del_rcd != NULL) &&
+				(write (delete_pipe_fd[0], &del_rcd, sizeof (del_rcd)) != sizeof (del_rcd))) {
+				free (del_rcd->cob_map);
+				free (del_rcd);
+			}
+		}
+
+		/* Updates the content information 			*/
+		csmgrd_stat_cob_update (csmgr_stat_hdl, entry->name, entry->name_len,
+			entry->chunk_num, entry->pay_len, entry->expiry, nowt, entry->node);
+		rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, entry->name, entry->name_len);
+		if (entry->ver_len && rcd && !rcd->ver_len) {
+			csmgrd_stat_content_info_version_init (csmgr_stat_hdl, rcd, entry->version, entry->ver_len);
+		}
+
+NEXTCOB:
+		free (cob->msg);
+		free (cob->name);
+		if (cob->ver_len) {
+			free (cob->version);
 		}
 		index++;
 	}
@@ -1317,11 +1645,21 @@ mem_cs_ac_cnt_inc (
 	uint32_t seq_num							/* sequence number						*/
 ) {
 	CsmgrdT_Content_Mem_Entry* entry;
+	CefT_Mem_Shard* shard;
+	uint32_t hash;
 
-	entry = cef_mem_hash_tbl_item_get (key, key_size);
+	hash  = cef_mem_hash_number_create (key, key_size);
+	shard = cef_mem_hash_shard_get (hash);
+
+	pthread_mutex_lock (&shard->mutex);
+	entry = cef_mem_hash_tbl_item_lookup (shard->hash_tbl, hash, key, key_size);
 	if (!entry) {
+		pthread_mutex_unlock (&shard->mutex);
 		return;
 	}
+	csmgrd_stat_access_count_update (
+			csmgr_stat_hdl, entry->name, entry->name_len);
+	pthread_mutex_unlock (&shard->mutex);
 
 	pthread_mutex_lock (&mem_cs_mutex);
 	if (hdl->algo_apis.hit) {
@@ -1329,9 +1667,6 @@ mem_cs_ac_cnt_inc (
 	}
 	pthread_mutex_unlock (&mem_cs_mutex);
 
-	csmgrd_stat_access_count_update (
-			csmgr_stat_hdl, entry->name, entry->name_len);
-
 	return;
 }
 
@@ -1361,6 +1696,8 @@ mem_config_read (
 	strcpy (params->algo_name, "None");
 	params->algo_name_size = 256;
 	params->algo_cob_size = 2048;
+	params->admission = 0;
+	params->snapshot[0] = 0x00;
 
 	/* Obtains the directory path where the csmgrd's config file is located. */
 #if 0 //+++++ GCC v9 +++++
@@ -1427,6 +1764,33 @@ mem_config_read (
 				return (-1);
 			}
 			params->algo_cob_size = res;
+		} else if (strcmp (option, "CACHE_ADMISSION") == 0) {
+			res = atoi (value);
+			if ((res != 0) && (res != 1)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_ADMISSION must be 0 or 1.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->admission = res;
+		} else if (strcmp (option, "CACHE_SNAPSHOT") == 0) {
+			if (strlen (value) + sizeof (".tmp") > sizeof (params->snapshot)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"[%s] Invalid value %s=%s\n", __func__, option, value);
+				fclose (fp);
+				return (-1);
+			}
+			strcpy (params->snapshot, value);
+		} else if (strcmp (option, "CACHE_MEMORY") == 0) {
+			char *endptr = "";
+			params->cache_memory = strtoul (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) || (params->cache_memory > 1048576)) {
+				csmgrd_log_write (CefC_Log_Error,
+				"CACHE_MEMORY must be higher than or equal to 0 and less than or equal to 1,048,576.\n");
+				fclose (fp);
+				return (-1);
+			}
+			params->cache_memory *= 1024 * 1024;
 		} else if (strcmp (option, "CACHE_CAPACITY") == 0) {
 			char *endptr = "";
 			params->cache_capacity = strtoul (value, &endptr, 0);
@@ -1487,7 +1851,7 @@ static int							/* The return value is negative if an error occurs	*/
 mem_change_cap (
 	uint64_t cap								/* New capacity to set					*/
 ) {
-	int n;
+	int res = 0;
 
 	if (ORG_cache_capacity == 0) {
 		ORG_cache_capacity = hdl->cache_capacity;
@@ -1510,6 +1874,8 @@ mem_change_cap (
 		}
 	}
 
+	pthread_mutex_lock (&mem_cs_mutex);
+
 	/* Recreate algorithm lib */
 	if (hdl->algo_lib) {
 		if (hdl->algo_apis.destroy) {
@@ -1522,38 +1888,23 @@ mem_change_cap (
 	hdl->cache_capacity = cap;
 	hdl->cache_cobs = 0;
 
-	/* Destroy table */
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		CefT_Mem_Hash_Cell* cp;
-		CefT_Mem_Hash_Cell* wcp;
-		cp = mem_hash_tbl->tbl[n];
-		while (cp != NULL) {
-			wcp = cp->next;
-			free (cp->elem);
-			free (cp);
-			cp = wcp;
-		}
-	}
-	free (mem_hash_tbl->tbl);
-	free (mem_hash_tbl);
-
-	/* Creates the memory cache 		*/
-	mem_hash_tbl = cef_mem_hash_tbl_create (hdl->cache_capacity);
-	if (mem_hash_tbl ==  NULL) {
+	/* Destroy table and creates the memory cache 		*/
+	mem_cs_shards_destroy ();
+	if (mem_cs_shards_create (hdl->cache_capacity) < 0) {
 		csmgrd_log_write (CefC_Log_Error, "Unable to create mem hash table\n");
-		return (-1);
+		res = -1;
 	}
 
 	hdl->cache_cobs = 0;
 	/* Recreate algorithm lib */
-	if (hdl->algo_lib) {
+	if ((res == 0) && (hdl->algo_lib)) {
 		if (hdl->algo_apis.init) {
 			(*(hdl->algo_apis.init))(cap, mem_cs_store, mem_cs_remove);
 		}
 	}
+	pthread_mutex_unlock (&mem_cs_mutex);
 
-
-	return (0);
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Set content lifetime
@@ -1568,7 +1919,14 @@ mem_cache_set_lifetime (
 	uint64_t nowt;
 	struct timeval tv;
 	uint64_t new_life;
-	int n;
+	uint64_t* cob_map;
+	uint32_t map_num;
+	uint32_t i;
+	uint64_t word;
+	unsigned char 	trg_key[CsmgrdC_Key_Max];
+	int 			trg_key_len;
+	CefT_Mem_Shard* shard;
+	uint32_t 		hash;
 
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
@@ -1577,28 +1935,36 @@ mem_cache_set_lifetime (
 	/* Updtes the content information */
 	csmgrd_stat_content_lifetime_update (csmgr_stat_hdl, name, name_len, new_life);
 
-	/* Check the cache entry information */
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			continue;
-		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = cp->next) {
-				entry = cp->elem;
-				if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
-					(nowt < entry->cache_time)) {
+	/* Visits only the chunks which are cached 	*/
+	map_num = csmgrd_stat_cob_map_get (csmgr_stat_hdl, name, name_len, &cob_map);
 
-					if (memcmp (name, entry->name, name_len)) {
-						continue;
-					}
-					entry->expiry = new_life;
-					entry->cache_time = new_life;
-				}
+	pthread_mutex_lock (&mem_cs_mutex);
+	for (i = 0 ; i < map_num ; i++) {
+		word = cob_map[i];
+		while (word) {
+			trg_key_len = csmgrd_name_chunknum_concatenate (
+							name, name_len, i * 64 + __builtin_ctzll (word), trg_key);
+			word &= word - 1;
+
+			hash  = cef_mem_hash_number_create (trg_key, trg_key_len);
+			shard = cef_mem_hash_shard_get (hash);
+
+			pthread_mutex_lock (&shard->mutex);
+			entry = cef_mem_hash_tbl_item_lookup (
+						shard->hash_tbl, hash, trg_key, trg_key_len);
+			if ((entry != NULL) &&
+				((entry->expiry == 0) || (nowt < entry->expiry)) &&
+				(nowt < entry->cache_time)) {
+				entry->expiry = new_life;
+				entry->cache_time = new_life;
+				cef_expque_update (shard->hash_tbl->exp_que,
+					entry->exp_pos, cef_mem_hash_exp_time_get (entry));
 			}
+			pthread_mutex_unlock (&shard->mutex);
 		}
 	}
+	pthread_mutex_unlock (&mem_cs_mutex);
+	free (cob_map);
 
 	return (0);
 }
@@ -1636,9 +2002,7 @@ mem_cache_del (
 		csmgr_stat_hdl, entry->name, entry->name_len,
 		entry->chunk_num, entry->pay_len);
 
-	free (entry->msg);
-	free (entry->name);
-	free (entry);
+	mem_cs_entry_free (entry);
 	pthread_mutex_unlock (&mem_cs_mutex);
 
 	return (0);
@@ -1660,7 +2024,11 @@ mem_cache_lifetime_get (
 ) {
 	CsmgrT_Stat* rcd = NULL;
 	CsmgrdT_Content_Mem_Entry* entry;
+	CefT_Mem_Shard* shard;
+	uint32_t hash;
 	uint64_t nowt;
+	uint64_t ins_time;
+	uint64_t expiry;
 	struct timeval tv;
 
 	gettimeofday (&tv, NULL);
@@ -1684,14 +2052,21 @@ mem_cache_lifetime_get (
 
 		for (idx = rcd->min_seq; idx <= rcd->max_seq; idx++) {
 			trg_key_len = csmgrd_name_chunknum_concatenate (name, name_len, idx, trg_key);
-			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+			hash  = cef_mem_hash_number_create (trg_key, trg_key_len);
+			shard = cef_mem_hash_shard_get (hash);
+
+			pthread_mutex_lock (&shard->mutex);
+			entry = cef_mem_hash_tbl_item_lookup (
+						shard->hash_tbl, hash, trg_key, trg_key_len);
 			if (!entry) {
+				pthread_mutex_unlock (&shard->mutex);
 				continue;
 			}
 			if (oldest_ins_time > entry->ins_time)
 				oldest_ins_time = entry->ins_time;
 			if (first_expire > entry->expiry)
 				first_expire = entry->expiry;
+			pthread_mutex_unlock (&shard->mutex);
 		}
 		*cache_time = (uint32_t)((nowt - oldest_ins_time) / 1000000);
 		if (first_expire < nowt)
@@ -1700,13 +2075,24 @@ mem_cache_lifetime_get (
 			*lifetime = (uint32_t)((first_expire - nowt) / 1000000);
 		return (1);
 	} else {
-		entry = cef_mem_hash_tbl_item_get (name, name_len);
-		if ((!entry) ||
-			(nowt > entry->expiry)) {
+		hash  = cef_mem_hash_number_create (name, name_len);
+		shard = cef_mem_hash_shard_get (hash);
+
+		pthread_mutex_lock (&shard->mutex);
+		entry = cef_mem_hash_tbl_item_lookup (shard->hash_tbl, hash, name, name_len);
+		if (!entry) {
+			pthread_mutex_unlock (&shard->mutex);
+			return (-1);
+		}
+		ins_time = entry->ins_time;
+		expiry   = entry->expiry;
+		pthread_mutex_unlock (&shard->mutex);
+
+		if (nowt > expiry) {
 			return (-1);
 		}
-		*cache_time = (uint32_t)((nowt - entry->ins_time) / 1000000);
-		*lifetime   = (uint32_t)((entry->expiry - nowt) / 1000000);
+		*cache_time = (uint32_t)((nowt - ins_time) / 1000000);
+		*lifetime   = (uint32_t)((expiry - nowt) / 1000000);
 		return (1);
 	}
 	return (-1);
@@ -1767,6 +2153,13 @@ cef_mem_hash_tbl_create (
 	}
 	memset (ht->tbl, 0, sizeof (CefT_Mem_Hash_Cell*) * table_size);
 
+	ht->exp_que = cef_expque_create (cef_mem_hash_exp_pos_set);
+	if (ht->exp_que == NULL) {
+		free (ht->tbl);
+		free (ht);
+		return (NULL);
+	}
+
 	srand ((unsigned) time (NULL));
 	ht->elem_max = capacity;
 	ht->tabl_max = table_size;
@@ -1776,6 +2169,36 @@ cef_mem_hash_tbl_create (
 	return (ht);
 }
 
+static void
+cef_mem_hash_tbl_destroy (
+	CefT_Mem_Hash* ht
+) {
+	cef_expque_destroy (ht->exp_que);
+	free (ht->tbl);
+	free (ht);
+}
+
+static void
+cef_mem_hash_exp_pos_set (
+	void* elem,
+	unsigned int pos
+) {
+	((CsmgrdT_Content_Mem_Entry*) elem)->exp_pos = pos;
+}
+
+/*--------------------------------------------------------------------------------------
+	Time when the entry is no longer served
+----------------------------------------------------------------------------------------*/
+static uint64_t
+cef_mem_hash_exp_time_get (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	if ((entry->expiry != 0) && (entry->expiry < entry->cache_time)) {
+		return (entry->expiry);
+	}
+	return (entry->cache_time);
+}
+
 static int
 cef_mem_hash_tbl_item_set (
 	const unsigned char* key,
@@ -1783,14 +2206,39 @@ cef_mem_hash_tbl_item_set (
 	CsmgrdT_Content_Mem_Entry* elem,
 	CsmgrdT_Content_Mem_Entry** old_elem
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
+	CefT_Mem_Shard* shard;
 	uint32_t hash = 0;
+	int res;
+
+	hash  = cef_mem_hash_number_create (key, klen);
+	shard = cef_mem_hash_shard_get (hash);
+
+	pthread_mutex_lock (&shard->mutex);
+	res = cef_mem_hash_tbl_item_insert (shard->hash_tbl, hash, key, klen, elem, old_elem);
+	pthread_mutex_unlock (&shard->mutex);
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the entry to the table of the shard, the caller holds the mutex of the shard
+----------------------------------------------------------------------------------------*/
+static int
+cef_mem_hash_tbl_item_insert (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen,
+	CsmgrdT_Content_Mem_Entry* elem,
+	CsmgrdT_Content_Mem_Entry** old_elem
+) {
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
 	*old_elem = NULL;
 
-	hash = cef_mem_hash_number_create (key, klen);
+	if (ht == NULL) {
+		return (-1);
+	}
 	y = hash % ht->tabl_max;
 
 	if (ht->tbl[y] == NULL) {
@@ -1798,6 +2246,11 @@ cef_mem_hash_tbl_item_set (
 		if (ht->tbl[y] == NULL) {
 			return (-1);
 		}
+		if (cef_expque_push (ht->exp_que, elem, cef_mem_hash_exp_time_get (elem)) < 0) {
+			free (ht->tbl[y]);
+			ht->tbl[y] = NULL;
+			return (-1);
+		}
 		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
 		cp->elem = elem;
@@ -1812,6 +2265,9 @@ cef_mem_hash_tbl_item_set (
 			   (memcmp (cp->key, key, klen) == 0)) {
 				*old_elem = cp->elem;
 				cp->elem = elem;
+				/* never fails, the old one has just left the queue 	*/
+				cef_expque_remove (ht->exp_que, (*old_elem)->exp_pos);
+				cef_expque_push (ht->exp_que, elem, cef_mem_hash_exp_time_get (elem));
 				return (1);
 		   }
 		}
@@ -1819,6 +2275,12 @@ cef_mem_hash_tbl_item_set (
 		wcp = ht->tbl[y];
 		ht->tbl[y] = (CefT_Mem_Hash_Cell* )calloc (1, sizeof (CefT_Mem_Hash_Cell) + klen);
 		if (ht->tbl[y] == NULL) {
+			ht->tbl[y] = wcp;
+			return (-1);
+		}
+		if (cef_expque_push (ht->exp_que, elem, cef_mem_hash_exp_time_get (elem)) < 0) {
+			free (ht->tbl[y]);
+			ht->tbl[y] = wcp;
 			return (-1);
 		}
 		ht->tbl[y]->key = ((unsigned char*)ht->tbl[y]) + sizeof (CefT_Mem_Hash_Cell);
@@ -1832,20 +2294,40 @@ cef_mem_hash_tbl_item_set (
 		return (1);
 	}
 }
+/*--------------------------------------------------------------------------------------
+	Gets the entry, the caller holds mem_cs_mutex which serializes all the updates
+----------------------------------------------------------------------------------------*/
 static CsmgrdT_Content_Mem_Entry*
 cef_mem_hash_tbl_item_get (
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
 	uint32_t hash = 0;
+
+	if (klen > MemC_Max_KLen) {
+		return (NULL);
+	}
+	hash = cef_mem_hash_number_create (key, klen);
+
+	return (cef_mem_hash_tbl_item_lookup (
+				cef_mem_hash_shard_get (hash)->hash_tbl, hash, key, klen));
+}
+/*--------------------------------------------------------------------------------------
+	Gets the entry from the table of the shard
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry*
+cef_mem_hash_tbl_item_lookup (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen
+) {
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 
 	if ((klen > MemC_Max_KLen) || (ht == NULL)) {
 		return (NULL);
 	}
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1862,23 +2344,48 @@ cef_mem_hash_tbl_item_get (
 	return (NULL);
 }
 
+/*--------------------------------------------------------------------------------------
+	Removes the entry, the readers of the shard do not see it after this returns
+----------------------------------------------------------------------------------------*/
 static CsmgrdT_Content_Mem_Entry*
 cef_mem_hash_tbl_item_remove (
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
+	CefT_Mem_Shard* shard;
+	CsmgrdT_Content_Mem_Entry* ret_elem;
 	uint32_t hash = 0;
+
+	if (klen > MemC_Max_KLen) {
+		return (NULL);
+	}
+	hash  = cef_mem_hash_number_create (key, klen);
+	shard = cef_mem_hash_shard_get (hash);
+
+	pthread_mutex_lock (&shard->mutex);
+	ret_elem = cef_mem_hash_tbl_item_delete (shard->hash_tbl, hash, key, klen);
+	pthread_mutex_unlock (&shard->mutex);
+
+	return (ret_elem);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the table of the shard, the caller holds its mutex
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Content_Mem_Entry*
+cef_mem_hash_tbl_item_delete (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
+	const unsigned char* key,
+	uint32_t klen
+) {
 	uint32_t y;
 	CsmgrdT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
 
-	if ((klen > MemC_Max_KLen) || (ht == NULL)) {
+	if (ht == NULL) {
 		return (NULL);
 	}
-
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1891,6 +2398,7 @@ cef_mem_hash_tbl_item_remove (
 		   	ht->tbl[y] = cp->next;
 			ht->elem_num--;
 		   	ret_elem = cp->elem;
+			cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 		   	free (cp);
 		   	return (ret_elem);
 		} else {
@@ -1901,6 +2409,7 @@ cef_mem_hash_tbl_item_remove (
 				   	cp->next = cp->next->next;
 					ht->elem_num--;
 				   	ret_elem = wcp->elem;
+					cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 					free (wcp);
 					return (ret_elem);
 				}
@@ -1925,6 +2434,84 @@ cef_mem_hash_number_create (
 
 	return (hash);
 }
+/*--------------------------------------------------------------------------------------
+	Selects the shard of the hash, the upper bits are not used for the bucket
+----------------------------------------------------------------------------------------*/
+static CefT_Mem_Shard*
+cef_mem_hash_shard_get (
+	uint32_t hash
+) {
+	return (&mem_shards[(hash >> 24) % MemC_Shard_Num]);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the shards of the memory cache
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+mem_cs_shards_create (
+	uint64_t capacity
+) {
+	CefT_Mem_Hash* ht;
+	int s;
+
+	/* The mutexes live as long as the plugin, the lookups may wait on them 	*/
+	if (mem_shard_f == 0) {
+		for (s = 0 ; s < MemC_Shard_Num ; s++) {
+			pthread_mutex_init (&mem_shards[s].mutex, NULL);
+			mem_shards[s].hash_tbl = NULL;
+		}
+		mem_shard_f = 1;
+	}
+
+	for (s = 0 ; s < MemC_Shard_Num ; s++) {
+		ht = cef_mem_hash_tbl_create ((capacity + MemC_Shard_Num - 1) / MemC_Shard_Num);
+		if (ht == NULL) {
+			return (-1);
+		}
+		pthread_mutex_lock (&mem_shards[s].mutex);
+		mem_shards[s].hash_tbl = ht;
+		pthread_mutex_unlock (&mem_shards[s].mutex);
+	}
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the shards and the cached entries
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shards_destroy (
+	void
+) {
+	CefT_Mem_Hash* ht;
+	CefT_Mem_Hash_Cell* cp;
+	CefT_Mem_Hash_Cell* wcp;
+	int i, s;
+
+	if (mem_shard_f == 0) {
+		return;
+	}
+	for (s = 0 ; s < MemC_Shard_Num ; s++) {
+		pthread_mutex_lock (&mem_shards[s].mutex);
+		ht = mem_shards[s].hash_tbl;
+		mem_shards[s].hash_tbl = NULL;
+		pthread_mutex_unlock (&mem_shards[s].mutex);
+
+		if (ht == NULL) {
+			continue;
+		}
+		for (i = 0 ; i < ht->tabl_max ; i++) {
+			cp = ht->tbl[i];
+			while (cp != NULL) {
+				wcp = cp->next;
+				mem_cs_entry_free (cp->elem);
+				free (cp);
+				cp = wcp;
+			}
+		}
+		cef_mem_hash_tbl_destroy (ht);
+	}
+
+	return;
+}
 
 int												/* length of the created key 			*/
 csmgrd_key_create_by_Mem_Entry (
@@ -1991,10 +2578,10 @@ mem_cache_delete_thread (
 	int 					read_fd;
 	struct pollfd 			fds[1];
 	CsmgrT_Stat*			stat_p;
-	unsigned char			buff[CefC_Max_Length*3];
-	int						n;
+	uint32_t				i;
+	uint64_t				word;
+	uint32_t				n;
 	CsmgrdT_Content_Mem_Entry* entry = NULL;
-	uint32_t				min_seq, max_seq;
 	int						rc = CefC_CV_Inconsistent;
 
 	read_fd = *(int *)p;
@@ -2008,52 +2595,46 @@ mem_cache_delete_thread (
 	while (1){
 		poll (fds, 1, 1);
 		if (fds[0].revents & POLLIN) {
-			unsigned char		del_name[CefC_Max_Length] = {0};
-			uint16_t			del_name_len;
-			unsigned char		del_version[CefC_Max_Length] = {0};
-			uint16_t			del_ver_len;
-			if (read (read_fd, buff, sizeof(CsmgrT_Stat)) < sizeof(CsmgrT_Stat)) {
+			if (read (read_fd, &stat_p, sizeof (stat_p)) < sizeof (stat_p)) {
 				continue;
 			}
 
-			stat_p = (CsmgrT_Stat*)buff;
-			min_seq = stat_p->min_seq;
-			max_seq = stat_p->max_seq;
-			del_name_len = stat_p->name_len;
-			memcpy (del_name, stat_p->name, stat_p->name_len);
-			del_ver_len = stat_p->ver_len;
-			if (del_ver_len) {
-				memcpy (del_version, stat_p->version, stat_p->ver_len);
-			}
-
 			pthread_mutex_lock (&mem_cs_mutex);
 
 #ifdef __MEMCACHE_VERSION__
 			fprintf (stderr, "--- mem_cache_delete_thread()\n");
-			fprintf (stderr, "  + delete [%s] %u-%u, cache_cob="FMTU64"\n", del_version, min_seq, max_seq, hdl->cache_cobs);
+			fprintf (stderr, "  + delete [%s] %u-%u, cache_cob="FMTU64"\n", stat_p->version, stat_p->min_seq, stat_p->max_seq, hdl->cache_cobs);
 #endif //__MEMCACHE_VERSION__
 
-			for (n = min_seq; n < max_seq; n++) {
-				unsigned char 	trg_key[CsmgrdC_Key_Max];
-				int 			trg_key_len;
+			/* Visits only the chunks which were cached 	*/
+			for (i = 0 ; i < stat_p->map_max ; i++) {
+				word = stat_p->cob_map[i];
+				while (word) {
+					unsigned char 	trg_key[CsmgrdC_Key_Max];
+					int 			trg_key_len;
 
-				/* Creates the key */
-				trg_key_len = csmgrd_name_chunknum_concatenate (del_name, del_name_len, n, trg_key);
+					n = i * 64 + __builtin_ctzll (word);
+					word &= word - 1;
 
-				entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
-				rc = cef_csmgr_cache_version_compare (del_version, del_ver_len, entry->version, entry->ver_len);
-				if (rc == CefC_CV_Same) {
-					entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
-					if (entry) {
-						if (hdl->algo_apis.erase) {
-							(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+					/* Creates the key */
+					trg_key_len = csmgrd_name_chunknum_concatenate (
+									stat_p->name, stat_p->name_len, n, trg_key);
+
+					entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+					if (entry == NULL) {
+						continue;
+					}
+					rc = cef_csmgr_cache_version_compare (
+							stat_p->version, stat_p->ver_len, entry->version, entry->ver_len);
+					if (rc == CefC_CV_Same) {
+						entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+						if (entry) {
+							if (hdl->algo_apis.erase) {
+								(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+							}
+							hdl->cache_cobs--;
+							mem_cs_entry_free (entry);
 						}
-						hdl->cache_cobs--;
-						free (entry->msg);
-						free (entry->name);
-						if (entry->ver_len)
-							free (entry->version);
-						free (entry);
 					}
 				}
 			}
@@ -2061,10 +2642,225 @@ mem_cache_delete_thread (
 			fprintf (stderr, "  + (*) cache_cobs="FMTU64"\n", hdl->cache_cobs);
 #endif //__MEMCACHE_VERSION__
 			pthread_mutex_unlock (&mem_cs_mutex);
+
+			free (stat_p->cob_map);
+			free (stat_p);
 		}
 	}
 
 	pthread_exit (NULL);
 	return 0;
 }
+/*--------------------------------------------------------------------------------------
+	Copies the stat record of the old version passed to the delete thread
+----------------------------------------------------------------------------------------*/
+static CsmgrT_Stat*
+mem_cache_del_rcd_create (
+	CsmgrT_Stat* rcd
+) {
+	CsmgrT_Stat* del_rcd;
+
+	del_rcd = (CsmgrT_Stat*) calloc (1, sizeof (CsmgrT_Stat) + rcd->name_len + rcd->ver_len);
+	if (del_rcd == NULL) {
+		return (NULL);
+	}
+	del_rcd->name = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat);
+	del_rcd->version = (unsigned char*)del_rcd + sizeof (CsmgrT_Stat) + rcd->name_len;
+	del_rcd->cob_num = rcd->cob_num;
+	del_rcd->min_seq = rcd->min_seq;
+	del_rcd->max_seq = rcd->max_seq;
+	del_rcd->name_len = rcd->name_len;
+	del_rcd->ver_len = rcd->ver_len;
+	memcpy (del_rcd->name, rcd->name, rcd->name_len);
+	if (rcd->ver_len) {
+		memcpy (del_rcd->version, rcd->version, rcd->ver_len);
+	}
+	/* The chunks to delete 	*/
+	del_rcd->map_max = csmgrd_stat_cob_map_get (
+				csmgr_stat_hdl, rcd->name, rcd->name_len, &del_rcd->cob_map);
+
+	return (del_rcd);
+}
+/*--------------------------------------------------------------------------------------
+	Saves the cached cobs to the snapshot file
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_snapshot_save (
+	void
+) {
+	char tmp_path[CefC_Csmgr_File_Path_Length + 8];
+	FILE* fp;
+	CefT_Mem_Hash* ht;
+	CefT_Mem_Hash_Cell* cp;
+	CsmgrdT_Content_Mem_Entry* entry;
+	MemT_Snapshot_Rec rec;
+	uint32_t version = MemC_Snapshot_Version;
+	uint64_t nowt;
+	uint64_t num = 0;
+	struct timeval tv;
+	int ok_f = 1;
+	int i, s;
+
+	if (mem_shard_f == 0) {
+		return;
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	/* The old snapshot is replaced only when the new one is written completely 	*/
+	sprintf (tmp_path, "%s.tmp", mem_snapshot_path);
+	fp = fopen (tmp_path, "w");
+	if (fp == NULL) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to create the snapshot (%s) - %s\n", tmp_path, strerror (errno));
+		return;
+	}
+	if ((fwrite (MemC_Snapshot_Magic, 8, 1, fp) != 1) ||
+		(fwrite (&version, sizeof (uint32_t), 1, fp) != 1)) {
+		ok_f = 0;
+	}
+	for (s = 0 ; (s < MemC_Shard_Num) && (ok_f) ; s++) {
+		pthread_mutex_lock (&mem_shards[s].mutex);
+		ht = mem_shards[s].hash_tbl;
+		for (i = 0 ; (ht) && (i < ht->tabl_max) && (ok_f) ; i++) {
+			for (cp = ht->tbl[i] ; (cp) && (ok_f) ; cp = cp->next) {
+				entry = cp->elem;
+				if (entry->expiry < nowt) {
+					continue;
+				}
+				memset (&rec, 0, sizeof (MemT_Snapshot_Rec));
+				rec.cache_time 	= entry->cache_time;
+				rec.expiry 		= entry->expiry;
+				rec.ins_time 	= entry->ins_time;
+				rec.chunk_num 	= entry->chunk_num;
+				rec.node 		= entry->node.s_addr;
+				rec.msg_len 	= entry->msg_len;
+				rec.name_len 	= entry->name_len;
+				rec.pay_len 	= entry->pay_len;
+				rec.ver_len 	= entry->ver_len;
+				if ((fwrite (&rec, sizeof (MemT_Snapshot_Rec), 1, fp) != 1) ||
+					(fwrite (entry->msg, 1, rec.msg_len, fp) != rec.msg_len) ||
+					(fwrite (entry->name, 1, rec.name_len, fp) != rec.name_len) ||
+					(fwrite (entry->version, 1, rec.ver_len, fp) != rec.ver_len)) {
+					ok_f = 0;
+				}
+				num++;
+			}
+		}
+		pthread_mutex_unlock (&mem_shards[s].mutex);
+	}
+	if ((fflush (fp) != 0) || (fsync (fileno (fp)) < 0)) {
+		ok_f = 0;
+	}
+	fclose (fp);
+
+	if ((ok_f == 0) || (rename (tmp_path, mem_snapshot_path) < 0)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to write the snapshot (%s) - %s\n", mem_snapshot_path, strerror (errno));
+		unlink (tmp_path);
+		return;
+	}
+	csmgrd_log_write (CefC_Log_Info,
+		"Snapshot : "FMTU64" cobs saved to %s\n", num, mem_snapshot_path);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Loads the cobs saved in the snapshot file
+----------------------------------------------------------------------------------------*/
+static void
+mem_cache_snapshot_load (
+	void
+) {
+	FILE* fp;
+	char magic[8];
+	uint32_t version;
+	MemT_Snapshot_Rec rec;
+	CsmgrdT_Content_Entry* cobs;
+	CsmgrdT_Content_Entry* cob;
+	uint64_t num = 0;
+	uint64_t start;
+	struct timeval tv;
+	int cob_num = 0;
+	int end_f = 0;
+
+	fp = fopen (mem_snapshot_path, "r");
+	if (fp == NULL) {
+		return;
+	}
+	if ((fread (magic, 8, 1, fp) != 1) ||
+		(memcmp (magic, MemC_Snapshot_Magic, 8) != 0) ||
+		(fread (&version, sizeof (uint32_t), 1, fp) != 1) ||
+		(version != MemC_Snapshot_Version)) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"%s is not the snapshot of the cache\n", mem_snapshot_path);
+		fclose (fp);
+		return;
+	}
+	cobs = (CsmgrdT_Content_Entry*)
+		calloc (MemC_Write_Batch, sizeof (CsmgrdT_Content_Entry));
+	if (cobs == NULL) {
+		fclose (fp);
+		return;
+	}
+	gettimeofday (&tv, NULL);
+	start = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	/* The cobs are inserted like the received ones, a batch at a time 		*/
+	while (1) {
+		if (fread (&rec, sizeof (MemT_Snapshot_Rec), 1, fp) == 1) {
+			cob = &cobs[cob_num];
+			memset (cob, 0, sizeof (CsmgrdT_Content_Entry));
+			cob->msg 	= (unsigned char*) malloc (rec.msg_len);
+			cob->name 	= (unsigned char*) malloc (rec.name_len);
+			if (rec.ver_len) {
+				cob->version = (unsigned char*) malloc (rec.ver_len);
+			}
+			if ((cob->msg == NULL) || (cob->name == NULL) ||
+				((rec.ver_len) && (cob->version == NULL)) ||
+				(fread (cob->msg, 1, rec.msg_len, fp) != rec.msg_len) ||
+				(fread (cob->name, 1, rec.name_len, fp) != rec.name_len) ||
+				(fread (cob->version, 1, rec.ver_len, fp) != rec.ver_len)) {
+				free (cob->msg);
+				free (cob->name);
+				free (cob->version);
+				end_f = 1;
+			} else {
+				cob->msg_len 	= rec.msg_len;
+				cob->name_len 	= rec.name_len;
+				cob->pay_len 	= rec.pay_len;
+				cob->chunk_num 	= rec.chunk_num;
+				cob->cache_time = rec.cache_time;
+				cob->expiry 	= rec.expiry;
+				cob->node.s_addr = rec.node;
+				cob->ins_time 	= rec.ins_time;
+				cob->ver_len 	= rec.ver_len;
+				cob_num++;
+			}
+		} else {
+			end_f = 1;
+		}
+		if ((cob_num == MemC_Write_Batch) || ((end_f) && (cob_num > 0))) {
+			pthread_mutex_lock (&mem_cs_mutex);
+			mem_cache_cob_write (cobs, cob_num);
+			pthread_mutex_unlock (&mem_cs_mutex);
+			num += cob_num;
+			cob_num = 0;
+		}
+		if (end_f) {
+			break;
+		}
+	}
+	free (cobs);
+	fclose (fp);
+
+	/* The cobs changed after the start are saved again at the stop 		*/
+	unlink (mem_snapshot_path);
+	gettimeofday (&tv, NULL);
+	csmgrd_log_write (CefC_Log_Info,
+		"Snapshot : "FMTU64" cobs loaded from %s ("FMTU64" ms)\n", num, mem_snapshot_path,
+		(tv.tv_sec * 1000000llu + tv.tv_usec - start) / 1000);
+
+	return;
+}
 
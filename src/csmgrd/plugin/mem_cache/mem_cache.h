@@ -66,6 +66,10 @@ typedef struct {
 	int				algo_cob_size;				/* average Cob size of Cob processed 	*/
                                   				/* by algorithm							*/
 	uint64_t 	 	cache_capacity;				/* size of cache capacity				*/
+	uint64_t 	 	cache_memory;				/* bytes of the cached cobs (0: no limit)*/
+	int				admission;					/* 1: TinyLFU admission is used 		*/
+	char			snapshot[CefC_Csmgr_File_Path_Length];
+												/* file to save the cobs at the stop 	*/
 	
 } MemT_Config_Param;
 
@@ -82,8 +86,11 @@ typedef struct {
 	/********** cache algorithm library **********/
 	void* 			algo_lib;					/* records to the loaded library 		*/
 	CsmgrdT_Lib_Interface algo_apis;
+	CefT_Hash_Sketch_Handle admit_sketch;		/* access frequency for the admission	*/
 	
 	uint64_t 		cache_cobs;					/* cached cobs 							*/
+	uint64_t 		cache_memory;				/* bytes of the cached cobs (0: no limit)*/
+	uint64_t 		cache_bytes;				/* bytes of the slab blocks of the cobs	*/
 	
 } MemT_Cache_Handle;
 
@@ -38,6 +38,7 @@
  ****************************************************************************************/
 #include <stdint.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
 #include <cefore/cef_plugin.h>
 #include <cefore/cef_rngque.h>
@@ -91,6 +92,69 @@
 #define CefC_Csmgr_Cmd_MaxLen			1024
 #define CefC_Csmgr_Cmd_ConnOK			"CMD://CsmgrConnOK"
 
+/*------------------------------------------------------------------*/
+/* Shared-memory transport between csmgrd and cefnetd				*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Shm_Magic			0x43534d52	/* "CSMR"							*/
+#define CefC_Csmgr_Shm_Max_Size			1024		/* Max size of the ring (MB)		*/
+#define CefC_Csmgr_Shm_Rec_Wrap			0xFFFFFFFF	/* Record that skips to the top		*/
+#define CefC_Csmgr_Shm_Batch			256			/* Max records read at once			*/
+
+/*------------------------------------------------------------------*/
+/* Batched lookup from cefnetd to csmgrd							*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Lookup_Buff_Max		32768		/* Max size of the bulk message		*/
+#define CefC_Csmgr_Lookup_Window_Max	100000		/* Max coalescing window (usec)		*/
+
+/*------------------------------------------------------------------*/
+/* Presence filter of the contents cached in csmgrd					*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_PT_Presence			0x0f		/* Packet type from csmgrd			*/
+#define CefC_Csmgr_Presence_Snapshot	0x01		/* Part of the whole bitmap			*/
+#define CefC_Csmgr_Presence_Delta		0x02		/* Bit changes						*/
+#define CefC_Csmgr_Presence_Chunk_Max	8192		/* Max bitmap bytes per message		*/
+#define CefC_Csmgr_Presence_Delta_Num	2048		/* Max bit changes per message		*/
+#define CefC_Csmgr_Presence_Interval	100000		/* Cycle to send changes (usec)		*/
+
+/*------------------------------------------------------------------*/
+/* Cluster of csmgrd instances behind one cefnetd					*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Cluster_Max			16			/* Max members of the cluster		*/
+#define CefC_Csmgr_Cluster_Vnode		64			/* Points of a member on the ring	*/
+#define CefC_Csmgr_Cluster_Retry		1000000		/* Cycle to check down member (usec)*/
+#define CefC_Csmgr_Reconnect_Retry		1000000		/* Cycle to connect csmgrd (usec)	*/
+
+/*------------------------------------------------------------------*/
+/* Insert queue and credits from csmgrd								*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_PT_Credit			0x0e		/* Packet type from csmgrd			*/
+#define CefC_Csmgr_Insert_Que_Default	8192		/* Default size of the queue (KB)	*/
+#define CefC_Csmgr_Insert_Que_Max		1048576		/* Max size of the queue (KB)		*/
+#define CefC_Csmgr_Insert_Drop_Newest	0x00		/* Drops the batch to be queued		*/
+#define CefC_Csmgr_Insert_Drop_Oldest	0x01		/* Drops the batches at the head	*/
+#define CefC_Csmgr_Insert_Sample		0x02		/* Queues 1 of N batches near full	*/
+#define CefC_Csmgr_Insert_Sample_Rate	4			/* N of CefC_Csmgr_Insert_Sample	*/
+#define CefC_Csmgr_Insert_Send_Timeout	1000		/* Max wait for the socket (msec)	*/
+#define CefC_Csmgr_Insert_Burst			16			/* Max batches sent at once			*/
+#define CefC_Csmgr_Credit_Interval		10000		/* Cycle to grant credits (usec)	*/
+
+/*------------------------------------------------------------------*/
+/* Disk I/O engine of the filesystem caches							*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Aio_Read				0x00		/* Reads the file into the buffer	*/
+#define CefC_Csmgr_Aio_Write			0x01		/* Writes the buffer to the file	*/
+#define CefC_Csmgr_Aio_Type_Thread		0x00		/* Served by the I/O threads		*/
+#define CefC_Csmgr_Aio_Type_Uring		0x01		/* Served by io_uring				*/
+#define CefC_Csmgr_Aio_Depth			256			/* Entries of the io_uring ring		*/
+#define CefC_Csmgr_Aio_Thread_Max		16			/* Max I/O threads					*/
+
+/*------------------------------------------------------------------*/
+/* Block compression of the filesystem caches						*/
+/*------------------------------------------------------------------*/
+#define CefC_Csmgr_Lz_Hash_Bits			12			/* Bits of the match finder table	*/
+#define CefC_Csmgr_Lz_Min_Match			4			/* Shortest match encoded			*/
+#define CefC_Csmgr_Lz_Max_Off			65535		/* Farthest match encoded			*/
+
 /*------------------------------------------------------------------*/
 /* type of queue entry												*/
 /*------------------------------------------------------------------*/
@@ -121,7 +185,11 @@
 #define CefC_Csmgr_Msg_Type_SCDL		0x13		/* Type Delete cache				*/
 #define CefC_Csmgr_Msg_Type_PreCcninfo	0x14		/* Type Prepare Ccninfo message		*/
 #define CefC_Csmgr_Msg_Type_ContInfo	0x15		/* Type Get Contents Information	*/
-#define CefC_Csmgr_Msg_Type_Num			0x16
+#define CefC_Csmgr_Msg_Type_Shm			0x16		/* Type Attach Shared Memory		*/
+#define CefC_Csmgr_Msg_Type_Bulk_Interest	0x17	/* Type Interest (Bulk)				*/
+#define CefC_Csmgr_Msg_Type_Presence	0x18		/* Type Subscribe Presence Filter	*/
+#define CefC_Csmgr_Msg_Type_Credit		0x19		/* Type Subscribe Insert Credit		*/
+#define CefC_Csmgr_Msg_Type_Num			0x1a
 //#define CefC_Csmgr_Msg_Type_Num			0x15
 
 #define CefC_Csmgr_Cob_Exist			0x00		/* Type Content is exist			*/
@@ -144,6 +212,8 @@
 #define CefC_Csmgr_Interest_ChunkNum_NotExist	0	/* Chunk Num Flag off				*/
 #define CefC_Csmgr_Interest_ChunkNum_Exist		1	/* Chunk Num Flag on				*/
 
+#define CefC_Csmgr_Interest_S_Faceid			4	/* Face-ID trailing the version		*/
+
 /*------------------------------------------------------------------*/
 /* Macros for get csmgr status										*/
 /*------------------------------------------------------------------*/
@@ -197,6 +267,170 @@ typedef enum {
  Structure Declarations
  ****************************************************************************************/
 
+/***** Header of the shared ring csmgrd writes Cobs to	*****/
+typedef struct {
+
+	uint32_t		magic;					/* CefC_Csmgr_Shm_Magic						*/
+	uint32_t		size;					/* Size of the object arena					*/
+	uint64_t		head;					/* Bytes written, updated by csmgrd only	*/
+	unsigned char	rsv1[48];				/* keeps head and tail on other lines		*/
+	uint64_t		tail;					/* Bytes read, updated by cefnetd only		*/
+	unsigned char	rsv2[56];
+
+} CefT_Csmgr_Shm_Hdr;
+
+/***** Mapping of the shared ring	*****/
+typedef struct {
+
+	CefT_Csmgr_Shm_Hdr*	hdr;				/* Header at the top of the mapping			*/
+	unsigned char*		arena;				/* Object arena following the header		*/
+	size_t				map_len;			/* Length of the mapping					*/
+	uint32_t			size;				/* Size of the arena, the peer can change	*/
+											/* the one in the header					*/
+	uint32_t			rec_len;			/* Record returned by the last peek			*/
+
+} CefT_Csmgr_Shm;
+
+/*** csmgrd which takes a part of the contents ***/
+typedef struct {
+
+	char			peer_id_str[NI_MAXHOST];
+	uint16_t		port_num;
+	int				sock;						/* -1 while the member is down			*/
+	int				down_f;						/* 1: cefnetd detected the disconnection*/
+	uint64_t		retry_time;					/* Time to connect it again (usec)		*/
+	int				new_sock;					/* connected by the health check		*/
+	int				fail_f;						/* 1: the sending thread failed to send	*/
+	int				send_ref;					/* sends in progress on the socket		*/
+	unsigned char	rcv_buff[CefC_Max_Length];
+	uint16_t		rcv_len;
+
+} CefT_Csmgr_Member;
+
+/*** point of a member on the consistent hash ring ***/
+typedef struct {
+
+	uint32_t		hash;
+	int				member;
+
+} CefT_Csmgr_Point;
+
+typedef struct {
+
+	/* The main thread of cefnetd owns the sockets of the members, the sending thread	*/
+	/* posts the sockets it connected and the failures under the mutex					*/
+	pthread_mutex_t		mutex;
+	int					member_num;
+	CefT_Csmgr_Member	member[CefC_Csmgr_Cluster_Max];
+	int					point_num;				/* Points sorted by the hash			*/
+	CefT_Csmgr_Point	point[CefC_Csmgr_Cluster_Max * CefC_Csmgr_Cluster_Vnode];
+
+} CefT_Csmgr_Cluster;
+
+/*** batch of Upload Request messages waiting for csmgrd ***/
+typedef struct CefT_Csmgr_Insert_Entry {
+
+	struct CefT_Csmgr_Insert_Entry*	next;
+	int				member;						/* cluster member to send to			*/
+	int				len;						/* length of the batch					*/
+	unsigned char	msg[];
+
+} CefT_Csmgr_Insert_Entry;
+
+/*** queue of the batches sent to csmgrd by the credits ***/
+typedef struct {
+
+	pthread_mutex_t				mutex;			/* protects all members of this queue	*/
+	CefT_Csmgr_Insert_Entry*	head;
+	CefT_Csmgr_Insert_Entry*	tail;
+	uint64_t		size;						/* capacity of the queue (bytes)		*/
+	uint64_t		used;						/* bytes of the queued batches			*/
+	int				policy;						/* CefC_Csmgr_Insert_XXX				*/
+	uint32_t		sample_cnt;					/* batches offered near full			*/
+	int64_t			credit[CefC_Csmgr_Cluster_Max];
+												/* bytes which csmgrd can take now		*/
+	int				credit_f[CefC_Csmgr_Cluster_Max];
+												/* 1: csmgrd grants the credits			*/
+
+	/* Statistics 		*/
+	uint64_t		queued_bytes;
+	uint64_t		sent_bytes;
+	uint64_t		dropped_bytes;
+	uint64_t		retried_bytes;
+	uint64_t		req_dropped;
+
+} CefT_Csmgr_Insert_Que;
+
+/*** disk I/O request served by the engine ***/
+typedef struct CefT_Csmgr_Aio_Req {
+
+	struct CefT_Csmgr_Aio_Req*	next;
+	int				op;							/* CefC_Csmgr_Aio_XXX					*/
+	int				fd;
+	unsigned char*	buf;
+	size_t			len;
+	off_t			off;
+	size_t			done_len;					/* bytes transferred, less than len if	*/
+												/* the read reached the end of file		*/
+	int				err;						/* errno, 0 if the request succeeded	*/
+	struct iovec	iov;						/* rest of the buffer for io_uring		*/
+	void			(*done)(struct CefT_Csmgr_Aio_Req*);
+												/* called by the thread of the engine	*/
+	void*			arg;
+
+} CefT_Csmgr_Aio_Req;
+
+/*** engine which completes the disk I/O requests in the background ***/
+typedef struct {
+
+	int				type;						/* CefC_Csmgr_Aio_Type_XXX				*/
+	pthread_mutex_t	mutex;						/* protects the queue and the SQ ring	*/
+	pthread_cond_t	cond;
+	CefT_Csmgr_Aio_Req*	head;					/* requests waiting to be served		*/
+	CefT_Csmgr_Aio_Req*	tail;
+	int				stop_f;
+	int				thread_num;
+	pthread_t		th[CefC_Csmgr_Aio_Thread_Max];
+
+	/* io_uring 	*/
+	int				ring_fd;
+	unsigned int	inflight;					/* requests submitted to the ring		*/
+	void*			sq_ptr;
+	size_t			sq_size;
+	void*			cq_ptr;
+	size_t			cq_size;
+	void*			sqes;
+	size_t			sqes_size;
+	unsigned int*	sq_tail;
+	unsigned int*	sq_array;
+	unsigned int	sq_mask;
+	unsigned int	sq_entries;
+	unsigned int*	cq_head;
+	unsigned int*	cq_tail;
+	unsigned int	cq_mask;
+	void*			cqes;
+
+	/* Statistics 		*/
+	uint64_t		submitted;
+	uint64_t		failed;
+
+} CefT_Csmgr_Aio;
+
+/********** Statistics of the insert queue 	**********/
+typedef struct {
+
+	uint64_t 		queued_bytes;			/* bytes put into the queue 				*/
+	uint64_t 		sent_bytes;				/* bytes sent to csmgrd 					*/
+	uint64_t 		dropped_bytes;			/* bytes dropped by the policy or errors 	*/
+	uint64_t 		retried_bytes;			/* bytes sent again after EAGAIN 			*/
+	uint64_t 		req_dropped;			/* lookups and other requests dropped 		*/
+	uint64_t 		used;					/* bytes in the queue now 					*/
+	uint64_t 		size;					/* capacity of the queue 					*/
+	int 			policy;					/* CefC_Csmgr_Insert_XXX 					*/
+	int 			credit_f;				/* 1: csmgrd controls the flow 				*/
+
+} CefT_Csmgr_Insert_Stat;
+
 typedef struct {
 
 	/********** Content Store Information	***********/
@@ -238,14 +472,45 @@ typedef struct {
 //	char 			local_sock_name[1024];
 	char 			local_sock_name[2048];
 
+	/********** Socket of the single csmgrd ***********/
+	/* The main thread owns local_sock and tcp_sock, the sending thread posts the	*/
+	/* socket it connected and the failure under the mutex							*/
+	pthread_mutex_t	sock_mutex;
+	int				new_sock;						/* connected by the sending thread		*/
+	int				sock_fail_f;					/* 1: the stream to csmgrd is broken	*/
+	int				sock_ref;						/* sends in progress on the socket		*/
+	uint64_t		sock_retry_time;				/* Time to connect it again (usec)		*/
+
 	/********** local Cache Information ***********/
 	uint32_t		local_cache_capacity;			/* Cache Capacity						*/
+	uint64_t		local_cache_memory;				/* Byte budget (0 means unlimited)		*/
+	int				local_cache_admission;			/* 1: TinyLFU admission is used			*/
 	uint32_t		local_cache_interval;			/* Expired check cycle (sec)			*/
 	int 			pipe_fd[2];						/* socket of cefnetd->Local cache		*/
 													/*  0: for cefnetd						*/
 													/*  1: for Local cache				*/
 	int				to_csmgrd_pipe_fd[2];
 
+	/********** Shared-memory transport ***********/
+	uint32_t		shm_size;						/* Size of the ring (MB), 0: not used	*/
+	CefT_Csmgr_Shm*	shm;							/* Ring csmgrd writes the Cobs to		*/
+
+	/********** Batched lookup ***********/
+	uint32_t		lookup_window;					/* Coalescing window (usec), 0: not used*/
+
+	/********** Presence filter ***********/
+	CefT_Hash_Presence_Handle	presence;			/* Mirror of the csmgrd's filter		*/
+	int				presence_valid;					/* 1: the whole bitmap has been received*/
+	uint32_t		presence_seq;					/* sequence number of the next changes	*/
+
+	/********** csmgrd cluster ***********/
+	CefT_Csmgr_Cluster*	cluster;					/* NULL: single csmgrd is used			*/
+
+	/********** Insert queue ***********/
+	uint32_t		insert_que_size;				/* CSMGR_INSERT_QUEUE (KB)				*/
+	int				insert_policy;					/* CSMGR_INSERT_POLICY					*/
+	CefT_Csmgr_Insert_Que*	insert_que;				/* Batches waiting for the credits		*/
+
 
 } CefT_Cs_Stat;
 
@@ -298,6 +563,15 @@ struct CefT_Csmgr_Status_Hdr {
 
 	uint16_t 		node_num;
 	uint32_t 		con_num;
+	uint64_t 		insert_rcv;				/* bytes of Upload Requests received 		*/
+	uint64_t 		insert_drop;			/* bytes of Upload Requests dropped 		*/
+	uint64_t 		insert_grant;			/* bytes granted to cefnetd(s) 				*/
+	uint64_t 		comp_raw;				/* bytes of the cobs to be stored 			*/
+	uint64_t 		comp_stored;			/* bytes stored for them 					*/
+	uint64_t 		comp_skip;				/* cobs stored raw 							*/
+	uint64_t 		comp_ns;				/* time (ns) spent to compress 				*/
+	uint64_t 		decomp_cobs;			/* cobs decompressed on the hits 			*/
+	uint64_t 		decomp_ns;				/* time (ns) spent to decompress 			*/
 
 } __attribute__((__packed__));
 
@@ -423,6 +697,41 @@ cef_csmgr_excache_lookup (
 	CefT_CcnMsg_OptHdr* poh,				/* Parsed Option Header						*/
 	CefT_Pit_Entry* pe						/* PIT entry								*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the lookups coalesced in the bulk message when the window expires
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_lookup_flush (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int force								/* 1 sends them regardless of the window	*/
+);
+/*--------------------------------------------------------------------------------------
+	Handles the presence filter message from csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_presence_msg_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* payload of the message					*/
+	uint16_t msg_len						/* length of the payload					*/
+);
+/*--------------------------------------------------------------------------------------
+	Handles the credit message from csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_credit_msg_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member which sent it				*/
+	unsigned char* msg,						/* payload of the message					*/
+	uint16_t msg_len						/* length of the payload					*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the insert queue
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_insert_stat_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Csmgr_Insert_Stat* stat
+);
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
@@ -470,6 +779,89 @@ void
 csmgr_sock_close (
 	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
 );
+/*--------------------------------------------------------------------------------------
+	Selects the cluster member which takes the content
+----------------------------------------------------------------------------------------*/
+int									/* Index of the member, -1 if all members are down	*/
+cef_csmgr_cluster_member_select (
+	CefT_Csmgr_Cluster* cluster,
+	const unsigned char* name,				/* Name without chunk (NULL: any member)	*/
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Marks the cluster member connected with the socket as down
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_cluster_member_down (
+	CefT_Csmgr_Cluster* cluster,
+	int sock
+);
+/*--------------------------------------------------------------------------------------
+	Takes the members the sending thread connected or failed to send to
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_cluster_member_update (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Marks the socket of the single csmgrd as broken
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_csmgr_sock_down (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Closes the broken socket of the single csmgrd and takes the one connected again
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_csmgr_sock_update (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the shared ring and hands it over to csmgrd
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_csmgr_shm_connect (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Maps the shared ring received from cefnetd
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*						/* The return value is null if an error occurs		*/
+cef_csmgr_shm_attach (
+	int fd									/* memfd of the shared ring					*/
+);
+/*--------------------------------------------------------------------------------------
+	Unmaps the shared ring
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_destroy (
+	CefT_Csmgr_Shm* shm						/* shared ring								*/
+);
+/*--------------------------------------------------------------------------------------
+	Writes the message to the shared ring (csmgrd side)
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if the ring is full	*/
+cef_csmgr_shm_put (
+	CefT_Csmgr_Shm* shm,					/* shared ring								*/
+	const unsigned char* msg,				/* message to write							*/
+	uint16_t msg_len						/* length of message						*/
+);
+/*--------------------------------------------------------------------------------------
+	Refers to the oldest message in the shared ring (cefnetd side)
+----------------------------------------------------------------------------------------*/
+unsigned char*						/* The return value is null if the ring is empty	*/
+cef_csmgr_shm_peek (
+	CefT_Csmgr_Shm* shm,					/* shared ring								*/
+	uint16_t* msg_len						/* length of message						*/
+);
+/*--------------------------------------------------------------------------------------
+	Releases the message returned by cef_csmgr_shm_peek
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_release (
+	CefT_Csmgr_Shm* shm						/* shared ring								*/
+);
 /*--------------------------------------------------------------------------------------
 	Change str to value
 ----------------------------------------------------------------------------------------*/
@@ -613,6 +1005,48 @@ cef_csmgr_content_info_get (
 	char** info
 );
 
+/*--------------------------------------------------------------------------------------
+	Creates the disk I/O engine, which uses io_uring if the kernel provides it
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Aio*						/* The return value is null if an error occurs		*/
+cef_csmgr_aio_create (
+	int thread_num							/* I/O threads used without io_uring		*/
+);
+/*--------------------------------------------------------------------------------------
+	Submits the disk I/O request, req->done is called when it completes
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_aio_submit (
+	CefT_Csmgr_Aio* aio,
+	CefT_Csmgr_Aio_Req* req
+);
+/*--------------------------------------------------------------------------------------
+	Completes the submitted requests and destroys the disk I/O engine
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_aio_destroy (
+	CefT_Csmgr_Aio* aio
+);
+/*--------------------------------------------------------------------------------------
+	Compresses the block with the fast LZ codec used by the filesystem caches
+----------------------------------------------------------------------------------------*/
+int									/* compressed length, 0 if it exceeds dst_size		*/
+cef_csmgr_lz_compress (
+	const unsigned char* src,				/* block to be compressed					*/
+	int src_len,							/* length of the block						*/
+	unsigned char* dst,						/* buffer for the compressed block			*/
+	int dst_size							/* size of dst								*/
+);
+/*--------------------------------------------------------------------------------------
+	Decompresses the block compressed by cef_csmgr_lz_compress
+----------------------------------------------------------------------------------------*/
+int									/* decompressed length, -1 if the block is broken	*/
+cef_csmgr_lz_decompress (
+	const unsigned char* src,				/* compressed block							*/
+	int src_len,							/* length of the compressed block			*/
+	unsigned char* dst,						/* buffer for the decompressed block		*/
+	int dst_size							/* size of dst								*/
+);
 /*--------------------------------------------------------------------------------------
 	Compare ver1 and ver2
 ----------------------------------------------------------------------------------------*/
@@ -52,6 +52,8 @@
 #include <cefore/cef_define.h>
 #include <cefore/cef_ccninfo.h>
 #include <cefore/cef_log.h>
+#include <cefore/cef_rngque.h>
+#include <cefore/cef_hash.h>
 
 #ifdef	CefC_DB_INDEX
 #include <hiredis/hiredis.h>
@@ -104,6 +106,7 @@ typedef struct CsmgrT_Stat {
 	uint32_t			map_num;		//0.8.3c
 
 	uint64_t 			expiry;
+	unsigned int		exp_pos;		/* position in the expiry queue			*/
 	uint64_t 			cached_time;
 	uint32_t 			min_seq;
 	uint32_t 			max_seq;
@@ -133,6 +136,8 @@ typedef struct {
 	uint64_t			cached_cob_num;
 	CsmgrT_Stat** 		rcds;
 	pthread_mutex_t 	stat_mutex;
+	CefT_Expque*		exp_que;		/* records in the order of expiry		*/
+	CefT_Hash_Presence_Handle	presence;	/* filter of the cached contents		*/
 
 } CsmgrT_Stat_Table;
 //0.8.3c E
@@ -334,6 +339,47 @@ csmgr_stat_content_lifetime_update (
 	uint16_t name_len, 
 	uint64_t expiry
 );
+/*--------------------------------------------------------------------------------------
+	Copies the map of the cached chunk numbers of the specified content
+----------------------------------------------------------------------------------------*/
+uint32_t 									/* words of the map (0: no cached chunk) 	*/
+csmgr_stat_cob_map_get (
+	CsmgrT_Stat_Handle hdl, 
+	const unsigned char* name, 
+	uint16_t name_len, 
+	uint64_t** cob_map							/* the caller frees the copy 				*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the presence filter of the cached contents
+----------------------------------------------------------------------------------------*/
+int 										/* negative if an error occurs 				*/
+csmgr_stat_presence_enable (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t capacity, 
+	double fp_rate
+);
+/*--------------------------------------------------------------------------------------
+	Drains the bit changes of the presence filter
+----------------------------------------------------------------------------------------*/
+int 										/* number of deltas, -1 if the whole bitmap */
+											/* must be sent again 						*/
+csmgr_stat_presence_delta_get (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t* delta, 
+	int max
+);
+/*--------------------------------------------------------------------------------------
+	Copies a part of the bitmap of the presence filter
+----------------------------------------------------------------------------------------*/
+uint32_t 									/* number of copied bytes 					*/
+csmgr_stat_presence_bitmap_read (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t offset, 
+	unsigned char* buff, 
+	uint32_t len, 
+	uint32_t* bit_num, 
+	int* hash_num
+);
 /*--------------------------------------------------------------------------------------
 	Obtains the number of cached content
 ----------------------------------------------------------------------------------------*/
@@ -664,6 +710,8 @@ csmgr_stat_my_node_id_get_db(
 		 csmgr_stat_cache_capacity_update(hdl, capacity)
 #define csmgrd_stat_content_lifetime_update(hdl, name, name_len, expiry) \
 		 csmgr_stat_content_lifetime_update(hdl, name, name_len, expiry)
+#define csmgrd_stat_cob_map_get(hdl, name, name_len, cob_map) \
+		 csmgr_stat_cob_map_get(hdl, name, name_len, cob_map)
 #define csmgrd_stat_cached_con_num_get(hdl) \
 		 csmgr_stat_cached_con_num_get(hdl)
 #define csmgrd_stat_cached_cob_num_get(hdl) \
@@ -137,6 +137,11 @@
 #define CefC_ParamName_CcninfoSha256KeyPrfx	"CCNINFO_SHA256_KEY_PRFX"
 #define CefC_ParamName_CcninfoReplyTimeout	"CCNINFO_REPLY_TIMEOUT"
 
+#define CefC_ParamName_VerifyThreadNum		"VERIFY_THREAD_NUM"
+#define CefC_ParamName_VerifyQueueSize		"VERIFY_QUEUE_SIZE"
+#define CefC_ParamName_VerifyCacheSize		"VERIFY_CACHE_SIZE"
+#define CefC_ParamName_VerifyCacheTtl		"VERIFY_CACHE_TTL"
+
 /*************** Default Values ***************/
 #define CefC_Default_PortNum			9896
 #define CefC_Default_PitSize			65535
@@ -171,6 +176,11 @@
 #define CefC_Default_CcninfoSha256KeyPrfx	"cefore"
 #define CefC_Default_CcninfoReplyTimeout	4
 
+#define CefC_Default_VerifyThreadNum		0		/* verify inline on the main thread 	*/
+#define CefC_Default_VerifyQueueSize		1024
+#define CefC_Default_VerifyCacheSize		0		/* KB, 0 disables the cache 			*/
+#define CefC_Default_VerifyCacheTtl			60		/* sec 									*/
+
 /*************** Applications   ***************/
 #define CefC_App_Version				0xCEF00101
 #define CefC_App_Type_Internal			0x10000000
@@ -72,10 +72,28 @@
 #define CefC_Hash_Coef_Cache		1			/* for Work Buffer, Memory Cache(conpubd/csmgrd),  */
 												/*     Cache Algorithm(csmgrd/conpubd/local cache) */
 
+/* [Frequency sketch used for the cache admission]                                  */
+#define CefC_Hash_Sketch_Depth		4			/* rows of the count-min sketch                    */
+#define CefC_Hash_Sketch_Cnt_Max	15			/* saturation value of a counter                   */
+#define CefC_Hash_Sketch_Width_Min	64
+#define CefC_Hash_Sketch_Width_Max	0x400000
+#define CefC_Hash_Sketch_Sample		10			/* counters are halved after (width * this) adds   */
+#define CefC_Hash_Sketch_Window		64			/* 1 of this many rejected candidates is admitted  */
+
+/* [Presence filter of the contents cached in csmgrd]                               */
+#define CefC_Hash_Presence_Cnt_Max	255			/* a saturated counter is never decremented        */
+#define CefC_Hash_Presence_Bits_Min	1024
+#define CefC_Hash_Presence_Bits_Max	0x10000000
+#define CefC_Hash_Presence_Hash_Max	16
+#define CefC_Hash_Presence_Delta_Max	65536		/* bit changes kept until they are drained         */
+#define CefC_Hash_Presence_Delta_Set	0x80000000	/* flag of the delta which sets the bit            */
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
 typedef size_t CefT_Hash_Handle;
+typedef size_t CefT_Hash_Sketch_Handle;
+typedef size_t CefT_Hash_Presence_Handle;
 
 #if 1
 typedef struct CefT_Hash_Table {
@@ -332,4 +350,107 @@ cef_lhash_tbl_item_check_exact (
 	uint32_t klen
 );
 //----- 0.9.0b : 2022.07.11
+
+/*--------------------------------------------------------------------------------------
+	Frequency sketch (count-min sketch with aging) for the cache admission
+----------------------------------------------------------------------------------------*/
+CefT_Hash_Sketch_Handle
+cef_hash_sketch_create (
+	uint32_t capacity
+);
+void
+cef_hash_sketch_destroy (
+	CefT_Hash_Sketch_Handle handle
+);
+void
+cef_hash_sketch_increment (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+);
+int
+cef_hash_sketch_estimate (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+);
+int
+cef_hash_sketch_admit (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* cand_key,
+	uint32_t cand_klen,
+	const unsigned char* vict_key,
+	uint32_t vict_klen
+);
+
+/*--------------------------------------------------------------------------------------
+	Presence filter (counting Bloom filter) of the cached contents
+----------------------------------------------------------------------------------------*/
+CefT_Hash_Presence_Handle
+cef_hash_presence_create (
+	uint32_t capacity,
+	double fp_rate
+);
+CefT_Hash_Presence_Handle
+cef_hash_presence_mirror_create (
+	uint32_t bit_num,
+	int hash_num
+);
+void
+cef_hash_presence_destroy (
+	CefT_Hash_Presence_Handle handle
+);
+void
+cef_hash_presence_add (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+);
+void
+cef_hash_presence_remove (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+);
+void
+cef_hash_presence_clear (
+	CefT_Hash_Presence_Handle handle
+);
+int
+cef_hash_presence_check (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+);
+void
+cef_hash_presence_info_get (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t* bit_num,
+	int* hash_num
+);
+int
+cef_hash_presence_delta_get (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t* delta,
+	int max
+);
+void
+cef_hash_presence_delta_apply (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t delta
+);
+uint32_t
+cef_hash_presence_bitmap_read (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t offset,
+	unsigned char* buff,
+	uint32_t len
+);
+uint32_t
+cef_hash_presence_bitmap_write (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t offset,
+	const unsigned char* buff,
+	uint32_t len
+);
 #endif // __CEF_HASH_HEADER__
@@ -62,6 +62,7 @@
 #include <cefore/cef_plugin.h>
 #include <cefore/cef_valid.h>
 #include <cefore/cef_log.h>
+#include <cefore/cef_mpool.h>
 #include <cefore/cef_csmgr_stat.h>
 
 #ifdef CefC_Ccore
@@ -116,9 +117,21 @@ typedef struct {
 	uint64_t		cache_time;					/* Cache time							*/
 	uint64_t		expiry;						/* Expiry								*/
 	struct in_addr	node;						/* Node address							*/
+	unsigned int	exp_pos;					/* position in the expiry queue			*/
 
 } CefMemCacheT_Content_Mem_Entry;
 
+/*** occupancy of the local cache ***/
+typedef struct {
+	uint32_t			entry_num;				/* number of cached entries				*/
+	uint32_t			entry_max;				/* maximum number of entries			*/
+	uint64_t			mem_used;				/* bytes charged to the budget			*/
+	uint64_t			mem_max;				/* byte budget (0 means unlimited)		*/
+	uint64_t			evict_num;				/* entries evicted to keep the budget	*/
+	uint64_t			reject_num;				/* entries refused by the admission		*/
+	CefT_Mp_Slab_Stat	slab;					/* storage of the entries				*/
+} CefMemCacheT_Stat;
+
 typedef struct {
 	uint32_t		con_size;
 	uint32_t		con_num;
@@ -140,7 +153,19 @@ typedef struct {
 ----------------------------------------------------------------------------------------*/
 int
 cef_mem_cache_init(
-		uint32_t		capacity
+		uint32_t		capacity,					/* maximum number of entries			*/
+		uint64_t		max_bytes,					/* byte budget (0 means unlimited)		*/
+		int				admission					/* 1 enables the TinyLFU admission		*/
+);
+/*--------------------------------------------------------------------------------------
+	Hands over the parsed content object to the put thread
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_mem_cache_put (
+	unsigned char* msg,							/* content object						*/
+	uint16_t msg_len,							/* length of content object				*/
+	CefT_CcnMsg_MsgBdy* pm,						/* parsed content object				*/
+	CefT_CcnMsg_OptHdr* poh						/* parsed option header					*/
 );
 /*--------------------------------------------------------------------------------------
 	A thread that puts a content object in the local cache
@@ -185,6 +210,13 @@ void
 cef_mem_cache_destroy (
 	void
 );
+/*--------------------------------------------------------------------------------------
+	Gets the occupancy of local cache
+----------------------------------------------------------------------------------------*/
+void
+cef_mem_cache_stat_get (
+	CefMemCacheT_Stat* stat
+);
 /*--------------------------------------------------------------------------------------
 	Function to increment access count
 ----------------------------------------------------------------------------------------*/
@@ -40,6 +40,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 #include <cefore/cef_define.h>
@@ -60,6 +61,21 @@
  Structures Declaration
  ****************************************************************************************/
 typedef size_t CefT_Mp_Handle;
+typedef size_t CefT_Mp_Slab_Handle;
+
+/*
+ * Occupancy of a slab. used_bytes - req_bytes is the internal fragmentation and
+ * reserved_bytes - used_bytes is the memory pooled but not used.
+ */
+typedef struct CefT_Mp_Slab_Stat {
+	uint64_t		reserved_bytes;			/* bytes of the blocks held by the pools 	*/
+	uint64_t		used_bytes;				/* bytes of the blocks in use 				*/
+	uint64_t		req_bytes;				/* bytes requested by the users 			*/
+	uint64_t		obj_num;				/* number of the objects in use 			*/
+	uint64_t		large_num;				/* objects larger than the largest class 	*/
+	uint64_t		large_bytes;
+	int				class_num;				/* number of size classes in use 			*/
+} CefT_Mp_Slab_Stat;
 
 /****************************************************************************************
  Function declaration
@@ -86,4 +102,45 @@ cef_mpool_free (
 	CefT_Mp_Handle ph,
 	void* ptr
 );
+
+CefT_Mp_Slab_Handle
+cef_mpool_slab_init (
+	const char* 	key,
+	size_t 			max_size
+);
+
+void
+cef_mpool_slab_destroy (
+	CefT_Mp_Slab_Handle sh
+);
+
+void*
+cef_mpool_slab_alloc (
+	CefT_Mp_Slab_Handle sh,
+	size_t size
+);
+
+void
+cef_mpool_slab_free (
+	CefT_Mp_Slab_Handle sh,
+	void* ptr,
+	size_t size
+);
+
+size_t
+cef_mpool_slab_block_size (
+	CefT_Mp_Slab_Handle sh,
+	size_t size
+);
+
+void
+cef_mpool_slab_stat_get (
+	CefT_Mp_Slab_Handle sh,
+	CefT_Mp_Slab_Stat* stat
+);
+
+uint64_t
+cef_mpool_slab_trim (
+	CefT_Mp_Slab_Handle sh
+);
 #endif // __CEF_MPOOL_HEADER__
@@ -38,12 +38,23 @@
  ****************************************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <pthread.h>
 
 /****************************************************************************************
  Macros
  ****************************************************************************************/
 
+/********** Types of the ring queue 	**********/
+#define CefC_Rngque_Type_Mutex		0		/* any producers/consumers, mutex guarded 	*/
+#define CefC_Rngque_Type_Spsc		1		/* lock-free, single producer/consumer 		*/
+#define CefC_Rngque_Type_Mpsc		2		/* lock-free, multi producer/single consumer*/
+
+#define CefC_Rngque_Cline			64		/* size of the cache line 					*/
+
+/********** Expiry queue 	**********/
+#define CefC_Expque_Invalid			0xFFFFFFFF	/* position of the body not in the queue 	*/
+#define CefC_Expque_Init_Size		1024		/* initial number of slots 					*/
 
 /****************************************************************************************
  Structure Declarations
@@ -52,20 +63,49 @@
 typedef struct {
 
 	void* 	body;
+	unsigned int seq;				/* sequence of the slot (MPSC only) 				*/
 
 } CefT_Rngque_Elem;
 
 /********** Tx queue (ring buffer) 	**********/
 typedef struct {
 
-	int top;						/* top of the ring buffer 							*/
-	int bottom;						/* bottom of the ring buffer 						*/
-	int mask;						/* capacity of the ring buffer 						*/
+	int type;						/* CefC_Rngque_Type_XXX 							*/
+	unsigned int mask;				/* capacity of the ring buffer 						*/
 	CefT_Rngque_Elem* que;			/* line buffer 										*/
-	pthread_mutex_t mutex;			/* mutex for thread safe 							*/
-	
+	pthread_mutex_t mutex;			/* mutex for thread safe (CefC_Rngque_Type_Mutex) 	*/
+	char pad0[CefC_Rngque_Cline];
+
+	/* Consumer side 	*/
+	volatile unsigned int top;		/* top of the ring buffer 							*/
+	unsigned int bottom_cache;		/* last bottom seen by the consumer (SPSC) 			*/
+	char pad1[CefC_Rngque_Cline];
+
+	/* Producer side 	*/
+	volatile unsigned int bottom;	/* bottom of the ring buffer 						*/
+	unsigned int top_cache;			/* last top seen by the producer (SPSC) 			*/
+	char pad2[CefC_Rngque_Cline];
+
 } CefT_Rngque;
 
+/********** Expiry queue (binary min-heap ordered by the time) 	**********/
+typedef struct {
+
+	uint64_t 	time;				/* time when the body expires 						*/
+	void* 		body;
+
+} CefT_Expque_Elem;
+
+typedef struct {
+
+	CefT_Expque_Elem* heap;
+	unsigned int num;				/* number of the queued bodies 						*/
+	unsigned int max;				/* number of the allocated slots 					*/
+	/* records the position of the body in the queue, which is passed to remove/update	*/
+	void (*pos_set)(void* body, unsigned int pos);
+
+} CefT_Expque;
+
 /****************************************************************************************
  Global Variables
  ****************************************************************************************/
@@ -80,6 +120,14 @@ CefT_Rngque* 								/* Created Ring Queue Information 			*/
 cef_rngque_create (
 	int capacity							/* Capacity of Ring queue 					*/
 );
+/*--------------------------------------------------------------------------------------
+	Creates Ring Queue of the specified type
+----------------------------------------------------------------------------------------*/
+CefT_Rngque* 								/* Created Ring Queue Information 			*/
+cef_rngque_create_ext (
+	int capacity,							/* Capacity of Ring queue 					*/
+	int type								/* CefC_Rngque_Type_XXX 					*/
+);
 void
 cef_rngque_destroy (
 	CefT_Rngque* qp							/* Ring Queue Information 					*/
@@ -102,5 +150,59 @@ void*										/* item which is removed from queue 		*/
 cef_rngque_read (
 	CefT_Rngque* qp							/* Ring Queue Information 					*/
 );
+/*--------------------------------------------------------------------------------------
+	Inserts the items to the bottom of Ring Queue
+----------------------------------------------------------------------------------------*/
+int 										/* number of inserted items 				*/
+cef_rngque_push_batch (
+	CefT_Rngque* qp, 						/* Ring Queue Information 					*/
+	void** items,
+	int num
+);
+/*--------------------------------------------------------------------------------------
+	Removes the items from the top of Ring Queue
+----------------------------------------------------------------------------------------*/
+int 										/* number of removed items 					*/
+cef_rngque_pop_batch (
+	CefT_Rngque* qp, 						/* Ring Queue Information 					*/
+	void** items,
+	int num
+);
+
+/*--------------------------------------------------------------------------------------
+	Expiry queue
+	The caller serializes the accesses. pos_set() is called whenever the position of
+	a body changes, and with CefC_Expque_Invalid when the body leaves the queue.
+----------------------------------------------------------------------------------------*/
+CefT_Expque* 								/* Created Expiry Queue 					*/
+cef_expque_create (
+	void (*pos_set)(void*, unsigned int)	/* records the position in the body 		*/
+);
+void
+cef_expque_destroy (
+	CefT_Expque* eq
+);
+int 										/* negative value if an error occurs 		*/
+cef_expque_push (
+	CefT_Expque* eq,
+	void* body,
+	uint64_t time
+);
+void
+cef_expque_remove (
+	CefT_Expque* eq,
+	unsigned int pos						/* position recorded by pos_set() 			*/
+);
+void
+cef_expque_update (
+	CefT_Expque* eq,
+	unsigned int pos,						/* position recorded by pos_set() 			*/
+	uint64_t time
+);
+void* 										/* NULL if no body has expired 				*/
+cef_expque_pop_expired (
+	CefT_Expque* eq,
+	uint64_t nowt
+);
 
 #endif // __CEF_NETD_HEADER__
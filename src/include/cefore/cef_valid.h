@@ -38,15 +38,62 @@
  ****************************************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 /****************************************************************************************
  Macros
  ****************************************************************************************/
 
+#define CefC_Valid_Pool_Thread_Max		64		/* maximum number of verify threads		*/
+#define CefC_Valid_Pool_Que_Max			65535	/* maximum number of queued jobs		*/
+
+/********** Engines of the CRC32 calculation 	**********/
+#define CefC_Crc_Engine_Auto			0		/* fastest one the CPU supports			*/
+#define CefC_Crc_Engine_Bytewise		1		/* one table lookup per byte			*/
+#define CefC_Crc_Engine_Slice8			2		/* slice-by-8 tables					*/
+#define CefC_Crc_Engine_Pclmul			3		/* PCLMULQDQ folding and slice-by-8		*/
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
 
+/********** Job of the verification offload pool 	**********/
+typedef struct {
+
+	unsigned char* 	msg;					/* message to verify 						*/
+	int 			msg_len;				/* length of the message 					*/
+	int 			res;					/* result of cef_valid_msg_verify 			*/
+	void* 			arg;					/* owner's context 							*/
+
+} CefT_Valid_Job;
+
+/********** Statistics of the verification offload pool 	**********/
+typedef struct {
+
+	uint64_t 		push_num;				/* number of the queued jobs 				*/
+	uint64_t 		done_num;				/* number of the verified jobs 				*/
+	uint64_t 		ng_num;					/* number of the jobs failed to verify 		*/
+	uint64_t 		full_num;				/* number of the jobs rejected since the 	*/
+											/* pool was full (backpressure)				*/
+	int 			que_num;				/* number of jobs in the pool 				*/
+	int 			que_max;				/* maximum number of jobs ever in the pool	*/
+	int 			que_size;				/* capacity of the pool 					*/
+	int 			thread_num;				/* number of the worker threads 			*/
+
+} CefT_Valid_Pool_Stat;
+
+/********** Statistics of the verified-object cache 	**********/
+typedef struct {
+
+	uint64_t 		hit_num;				/* number of the cache hits 				*/
+	uint64_t 		miss_num;				/* number of the cache misses 				*/
+	uint64_t 		evict_num;				/* number of the evicted live entries 		*/
+	uint64_t 		invalidate_num;			/* number of the invalidated entries 		*/
+	uint32_t 		entry_num;				/* number of the unexpired entries 			*/
+	uint32_t 		entry_max;				/* capacity of the cache 					*/
+
+} CefT_Valid_Vcache_Stat;
+
 /****************************************************************************************
  Global Variables
  ****************************************************************************************/
@@ -75,6 +122,10 @@ int
 cef_valid_type_get (
 	const char* type
 );
+int 								/* Returns a negative value if it is not available	*/
+cef_valid_crc_engine_set (
+	int engine 						/* CefC_Crc_Engine_XXX 								*/
+);
 uint32_t
 cef_valid_crc32_calc (
 	const unsigned char* buf,
@@ -107,6 +158,57 @@ cef_valid_msg_verify (
 	const unsigned char* msg,
 	int msg_len
 );
+int 								/* Validation Algorithm Type (CefC_T_XXX). 			*/
+									/* CefC_T_ALG_INVALID means no validation and a 	*/
+									/* negative value means the malformed message. 		*/
+cef_valid_msg_alg_get (
+	const unsigned char* msg,
+	int msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Verification offload pool
+----------------------------------------------------------------------------------------*/
+int 								/* Returns a negative value if it fails 			*/
+cef_valid_pool_init (
+	int thread_num, 				/* number of the worker threads 					*/
+	int que_size 					/* maximum number of jobs in the pool 				*/
+);
+void
+cef_valid_pool_destroy (
+	void
+);
+int 								/* Returns 1 if queued, 0 if the pool is full		*/
+cef_valid_pool_push (
+	CefT_Valid_Job* job
+);
+CefT_Valid_Job* 					/* completed job, or NULL if there is none 			*/
+cef_valid_pool_pop (
+	void
+);
+void
+cef_valid_pool_stat_get (
+	CefT_Valid_Pool_Stat* stat
+);
+/*--------------------------------------------------------------------------------------
+	Verified-object cache
+----------------------------------------------------------------------------------------*/
+int 								/* Returns a negative value if it fails 			*/
+cef_valid_vcache_init (
+	size_t mem_size, 				/* upper limit of the memory [bytes] 				*/
+	uint32_t ttl 					/* lifetime of the cached result [sec] 				*/
+);
+void
+cef_valid_vcache_destroy (
+	void
+);
+int 								/* number of the removed entries 					*/
+cef_valid_vcache_flush (
+	void
+);
+void
+cef_valid_vcache_stat_get (
+	CefT_Valid_Vcache_Stat* stat
+);
 
 int
 cef_valid_keyid_create_forccninfo (
@@ -32,14 +32,28 @@
 
 #define __CEF_CSMGR_SOURCE__
 
-//#define	__DEV_CEF_CSMGR_SEND__
+#define _GNU_SOURCE
 
 #define		CEF_CSMGR_SEND_USLEEP	100000
-#define		CEF_CSMGR_SEND_TIMEOUT	10000
 
 /****************************************************************************************
  Include Files
  ****************************************************************************************/
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define CefC_Csmgr_Aio_Uring
+#endif
+#endif
+#endif // __linux__
+
 #include <cefore/cef_client.h>
 #include <cefore/cef_csmgr.h>
 #include <cefore/cef_define.h>
@@ -62,8 +76,6 @@ uint32_t bchunk = 0xFFFF;
 #define	BUFF_SIZE	0
 #endif
 
-#define	DEMO_RETRY_NUM	10
-
 
 /****************************************************************************************
  Structures Declaration
@@ -76,8 +88,15 @@ uint32_t bchunk = 0xFFFF;
 
 static unsigned char* 	cefnetd_msg_buff 		= NULL;
 static int 				cefnetd_msg_buff_index 	= 0;
+static int 				cefnetd_msg_buff_member = 0;
 static unsigned char* 	work_msg_buff 			= NULL;
 
+/* Bulk Interest message in which the lookups are coalesced 	*/
+static unsigned char 	cefnetd_lookup_buff[CefC_Csmgr_Lookup_Buff_Max];
+static int 				cefnetd_lookup_buff_index 	= 0;
+static uint64_t 		cefnetd_lookup_flush_time 	= 0;
+static int 				cefnetd_lookup_buff_member 	= 0;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -100,7 +119,8 @@ cef_csmgr_interest_msg_create (
 	unsigned char buff[],					/* Interest message							*/
 	uint16_t* index,						/* Length of message						*/
 	CefT_CcnMsg_OptHdr* poh,				/* Parsed Option Header						*/
-	CefT_CcnMsg_MsgBdy* pm					/* Parsed CEFORE message					*/
+	CefT_CcnMsg_MsgBdy* pm,					/* Parsed CEFORE message					*/
+	int faceid								/* Face-ID which received the Interest		*/
 );
 /*--------------------------------------------------------------------------------------
 	Connect csmgr local socket
@@ -115,9 +135,130 @@ cef_csmgr_csmgr_connect_local (
 static int							/* The return value is negative if an error occurs	*/
 cef_csmgr_send_msg_to_csmgr (
 	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member to send to				*/
 	unsigned char* msg,						/* send message								*/
 	int msg_len								/* message length							*/
 );
+/*--------------------------------------------------------------------------------------
+	Requests csmgrd to send the presence filter
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_presence_subscribe (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int sock								/* socket to send to (-1: the pipe)			*/
+);
+/*--------------------------------------------------------------------------------------
+	Connects to csmgrd to send a request about the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_ctrl_connect (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	const unsigned char* name,				/* Name which selects the member (or NULL)	*/
+	uint16_t name_len
+);
+/*--------------------------------------------------------------------------------------
+	Reads the members of the cluster from the value of CSMGR_CLUSTER
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_cluster_config_parse (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	char* value								/* host:port list separated by commas		*/
+);
+/*--------------------------------------------------------------------------------------
+	Checks the members and connects again the member which was down
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_cluster_health_check (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Requests csmgrd to grant the credits for the Upload Requests
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_credit_subscribe (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member connected with the socket	*/
+	int sock								/* socket connected to csmgrd				*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the insert queue
+----------------------------------------------------------------------------------------*/
+static CefT_Csmgr_Insert_Que*		/* The return value is null if an error occurs		*/
+cef_csmgr_insert_que_create (
+	uint64_t size,							/* capacity of the queue (bytes)			*/
+	int policy								/* CefC_Csmgr_Insert_XXX					*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the insert queue
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_insert_que_destroy (
+	CefT_Csmgr_Insert_Que* que
+);
+/*--------------------------------------------------------------------------------------
+	Puts the batch of Upload Requests into the insert queue
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_insert_que_push (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member to send to				*/
+	unsigned char* msg,						/* batch of Upload Request messages			*/
+	int msg_len								/* length of the batch						*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the batches in the insert queue as far as the credits allow
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the batches which can be sent remain		*/
+cef_csmgr_insert_que_send (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the message read from the pipe to csmgrd
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_pipe_msg_send (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* message read from the pipe				*/
+	int msg_len								/* message length							*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the socket connected to the member of csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is -1 if the member is down		*/
+cef_csmgr_member_sock_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member								/* cluster member (0 for single csmgrd)		*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the socket obtained by cef_csmgr_member_sock_get
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_member_sock_put (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member (0 for single csmgrd)		*/
+	int res									/* negative if the send failed				*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the capacity message to the csmgrd connected with the socket
+----------------------------------------------------------------------------------------*/
+#ifdef CefC_Ccore
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_capacity_msg_send (
+	int sock,								/* socket connected to csmgrd				*/
+	uint8_t msg_type,						/* CefC_Csmgr_Msg_Type_RCap or SCap			*/
+	uint64_t* cap							/* Capacity									*/
+);
+#endif // CefC_Ccore
+/*--------------------------------------------------------------------------------------
+	Sends the whole message to the socket of csmgrd without dropping a part
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_sock_send_all (
+	int sock,
+	unsigned char* msg,
+	int msg_len,
+	uint64_t* retried						/* bytes which had to wait for the socket	*/
+);
 
 
 /****************************************************************************************
@@ -146,6 +287,8 @@ cef_csmgr_stat_create (
 	cs_stat->tx_que = NULL;
 	cs_stat->local_sock = -1;
 	cs_stat->tcp_sock 	= -1;
+	cs_stat->new_sock 	= -1;
+	pthread_mutex_init (&cs_stat->sock_mutex, NULL);
 	cs_stat->pipe_fd[0] = -1;
 	cs_stat->pipe_fd[1] = -1;
 	cs_stat->to_csmgrd_pipe_fd[0] = -1;
@@ -169,6 +312,23 @@ cef_csmgr_stat_create (
 	}
 
 	if (cs_stat->cache_type == CefC_Cache_Type_Excache) {
+		cs_stat->insert_que = cef_csmgr_insert_que_create (
+				(uint64_t) cs_stat->insert_que_size * 1024, cs_stat->insert_policy);
+		if (cs_stat->insert_que == NULL) {
+			cef_csmgr_stat_destroy (&cs_stat);
+			cef_log_write (CefC_Log_Error, "%s (create insert queue)\n", __func__);
+			return (NULL);
+		}
+		if (cs_stat->cluster != NULL) {
+			/* Members which are down now join the cluster by the health check 	*/
+			cef_csmgr_cluster_health_check (cs_stat);
+			cef_csmgr_cluster_member_update (cs_stat);
+			if (cef_csmgr_cluster_member_select (cs_stat->cluster, NULL, 0) < 0) {
+				cef_csmgr_stat_destroy (&cs_stat);
+				cef_log_write (CefC_Log_Error, "%s (connect to csmgrd cluster)\n", __func__);
+				return (NULL);
+			}
+		} else
 		if ((strcmp (cs_stat->peer_id_str, "localhost")) &&
 			(strcmp (cs_stat->peer_id_str, "127.0.0.1"))) {
 			sprintf (port_str, "%d", cs_stat->tcp_port_num);
@@ -179,6 +339,7 @@ cef_csmgr_stat_create (
 				cef_log_write (CefC_Log_Error, "%s (connect to csmgrd)\n", __func__);
 				return (NULL);
 			}
+			cef_csmgr_credit_subscribe (cs_stat, 0, cs_stat->tcp_sock);
 		} else {
 			cs_stat->local_sock = cef_csmgr_csmgr_connect_local (cs_stat);
 
@@ -187,6 +348,12 @@ cef_csmgr_stat_create (
 				cef_log_write (CefC_Log_Error, "%s (connect to csmgrd)\n", __func__);
 				return (NULL);
 			}
+			cef_csmgr_credit_subscribe (cs_stat, 0, cs_stat->local_sock);
+			/* csmgrd returns the Cobs through the shared ring if it is enabled 	*/
+			if ((cs_stat->shm_size > 0) && (cef_csmgr_shm_connect (cs_stat) < 0)) {
+				cef_log_write (CefC_Log_Warn,
+					"Shared-memory transport is not available, so the socket is used\n");
+			}
 		}
 
 		/*###########*/
@@ -222,6 +389,7 @@ cef_csmgr_stat_create (
 		}
 		}
 		/*###########*/
+		cef_csmgr_presence_subscribe (cs_stat, -1);
 	}
 #ifdef CefC_Conpub
 	else
@@ -247,36 +415,11 @@ cef_csmgr_stat_create (
 		}
 	}
 #endif //CefC_Conpub
-#ifdef CefC_CefnetdCache
-	else
-	if (cs_stat->cache_type == CefC_Cache_Type_Localcache) {
-		int flags;
-		/* Create socket for communication between cednetd and memory cache */
-		if ( socketpair(AF_UNIX,SOCK_DGRAM, 0, cs_stat->pipe_fd) == -1 ) {
-			cef_csmgr_stat_destroy (&cs_stat);
-			cef_log_write (CefC_Log_Error, "%s pair socket creation error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-	  	}
-		/* Set cefnetd side socket as non-blocking I/O */
-		if ( (flags = fcntl(cs_stat->pipe_fd[0], F_GETFL, 0) ) < 0) {
-			cef_log_write (CefC_Log_Error, "%s fcntl error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-		}
-		flags |= O_NONBLOCK;
-		if (fcntl(cs_stat->pipe_fd[0], F_SETFL, flags) < 0) {
-			cef_log_write (CefC_Log_Error, "%s fcntl error (%s)\n"
-							, __func__, strerror(errno));
-			return (NULL);
-		}
-	}
-#endif
 
 	/* Create memory cache */
 	if (cs_stat->cache_type != CefC_Default_Cache_Type) {
 		/* create Cs_Tx_Que */
-		cs_stat->tx_que = cef_rngque_create (CefC_Tx_Que_Size);
+		cs_stat->tx_que = cef_rngque_create_ext (CefC_Tx_Que_Size, CefC_Rngque_Type_Mpsc);
 		cs_stat->tx_cob_mp = cef_mpool_init (
 										"CefCsCobQue",
 										sizeof (CefT_Cs_Tx_Elem_Cob),
@@ -331,7 +474,8 @@ cef_csmgr_stat_create (
 			pthread_t cef_mem_cache_put_th;
 			pthread_t cef_mem_cache_clear_th;
 			int rtc;
-			rtc = cef_mem_cache_init (cs_stat->cache_cap);
+			rtc = cef_mem_cache_init (cs_stat->cache_cap, cs_stat->local_cache_memory,
+									cs_stat->local_cache_admission);
 			if(rtc != 0){
 				cef_csmgr_stat_destroy (&cs_stat);
 				cef_log_write (CefC_Log_Error
@@ -340,7 +484,7 @@ cef_csmgr_stat_create (
 				return (NULL);
 			}
 			if (pthread_create(&cef_mem_cache_put_th, NULL
-							, &cef_mem_cache_put_thread, &(cs_stat->pipe_fd[1])) == -1) {
+							, &cef_mem_cache_put_thread, NULL) == -1) {
 				cef_csmgr_stat_destroy (&cs_stat);
 				cef_log_write (CefC_Log_Error
 								, "%s Failed to create the new thread(cef_mem_cache_put_thead)\n"
@@ -453,8 +597,12 @@ cef_csmgr_config_read (
 	cs_stat->cache_cap 		= CefC_Default_Cache_Capacity;
 	cs_stat->tcp_port_num 	= CefC_Default_Tcp_Prot;
 	strcpy (cs_stat->peer_id_str, CefC_Default_Node_Path);
+	cs_stat->insert_que_size = CefC_Csmgr_Insert_Que_Default;
+	cs_stat->insert_policy 	= CefC_Csmgr_Insert_Drop_Newest;
 #ifdef CefC_CefnetdCache
 	cs_stat->local_cache_capacity = 65535;
+	cs_stat->local_cache_memory = 0;
+	cs_stat->local_cache_admission = 0;
 	cs_stat->local_cache_interval = 60;
 #endif //CefC_CefnetdCache
 
@@ -510,6 +658,55 @@ cef_csmgr_config_read (
 			}
 			strcpy (local_sock_id, value);
 		}
+		else if (strcmp (option, "CSMGR_CLUSTER") == 0) {
+			if (cef_csmgr_cluster_config_parse (cs_stat, value) < 0) {
+				fclose (fp);
+				return (-1);
+			}
+		}
+		else if (strcmp (option, "CSMGR_SHM_SIZE") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res < 0) || (res > CefC_Csmgr_Shm_Max_Size)) {
+				cef_log_write (CefC_Log_Error,
+					"CSMGR_SHM_SIZE must be higher than or equal to 0 and less than or equal to %d.\n",
+					CefC_Csmgr_Shm_Max_Size);
+				return (-1);
+			}
+			cs_stat->shm_size = (uint32_t) res;
+		}
+		else if (strcmp (option, "CSMGR_LOOKUP_WINDOW") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res < 0) || (res > CefC_Csmgr_Lookup_Window_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"CSMGR_LOOKUP_WINDOW must be higher than or equal to 0 and less than or equal to %d.\n",
+					CefC_Csmgr_Lookup_Window_Max);
+				return (-1);
+			}
+			cs_stat->lookup_window = (uint32_t) res;
+		}
+		else if (strcmp (option, "CSMGR_INSERT_QUEUE") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res < 128) || (res > CefC_Csmgr_Insert_Que_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"CSMGR_INSERT_QUEUE must be higher than or equal to 128 and less than or equal to %d.\n",
+					CefC_Csmgr_Insert_Que_Max);
+				return (-1);
+			}
+			cs_stat->insert_que_size = (uint32_t) res;
+		}
+		else if (strcmp (option, "CSMGR_INSERT_POLICY") == 0) {
+			if (strcasecmp (value, "drop_newest") == 0) {
+				cs_stat->insert_policy = CefC_Csmgr_Insert_Drop_Newest;
+			} else if (strcasecmp (value, "drop_oldest") == 0) {
+				cs_stat->insert_policy = CefC_Csmgr_Insert_Drop_Oldest;
+			} else if (strcasecmp (value, "sample") == 0) {
+				cs_stat->insert_policy = CefC_Csmgr_Insert_Sample;
+			} else {
+				cef_log_write (CefC_Log_Error,
+					"CSMGR_INSERT_POLICY must be drop_newest, drop_oldest or sample.\n");
+				return (-1);
+			}
+		}
 		else if (strcmp (option, "LOCAL_CACHE_DEFAULT_RCT") == 0) {
 			res = cef_csmgr_config_get_value (option, value);
 			if ((res < 1) || (res > 3600)) {
@@ -529,6 +726,24 @@ cef_csmgr_config_read (
 			}
 			cs_stat->local_cache_capacity = res;
 		}
+		else if (strcmp (option, "LOCAL_CACHE_MEMORY") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res < 0) || (res > 1048576)) {
+				cef_log_write (CefC_Log_Error,
+					"LOCAL_CACHE_MEMORY must be higher than or equal to 0 and less than or equal to 1,048,576.\n");
+				return (-1);
+			}
+			cs_stat->local_cache_memory = (uint64_t) res * 1024 * 1024;
+		}
+		else if (strcmp (option, "LOCAL_CACHE_ADMISSION") == 0) {
+			res = cef_csmgr_config_get_value (option, value);
+			if ((res != 0) && (res != 1)) {
+				cef_log_write (CefC_Log_Error,
+					"LOCAL_CACHE_ADMISSION must be 0 or 1.\n");
+				return (-1);
+			}
+			cs_stat->local_cache_admission = (int) res;
+		}
 		else if (strcmp (option, "LOCAL_CACHE_INTERVAL") == 0) {
 			res = cef_csmgr_config_get_value (option, value);
 			if ((res <= 1) || (res >= 86400)) {
@@ -881,6 +1096,14 @@ cef_csmgr_stat_destroy (
 	}
 
 	if (stat != NULL) {
+		if (stat->cluster != NULL) {
+			pthread_mutex_destroy (&stat->cluster->mutex);
+			free (stat->cluster);
+		}
+		if (stat->insert_que != NULL) {
+			cef_csmgr_insert_que_destroy (stat->insert_que);
+		}
+		pthread_mutex_destroy (&stat->sock_mutex);
 		free (stat);
 		*cs_stat = NULL;
 	}
@@ -1149,10 +1372,8 @@ cef_csmgr_cache_insert (
 	}
 #ifdef	CefC_CefnetdCache
 	else if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
-		/* Send to Local cache write thread */
-		if (write(cs_stat->pipe_fd[0], msg, msg_len) != msg_len){
-			; /* NOP */
-		}
+		/* Hand the parsed object over to Local cache write thread */
+		cef_mem_cache_put (msg, msg_len, pm, poh);
 	}
 #endif	//CefC_CefnetdCache
 
@@ -1205,17 +1426,64 @@ cef_csmgr_send_msg (
 static int							/* The return value is negative if an error occurs	*/
 cef_csmgr_send_msg_to_csmgr (
 	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member to send to				*/
 	unsigned char* msg,						/* send message								*/
 	int msg_len								/* message length							*/
 ) {
+	struct iovec iov[2];
+	unsigned char dst;
+
+	if (cs_stat->cluster == NULL) {
+		if (write(cs_stat->to_csmgrd_pipe_fd[0], msg, msg_len) != msg_len){
+			/* NOP */
+		}
+		return (0);
+	}
 
-	if (write(cs_stat->to_csmgrd_pipe_fd[0], msg, msg_len) != msg_len){
+	/* The sending thread finds the member from the top byte of the datagram 	*/
+	dst = (unsigned char) member;
+	iov[0].iov_base = &dst;
+	iov[0].iov_len  = 1;
+	iov[1].iov_base = msg;
+	iov[1].iov_len  = msg_len;
+	if (writev (cs_stat->to_csmgrd_pipe_fd[0], iov, 2) != msg_len + 1) {
 		/* NOP */
 	}
 
 	return (0);
 
 }
+/*--------------------------------------------------------------------------------------
+	Requests csmgrd to send the presence filter
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_presence_subscribe (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int sock								/* socket to send to (-1: the pipe)			*/
+) {
+	unsigned char buff[CefC_Csmgr_Msg_HeaderLen];
+	uint16_t value16;
+	uint64_t retried = 0;
+
+	/* The filter is not mirrored from the members of the cluster 	*/
+	if (cs_stat->cluster != NULL) {
+		return;
+	}
+
+	/* csmgrd answers with the bitmap only if the filter is enabled in csmgrd.conf 	*/
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Presence;
+	value16 = htons ((uint16_t) sizeof (buff));
+	memcpy (&buff[CefC_O_Length], &value16, CefC_S_Length);
+
+	if (sock == -1) {
+		cef_csmgr_send_msg_to_csmgr (cs_stat, 0, buff, sizeof (buff));
+	} else if (cef_csmgr_sock_send_all (sock, buff, sizeof (buff), &retried) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (send the presence request)\n", __func__);
+	}
+
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Puts Content Object to excache
 ----------------------------------------------------------------------------------------*/
@@ -1240,6 +1508,7 @@ cef_csmgr_excache_item_put (
 	CefT_Sock* sock = NULL;
 	CefT_Hash_Handle* sock_tbl = NULL;
 	uint64_t nowt = cef_client_present_timeus_get ();
+	int member = 0;
 
 	/* Checks cache time 		*/
 	if (poh->cachetime_f) {
@@ -1287,6 +1556,13 @@ cef_csmgr_excache_item_put (
 		/* set cob name */
 		if (pm->chunk_num_f) {
 			value16_namelen = pm->name_len - chunk_field_len;
+			if (cs_stat->cluster != NULL) {
+				member = cef_csmgr_cluster_member_select (
+								cs_stat->cluster, pm->name, value16_namelen);
+				if (member < 0) {
+					return;
+				}
+			}
 			value16 = htons (value16_namelen);
 			memcpy (buff + index, &value16, CefC_S_Length);
 			memcpy (buff + index + CefC_S_Length, pm->name, value16_namelen);
@@ -1345,13 +1621,15 @@ cef_csmgr_excache_item_put (
 		index += 3;
 
 		/* send message */
-	    if(cefnetd_msg_buff_index > BUFF_SIZE){
-			cef_csmgr_send_msg_to_csmgr (
-					cs_stat, cefnetd_msg_buff, cefnetd_msg_buff_index);
+	    if((cefnetd_msg_buff_index > BUFF_SIZE) ||
+	    	((cefnetd_msg_buff_index > 0) && (member != cefnetd_msg_buff_member))){
+			cef_csmgr_insert_que_push (
+					cs_stat, cefnetd_msg_buff_member, cefnetd_msg_buff, cefnetd_msg_buff_index);
 			cefnetd_msg_buff_index = 0;
 		}
 		memcpy (&cefnetd_msg_buff[cefnetd_msg_buff_index], buff, index);
 		cefnetd_msg_buff_index += index;
+		cefnetd_msg_buff_member = member;
 	}
 
 	return;
@@ -1365,7 +1643,8 @@ cef_csmgr_excache_item_push (
 ) {
 
 	if (cefnetd_msg_buff_index > 0) {
-		cef_csmgr_send_msg_to_csmgr (cs_stat, cefnetd_msg_buff, cefnetd_msg_buff_index);
+		cef_csmgr_insert_que_push (
+				cs_stat, cefnetd_msg_buff_member, cefnetd_msg_buff, cefnetd_msg_buff_index);
 		cefnetd_msg_buff_index = 0;
 
 	}
@@ -1386,7 +1665,10 @@ cef_csmgr_excache_lookup (
 ) {
 	unsigned char buff[CefC_Max_Length];
 	uint16_t index = 0;
+	uint16_t rec_len;
+	uint16_t value16;
 	int res;
+	int member = 0;
 
 	if (pm->org.longlife_f) {
 		return;
@@ -1397,17 +1679,180 @@ cef_csmgr_excache_lookup (
 	}
 #endif	//CefC_CefnetdCache
 
+	/* Skips the lookup which surely misses in csmgrd 	*/
+	if (cs_stat->presence_valid) {
+		rec_len = (pm->chunk_num_f) ?
+			pm->name_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum) : pm->name_len;
+		if (cef_hash_presence_check (cs_stat->presence, pm->name, rec_len) == 0) {
+			return;
+		}
+	}
+
+	/* Only the member which takes the content is asked 	*/
+	if (cs_stat->cluster != NULL) {
+		rec_len = (pm->chunk_num_f) ?
+			pm->name_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum) : pm->name_len;
+		member = cef_csmgr_cluster_member_select (cs_stat->cluster, pm->name, rec_len);
+		if (member < 0) {
+			return;
+		}
+	}
+
 	/* Create Interest message 		*/
-	cef_csmgr_interest_msg_create (buff, &index, poh, pm);
+	cef_csmgr_interest_msg_create (buff, &index, poh, pm, faceid);
+
+	/* Coalesces the Interest into the bulk message while the window is open 	*/
+	if (cs_stat->lookup_window > 0) {
+		rec_len = index - CefC_Csmgr_Msg_HeaderLen;
+
+		if ((cefnetd_lookup_buff_index + CefC_S_Length + rec_len > CefC_Csmgr_Lookup_Buff_Max) ||
+			((cefnetd_lookup_buff_index > 0) && (member != cefnetd_lookup_buff_member))) {
+			cef_csmgr_excache_lookup_flush (cs_stat, 1);
+		}
+		if (CefC_Csmgr_Msg_HeaderLen + CefC_S_Length + rec_len <= CefC_Csmgr_Lookup_Buff_Max) {
+			if (cefnetd_lookup_buff_index == 0) {
+				cefnetd_lookup_buff_index = CefC_Csmgr_Msg_HeaderLen;
+				cefnetd_lookup_flush_time =
+					cef_client_present_timeus_calc () + cs_stat->lookup_window;
+				cefnetd_lookup_buff_member = member;
+			}
+			value16 = htons (rec_len);
+			memcpy (&cefnetd_lookup_buff[cefnetd_lookup_buff_index], &value16, CefC_S_Length);
+			memcpy (&cefnetd_lookup_buff[cefnetd_lookup_buff_index + CefC_S_Length],
+				&buff[CefC_Csmgr_Msg_HeaderLen], rec_len);
+			cefnetd_lookup_buff_index += CefC_S_Length + rec_len;
+			return;
+		}
+	}
 
 	/* Send messages 				*/
-	res = cef_csmgr_send_msg_to_csmgr (cs_stat, buff, index);
+	res = cef_csmgr_send_msg_to_csmgr (cs_stat, member, buff, index);
 	if (res < 0) {
 		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
 	}
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Sends the lookups coalesced in the bulk message when the window expires
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_lookup_flush (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int force								/* 1 sends them regardless of the window	*/
+) {
+	uint16_t value16;
+
+	if (cefnetd_lookup_buff_index == 0) {
+		return;
+	}
+	if ((force == 0) &&
+		(cef_client_present_timeus_calc () < cefnetd_lookup_flush_time)) {
+		return;
+	}
+
+	/* Sets the header of the bulk message 	*/
+	cefnetd_lookup_buff[CefC_O_Fix_Ver]  = CefC_Version;
+	cefnetd_lookup_buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Bulk_Interest;
+	value16 = htons ((uint16_t) cefnetd_lookup_buff_index);
+	memcpy (&cefnetd_lookup_buff[CefC_O_Length], &value16, CefC_S_Length);
+
+	if (cef_csmgr_send_msg_to_csmgr (cs_stat, cefnetd_lookup_buff_member,
+			cefnetd_lookup_buff, cefnetd_lookup_buff_index) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
+	}
+	cefnetd_lookup_buff_index = 0;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Handles the presence filter message from csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_presence_msg_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* payload of the message					*/
+	uint16_t msg_len						/* length of the payload					*/
+) {
+	uint32_t bit_num;
+	uint32_t cur_bit_num;
+	uint32_t offset;
+	uint32_t value32;
+	uint32_t seq;
+	int hash_num;
+	int cur_hash_num;
+	int index;
+
+	if (msg_len < 1) {
+		return;
+	}
+
+	if (msg[0] == CefC_Csmgr_Presence_Snapshot) {
+		/* [type][seq(4)][bit num(4)][hash num(1)][offset(4)][bitmap] 	*/
+		if (msg_len < 14) {
+			return;
+		}
+		memcpy (&value32, &msg[1], sizeof (uint32_t));
+		seq 	 = ntohl (value32);
+		memcpy (&value32, &msg[5], sizeof (uint32_t));
+		bit_num  = ntohl (value32);
+		hash_num = msg[9];
+		memcpy (&value32, &msg[10], sizeof (uint32_t));
+		offset 	 = ntohl (value32);
+
+		cef_hash_presence_info_get (cs_stat->presence, &cur_bit_num, &cur_hash_num);
+		if (offset == 0) {
+			/* Lookups are not skipped until the whole bitmap arrives 	*/
+			cs_stat->presence_valid = 0;
+			cs_stat->presence_seq 	= seq;
+			if ((cur_bit_num != bit_num) || (cur_hash_num != hash_num)) {
+				cef_hash_presence_destroy (cs_stat->presence);
+				cs_stat->presence = cef_hash_presence_mirror_create (bit_num, hash_num);
+				if (cs_stat->presence == (CefT_Hash_Presence_Handle) NULL) {
+					cef_log_write (CefC_Log_Warn,
+						"%s (invalid presence filter, bits=%u, hashes=%d)\n",
+						__func__, bit_num, hash_num);
+					return;
+				}
+			}
+		} else if ((cur_bit_num != bit_num) || (cur_hash_num != hash_num) ||
+				   (cs_stat->presence_seq != seq)) {
+			return;
+		}
+		cef_hash_presence_bitmap_write (cs_stat->presence, offset, &msg[14], msg_len - 14);
+
+		if ((offset + (msg_len - 14) >= bit_num / 8) && (cs_stat->presence_valid == 0)) {
+			cs_stat->presence_valid = 1;
+			cef_log_write (CefC_Log_Info,
+				"Presence filter of csmgrd is enabled (%u bits, %d hashes)\n",
+				bit_num, hash_num);
+		}
+	} else if (msg[0] == CefC_Csmgr_Presence_Delta) {
+		/* [type][seq(4)][bit change(4)]... 	*/
+		if ((msg_len < 5) || (cs_stat->presence_valid == 0)) {
+			return;
+		}
+		memcpy (&value32, &msg[1], sizeof (uint32_t));
+		seq = ntohl (value32);
+		if (seq != cs_stat->presence_seq) {
+			/* The mirror missed the changes, so it is not used until the whole 	*/
+			/* bitmap arrives again 												*/
+			cef_log_write (CefC_Log_Warn,
+				"Presence filter lost the changes (seq=%u, expected=%u)\n",
+				seq, cs_stat->presence_seq);
+			cs_stat->presence_valid = 0;
+			cef_csmgr_presence_subscribe (cs_stat, -1);
+			return;
+		}
+		cs_stat->presence_seq++;
+		for (index = 5 ; index + (int) sizeof (uint32_t) <= msg_len ; index += sizeof (uint32_t)) {
+			memcpy (&value32, &msg[index], sizeof (uint32_t));
+			cef_hash_presence_delta_apply (cs_stat->presence, ntohl (value32));
+		}
+	}
+
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
@@ -1563,37 +2008,325 @@ csmgr_sock_close (
 		cs_stat->tcp_sock = -1;
 	}
 
-	return;
-}
-/*--------------------------------------------------------------------------------------
-	Change str to value
-----------------------------------------------------------------------------------------*/
-int64_t								/* The return value is negative if an error occurs	*/
-cef_csmgr_config_get_value (
-	char* option,							/* csmgr option								*/
-	char* value								/* String									*/
-) {
-	int i;
-	uint64_t res;
-	/* check num */
-	for (i = 0 ; value[i] ; i++) {
-		if (isdigit (value[i]) == 0) {
-			return (-1);
-		}
+	if (cs_stat->new_sock != -1) {
+		close (cs_stat->new_sock);
+		cs_stat->new_sock = -1;
 	}
-	/* change str */
-	res = (uint64_t)strtoull (value, NULL, 10);
-	if (res == ULLONG_MAX) {
-		if (errno == ERANGE) {
-			/* overflow */
-			return (-1);
+
+	if (cs_stat->cluster != NULL) {
+		int m;
+		pthread_mutex_lock (&cs_stat->cluster->mutex);
+		for (m = 0 ; m < cs_stat->cluster->member_num ; m++) {
+			if (cs_stat->cluster->member[m].sock != -1) {
+				close (cs_stat->cluster->member[m].sock);
+				cs_stat->cluster->member[m].sock = -1;
+			}
+			if (cs_stat->cluster->member[m].new_sock != -1) {
+				close (cs_stat->cluster->member[m].new_sock);
+				cs_stat->cluster->member[m].new_sock = -1;
+			}
 		}
+		pthread_mutex_unlock (&cs_stat->cluster->mutex);
 	}
-	/* check num */
-	if (res > UINT32_MAX) {
-		return (-1);
+
+	if (cs_stat->shm != NULL) {
+		cef_csmgr_shm_destroy (cs_stat->shm);
+		cs_stat->shm = NULL;
 	}
-	return (res);
+
+	cef_hash_presence_destroy (cs_stat->presence);
+	cs_stat->presence 		= (CefT_Hash_Presence_Handle) NULL;
+	cs_stat->presence_valid = 0;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the shared ring and hands it over to csmgrd
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_csmgr_shm_connect (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+#ifdef MFD_CLOEXEC
+	int fd;
+	CefT_Csmgr_Shm* shm;
+	size_t map_len;
+	unsigned char buff[CefC_Csmgr_Msg_HeaderLen + sizeof (uint32_t)];
+	uint16_t value16;
+	uint32_t value32;
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	union {
+		char			buf[CMSG_SPACE (sizeof (int))];
+		struct cmsghdr	align;
+	} ctrl;
+
+	map_len = sizeof (CefT_Csmgr_Shm_Hdr) + (size_t) cs_stat->shm_size * 1024 * 1024;
+
+	/* Creates the memfd, csmgrd maps the same pages after receiving it 	*/
+	fd = memfd_create ("csmgr_shm", MFD_CLOEXEC);
+	if (fd < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (memfd_create: %s)\n", __func__, strerror (errno));
+		return (-1);
+	}
+	if (ftruncate (fd, (off_t) map_len) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (ftruncate: %s)\n", __func__, strerror (errno));
+		close (fd);
+		return (-1);
+	}
+	shm = cef_csmgr_shm_attach (fd);
+	if (shm == NULL) {
+		close (fd);
+		return (-1);
+	}
+	shm->hdr->size 	= shm->size;
+	shm->hdr->head 	= 0;
+	shm->hdr->tail 	= 0;
+	__atomic_store_n (&shm->hdr->magic, CefC_Csmgr_Shm_Magic, __ATOMIC_RELEASE);
+
+	/* Sends the Attach Shared Memory message with the memfd 	*/
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Shm;
+	value16 = htons ((uint16_t) sizeof (buff));
+	memcpy (&buff[CefC_O_Length], &value16, sizeof (uint16_t));
+	value32 = htonl (cs_stat->shm_size);
+	memcpy (&buff[CefC_Csmgr_Msg_HeaderLen], &value32, sizeof (uint32_t));
+
+	memset (&mh, 0, sizeof (mh));
+	memset (&ctrl, 0, sizeof (ctrl));
+	iov.iov_base 		= buff;
+	iov.iov_len 		= sizeof (buff);
+	mh.msg_iov 			= &iov;
+	mh.msg_iovlen 		= 1;
+	mh.msg_control 		= ctrl.buf;
+	mh.msg_controllen 	= sizeof (ctrl.buf);
+	cmsg = CMSG_FIRSTHDR (&mh);
+	cmsg->cmsg_level 	= SOL_SOCKET;
+	cmsg->cmsg_type 	= SCM_RIGHTS;
+	cmsg->cmsg_len 		= CMSG_LEN (sizeof (int));
+	memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+	if (sendmsg (cs_stat->local_sock, &mh, 0) != (ssize_t) sizeof (buff)) {
+		cef_log_write (CefC_Log_Warn, "%s (sendmsg: %s)\n", __func__, strerror (errno));
+		cef_csmgr_shm_destroy (shm);
+		close (fd);
+		return (-1);
+	}
+	close (fd);
+
+	cs_stat->shm = shm;
+	cef_log_write (CefC_Log_Info,
+		"Shared-memory transport to csmgrd is enabled (%u MB)\n", cs_stat->shm_size);
+
+	return (1);
+#else // MFD_CLOEXEC
+	return (-1);
+#endif // MFD_CLOEXEC
+}
+/*--------------------------------------------------------------------------------------
+	Maps the shared ring received from cefnetd
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Shm*						/* The return value is null if an error occurs		*/
+cef_csmgr_shm_attach (
+	int fd									/* memfd of the shared ring					*/
+) {
+	CefT_Csmgr_Shm* shm;
+	struct stat st;
+	void* addr;
+
+	if ((fstat (fd, &st) < 0) ||
+		(st.st_size <= (off_t) sizeof (CefT_Csmgr_Shm_Hdr)) ||
+		(st.st_size > (off_t) sizeof (CefT_Csmgr_Shm_Hdr) +
+						(off_t) CefC_Csmgr_Shm_Max_Size * 1024 * 1024)) {
+		cef_log_write (CefC_Log_Warn, "%s (invalid shared memory)\n", __func__);
+		return (NULL);
+	}
+	addr = mmap (NULL, (size_t) st.st_size,
+				PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+		cef_log_write (CefC_Log_Warn, "%s (mmap: %s)\n", __func__, strerror (errno));
+		return (NULL);
+	}
+	shm = (CefT_Csmgr_Shm*) malloc (sizeof (CefT_Csmgr_Shm));
+	if (shm == NULL) {
+		munmap (addr, (size_t) st.st_size);
+		return (NULL);
+	}
+	shm->hdr 		= (CefT_Csmgr_Shm_Hdr*) addr;
+	shm->arena 		= (unsigned char*) addr + sizeof (CefT_Csmgr_Shm_Hdr);
+	shm->map_len 	= (size_t) st.st_size;
+	shm->size 		= (uint32_t)(shm->map_len - sizeof (CefT_Csmgr_Shm_Hdr));
+	shm->rec_len 	= 0;
+
+	return (shm);
+}
+/*--------------------------------------------------------------------------------------
+	Unmaps the shared ring
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_destroy (
+	CefT_Csmgr_Shm* shm						/* shared ring								*/
+) {
+	if (shm == NULL) {
+		return;
+	}
+	munmap (shm->hdr, shm->map_len);
+	free (shm);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the message to the shared ring (csmgrd side)
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if the ring is full	*/
+cef_csmgr_shm_put (
+	CefT_Csmgr_Shm* shm,					/* shared ring								*/
+	const unsigned char* msg,				/* message to write							*/
+	uint16_t msg_len						/* length of message						*/
+) {
+	CefT_Csmgr_Shm_Hdr* hdr = shm->hdr;
+	uint64_t head;
+	uint64_t tail;
+	uint32_t pos;
+	uint32_t rec_len;
+	uint32_t room;
+	uint32_t value32;
+
+	if (__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != CefC_Csmgr_Shm_Magic) {
+		return (-1);
+	}
+	/* Each record is the length, the message and the padding to 8 bytes 	*/
+	rec_len = (sizeof (uint32_t) + msg_len + 7) & ~7u;
+	head = hdr->head;
+	tail = __atomic_load_n (&hdr->tail, __ATOMIC_ACQUIRE);
+	if ((tail > head) || (head - tail > shm->size)) {
+		/* The header is broken, so the socket is used 	*/
+		return (-1);
+	}
+	pos  = (uint32_t)(head % shm->size);
+	room = shm->size - pos;
+
+	/* A record is never split, so the rest of the arena is skipped if short 	*/
+	if (room < rec_len) {
+		if (head + room + rec_len - tail > shm->size) {
+			return (-1);
+		}
+		value32 = CefC_Csmgr_Shm_Rec_Wrap;
+		memcpy (&shm->arena[pos], &value32, sizeof (uint32_t));
+		head += room;
+		pos = 0;
+	} else if (head + rec_len - tail > shm->size) {
+		return (-1);
+	}
+	value32 = msg_len;
+	memcpy (&shm->arena[pos], &value32, sizeof (uint32_t));
+	memcpy (&shm->arena[pos + sizeof (uint32_t)], msg, msg_len);
+
+	/* Publishes the record after its contents are written 	*/
+	__atomic_store_n (&hdr->head, head + rec_len, __ATOMIC_RELEASE);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Refers to the oldest message in the shared ring (cefnetd side)
+----------------------------------------------------------------------------------------*/
+unsigned char*						/* The return value is null if the ring is empty	*/
+cef_csmgr_shm_peek (
+	CefT_Csmgr_Shm* shm,					/* shared ring								*/
+	uint16_t* msg_len						/* length of message						*/
+) {
+	CefT_Csmgr_Shm_Hdr* hdr = shm->hdr;
+	uint64_t head;
+	uint64_t tail;
+	uint32_t pos;
+	uint32_t rec_len;
+	uint32_t value32;
+
+	if (__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != CefC_Csmgr_Shm_Magic) {
+		return (NULL);
+	}
+	head = __atomic_load_n (&hdr->head, __ATOMIC_ACQUIRE);
+	tail = hdr->tail;
+
+	/* Every offset and length read from the ring is checked with the local size 	*/
+	while (tail != head) {
+		pos = (uint32_t)(tail % shm->size);
+		if ((tail > head) || (head - tail > shm->size) ||
+			(pos + sizeof (uint32_t) > shm->size)) {
+			break;
+		}
+		memcpy (&value32, &shm->arena[pos], sizeof (uint32_t));
+		if (value32 == CefC_Csmgr_Shm_Rec_Wrap) {
+			tail += shm->size - pos;
+			__atomic_store_n (&hdr->tail, tail, __ATOMIC_RELEASE);
+			continue;
+		}
+		rec_len = (sizeof (uint32_t) + value32 + 7) & ~7u;
+		if ((value32 > UINT16_MAX) ||
+			(rec_len > shm->size - pos) || (rec_len > head - tail)) {
+			break;
+		}
+		shm->rec_len = rec_len;
+		*msg_len = (uint16_t) value32;
+		return (&shm->arena[pos + sizeof (uint32_t)]);
+	}
+	if (tail == head) {
+		return (NULL);
+	}
+
+	/* The ring is broken, csmgrd sends the Cobs with the socket from now on 	*/
+	cef_log_write (CefC_Log_Warn,
+		"Detects the broken shared ring from csmgr, so the socket is used\n");
+	__atomic_store_n (&hdr->magic, 0, __ATOMIC_RELEASE);
+
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the message returned by cef_csmgr_shm_peek
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_shm_release (
+	CefT_Csmgr_Shm* shm						/* shared ring								*/
+) {
+	CefT_Csmgr_Shm_Hdr* hdr = shm->hdr;
+
+	/* The space is handed back to csmgrd only now, the message was used in place. 	*/
+	/* The length is the one peek checked, csmgrd may have changed the ring 		*/
+	__atomic_store_n (&hdr->tail, hdr->tail + shm->rec_len, __ATOMIC_RELEASE);
+	shm->rec_len = 0;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Change str to value
+----------------------------------------------------------------------------------------*/
+int64_t								/* The return value is negative if an error occurs	*/
+cef_csmgr_config_get_value (
+	char* option,							/* csmgr option								*/
+	char* value								/* String									*/
+) {
+	int i;
+	uint64_t res;
+	/* check num */
+	for (i = 0 ; value[i] ; i++) {
+		if (isdigit (value[i]) == 0) {
+			return (-1);
+		}
+	}
+	/* change str */
+	res = (uint64_t)strtoull (value, NULL, 10);
+	if (res == ULLONG_MAX) {
+		if (errno == ERANGE) {
+			/* overflow */
+			return (-1);
+		}
+	}
+	/* check num */
+	if (res > UINT32_MAX) {
+		return (-1);
+	}
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Incoming pre-ccninfoo message
@@ -1614,7 +2347,6 @@ cef_csmgr_excache_item_check_for_ccninfo (
 	int res;
 	uint8_t type;
 
-	char port_str[NI_MAXSERV];
 	int tmp_sock;
 
 #ifdef CefC_CefnetdCache
@@ -1627,8 +2359,7 @@ cef_csmgr_excache_item_check_for_ccninfo (
 		Sends the PreCcninfo request message
 	------------------------------------------------------*/
 	/* Creates the socket to csmgr with TCP 		*/
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, name, name_len);
 	if (tmp_sock < 0) {
 		return (-1);
 	}
@@ -1707,14 +2438,13 @@ cef_csmgr_excache_info_get (
 	int res;
 
 	int tmp_sock;
-	char port_str[NI_MAXSERV];
 
 	/*----------------------------------------------------
 		Sends the ccninfo request message
 	------------------------------------------------------*/
 	/* Creates the socket to csmgr with TCP 		*/
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, name, (ccninfo_flag) ?
+					name_len : name_len - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum));
 	if (tmp_sock < 0) {
 		return (-1);
 	}
@@ -1894,89 +2624,47 @@ cef_csmgr_capacity_retrieve (
 	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
 	uint64_t* cap							/* Capacity									*/
 ) {
-	unsigned char buff[CefC_Max_Length] = {0};
-	unsigned char msg[CefC_Max_Length] = {0};
-	int buff_size;
-	uint16_t index = 0;
-	struct pollfd fds[1];
-	int len;
-	int res = 0;
-	uint8_t type;
+	CefT_Csmgr_Member* mp;
 	char port_str[NI_MAXSERV];
-	int tmp_sock;
-	uint8_t result;
-	uint16_t value16;
 	uint64_t value64;
+	int tmp_sock;
+	int res = -1;
+	int m;
 
 	if (cs_stat == NULL) {
 		/* CS is not used */
 		return (0);
 	}
 
-	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
-	if (tmp_sock < 0) {
-		/* Connection Failed */
-		return (-1);
-	}
-
-	/* Creates the retrieve capacity message */
-	buff[CefC_O_Fix_Ver]  = CefC_Version;
-	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_RCap;
-	index += CefC_Csmgr_Msg_HeaderLen;
-	/* Insert dummy data */
-	buff[index] = 0;
-	index++;
-	value16 = htons (index);
-	memcpy (buff + CefC_O_Length, &value16, CefC_S_Length);
-	/* Sends the created message 		*/
-	res = write (tmp_sock, buff, index);
-	if (res < 0) {
+	if (cs_stat->cluster == NULL) {
+		/* Creates the socket to csmgr with TCP */
+		tmp_sock = cef_csmgr_ctrl_connect (cs_stat, NULL, 0);
+		if (tmp_sock < 0) {
+			/* Connection Failed */
+			return (-1);
+		}
+		res = cef_csmgr_capacity_msg_send (tmp_sock, CefC_Csmgr_Msg_Type_RCap, cap);
 		close (tmp_sock);
-		return (-1);
+		return (res);
 	}
 
-	/*----------------------------------------------------
-		Receives the capacity response message
-	------------------------------------------------------*/
-	fds[0].fd = tmp_sock;
-	fds[0].events = POLLIN | POLLERR;
-	memset (buff, 0, sizeof (buff));
-
-	res = poll (fds, 1, CefC_Csmgr_Max_Wait_Response);
-	if ((res <= 0) || (fds[0].revents & (POLLERR | POLLNVAL | POLLHUP))) {
+	/* The capacity of the cluster is the sum of the members which answer 	*/
+	*cap = 0;
+	for (m = 0 ; m < cs_stat->cluster->member_num ; m++) {
+		mp = &cs_stat->cluster->member[m];
+		sprintf (port_str, "%u", mp->port_num);
+		tmp_sock = cef_csmgr_connect_tcp_to_csmgr (mp->peer_id_str, port_str);
+		if (tmp_sock < 0) {
+			continue;
+		}
+		if (cef_csmgr_capacity_msg_send (
+				tmp_sock, CefC_Csmgr_Msg_Type_RCap, &value64) > 0) {
+			*cap += value64;
+			res = 1;
+		}
 		close (tmp_sock);
-		return (-1);
 	}
 
-	len = recv (fds[0].fd, buff, CefC_Max_Length, 0);
-	if (len > 0) {
-		/* Parses the received message */
-		len = csmgr_frame_get (buff, len, msg, &buff_size, &type);
-		if (buff_size > 0) {
-			if (type != CefC_Csmgr_Msg_Type_RCap) {
-				res = -1;
-			} else {
-				if (buff_size < (sizeof (result) + sizeof (value64))) {
-					res = -1;
-				} else {
-					/* Checks the result */
-					memcpy (&result, msg, sizeof (result));
-					if (result == CcoreC_Success) {
-						memcpy (&value64, msg + sizeof (result), sizeof (value64));
-						*cap = cef_client_ntohb (value64);
-						res = 1;
-					} else {
-						fprintf (stderr,
-							"Failed to acquire the value inside Content Store.\n");
-						res = -1;
-					}
-				}
-			}
-		}
-	}
-	close (tmp_sock);
 	return (res);
 }
 /*--------------------------------------------------------------------------------------
@@ -1986,6 +2674,58 @@ int									/* The return value is negative if an error occurs	*/
 cef_csmgr_capacity_update (
 	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
 	uint64_t cap							/* Capacity									*/
+) {
+	CefT_Csmgr_Member* mp;
+	char port_str[NI_MAXSERV];
+	uint64_t value64;
+	int tmp_sock;
+	int res = 1;
+	int m;
+
+	if (cs_stat->cluster == NULL) {
+		/* Creates the socket to csmgr with TCP */
+		tmp_sock = cef_csmgr_ctrl_connect (cs_stat, NULL, 0);
+		if (tmp_sock < 0) {
+			/* Connection Failed */
+			return (-1);
+		}
+		res = cef_csmgr_capacity_msg_send (tmp_sock, CefC_Csmgr_Msg_Type_SCap, &cap);
+		close (tmp_sock);
+		return (res);
+	}
+
+	/* Each member takes an equal share as the ring spreads the contents evenly 	*/
+	for (m = 0 ; m < cs_stat->cluster->member_num ; m++) {
+		mp = &cs_stat->cluster->member[m];
+		value64 = cap / cs_stat->cluster->member_num;
+		if (m < cap % cs_stat->cluster->member_num) {
+			value64++;
+		}
+		sprintf (port_str, "%u", mp->port_num);
+		tmp_sock = cef_csmgr_connect_tcp_to_csmgr (mp->peer_id_str, port_str);
+		if (tmp_sock < 0) {
+			cef_log_write (CefC_Log_Error, "Failed to update the capacity of "
+				"csmgrd (%s:%u).\n", mp->peer_id_str, mp->port_num);
+			res = -1;
+			continue;
+		}
+		if (cef_csmgr_capacity_msg_send (
+				tmp_sock, CefC_Csmgr_Msg_Type_SCap, &value64) < 0) {
+			res = -1;
+		}
+		close (tmp_sock);
+	}
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the capacity message to the csmgrd connected with the socket
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_capacity_msg_send (
+	int sock,								/* socket connected to csmgrd				*/
+	uint8_t msg_type,						/* CefC_Csmgr_Msg_Type_RCap or SCap			*/
+	uint64_t* cap							/* Capacity									*/
 ) {
 	unsigned char buff[CefC_Max_Length] = {0};
 	unsigned char msg[CefC_Max_Length] = {0};
@@ -1995,46 +2735,40 @@ cef_csmgr_capacity_update (
 	int len;
 	int res = 0;
 	uint8_t type;
-	char port_str[NI_MAXSERV];
-	int tmp_sock;
 	uint8_t result;
 	uint16_t value16;
 	uint64_t value64;
 
-	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
-	if (tmp_sock < 0) {
-		/* Connection Failed */
-		return (-1);
-	}
-
-	/* Creates the retrieve capacity message */
+	/* Creates the retrieve or update capacity message */
 	buff[CefC_O_Fix_Ver]  = CefC_Version;
-	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_SCap;
+	buff[CefC_O_Fix_Type] = msg_type;
 	index += CefC_Csmgr_Msg_HeaderLen;
-	value64 = cef_client_htonb (cap);
-	memcpy (buff + index, &value64, sizeof (uint64_t));
-	index += sizeof (uint64_t);
+	if (msg_type == CefC_Csmgr_Msg_Type_SCap) {
+		value64 = cef_client_htonb (*cap);
+		memcpy (buff + index, &value64, sizeof (uint64_t));
+		index += sizeof (uint64_t);
+	} else {
+		/* Insert dummy data */
+		buff[index] = 0;
+		index++;
+	}
 	value16 = htons (index);
 	memcpy (buff + CefC_O_Length, &value16, CefC_S_Length);
 	/* Sends the created message 		*/
-	res = write (tmp_sock, buff, index);
+	res = write (sock, buff, index);
 	if (res < 0) {
-		close (tmp_sock);
 		return (-1);
 	}
 
 	/*----------------------------------------------------
 		Receives the capacity response message
 	------------------------------------------------------*/
-	fds[0].fd = tmp_sock;
+	fds[0].fd = sock;
 	fds[0].events = POLLIN | POLLERR;
 	memset (buff, 0, sizeof (buff));
 
 	res = poll (fds, 1, CefC_Csmgr_Max_Wait_Response);
 	if ((res <= 0) || (fds[0].revents & (POLLERR | POLLNVAL | POLLHUP))) {
-		close (tmp_sock);
 		return (-1);
 	}
 
@@ -2043,9 +2777,9 @@ cef_csmgr_capacity_update (
 		/* Parses the received message */
 		len = csmgr_frame_get (buff, len, msg, &buff_size, &type);
 		if (buff_size > 0) {
-			if (type != CefC_Csmgr_Msg_Type_SCap) {
+			if (type != msg_type) {
 				res = -1;
-			} else {
+			} else if (msg_type == CefC_Csmgr_Msg_Type_SCap) {
 				if (buff_size < (sizeof (result))) {
 					res = -1;
 				} else {
@@ -2059,10 +2793,25 @@ cef_csmgr_capacity_update (
 						res = -1;
 					}
 				}
+			} else {
+				if (buff_size < (sizeof (result) + sizeof (value64))) {
+					res = -1;
+				} else {
+					/* Checks the result */
+					memcpy (&result, msg, sizeof (result));
+					if (result == CcoreC_Success) {
+						memcpy (&value64, msg + sizeof (result), sizeof (value64));
+						*cap = cef_client_ntohb (value64);
+						res = 1;
+					} else {
+						fprintf (stderr,
+							"Failed to acquire the value inside Content Store.\n");
+						res = -1;
+					}
+				}
 			}
 		}
 	}
-	close (tmp_sock);
 	return (res);
 }
 /*--------------------------------------------------------------------------------------
@@ -2075,7 +2824,6 @@ cef_csmgr_con_lifetime_retrieve (
 	uint16_t name_len,						/* Name length								*/
 	uint64_t* lifetime						/* Lifetime									*/
 ) {
-	char port_str[NI_MAXSERV];
 	int tmp_sock;
 	unsigned char buff[CefC_Max_Length] = {0};
 	int buff_size;
@@ -2095,8 +2843,7 @@ cef_csmgr_con_lifetime_retrieve (
 	}
 
 	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, (const unsigned char*) name, name_len);
 	if (tmp_sock < 0) {
 		/* Connection Failed */
 		return (-1);
@@ -2172,7 +2919,6 @@ cef_csmgr_con_lifetime_set (
 	uint16_t name_len,						/* Name length								*/
 	uint64_t lifetime						/* Lifetime									*/
 ) {
-	char port_str[NI_MAXSERV];
 	int tmp_sock;
 	unsigned char buff[CefC_Max_Length] = {0};
 	int buff_size;
@@ -2192,8 +2938,7 @@ cef_csmgr_con_lifetime_set (
 	}
 
 	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, (const unsigned char*) name, name_len);
 	if (tmp_sock < 0) {
 		/* Connection Failed */
 		return (-1);
@@ -2273,7 +3018,6 @@ cef_csmgr_con_chunk_retrieve (
 	uint16_t range_len,						/* Range length								*/
 	char* info								/* cache information						*/
 ) {
-	char port_str[NI_MAXSERV];
 	int tmp_sock;
 	unsigned char buff[CefC_Max_Length] = {0};
 	int buff_size;
@@ -2292,8 +3036,7 @@ cef_csmgr_con_chunk_retrieve (
 	}
 
 	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, (const unsigned char*) name, name_len);
 	if (tmp_sock < 0) {
 		/* Connection Failed */
 		return (-1);
@@ -2380,7 +3123,6 @@ cef_csmgr_con_chunk_delete (
 	char* range,							/* Cache Range								*/
 	uint16_t range_len						/* Range length								*/
 ) {
-	char port_str[NI_MAXSERV];
 	int tmp_sock;
 	unsigned char buff[CefC_Max_Length] = {0};
 	int buff_size;
@@ -2399,8 +3141,7 @@ cef_csmgr_con_chunk_delete (
 	}
 
 	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, (const unsigned char*) name, name_len);
 	if (tmp_sock < 0) {
 		/* Connection Failed */
 		return (-1);
@@ -2487,6 +3228,7 @@ cef_csmgr_excache_access_increment (
 	uint16_t value16;
 	uint32_t value32;
 	int res;
+	int member = 0;
 
 #ifdef CefC_CefnetdCache
 	if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
@@ -2516,7 +3258,15 @@ cef_csmgr_excache_access_increment (
 	memcpy (buff + CefC_O_Length, &value16, CefC_S_Length);
 
 	/* send message */
-	res = cef_csmgr_send_msg_to_csmgr (cs_stat, buff, index);
+	if (cs_stat->cluster != NULL) {
+		/* The key ends with the chunk number 	*/
+		member = cef_csmgr_cluster_member_select (cs_stat->cluster,
+					key, (uint16_t)(klen - (CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum)));
+		if (member < 0) {
+			return;
+		}
+	}
+	res = cef_csmgr_send_msg_to_csmgr (cs_stat, member, buff, index);
 	if (res < 0) {
 		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
 	}
@@ -2532,7 +3282,8 @@ cef_csmgr_interest_msg_create (
 	unsigned char buff[],					/* Interest message							*/
 	uint16_t* index,						/* Length of message						*/
 	CefT_CcnMsg_OptHdr* poh,				/* Parsed Option Header						*/
-	CefT_CcnMsg_MsgBdy* pm					/* Parsed CEFORE message					*/
+	CefT_CcnMsg_MsgBdy* pm,					/* Parsed CEFORE message					*/
+	int faceid								/* Face-ID which received the Interest		*/
 ) {
 	uint16_t value16;
 	uint16_t value16_nw;
@@ -2584,6 +3335,11 @@ cef_csmgr_interest_msg_create (
 		*index += pm->org.version_len;
 	}
 
+	/* Sets Face-ID, csmgrd follows the read-ahead flow of each consumer with it */
+	value32_nw = htonl ((uint32_t) faceid);
+	memcpy (buff + *index, &value32_nw, CefC_Csmgr_Interest_S_Faceid);
+	*index += CefC_Csmgr_Interest_S_Faceid;
+
 	/* set Length */
 	value16_nw = htons (*index);
 	memcpy (buff + CefC_O_Length, &value16_nw, CefC_S_Length);
@@ -2695,6 +3451,7 @@ cef_csmgr_send_to_csmgrd_thread (
 	struct pollfd 				poll_fds[1];
 	unsigned char				msg[CefC_Max_Length*2];
 	int							msg_len;
+	int							timeout = 1;
 
 	cs_stat = (CefT_Cs_Stat*)p;
 
@@ -2708,162 +3465,890 @@ cef_csmgr_send_to_csmgrd_thread (
 	poll_fds[0].events = POLLIN | POLLERR;
 
 	while (1){
-	    poll(poll_fds, 1, 1);
+	    poll(poll_fds, 1, timeout);
+
+		if (cs_stat->cluster != NULL) {
+			cef_csmgr_cluster_health_check (cs_stat);
+		}
 	    if (poll_fds[0].revents & POLLIN) {
-			if((msg_len = read(read_fd, msg, sizeof(msg))) < 1){
-				continue;
+			if((msg_len = read(read_fd, msg, sizeof(msg))) > 0){
+				cef_csmgr_pipe_msg_send (cs_stat, msg, msg_len);
 			}
-			/*###########*/
-			int res;
-			char port_str[NI_MAXSERV];
+		}
 
-			if (cs_stat->local_sock != -1) {
-				int	send_count = 0;
-				res = 0;
-    			unsigned char* mp = msg;
-    			int len = msg_len;
-				fd_set fds, writefds;
-				int n;
-				struct timeval timeout;
-
-		   		res = send( cs_stat->local_sock, mp, len,  MSG_DONTWAIT);
-				if ( res <= 0 ) {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-					fprintf(stderr, "[%s](res <=0): ###########(1) ERROR(%d)=%s send_count:%d\n", __FUNCTION__, errno, strerror (errno), send_count);
-#endif
-					if ( errno == EAGAIN ) {
-						usleep(CEF_CSMGR_SEND_USLEEP);
-					}
-					continue;
-				}
-				len -= res;
-				mp += res;
-				send_count++;
-
-				while( len > 0 ){
-					timeout.tv_sec  = 0;
-					timeout.tv_usec = CEF_CSMGR_SEND_TIMEOUT;
-					FD_ZERO (&writefds);
-					FD_SET (cs_stat->local_sock, &writefds);
-					memcpy (&fds, &writefds, sizeof (fds));
-					n = select(cs_stat->local_sock+1, NULL, &fds, NULL, &timeout);
-					if (n > 0) {
-						if (FD_ISSET (cs_stat->local_sock, &fds)) {
-				    		res = send( cs_stat->local_sock, mp, len,  MSG_DONTWAIT);
-							if(res > 0) {
-								len -= res;
-								mp += res;
-							} else {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-								fprintf(stderr, "[%s](res <=0): ###########(2) ERROR(%d)=%s \n", __FUNCTION__, errno, strerror (errno));
-#endif
-								if ( errno == EAGAIN ) {
-									usleep(CEF_CSMGR_SEND_USLEEP);
-								}
-							}
-							send_count++;
-							if ( send_count > DEMO_RETRY_NUM ) {
-								break;
-							}
-						}
-					} else {
-						if ( send_count == 0 ) {
-							break;
-						} else if ( send_count > DEMO_RETRY_NUM ) {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-							fprintf(stderr, "[%s](%d): ########### n:%d   send_count:%d   len:%d   %s\n",
-										__FUNCTION__, __LINE__, n, send_count, len, strerror (errno));
-#endif
-							break;
-						}
-						send_count++;
-						if ( errno == EAGAIN ) {
-							usleep(CEF_CSMGR_SEND_USLEEP);
-						}
-					}
-				}
+		/* Lookups go ahead of the Upload Requests which wait for the credits 	*/
+		if (cef_csmgr_insert_que_send (cs_stat) > 0) {
+			timeout = 0;
+		} else {
+			timeout = 1;
+		}
+	}
+
+	pthread_exit (NULL);
+	return 0;
+
+}
+/*--------------------------------------------------------------------------------------
+	Sends the message read from the pipe to csmgrd
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_pipe_msg_send (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	unsigned char* msg,						/* message read from the pipe				*/
+	int msg_len								/* message length							*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	int member = 0;
+	int sock;
+	int res = -1;
+	uint64_t retried = 0;
+
+	if (cs_stat->cluster != NULL) {
+		/* The top byte is the member which takes the content 	*/
+		if ((msg_len < 2) || (msg[0] >= cs_stat->cluster->member_num)) {
+			return;
+		}
+		member = msg[0];
+		msg++;
+		msg_len--;
+	}
+
+	/* A message cut in the middle breaks the stream to csmgrd, so it is sent 	*/
+	/* whole or the stream is reset by cef_csmgr_member_sock_put 				*/
+	sock = cef_csmgr_member_sock_get (cs_stat, member);
+	if (sock != -1) {
+		res = cef_csmgr_sock_send_all (sock, msg, msg_len, &retried);
+		cef_csmgr_member_sock_put (cs_stat, member, res);
+	}
+
+	if (que != NULL) {
+		pthread_mutex_lock (&que->mutex);
+		que->retried_bytes += retried;
+		if (res < 0) {
+			que->req_dropped++;
+		}
+		pthread_mutex_unlock (&que->mutex);
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the socket connected to the member of csmgrd
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is -1 if the member is down		*/
+cef_csmgr_member_sock_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member								/* cluster member (0 for single csmgrd)		*/
+) {
+	CefT_Csmgr_Member* mp;
+	char port_str[NI_MAXSERV];
+	uint64_t nowt;
+	int connect_f;
+	int new_sock;
+	int sock = -1;
+
+	if (cs_stat->cluster != NULL) {
+		if ((member < 0) || (member >= cs_stat->cluster->member_num)) {
+			return (-1);
+		}
+		mp = &cs_stat->cluster->member[member];
+
+		/* The main thread does not close the socket while it is referred 	*/
+		pthread_mutex_lock (&cs_stat->cluster->mutex);
+		if ((mp->sock != -1) && (mp->down_f == 0) && (mp->fail_f == 0)) {
+			sock = mp->sock;
+			mp->send_ref++;
+		}
+		pthread_mutex_unlock (&cs_stat->cluster->mutex);
+		return (sock);
+	}
+
+	/* The main thread does not close the socket while it is referred 	*/
+	nowt = cef_client_present_timeus_calc ();
+	pthread_mutex_lock (&cs_stat->sock_mutex);
+	if (cs_stat->sock_fail_f == 0) {
+		sock = (cs_stat->local_sock != -1) ? cs_stat->local_sock : cs_stat->tcp_sock;
+		if (sock != -1) {
+			cs_stat->sock_ref++;
+		}
+	}
+	connect_f = (cs_stat->local_sock == -1) && (cs_stat->tcp_sock == -1) &&
+				(cs_stat->new_sock == -1) && (nowt >= cs_stat->sock_retry_time);
+	pthread_mutex_unlock (&cs_stat->sock_mutex);
+	if (connect_f == 0) {
+		return (sock);
+	}
+
+	/* Connects again and subscribes before the main thread starts to use it 	*/
+	if ((strcmp (cs_stat->peer_id_str, "localhost")) &&
+		(strcmp (cs_stat->peer_id_str, "127.0.0.1"))) {
+		sprintf (port_str, "%d", cs_stat->tcp_port_num);
+		new_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	} else {
+		new_sock = cef_csmgr_csmgr_connect_local (cs_stat);
+	}
+	if (new_sock != -1) {
+		cef_csmgr_credit_subscribe (cs_stat, 0, new_sock);
+		cef_csmgr_presence_subscribe (cs_stat, new_sock);
+	}
+	pthread_mutex_lock (&cs_stat->sock_mutex);
+	if (new_sock != -1) {
+		cs_stat->new_sock = new_sock;
+	} else {
+		cs_stat->sock_retry_time = nowt + CefC_Csmgr_Reconnect_Retry;
+	}
+	pthread_mutex_unlock (&cs_stat->sock_mutex);
+
+	return (sock);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the socket obtained by cef_csmgr_member_sock_get
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_member_sock_put (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member (0 for single csmgrd)		*/
+	int res									/* negative if the send failed				*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	CefT_Csmgr_Member* mp;
+
+	/* A part of the message may have been sent, so the stream is closed and the 	*/
+	/* credits are counted again from the subscription on the next connection 		*/
+	if ((res < 0) && (que != NULL)) {
+		pthread_mutex_lock (&que->mutex);
+		que->credit_f[member] = 0;
+		que->credit[member]   = 0;
+		pthread_mutex_unlock (&que->mutex);
+	}
+
+	if (cs_stat->cluster == NULL) {
+		pthread_mutex_lock (&cs_stat->sock_mutex);
+		if (res < 0) {
+			cs_stat->sock_fail_f = 1;
+		}
+		cs_stat->sock_ref--;
+		pthread_mutex_unlock (&cs_stat->sock_mutex);
+		return;
+	}
+	mp = &cs_stat->cluster->member[member];
+
+	/* The main thread closes the socket and the health check connects it again 	*/
+	pthread_mutex_lock (&cs_stat->cluster->mutex);
+	if (res < 0) {
+		mp->fail_f = 1;
+	}
+	mp->send_ref--;
+	pthread_mutex_unlock (&cs_stat->cluster->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Requests csmgrd to grant the credits for the Upload Requests
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_credit_subscribe (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member connected with the socket	*/
+	int sock								/* socket connected to csmgrd				*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	unsigned char buff[CefC_Csmgr_Msg_HeaderLen];
+	uint16_t value16;
+	uint64_t retried = 0;
+
+	if ((que == NULL) || (member < 0) || (member >= CefC_Csmgr_Cluster_Max)) {
+		return;
+	}
+
+	/* The batches flow freely until the first credits arrive, csmgrd which 	*/
+	/* does not know this message never grants them 							*/
+	pthread_mutex_lock (&que->mutex);
+	que->credit_f[member] = 0;
+	que->credit[member]   = 0;
+	pthread_mutex_unlock (&que->mutex);
+
+	buff[CefC_O_Fix_Ver]  = CefC_Version;
+	buff[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Credit;
+	value16 = htons ((uint16_t) sizeof (buff));
+	memcpy (&buff[CefC_O_Length], &value16, CefC_S_Length);
+
+	if (cef_csmgr_sock_send_all (sock, buff, sizeof (buff), &retried) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (send the credit request)\n", __func__);
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Handles the credit message from csmgrd
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_credit_msg_process (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member which sent it				*/
+	unsigned char* msg,						/* payload of the message					*/
+	uint16_t msg_len						/* length of the payload					*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	uint32_t value32;
+
+	/* [granted bytes(4)] 	*/
+	if ((que == NULL) || (msg_len < sizeof (uint32_t)) ||
+		(member < 0) || (member >= CefC_Csmgr_Cluster_Max)) {
+		return;
+	}
+	memcpy (&value32, msg, sizeof (uint32_t));
+
+	pthread_mutex_lock (&que->mutex);
+	if (que->credit_f[member] == 0) {
+		que->credit_f[member] = 1;
+		que->credit[member]   = 0;
+		cef_log_write (CefC_Log_Info,
+			"csmgrd controls the flow of Upload Requests (window %u bytes)\n",
+			ntohl (value32));
+	}
+	que->credit[member] += ntohl (value32);
+	pthread_mutex_unlock (&que->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the insert queue
+----------------------------------------------------------------------------------------*/
+static CefT_Csmgr_Insert_Que*		/* The return value is null if an error occurs		*/
+cef_csmgr_insert_que_create (
+	uint64_t size,							/* capacity of the queue (bytes)			*/
+	int policy								/* CefC_Csmgr_Insert_XXX					*/
+) {
+	CefT_Csmgr_Insert_Que* que;
+
+	que = (CefT_Csmgr_Insert_Que*) calloc (1, sizeof (CefT_Csmgr_Insert_Que));
+	if (que == NULL) {
+		return (NULL);
+	}
+	pthread_mutex_init (&que->mutex, NULL);
+	que->size 	= size;
+	que->policy = policy;
+
+	return (que);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the insert queue
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_insert_que_destroy (
+	CefT_Csmgr_Insert_Que* que
+) {
+	CefT_Csmgr_Insert_Entry* entry;
+
+	while (que->head != NULL) {
+		entry = que->head;
+		que->head = entry->next;
+		free (entry);
+	}
+	pthread_mutex_destroy (&que->mutex);
+	free (que);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Puts the batch of Upload Requests into the insert queue
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_insert_que_push (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	int member,								/* cluster member to send to				*/
+	unsigned char* msg,						/* batch of Upload Request messages			*/
+	int msg_len								/* length of the batch						*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	CefT_Csmgr_Insert_Entry* entry;
+	CefT_Csmgr_Insert_Entry* old;
+
+	if (que == NULL) {
+		cef_csmgr_send_msg_to_csmgr (cs_stat, member, msg, msg_len);
+		return;
+	}
+
+	entry = (CefT_Csmgr_Insert_Entry*) malloc (sizeof (CefT_Csmgr_Insert_Entry) + msg_len);
+	if (entry == NULL) {
+		pthread_mutex_lock (&que->mutex);
+		que->dropped_bytes += msg_len;
+		pthread_mutex_unlock (&que->mutex);
+		return;
+	}
+	entry->next   = NULL;
+	entry->member = member;
+	entry->len 	  = msg_len;
+	memcpy (entry->msg, msg, msg_len);
+
+	pthread_mutex_lock (&que->mutex);
+
+	/* Keeps a sample of the batches before the queue becomes full 	*/
+	if ((que->policy == CefC_Csmgr_Insert_Sample) &&
+		(que->used + msg_len > que->size / 4 * 3)) {
+		que->sample_cnt++;
+		if (que->sample_cnt % CefC_Csmgr_Insert_Sample_Rate != 0) {
+			que->dropped_bytes += msg_len;
+			pthread_mutex_unlock (&que->mutex);
+			free (entry);
+			return;
+		}
+	}
+	if ((que->policy == CefC_Csmgr_Insert_Drop_Oldest) &&
+		(que->used + msg_len > que->size)) {
+		while ((que->head != NULL) && (que->used + msg_len > que->size)) {
+			old = que->head;
+			que->head = old->next;
+			que->used -= old->len;
+			que->dropped_bytes += old->len;
+			free (old);
+		}
+		if (que->head == NULL) {
+			que->tail = NULL;
+		}
+	}
+	if (que->used + msg_len > que->size) {
+		que->dropped_bytes += msg_len;
+		pthread_mutex_unlock (&que->mutex);
+		free (entry);
+		return;
+	}
+
+	if (que->tail != NULL) {
+		que->tail->next = entry;
+	} else {
+		que->head = entry;
+	}
+	que->tail = entry;
+	que->used += msg_len;
+	que->queued_bytes += msg_len;
+
+	pthread_mutex_unlock (&que->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the batches in the insert queue as far as the credits allow
+----------------------------------------------------------------------------------------*/
+static int							/* 1 if the batches which can be sent remain		*/
+cef_csmgr_insert_que_send (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	CefT_Csmgr_Insert_Entry* entry;
+	CefT_Csmgr_Insert_Entry* prev;
+	uint64_t retried;
+	int sock;
+	int res;
+	int n;
+
+	if (que == NULL) {
+		return (0);
+	}
+
+	for (n = 0 ; n < CefC_Csmgr_Insert_Burst ; n++) {
+		/* Takes the oldest batch of the member which has the credits, a batch 	*/
+		/* larger than the remaining credits is sent as long as any remain 		*/
+		pthread_mutex_lock (&que->mutex);
+		prev = NULL;
+		for (entry = que->head ; entry != NULL ; prev = entry, entry = entry->next) {
+			if ((que->credit_f[entry->member] == 0) || (que->credit[entry->member] > 0)) {
+				break;
+			}
+		}
+		if (entry == NULL) {
+			pthread_mutex_unlock (&que->mutex);
+			return (0);
+		}
+		if (prev != NULL) {
+			prev->next = entry->next;
+		} else {
+			que->head = entry->next;
+		}
+		if (que->tail == entry) {
+			que->tail = prev;
+		}
+		que->used -= entry->len;
+		if (que->credit_f[entry->member]) {
+			que->credit[entry->member] -= entry->len;
+		}
+		pthread_mutex_unlock (&que->mutex);
+
+		/* Sends it without the lock, so cefnetd can queue the next batches 	*/
+		retried = 0;
+		res = -1;
+		sock = cef_csmgr_member_sock_get (cs_stat, entry->member);
+		if (sock != -1) {
+			res = cef_csmgr_sock_send_all (sock, entry->msg, entry->len, &retried);
+			cef_csmgr_member_sock_put (cs_stat, entry->member, res);
+		}
+
+		pthread_mutex_lock (&que->mutex);
+		que->retried_bytes += retried;
+		if (res < 0) {
+			que->dropped_bytes += entry->len;
+		} else {
+			que->sent_bytes += entry->len;
+		}
+		pthread_mutex_unlock (&que->mutex);
+		free (entry);
+	}
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the insert queue
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_insert_stat_get (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_Csmgr_Insert_Stat* stat
+) {
+	CefT_Csmgr_Insert_Que* que = cs_stat->insert_que;
+	int m;
+
+	memset (stat, 0, sizeof (CefT_Csmgr_Insert_Stat));
+	if (que == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock (&que->mutex);
+	stat->queued_bytes 	= que->queued_bytes;
+	stat->sent_bytes 	= que->sent_bytes;
+	stat->dropped_bytes = que->dropped_bytes;
+	stat->retried_bytes = que->retried_bytes;
+	stat->req_dropped 	= que->req_dropped;
+	stat->used 			= que->used;
+	stat->size 			= que->size;
+	stat->policy 		= que->policy;
+	for (m = 0 ; m < CefC_Csmgr_Cluster_Max ; m++) {
+		if (que->credit_f[m]) {
+			stat->credit_f = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock (&que->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the whole message to the socket of csmgrd without dropping a part
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_sock_send_all (
+	int sock,
+	unsigned char* msg,
+	int msg_len,
+	uint64_t* retried						/* bytes which had to wait for the socket	*/
+) {
+	struct pollfd fds[1];
+	int index = 0;
+	int res;
+
+	/* A partial batch would break the stream, so the rest is always sent 	*/
+	while (index < msg_len) {
+		res = send (sock, &msg[index], msg_len - index, MSG_DONTWAIT);
+		if (res > 0) {
+			index += res;
+			continue;
+		}
+		if ((res < 0) &&
+			(errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+			return (-1);
+		}
+		*retried += msg_len - index;
+
+		fds[0].fd = sock;
+		fds[0].events = POLLOUT | POLLERR;
+		if (poll (fds, 1, CefC_Csmgr_Insert_Send_Timeout) < 1) {
+			return (-1);
+		}
+	}
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Connects to csmgrd to send a request about the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_ctrl_connect (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	const unsigned char* name,				/* Name which selects the member (or NULL)	*/
+	uint16_t name_len
+) {
+	char port_str[NI_MAXSERV];
+	CefT_Csmgr_Member* mp;
+	int member;
+
+	if (cs_stat->cluster == NULL) {
+		sprintf (port_str, "%d", cs_stat->tcp_port_num);
+		return (cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str));
+	}
+
+	member = cef_csmgr_cluster_member_select (cs_stat->cluster, name, name_len);
+	if (member < 0) {
+		return (-1);
+	}
+	mp = &cs_stat->cluster->member[member];
+	sprintf (port_str, "%d", mp->port_num);
+
+	return (cef_csmgr_connect_tcp_to_csmgr (mp->peer_id_str, port_str));
+}
+/*--------------------------------------------------------------------------------------
+	Hash of the consistent hash ring (FNV-1a)
+----------------------------------------------------------------------------------------*/
+static uint32_t
+cef_csmgr_cluster_hash (
+	const unsigned char* key,
+	int key_len
+) {
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0 ; i < key_len ; i++) {
+		hash ^= key[i];
+		hash *= 16777619u;
+	}
+	/* Mixes the bits since names often differ only in the last bytes 	*/
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+
+	return (hash);
+}
+/*--------------------------------------------------------------------------------------
+	Compares the points on the ring
+----------------------------------------------------------------------------------------*/
+static int
+cef_csmgr_cluster_point_compare (
+	const void* a,
+	const void* b
+) {
+	const CefT_Csmgr_Point* pa = (const CefT_Csmgr_Point*) a;
+	const CefT_Csmgr_Point* pb = (const CefT_Csmgr_Point*) b;
+
+	if (pa->hash != pb->hash) {
+		return ((pa->hash < pb->hash) ? -1 : 1);
+	}
+	return (pa->member - pb->member);
+}
+/*--------------------------------------------------------------------------------------
+	Reads the members of the cluster from the value of CSMGR_CLUSTER
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_cluster_config_parse (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	char* value								/* host:port list separated by commas		*/
+) {
+	CefT_Csmgr_Cluster* cluster;
+	CefT_Csmgr_Member* mp;
+	char* entry;
+	char* port;
+	char vnode[NI_MAXHOST + 32];
+	int64_t res;
+	int m, v;
+
+	if (cs_stat->cluster == NULL) {
+		cs_stat->cluster = (CefT_Csmgr_Cluster*) malloc (sizeof (CefT_Csmgr_Cluster));
+		if (cs_stat->cluster == NULL) {
+			cef_log_write (CefC_Log_Error, "%s (malloc CefT_Csmgr_Cluster)\n", __func__);
+			return (-1);
+		}
+	}
+	cluster = cs_stat->cluster;
+	memset (cluster, 0, sizeof (CefT_Csmgr_Cluster));
+
+	while ((entry = strsep (&value, ",")) != NULL) {
+		if (entry[0] == 0x00) {
+			continue;
+		}
+		if (cluster->member_num >= CefC_Csmgr_Cluster_Max) {
+			cef_log_write (CefC_Log_Error,
+				"CSMGR_CLUSTER must have less than or equal to %d members.\n",
+				CefC_Csmgr_Cluster_Max);
+			return (-1);
+		}
+		mp = &cluster->member[cluster->member_num];
+
+		/* Port number can be omitted 	*/
+		port = strrchr (entry, ':');
+		if (port != NULL) {
+			*port = 0x00;
+			port++;
+			res = cef_csmgr_config_get_value ("CSMGR_CLUSTER", port);
+			if ((res < 1025) || (res > 65535)) {
+				cef_log_write (CefC_Log_Error,
+					"Port number of CSMGR_CLUSTER must be higher than 1024 and lower than 65536.\n");
+				return (-1);
+			}
+			mp->port_num = (uint16_t) res;
+		} else {
+			mp->port_num = CefC_Default_Tcp_Prot;
+		}
+		if ((entry[0] == 0x00) || (strlen (entry) >= NI_MAXHOST)) {
+			cef_log_write (CefC_Log_Error, "Invalid node in CSMGR_CLUSTER.\n");
+			return (-1);
+		}
+		strcpy (mp->peer_id_str, entry);
+		mp->sock 	 = -1;
+		mp->new_sock = -1;
+		cluster->member_num++;
+	}
+	if (cluster->member_num == 0) {
+		free (cs_stat->cluster);
+		cs_stat->cluster = NULL;
+		return (0);
+	}
+	pthread_mutex_init (&cluster->mutex, NULL);
+
+	/* Each member owns the arcs which end at its points on the ring 	*/
+	for (m = 0 ; m < cluster->member_num ; m++) {
+		mp = &cluster->member[m];
+		for (v = 0 ; v < CefC_Csmgr_Cluster_Vnode ; v++) {
+			sprintf (vnode, "%s:%u#%d", mp->peer_id_str, mp->port_num, v);
+			cluster->point[cluster->point_num].hash =
+				cef_csmgr_cluster_hash ((unsigned char*) vnode, strlen (vnode));
+			cluster->point[cluster->point_num].member = m;
+			cluster->point_num++;
+		}
+	}
+	qsort (cluster->point, cluster->point_num,
+		sizeof (CefT_Csmgr_Point), cef_csmgr_cluster_point_compare);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Selects the cluster member which takes the content
+----------------------------------------------------------------------------------------*/
+int									/* Index of the member, -1 if all members are down	*/
+cef_csmgr_cluster_member_select (
+	CefT_Csmgr_Cluster* cluster,
+	const unsigned char* name,				/* Name without chunk (NULL: any member)	*/
+	uint16_t name_len
+) {
+	CefT_Csmgr_Member* mp;
+	uint32_t hash;
+	int lo, hi, mid;
+	int n;
+
+	if (name == NULL) {
+		for (n = 0 ; n < cluster->member_num ; n++) {
+			if ((cluster->member[n].sock != -1) && (cluster->member[n].down_f == 0)) {
+				return (n);
+			}
+		}
+		return (-1);
+	}
+
+	/* Finds the first point at or after the hash of the name 	*/
+	hash = cef_csmgr_cluster_hash (name, name_len);
+	lo = 0;
+	hi = cluster->point_num;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (cluster->point[mid].hash < hash) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	/* The contents of the member which is down move to the next member on the ring, */
+	/* and come back to it when it joins again 										 */
+	for (n = 0 ; n < cluster->point_num ; n++) {
+		mp = &cluster->member[cluster->point[(lo + n) % cluster->point_num].member];
+		if ((mp->sock != -1) && (mp->down_f == 0)) {
+			return (cluster->point[(lo + n) % cluster->point_num].member);
+		}
+	}
+
+	return (-1);
+}
+/*--------------------------------------------------------------------------------------
+	Marks the cluster member connected with the socket as down
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_cluster_member_down (
+	CefT_Csmgr_Cluster* cluster,
+	int sock
+) {
+	int m;
+
+	pthread_mutex_lock (&cluster->mutex);
+	for (m = 0 ; m < cluster->member_num ; m++) {
+		if ((cluster->member[m].sock == sock) && (cluster->member[m].down_f == 0)) {
+			/* cef_csmgr_cluster_member_update closes the socket 	*/
+			cluster->member[m].rcv_len = 0;
+			cluster->member[m].down_f  = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock (&cluster->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Takes the members the sending thread connected or failed to send to
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_cluster_member_update (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	CefT_Csmgr_Cluster* cluster = cs_stat->cluster;
+	CefT_Csmgr_Member* mp;
+	uint64_t nowt;
+	int m;
+
+	nowt = cef_client_present_timeus_calc ();
+
+	pthread_mutex_lock (&cluster->mutex);
+	for (m = 0 ; m < cluster->member_num ; m++) {
+		mp = &cluster->member[m];
+
+		if (mp->fail_f) {
+			mp->fail_f = 0;
+			if (mp->sock != -1) {
+				mp->down_f = 1;
+			}
+		}
+		if ((mp->sock != -1) && (mp->down_f)) {
+			if (mp->send_ref > 0) {
+				/* The sending thread returns from the socket soon 	*/
+				shutdown (mp->sock, SHUT_RDWR);
 				continue;
 			}
+			cef_log_write (CefC_Log_Warn,
+				"csmgrd (%s:%u) leaves the cluster\n", mp->peer_id_str, mp->port_num);
+			close (mp->sock);
+			mp->sock 	   = -1;
+			mp->down_f 	   = 0;
+			mp->rcv_len    = 0;
+			mp->retry_time = nowt + CefC_Csmgr_Cluster_Retry;
+		}
+		if ((mp->sock == -1) && (mp->new_sock != -1)) {
+			mp->sock 	 = mp->new_sock;
+			mp->new_sock = -1;
+			mp->rcv_len  = 0;
+			cef_log_write (CefC_Log_Info,
+				"csmgrd (%s:%u) joins the cluster\n", mp->peer_id_str, mp->port_num);
+		}
+	}
+	pthread_mutex_unlock (&cluster->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Marks the socket of the single csmgrd as broken
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_csmgr_sock_down (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	pthread_mutex_lock (&cs_stat->sock_mutex);
+	cs_stat->sock_fail_f = 1;
+	pthread_mutex_unlock (&cs_stat->sock_mutex);
 
-			if (cs_stat->tcp_sock == -1) {
-				sprintf (port_str, "%d", cs_stat->tcp_port_num);
-				cs_stat->tcp_sock
-						= cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Closes the broken socket of the single csmgrd and takes the one connected again
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_csmgr_sock_update (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	pthread_mutex_lock (&cs_stat->sock_mutex);
+	if (cs_stat->sock_fail_f) {
+		if (cs_stat->sock_ref > 0) {
+			/* The sending thread returns from the socket soon 	*/
+			if (cs_stat->local_sock != -1) {
+				shutdown (cs_stat->local_sock, SHUT_RDWR);
 			}
 			if (cs_stat->tcp_sock != -1) {
-				int	send_count = 0;
-				res = 0;
-    			unsigned char* mp = msg;
-    			int len = msg_len;
-				fd_set fds, writefds;
-				int n;
-				struct timeval timeout;
-
-				res = send( cs_stat->tcp_sock, mp, len, MSG_DONTWAIT );
-				if ( res <= 0 ) {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-					fprintf(stderr, "[%s](res <=0): ###########(3) ERROR(%d)=%s send_count:%d\n", __FUNCTION__, errno, strerror (errno), send_count);
-#endif
-					if ( errno == EAGAIN ) {
-						usleep(CEF_CSMGR_SEND_USLEEP);
-					}
-					continue;
-				}
-				len -= res;
-				mp += res;
-				send_count++;
-
-				while( len > 0 ){
-					timeout.tv_sec  = 0;
-					timeout.tv_usec = CEF_CSMGR_SEND_TIMEOUT;
-					FD_ZERO (&writefds);
-					FD_SET (cs_stat->tcp_sock, &writefds);
-					memcpy (&fds, &writefds, sizeof (fds));
-					n = select(cs_stat->tcp_sock+1, NULL, &fds, NULL, &timeout);
-					if (n > 0) {
-						if (FD_ISSET (cs_stat->tcp_sock, &fds)) {
-							res = send( cs_stat->tcp_sock, mp, len, MSG_DONTWAIT );
-								if(res > 0) {
-								len -= res;
-								mp += res;
-							} else {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-								fprintf(stderr, "[%s](res <=0): ###########(4) ERROR(%d)=%s \n", __FUNCTION__, errno, strerror (errno));
-#endif
-								if ( errno == EAGAIN ) {
-									usleep(CEF_CSMGR_SEND_USLEEP);
-								}
-							}
-							send_count++;
-							if ( send_count > DEMO_RETRY_NUM ) {
-								break;
-							}
-						}
-					} else {
-						if ( send_count == 0 ) {
-							break;
-						} else if ( send_count > DEMO_RETRY_NUM ) {
-#ifdef	__DEV_CEF_CSMGR_SEND__
-							fprintf(stderr, "[%s](%d): ########### n:%d   send_count:%d   len:%d   %s\n",
-												__FUNCTION__, __LINE__, n, send_count, len, strerror (errno));
-#endif
-							break;
-						}
-						send_count++;
-						if ( errno == EAGAIN ) {
-							usleep(CEF_CSMGR_SEND_USLEEP);
-						}
-					}
-				}
-				continue;
+				shutdown (cs_stat->tcp_sock, SHUT_RDWR);
 			}
-			/*###########*/
+			pthread_mutex_unlock (&cs_stat->sock_mutex);
+			return;
+		}
+		if ((cs_stat->local_sock != -1) || (cs_stat->tcp_sock != -1)) {
+			cef_log_write (CefC_Log_Warn,
+				"Connection to csmgrd is closed, so cefnetd connects again\n");
+		}
+		csmgr_sock_close (cs_stat);
+		cs_stat->rcv_len 		 = 0;
+		cs_stat->sock_fail_f 	 = 0;
+		cs_stat->sock_retry_time =
+			cef_client_present_timeus_calc () + CefC_Csmgr_Reconnect_Retry;
+	}
+	if ((cs_stat->local_sock == -1) && (cs_stat->tcp_sock == -1) &&
+		(cs_stat->new_sock != -1)) {
+		if ((strcmp (cs_stat->peer_id_str, "localhost")) &&
+			(strcmp (cs_stat->peer_id_str, "127.0.0.1"))) {
+			cs_stat->tcp_sock = cs_stat->new_sock;
+		} else {
+			cs_stat->local_sock = cs_stat->new_sock;
+		}
+		cs_stat->new_sock = -1;
+		cs_stat->rcv_len  = 0;
+		cef_log_write (CefC_Log_Info, "Connected to csmgrd again\n");
+
+		/* The ring went with the old connection, it is handed over before the 	*/
+		/* sending thread uses the socket 										*/
+		if ((cs_stat->local_sock != -1) && (cs_stat->shm_size > 0) &&
+			(cef_csmgr_shm_connect (cs_stat) < 0)) {
+			cef_log_write (CefC_Log_Warn,
+				"Shared-memory transport is not available, so the socket is used\n");
 		}
 	}
+	pthread_mutex_unlock (&cs_stat->sock_mutex);
 
-	pthread_exit (NULL);
-	return 0;
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Checks the members and connects again the member which was down
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_cluster_health_check (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	CefT_Csmgr_Cluster* cluster = cs_stat->cluster;
+	CefT_Csmgr_Member* mp;
+	char port_str[NI_MAXSERV];
+	uint64_t nowt;
+	int wait_f;
+	int sock;
+	int m;
+
+	nowt = cef_client_present_timeus_calc ();
+
+	for (m = 0 ; m < cluster->member_num ; m++) {
+		mp = &cluster->member[m];
+
+		pthread_mutex_lock (&cluster->mutex);
+		wait_f = (mp->sock != -1) || (mp->new_sock != -1) || (nowt < mp->retry_time);
+		pthread_mutex_unlock (&cluster->mutex);
+		if (wait_f) {
+			continue;
+		}
 
+		sprintf (port_str, "%u", mp->port_num);
+		sock = cef_csmgr_connect_tcp_to_csmgr (mp->peer_id_str, port_str);
+		if (sock < 0) {
+			pthread_mutex_lock (&cluster->mutex);
+			mp->retry_time = nowt + CefC_Csmgr_Cluster_Retry;
+			pthread_mutex_unlock (&cluster->mutex);
+			continue;
+		}
+		cef_csmgr_credit_subscribe (cs_stat, m, sock);
+
+		/* The main thread starts to use it from cef_csmgr_cluster_member_update 	*/
+		pthread_mutex_lock (&cluster->mutex);
+		mp->new_sock = sock;
+		pthread_mutex_unlock (&cluster->mutex);
+	}
+
+	return;
 }
 
 int
@@ -2875,7 +4360,6 @@ cef_csmgr_content_info_get (
 	uint16_t		range_len,				/* Range length								*/
 	char**			info
 ) {
-	char			port_str[NI_MAXSERV];
 	int				tmp_sock;
 	unsigned char	buff[CefC_Max_Length] = {0};
 	int				buff_size;
@@ -2894,8 +4378,7 @@ cef_csmgr_content_info_get (
 	}
 
 	/* Creates the socket to csmgr with TCP */
-	sprintf (port_str, "%d", cs_stat->tcp_port_num);
-	tmp_sock = cef_csmgr_connect_tcp_to_csmgr (cs_stat->peer_id_str, port_str);
+	tmp_sock = cef_csmgr_ctrl_connect (cs_stat, (const unsigned char*) name, name_len);
 	if (tmp_sock < 0) {
 		/* Connection Failed */
 		return (-1);
@@ -2995,6 +4478,626 @@ RETCEFNETD:;
 	return (res);
 }
 
+/*--------------------------------------------------------------------------------------
+	Serves the disk I/O request in the calling thread
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_aio_io (
+	CefT_Csmgr_Aio_Req* req
+) {
+	ssize_t res;
+
+	while (req->done_len < req->len) {
+		if (req->op == CefC_Csmgr_Aio_Read) {
+			res = pread (req->fd, req->buf + req->done_len,
+					req->len - req->done_len, req->off + (off_t) req->done_len);
+		} else {
+			res = pwrite (req->fd, req->buf + req->done_len,
+					req->len - req->done_len, req->off + (off_t) req->done_len);
+		}
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			req->err = errno;
+			return;
+		}
+		if (res == 0) {
+			/* End of file 		*/
+			return;
+		}
+		req->done_len += (size_t) res;
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Thread which serves the disk I/O requests without io_uring
+----------------------------------------------------------------------------------------*/
+static void*
+cef_csmgr_aio_thread (
+	void* arg
+) {
+	CefT_Csmgr_Aio* aio = (CefT_Csmgr_Aio*) arg;
+	CefT_Csmgr_Aio_Req* req;
+
+	while (1) {
+		pthread_mutex_lock (&aio->mutex);
+		while ((aio->head == NULL) && (aio->stop_f == 0)) {
+			pthread_cond_wait (&aio->cond, &aio->mutex);
+		}
+		req = aio->head;
+		if (req == NULL) {
+			/* Stops after all requests have completed 		*/
+			pthread_mutex_unlock (&aio->mutex);
+			break;
+		}
+		aio->head = req->next;
+		if (aio->head == NULL) {
+			aio->tail = NULL;
+		}
+		pthread_mutex_unlock (&aio->mutex);
+
+		cef_csmgr_aio_io (req);
+		if (req->err) {
+			__atomic_add_fetch (&aio->failed, 1, __ATOMIC_RELAXED);
+		}
+		(*req->done)(req);
+	}
+
+	pthread_exit (NULL);
+	return ((void*) NULL);
+}
+#ifdef CefC_Csmgr_Aio_Uring
+/*--------------------------------------------------------------------------------------
+	Sets up the io_uring rings
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+cef_csmgr_aio_uring_setup (
+	CefT_Csmgr_Aio* aio
+) {
+	struct io_uring_params params;
+	unsigned char* sq_ptr;
+	unsigned char* cq_ptr;
+	int fd;
+
+	memset (&params, 0, sizeof (params));
+	fd = (int) syscall (__NR_io_uring_setup, CefC_Csmgr_Aio_Depth, &params);
+	if (fd < 0) {
+		return (-1);
+	}
+	aio->ring_fd 	= fd;
+	aio->sq_size 	= params.sq_off.array + params.sq_entries * sizeof (unsigned int);
+	aio->cq_size 	= params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+	aio->sqes_size 	= params.sq_entries * sizeof (struct io_uring_sqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (aio->cq_size > aio->sq_size) {
+			aio->sq_size = aio->cq_size;
+		}
+		aio->cq_size = 0;
+	}
+#endif // IORING_FEAT_SINGLE_MMAP
+
+	aio->sq_ptr = mmap (NULL, aio->sq_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (aio->sq_ptr == MAP_FAILED) {
+		aio->sq_ptr = NULL;
+		return (-1);
+	}
+	if (aio->cq_size) {
+		aio->cq_ptr = mmap (NULL, aio->cq_size, PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (aio->cq_ptr == MAP_FAILED) {
+			aio->cq_ptr = NULL;
+			return (-1);
+		}
+	} else {
+		aio->cq_ptr = aio->sq_ptr;
+	}
+	aio->sqes = mmap (NULL, aio->sqes_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (aio->sqes == MAP_FAILED) {
+		aio->sqes = NULL;
+		return (-1);
+	}
+
+	sq_ptr = (unsigned char*) aio->sq_ptr;
+	cq_ptr = (unsigned char*) aio->cq_ptr;
+	aio->sq_tail 	= (unsigned int*)(sq_ptr + params.sq_off.tail);
+	aio->sq_array 	= (unsigned int*)(sq_ptr + params.sq_off.array);
+	aio->sq_mask 	= *(unsigned int*)(sq_ptr + params.sq_off.ring_mask);
+	aio->sq_entries = params.sq_entries;
+	aio->cq_head 	= (unsigned int*)(cq_ptr + params.cq_off.head);
+	aio->cq_tail 	= (unsigned int*)(cq_ptr + params.cq_off.tail);
+	aio->cq_mask 	= *(unsigned int*)(cq_ptr + params.cq_off.ring_mask);
+	aio->cqes 		= cq_ptr + params.cq_off.cqes;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the io_uring rings
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_aio_uring_cleanup (
+	CefT_Csmgr_Aio* aio
+) {
+	if (aio->sqes) {
+		munmap (aio->sqes, aio->sqes_size);
+	}
+	if (aio->cq_ptr && (aio->cq_ptr != aio->sq_ptr)) {
+		munmap (aio->cq_ptr, aio->cq_size);
+	}
+	if (aio->sq_ptr) {
+		munmap (aio->sq_ptr, aio->sq_size);
+	}
+	if (aio->ring_fd != -1) {
+		close (aio->ring_fd);
+	}
+	aio->sqes 		= NULL;
+	aio->cq_ptr 	= NULL;
+	aio->sq_ptr 	= NULL;
+	aio->ring_fd 	= -1;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Moves the waiting requests to the SQ ring (called with aio->mutex held)
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_aio_uring_push (
+	CefT_Csmgr_Aio* aio
+) {
+	struct io_uring_sqe* sqe;
+	CefT_Csmgr_Aio_Req* req;
+	unsigned int tail;
+	unsigned int idx;
+	unsigned int num = 0;
+	int res;
+
+	tail = *aio->sq_tail;
+	while ((aio->head != NULL) && (aio->inflight < aio->sq_entries)) {
+		req = aio->head;
+		aio->head = req->next;
+		if (aio->head == NULL) {
+			aio->tail = NULL;
+		}
+
+		idx = tail & aio->sq_mask;
+		sqe = &((struct io_uring_sqe*) aio->sqes)[idx];
+		memset (sqe, 0, sizeof (struct io_uring_sqe));
+		req->iov.iov_base 	= req->buf + req->done_len;
+		req->iov.iov_len 	= req->len - req->done_len;
+		sqe->opcode 	= (req->op == CefC_Csmgr_Aio_Read) ?
+							IORING_OP_READV : IORING_OP_WRITEV;
+		sqe->fd 		= req->fd;
+		sqe->off 		= (uint64_t)(req->off + (off_t) req->done_len);
+		sqe->addr 		= (uint64_t)(uintptr_t) &req->iov;
+		sqe->len 		= 1;
+		sqe->user_data 	= (uint64_t)(uintptr_t) req;
+		aio->sq_array[idx] = idx;
+		tail++;
+		num++;
+		aio->inflight++;
+	}
+	/* A NOP without the request wakes up the completion thread to stop it 	*/
+	if ((aio->head == NULL) && (aio->stop_f == 1) && (aio->inflight < aio->sq_entries)) {
+		idx = tail & aio->sq_mask;
+		sqe = &((struct io_uring_sqe*) aio->sqes)[idx];
+		memset (sqe, 0, sizeof (struct io_uring_sqe));
+		sqe->opcode = IORING_OP_NOP;
+		aio->sq_array[idx] = idx;
+		aio->stop_f = 2;
+		tail++;
+		num++;
+		aio->inflight++;
+	}
+	if (num == 0) {
+		return;
+	}
+	__atomic_store_n (aio->sq_tail, tail, __ATOMIC_RELEASE);
+
+	do {
+		res = (int) syscall (__NR_io_uring_enter, aio->ring_fd, num, 0, 0, NULL, 0);
+	} while ((res < 0) && (errno == EINTR));
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Thread which reaps the completions of io_uring
+----------------------------------------------------------------------------------------*/
+static void*
+cef_csmgr_aio_uring_thread (
+	void* arg
+) {
+	CefT_Csmgr_Aio* aio = (CefT_Csmgr_Aio*) arg;
+	struct io_uring_cqe* cqe;
+	CefT_Csmgr_Aio_Req* req;
+	CefT_Csmgr_Aio_Req* retry;
+	unsigned int head;
+	unsigned int num;
+	int res;
+
+	while (1) {
+		res = (int) syscall (__NR_io_uring_enter,
+				aio->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		if ((res < 0) && (errno != EINTR)) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to wait for the disk I/O (%s)\n", strerror (errno));
+			break;
+		}
+
+		num = 0;
+		head = *aio->cq_head;
+		while (head != __atomic_load_n (aio->cq_tail, __ATOMIC_ACQUIRE)) {
+			cqe = &((struct io_uring_cqe*) aio->cqes)[head & aio->cq_mask];
+			req = (CefT_Csmgr_Aio_Req*)(uintptr_t) cqe->user_data;
+			res = cqe->res;
+			head++;
+			__atomic_store_n (aio->cq_head, head, __ATOMIC_RELEASE);
+			num++;
+
+			if (req == NULL) {
+				continue;
+			}
+			retry = NULL;
+			if (res < 0) {
+				if (res == -EINTR || res == -EAGAIN) {
+					retry = req;
+				} else {
+					req->err = -res;
+				}
+			} else if (res > 0) {
+				req->done_len += (size_t) res;
+				if (req->done_len < req->len) {
+					retry = req;
+				}
+			}
+			if (retry) {
+				/* Submits the rest of the buffer again 		*/
+				pthread_mutex_lock (&aio->mutex);
+				retry->next = aio->head;
+				aio->head = retry;
+				if (aio->tail == NULL) {
+					aio->tail = retry;
+				}
+				pthread_mutex_unlock (&aio->mutex);
+				continue;
+			}
+			if (req->err) {
+				__atomic_add_fetch (&aio->failed, 1, __ATOMIC_RELAXED);
+			}
+			(*req->done)(req);
+		}
+
+		pthread_mutex_lock (&aio->mutex);
+		aio->inflight -= num;
+		cef_csmgr_aio_uring_push (aio);
+		if (aio->stop_f && (aio->head == NULL) && (aio->inflight == 0)) {
+			/* Stops after all requests have completed 		*/
+			pthread_mutex_unlock (&aio->mutex);
+			break;
+		}
+		pthread_mutex_unlock (&aio->mutex);
+	}
+
+	pthread_exit (NULL);
+	return ((void*) NULL);
+}
+#endif // CefC_Csmgr_Aio_Uring
+/*--------------------------------------------------------------------------------------
+	Creates the disk I/O engine, which uses io_uring if the kernel provides it
+----------------------------------------------------------------------------------------*/
+CefT_Csmgr_Aio*						/* The return value is null if an error occurs		*/
+cef_csmgr_aio_create (
+	int thread_num							/* I/O threads used without io_uring		*/
+) {
+	CefT_Csmgr_Aio* aio;
+	int i;
+
+	aio = (CefT_Csmgr_Aio*) calloc (1, sizeof (CefT_Csmgr_Aio));
+	if (aio == NULL) {
+		return (NULL);
+	}
+	pthread_mutex_init (&aio->mutex, NULL);
+	pthread_cond_init (&aio->cond, NULL);
+	aio->ring_fd = -1;
+
+#ifdef CefC_Csmgr_Aio_Uring
+	/* io_uring may be unavailable (old kernels, seccomp), then the threads are used 	*/
+	if (cef_csmgr_aio_uring_setup (aio) == 0) {
+		if (pthread_create (&aio->th[0], NULL, cef_csmgr_aio_uring_thread, aio) == 0) {
+			aio->type 		= CefC_Csmgr_Aio_Type_Uring;
+			aio->thread_num = 1;
+			return (aio);
+		}
+	}
+	cef_csmgr_aio_uring_cleanup (aio);
+#endif // CefC_Csmgr_Aio_Uring
+
+	aio->type = CefC_Csmgr_Aio_Type_Thread;
+	if (thread_num < 1) {
+		thread_num = 1;
+	}
+	if (thread_num > CefC_Csmgr_Aio_Thread_Max) {
+		thread_num = CefC_Csmgr_Aio_Thread_Max;
+	}
+	for (i = 0 ; i < thread_num ; i++) {
+		if (pthread_create (&aio->th[i], NULL, cef_csmgr_aio_thread, aio) != 0) {
+			break;
+		}
+		aio->thread_num++;
+	}
+	if (aio->thread_num == 0) {
+		pthread_cond_destroy (&aio->cond);
+		pthread_mutex_destroy (&aio->mutex);
+		free (aio);
+		return (NULL);
+	}
+
+	return (aio);
+}
+/*--------------------------------------------------------------------------------------
+	Submits the disk I/O request, req->done is called when it completes
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_aio_submit (
+	CefT_Csmgr_Aio* aio,
+	CefT_Csmgr_Aio_Req* req
+) {
+	req->next 		= NULL;
+	req->done_len 	= 0;
+	req->err 		= 0;
+
+	pthread_mutex_lock (&aio->mutex);
+	if (aio->tail) {
+		aio->tail->next = req;
+	} else {
+		aio->head = req;
+	}
+	aio->tail = req;
+	aio->submitted++;
+#ifdef CefC_Csmgr_Aio_Uring
+	if (aio->type == CefC_Csmgr_Aio_Type_Uring) {
+		cef_csmgr_aio_uring_push (aio);
+		pthread_mutex_unlock (&aio->mutex);
+		return;
+	}
+#endif // CefC_Csmgr_Aio_Uring
+	pthread_cond_signal (&aio->cond);
+	pthread_mutex_unlock (&aio->mutex);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Completes the submitted requests and destroys the disk I/O engine
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_aio_destroy (
+	CefT_Csmgr_Aio* aio
+) {
+	void* status;
+	int i;
+
+	if (aio == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock (&aio->mutex);
+	aio->stop_f = 1;
+#ifdef CefC_Csmgr_Aio_Uring
+	if (aio->type == CefC_Csmgr_Aio_Type_Uring) {
+		cef_csmgr_aio_uring_push (aio);
+	}
+#endif // CefC_Csmgr_Aio_Uring
+	pthread_cond_broadcast (&aio->cond);
+	pthread_mutex_unlock (&aio->mutex);
+
+	for (i = 0 ; i < aio->thread_num ; i++) {
+		pthread_join (aio->th[i], &status);
+	}
+#ifdef CefC_Csmgr_Aio_Uring
+	cef_csmgr_aio_uring_cleanup (aio);
+#endif // CefC_Csmgr_Aio_Uring
+	pthread_cond_destroy (&aio->cond);
+	pthread_mutex_destroy (&aio->mutex);
+	free (aio);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Writes the rest of the length which does not fit in the token
+----------------------------------------------------------------------------------------*/
+static int							/* bytes written									*/
+cef_csmgr_lz_len_put (
+	unsigned char* dst,
+	int len									/* length minus 15							*/
+) {
+	int n = 0;
+
+	while (len >= 255) {
+		dst[n++] = 255;
+		len -= 255;
+	}
+	dst[n++] = (unsigned char) len;
+
+	return (n);
+}
+/*--------------------------------------------------------------------------------------
+	Compresses the block with the fast LZ codec used by the filesystem caches
+		The block is a list of the sequences, each of which has a token (4 bits of
+		the literal length and 4 bits of the match length), the literals and the
+		2 bytes offset of the match. The last sequence has the literals only.
+----------------------------------------------------------------------------------------*/
+int									/* compressed length, 0 if it exceeds dst_size		*/
+cef_csmgr_lz_compress (
+	const unsigned char* src,				/* block to be compressed					*/
+	int src_len,							/* length of the block						*/
+	unsigned char* dst,						/* buffer for the compressed block			*/
+	int dst_size							/* size of dst								*/
+) {
+	uint32_t tbl[1 << CefC_Csmgr_Lz_Hash_Bits];
+	uint32_t v, h;
+	int ip = 0;
+	int anchor = 0;
+	int op = 0;
+	int ref;
+	int lit;
+	int ml;
+	int token;
+	int limit = src_len - 12;				/* no match starts in the last 12 bytes 	*/
+	int mlimit = src_len - 5;				/* and covers the last 5 bytes 				*/
+
+	if ((src == NULL) || (dst == NULL) || (src_len <= 0)) {
+		return (0);
+	}
+	memset (tbl, 0, sizeof (tbl));
+
+	while (ip < limit) {
+		memcpy (&v, &src[ip], sizeof (uint32_t));
+		h = (v * 2654435761U) >> (32 - CefC_Csmgr_Lz_Hash_Bits);
+		ref = (int) tbl[h];
+		tbl[h] = (uint32_t) ip;
+
+		if ((ref >= ip) || (ip - ref > CefC_Csmgr_Lz_Max_Off) ||
+			(memcmp (&src[ref], &src[ip], sizeof (uint32_t)) != 0)) {
+			/* Steps faster over the data which does not match 	*/
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+		ml = CefC_Csmgr_Lz_Min_Match;
+		while ((ip + ml < mlimit) && (src[ref + ml] == src[ip + ml])) {
+			ml++;
+		}
+
+		/* [token][literal length][literals][offset(2)][match length] 	*/
+		lit = ip - anchor;
+		if (op + 1 + lit / 255 + 1 + lit + 2 + (ml - 4) / 255 + 1 > dst_size) {
+			return (0);
+		}
+		token = op++;
+		if (lit >= 15) {
+			dst[token] = 15 << 4;
+			op += cef_csmgr_lz_len_put (&dst[op], lit - 15);
+		} else {
+			dst[token] = (unsigned char)(lit << 4);
+		}
+		memcpy (&dst[op], &src[anchor], lit);
+		op += lit;
+		dst[op++] = (unsigned char)((ip - ref) & 0xFF);
+		dst[op++] = (unsigned char)((ip - ref) >> 8);
+		if (ml - 4 >= 15) {
+			dst[token] |= 15;
+			op += cef_csmgr_lz_len_put (&dst[op], ml - 4 - 15);
+		} else {
+			dst[token] |= (unsigned char)(ml - 4);
+		}
+		ip += ml;
+		anchor = ip;
+
+		/* Keeps the position in the match for the next one 	*/
+		if (ip < limit) {
+			memcpy (&v, &src[ip - 2], sizeof (uint32_t));
+			tbl[(v * 2654435761U) >> (32 - CefC_Csmgr_Lz_Hash_Bits)] = (uint32_t)(ip - 2);
+		}
+	}
+
+	/* Last literals 		*/
+	lit = src_len - anchor;
+	if (op + 1 + lit / 255 + 1 + lit > dst_size) {
+		return (0);
+	}
+	if (lit >= 15) {
+		dst[op++] = 15 << 4;
+		op += cef_csmgr_lz_len_put (&dst[op], lit - 15);
+	} else {
+		dst[op++] = (unsigned char)(lit << 4);
+	}
+	memcpy (&dst[op], &src[anchor], lit);
+	op += lit;
+
+	return (op);
+}
+/*--------------------------------------------------------------------------------------
+	Decompresses the block compressed by cef_csmgr_lz_compress
+----------------------------------------------------------------------------------------*/
+int									/* decompressed length, -1 if the block is broken	*/
+cef_csmgr_lz_decompress (
+	const unsigned char* src,				/* compressed block							*/
+	int src_len,							/* length of the compressed block			*/
+	unsigned char* dst,						/* buffer for the decompressed block		*/
+	int dst_size							/* size of dst								*/
+) {
+	int ip = 0;
+	int op = 0;
+	int token;
+	int len;
+	int off;
+	int b;
+	int i;
+
+	if ((src == NULL) || (dst == NULL)) {
+		return (-1);
+	}
+	while (ip < src_len) {
+		token = src[ip++];
+
+		/* Literals 		*/
+		len = token >> 4;
+		if (len == 15) {
+			do {
+				if (ip >= src_len) {
+					return (-1);
+				}
+				b = src[ip++];
+				len += b;
+			} while (b == 255);
+		}
+		if ((len > src_len - ip) || (len > dst_size - op)) {
+			return (-1);
+		}
+		memcpy (&dst[op], &src[ip], len);
+		ip += len;
+		op += len;
+		if (ip == src_len) {
+			break;
+		}
+
+		/* Match, which may overlap the bytes it produces 		*/
+		if (src_len - ip < 2) {
+			return (-1);
+		}
+		off = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+		if ((off == 0) || (off > op)) {
+			return (-1);
+		}
+		len = token & 0x0F;
+		if (len == 15) {
+			do {
+				if (ip >= src_len) {
+					return (-1);
+				}
+				b = src[ip++];
+				len += b;
+			} while (b == 255);
+		}
+		len += CefC_Csmgr_Lz_Min_Match;
+		if (len > dst_size - op) {
+			return (-1);
+		}
+		if (off >= len) {
+			memcpy (&dst[op], &dst[op - off], len);
+		} else {
+			for (i = 0 ; i < len ; i++) {
+				dst[op + i] = dst[op - off + i];
+			}
+		}
+		op += len;
+	}
+
+	return (op);
+}
 /*--------------------------------------------------------------------------------------
 	Compare ver1 and ver2
 		versioned and unversioned(Inconsistent version) : CefC_CV_Inconsistent
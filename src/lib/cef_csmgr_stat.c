@@ -121,6 +121,17 @@ csmgr_stat_hash_number_create (
 	const unsigned char* key, 
 	uint16_t klen
 );
+static void
+csmgr_stat_exp_pos_set (
+	void* rcd,
+	unsigned int pos
+);
+static void
+csmgr_stat_expiry_set (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd,
+	uint64_t expiry
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -143,6 +154,12 @@ csmgr_stat_handle_create (
 	
 	tbl->rcds = (CsmgrT_Stat**) malloc (sizeof (CsmgrT_Stat*) * CsmgrT_Stat_Max);
 	memset (tbl->rcds, 0, sizeof (CsmgrT_Stat*) * CsmgrT_Stat_Max);
+	tbl->exp_que = cef_expque_create (csmgr_stat_exp_pos_set);
+	if (tbl->exp_que == NULL) {
+		free (tbl->rcds);
+		free (tbl);
+		return (CsmgrC_Invalid);
+	}
 	
 	memset (stat_index_mngr, 0, sizeof (int)*CsmgrT_Stat_Max);
 	
@@ -187,6 +204,8 @@ csmgr_stat_handle_destroy (
 			cp = wcp;
 		}
 	}
+	cef_expque_destroy (tbl->exp_que);
+	cef_hash_presence_destroy (tbl->presence);
 	free (tbl->rcds);
 	free (tbl);
 
@@ -527,9 +546,9 @@ csmgr_stat_expired_content_info_get (
 	int* index
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
 	uint64_t nowt;
 	struct timeval tv;
-	int i;
 	
 	if (!tbl) {
 		return (0);
@@ -537,25 +556,16 @@ csmgr_stat_expired_content_info_get (
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 	
+	/* The record leaves the queue here, so each one is returned only once 	*/
+	/* unless its lifetime is extended afterwards.							*/
 	pthread_mutex_lock (&tbl->stat_mutex);
-	for (i = *index ; i < CsmgrT_Stat_Max ; i++) {
-		CsmgrT_Stat* cp;
-		cp = tbl->rcds[i];
-		while (cp != NULL) {
-			if (cp->expiry != 0 && nowt > cp->expiry) {
-				if (cp->next == NULL) {
-					*index += 1;
-				}
-				cp->expire_f = 1;
-				pthread_mutex_unlock (&tbl->stat_mutex);
-				return (cp);
-			}
-			cp = cp->next;
-		}
-	}	
+	rcd = (CsmgrT_Stat*) cef_expque_pop_expired (tbl->exp_que, nowt - 1);
+	if (rcd != NULL) {
+		rcd->expire_f = 1;
+	}
 	pthread_mutex_unlock (&tbl->stat_mutex);
 	
-	return (NULL);
+	return (rcd);
 }
 /*--------------------------------------------------------------------------------------
 	Update cached Cob status
@@ -644,7 +654,7 @@ csmgr_stat_cob_update (
 #endif //CS_COB_NUM //@@@@@----- Show cached_cob_num status -----
 	}
 	if (rcd->expiry < expiry) {
-		rcd->expiry = expiry;
+		csmgr_stat_expiry_set (tbl, rcd, expiry);
 	}
 	
 	if (!(rcd->cob_map[x] & mask)) {
@@ -798,6 +808,9 @@ csmgr_stat_cache_capacity_update (
 	}
 
 	pthread_mutex_lock (&tbl->stat_mutex);
+	while (cef_expque_pop_expired (tbl->exp_que, UINT64_MAX) != NULL) {
+		;
+	}
 	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
 		CsmgrT_Stat* cp;
 		CsmgrT_Stat* wcp;
@@ -813,6 +826,7 @@ csmgr_stat_cache_capacity_update (
 	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
 		tbl->rcds[i] = NULL;
 	}
+	cef_hash_presence_clear (tbl->presence);
 
 	tbl->cached_con_num = 0;
 	tbl->capacity = capacity;
@@ -844,11 +858,137 @@ csmgr_stat_content_lifetime_update (
 		pthread_mutex_unlock (&tbl->stat_mutex);
 		return;
 	}
-	rcd->expiry = expiry;
+	csmgr_stat_expiry_set (tbl, rcd, expiry);
 	pthread_mutex_unlock (&tbl->stat_mutex);
 	
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Copies the map of the cached chunk numbers of the specified content
+----------------------------------------------------------------------------------------*/
+uint32_t 									/* words of the map (0: no cached chunk) 	*/
+csmgr_stat_cob_map_get (
+	CsmgrT_Stat_Handle hdl, 
+	const unsigned char* name, 
+	uint16_t name_len, 
+	uint64_t** cob_map							/* the caller frees the copy 				*/
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	uint32_t num;
+	
+	*cob_map = NULL;
+	if (!tbl) {
+		return (0);
+	}
+	pthread_mutex_lock (&tbl->stat_mutex);
+	rcd = csmgr_stat_content_search (tbl, name, name_len);
+	if ((!rcd) || (rcd->cob_num == 0)) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (0);
+	}
+	/* Trims the words beyond the last cached chunk 	*/
+	for (num = rcd->map_max ; num > 0 ; num--) {
+		if (rcd->cob_map[num - 1]) {
+			break;
+		}
+	}
+	if (num > 0) {
+		*cob_map = (uint64_t*) malloc (sizeof (uint64_t) * num);
+		if (*cob_map == NULL) {
+			num = 0;
+		} else {
+			memcpy (*cob_map, rcd->cob_map, sizeof (uint64_t) * num);
+		}
+	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return (num);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the presence filter of the cached contents
+----------------------------------------------------------------------------------------*/
+int 										/* negative if an error occurs 				*/
+csmgr_stat_presence_enable (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t capacity, 							/* number of contents to be held 		*/
+	double fp_rate								/* false positive rate 					*/
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* cp;
+	int i;
+	
+	if (!tbl) {
+		return (-1);
+	}
+	pthread_mutex_lock (&tbl->stat_mutex);
+	if (tbl->presence) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (0);
+	}
+	tbl->presence = cef_hash_presence_create (capacity, fp_rate);
+	if (!tbl->presence) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (-1);
+	}
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		for (cp = tbl->rcds[i] ; cp != NULL ; cp = cp->next) {
+			cef_hash_presence_add (tbl->presence, cp->name, cp->name_len);
+		}
+	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Drains the bit changes of the presence filter
+----------------------------------------------------------------------------------------*/
+int 										/* number of deltas, -1 if the whole bitmap */
+											/* must be sent again 						*/
+csmgr_stat_presence_delta_get (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t* delta, 
+	int max
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	int num;
+	
+	if ((!tbl) || (!tbl->presence)) {
+		return (0);
+	}
+	pthread_mutex_lock (&tbl->stat_mutex);
+	num = cef_hash_presence_delta_get (tbl->presence, delta, max);
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return (num);
+}
+/*--------------------------------------------------------------------------------------
+	Copies a part of the bitmap of the presence filter
+----------------------------------------------------------------------------------------*/
+uint32_t 									/* number of copied bytes 					*/
+csmgr_stat_presence_bitmap_read (
+	CsmgrT_Stat_Handle hdl, 
+	uint32_t offset, 							/* offset in bytes 						*/
+	unsigned char* buff, 
+	uint32_t len, 
+	uint32_t* bit_num, 
+	int* hash_num
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	uint32_t res;
+	
+	*bit_num 	= 0;
+	*hash_num 	= 0;
+	if ((!tbl) || (!tbl->presence)) {
+		return (0);
+	}
+	pthread_mutex_lock (&tbl->stat_mutex);
+	cef_hash_presence_info_get (tbl->presence, bit_num, hash_num);
+	res = cef_hash_presence_bitmap_read (tbl->presence, offset, buff, len);
+	pthread_mutex_unlock (&tbl->stat_mutex);
+	
+	return (res);
+}
 /*--------------------------------------------------------------------------------------
 	Init the valiables of the specified content
 ----------------------------------------------------------------------------------------*/
@@ -941,7 +1081,9 @@ csmgr_stat_content_info_delete (
 			(memcmp (cp->name, name, name_len) == 0)) {
 			tbl->rcds[index] = cp->next;
 			tbl->cached_con_num--;
+			cef_hash_presence_remove (tbl->presence, name, name_len);
 			stat_index_mngr[cp->index] = 0;
+			cef_expque_remove (tbl->exp_que, cp->exp_pos);
 			free (cp->cob_map);
 			if (cp->version != NULL && cp->ver_len > 0) {
 				free (cp->version);
@@ -957,7 +1099,9 @@ csmgr_stat_content_info_delete (
 					wcp = cp->next;
 					cp->next = cp->next->next;
 					tbl->cached_con_num--;
+					cef_hash_presence_remove (tbl->presence, name, name_len);
 					stat_index_mngr[wcp->index] = 0;
+					cef_expque_remove (tbl->exp_que, wcp->exp_pos);
 					free (wcp->cob_map);
 					if (wcp->version != NULL && wcp->ver_len > 0) {
 						free (wcp->version);
@@ -1157,7 +1301,7 @@ csmgr_stat_cob_update_for_pub (
 		rcd->node 			= node;
 	}
 	if (rcd->expiry < expiry) {
-		rcd->expiry = expiry;
+		csmgr_stat_expiry_set (tbl, rcd, expiry);
 	}
 	rcd->cob_num++;
 	rcd->con_size += cob_size;
@@ -1251,6 +1395,7 @@ csmgr_stat_content_lookup (
 		cp->tx_seq = 0;
 		cp->tx_num = -1;
 		cp->tx_time = 0;
+		cp->exp_pos = CefC_Expque_Invalid;
 		cp->cob_map = (uint64_t *) calloc (1, sizeof (uint64_t) * CsmgrT_Add_Maps);
 		cp->map_max = CsmgrT_Add_Maps;
 		for (int i=0; i<CsmgrT_Stat_Max; i++) {
@@ -1260,6 +1405,7 @@ csmgr_stat_content_lookup (
 				break;
 			}
 		}
+		cef_hash_presence_add (tbl->presence, name, name_len);
 		if (create_f) {
 			*create_f = 1;
 		}
@@ -1281,6 +1427,7 @@ csmgr_stat_content_lookup (
 		cp->tx_seq = 0;
 		cp->tx_num = -1;
 		cp->tx_time = 0;
+		cp->exp_pos = CefC_Expque_Invalid;
 		cp->cob_map = (uint64_t *) calloc (1, sizeof (uint64_t) * CsmgrT_Add_Maps/*@*/);
 		cp->map_max = CsmgrT_Add_Maps;
 		for (int i=0; i<CsmgrT_Stat_Max; i++) {
@@ -1290,6 +1437,7 @@ csmgr_stat_content_lookup (
 				break;
 			}
 		}
+		cef_hash_presence_add (tbl->presence, name, name_len);
 		if (create_f) {
 			*create_f = 1;
 		}
@@ -1383,6 +1531,38 @@ csmgr_stat_content_salvage (
 	return (NULL);
 }
 
+/*--------------------------------------------------------------------------------------
+	Records the position of the record in the expiry queue
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_exp_pos_set (
+	void* rcd,
+	unsigned int pos
+) {
+	((CsmgrT_Stat*) rcd)->exp_pos = pos;
+}
+/*--------------------------------------------------------------------------------------
+	Sets the expiry of the record and moves it in the expiry queue
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_expiry_set (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd,
+	uint64_t expiry
+) {
+	rcd->expiry = expiry;
+	
+	if (expiry == 0) {
+		/* never expires 		*/
+		cef_expque_remove (tbl->exp_que, rcd->exp_pos);
+	} else if (rcd->exp_pos != CefC_Expque_Invalid) {
+		cef_expque_update (tbl->exp_que, rcd->exp_pos, expiry);
+	} else {
+		/* if this fails, the record is kept until it is deleted explicitly 	*/
+		cef_expque_push (tbl->exp_que, rcd, expiry);
+	}
+	return;
+}
 static uint32_t
 csmgr_stat_hash_number_create (
 	const unsigned char* key, 
@@ -69,6 +69,26 @@ typedef struct CefT_List_Hash {
 	uint32_t 			def_elem_max;		/* User defined maximum size	*/
 } CefT_List_Hash;
 
+typedef struct CefT_Hash_Sketch {
+	uint8_t*			cnt;				/* CefC_Hash_Sketch_Depth rows of counters	*/
+	uint32_t 			width;				/* counters per row (power of 2)			*/
+	uint32_t 			mask;
+	uint32_t 			sample_max;			/* additions before the counters are aged	*/
+	uint32_t 			sample_num;			/* additions since the last aging			*/
+	uint32_t 			reject_num;			/* rejections since the last window admit	*/
+} CefT_Hash_Sketch;
+
+typedef struct CefT_Hash_Presence {
+	uint8_t*			cnt;				/* counters, NULL for the mirror			*/
+	uint8_t*			bits;				/* bit i is set while counter i is not 0	*/
+	uint32_t 			bit_num;			/* number of bits (power of 2)				*/
+	uint32_t 			mask;
+	int 				hash_num;			/* number of bits per key					*/
+	uint32_t*			delta;				/* bit changes not yet drained				*/
+	int 				delta_num;
+	int 				resync_f;			/* 1 if the deltas were lost				*/
+} CefT_Hash_Presence;
+
 
 /****************************************************************************************
  State Variables
@@ -89,6 +109,27 @@ cef_lhash_number_create (
 	const unsigned char* key,
 	uint32_t klen
 );
+static uint64_t
+cef_hash_sketch_number_create (
+	const unsigned char* key,
+	uint32_t klen
+);
+static void
+cef_hash_sketch_age (
+	CefT_Hash_Sketch* sk
+);
+static void
+cef_hash_presence_index_get (
+	CefT_Hash_Presence* pf,
+	const unsigned char* key,
+	uint32_t klen,
+	uint32_t idx[]
+);
+static void
+cef_hash_presence_delta_put (
+	CefT_Hash_Presence* pf,
+	uint32_t delta
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -1474,6 +1515,477 @@ cef_lhash_tbl_item_check_exact (
 }
 //----- 0.9.0b : 2022.07.11
 
+/****************************************************************************************
+ Frequency sketch for the cache admission
+
+ The sketch is a count-min sketch of counters saturating at CefC_Hash_Sketch_Cnt_Max.
+ When the number of additions reaches (width * CefC_Hash_Sketch_Sample), all counters
+ are halved so that the popularity of old contents fades away. The counters are
+ accessed with relaxed atomics; a lost update only makes the estimate a little lower.
+ A candidate which ties with the victim is admitted, and one of every
+ CefC_Hash_Sketch_Window candidates rejected in a row is admitted anyway, so that
+ contents never looked up (e.g. pushed by a producer) still enter a full cache.
+ ****************************************************************************************/
+/*--------------------------------------------------------------------------------------
+	Creates the frequency sketch
+----------------------------------------------------------------------------------------*/
+CefT_Hash_Sketch_Handle						/* NULL if an error occurs 					*/
+cef_hash_sketch_create (
+	uint32_t capacity						/* number of entries of the cache 			*/
+) {
+	CefT_Hash_Sketch* sk;
+	uint32_t width = CefC_Hash_Sketch_Width_Min;
+
+	while ((width < capacity) && (width < CefC_Hash_Sketch_Width_Max)) {
+		width <<= 1;
+	}
+	sk = (CefT_Hash_Sketch*) calloc (1, sizeof (CefT_Hash_Sketch));
+	if (sk == NULL) {
+		return ((CefT_Hash_Sketch_Handle) NULL);
+	}
+	sk->cnt = (uint8_t*) calloc (CefC_Hash_Sketch_Depth, width);
+	if (sk->cnt == NULL) {
+		free (sk);
+		return ((CefT_Hash_Sketch_Handle) NULL);
+	}
+	sk->width 		= width;
+	sk->mask 		= width - 1;
+	sk->sample_max 	= width * CefC_Hash_Sketch_Sample;
+	sk->sample_num 	= 0;
+
+	return ((CefT_Hash_Sketch_Handle) sk);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the frequency sketch
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_sketch_destroy (
+	CefT_Hash_Sketch_Handle handle
+) {
+	CefT_Hash_Sketch* sk = (CefT_Hash_Sketch*) handle;
+
+	if (sk == NULL) {
+		return;
+	}
+	free (sk->cnt);
+	free (sk);
+}
+/*--------------------------------------------------------------------------------------
+	Records an access to the key
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_sketch_increment (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+) {
+	CefT_Hash_Sketch* sk = (CefT_Hash_Sketch*) handle;
+	uint32_t idx[CefC_Hash_Sketch_Depth];
+	uint64_t hv;
+	uint32_t h1, h2;
+	uint8_t  v;
+	uint8_t  min = CefC_Hash_Sketch_Cnt_Max;
+	int i;
+
+	if (sk == NULL) {
+		return;
+	}
+	hv = cef_hash_sketch_number_create (key, klen);
+	h1 = (uint32_t) hv;
+	h2 = (uint32_t)(hv >> 32) | 1;
+
+	for (i = 0 ; i < CefC_Hash_Sketch_Depth ; i++) {
+		idx[i] = i * sk->width + ((h1 + i * h2) & sk->mask);
+		v = __atomic_load_n (&sk->cnt[idx[i]], __ATOMIC_RELAXED);
+		if (v < min) {
+			min = v;
+		}
+	}
+	/* Conservative update: only the smallest counters are incremented 	*/
+	if (min < CefC_Hash_Sketch_Cnt_Max) {
+		for (i = 0 ; i < CefC_Hash_Sketch_Depth ; i++) {
+			if (__atomic_load_n (&sk->cnt[idx[i]], __ATOMIC_RELAXED) == min) {
+				__atomic_store_n (&sk->cnt[idx[i]], min + 1, __ATOMIC_RELAXED);
+			}
+		}
+	}
+	if (__atomic_add_fetch (&sk->sample_num, 1, __ATOMIC_RELAXED) == sk->sample_max) {
+		cef_hash_sketch_age (sk);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Estimates the access frequency of the key
+----------------------------------------------------------------------------------------*/
+int											/* estimated frequency (0 to Cnt_Max) 		*/
+cef_hash_sketch_estimate (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+) {
+	CefT_Hash_Sketch* sk = (CefT_Hash_Sketch*) handle;
+	uint64_t hv;
+	uint32_t h1, h2;
+	uint8_t  v;
+	uint8_t  min = CefC_Hash_Sketch_Cnt_Max;
+	int i;
+
+	if (sk == NULL) {
+		return (0);
+	}
+	hv = cef_hash_sketch_number_create (key, klen);
+	h1 = (uint32_t) hv;
+	h2 = (uint32_t)(hv >> 32) | 1;
+
+	for (i = 0 ; i < CefC_Hash_Sketch_Depth ; i++) {
+		v = __atomic_load_n (
+				&sk->cnt[i * sk->width + ((h1 + i * h2) & sk->mask)], __ATOMIC_RELAXED);
+		if (v < min) {
+			min = v;
+		}
+	}
+	return ((int) min);
+}
+/*--------------------------------------------------------------------------------------
+	Decides whether the candidate may replace the victim of the cache
+----------------------------------------------------------------------------------------*/
+int											/* 1 if the candidate is admitted 			*/
+cef_hash_sketch_admit (
+	CefT_Hash_Sketch_Handle handle,
+	const unsigned char* cand_key,			/* key of the content to be cached 			*/
+	uint32_t cand_klen,
+	const unsigned char* vict_key,			/* key of the content to be evicted 		*/
+	uint32_t vict_klen
+) {
+	CefT_Hash_Sketch* sk = (CefT_Hash_Sketch*) handle;
+
+	if (sk == NULL) {
+		return (1);
+	}
+	/* A one-hit content does not push out the content accessed more often 	*/
+	if (cef_hash_sketch_estimate (handle, cand_key, cand_klen) >=
+			cef_hash_sketch_estimate (handle, vict_key, vict_klen)) {
+		return (1);
+	}
+	/* Admission window: a new content gets a chance to build up its count 	*/
+	if (__atomic_add_fetch (&sk->reject_num, 1, __ATOMIC_RELAXED)
+			% CefC_Hash_Sketch_Window == 0) {
+		return (1);
+	}
+	return (0);
+}
+
+/****************************************************************************************
+ Presence filter of the contents cached in csmgrd
+
+ The filter is a counting Bloom filter of 8-bit counters; csmgrd counts the contents
+ and cefnetd keeps only the bits (mirror) to skip the lookups which surely miss.
+ Every time a counter moves between 0 and 1, the bit change is recorded as a delta
+ so that csmgrd sends only the changes. If the deltas overflow, resync_f is set and
+ the whole bitmap has to be sent again. The bitmap is byte-ordered, so that it can be
+ copied as it is between hosts of different endianness. The caller serializes the
+ accesses to the filter.
+ ****************************************************************************************/
+/*--------------------------------------------------------------------------------------
+	Creates the presence filter sized for the capacity and the false positive rate
+----------------------------------------------------------------------------------------*/
+CefT_Hash_Presence_Handle					/* NULL if an error occurs 					*/
+cef_hash_presence_create (
+	uint32_t capacity,						/* number of contents to be held 			*/
+	double fp_rate							/* false positive rate (0 < fp_rate < 1) 	*/
+) {
+	CefT_Hash_Presence* pf;
+	double   rate;
+	uint64_t bits;
+	uint32_t bit_num = CefC_Hash_Presence_Bits_Min;
+	int 	 hash_num = 0;
+
+	if ((capacity == 0) || (fp_rate <= 0.0) || (fp_rate >= 1.0)) {
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+	/* k = log2(1/p) and m = n * k / ln2 	*/
+	for (rate = fp_rate ; rate < 1.0 ; rate *= 2.0) {
+		hash_num++;
+	}
+	if (hash_num > CefC_Hash_Presence_Hash_Max) {
+		hash_num = CefC_Hash_Presence_Hash_Max;
+	}
+	bits = (uint64_t) capacity * hash_num * 1443 / 1000;
+	while ((bit_num < bits) && (bit_num < CefC_Hash_Presence_Bits_Max)) {
+		bit_num <<= 1;
+	}
+
+	pf = (CefT_Hash_Presence*) cef_hash_presence_mirror_create (bit_num, hash_num);
+	if (pf == NULL) {
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+	pf->cnt 	= (uint8_t*) calloc (bit_num, sizeof (uint8_t));
+	pf->delta 	= (uint32_t*) malloc (sizeof (uint32_t) * CefC_Hash_Presence_Delta_Max);
+	if ((pf->cnt == NULL) || (pf->delta == NULL)) {
+		cef_hash_presence_destroy ((CefT_Hash_Presence_Handle) pf);
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+
+	return ((CefT_Hash_Presence_Handle) pf);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the mirror which holds only the bits of the presence filter
+----------------------------------------------------------------------------------------*/
+CefT_Hash_Presence_Handle					/* NULL if an error occurs 					*/
+cef_hash_presence_mirror_create (
+	uint32_t bit_num,						/* number of bits (power of 2) 				*/
+	int hash_num							/* number of bits per key 					*/
+) {
+	CefT_Hash_Presence* pf;
+
+	if ((bit_num < CefC_Hash_Presence_Bits_Min) || (bit_num > CefC_Hash_Presence_Bits_Max) ||
+		(bit_num & (bit_num - 1)) ||
+		(hash_num < 1) || (hash_num > CefC_Hash_Presence_Hash_Max)) {
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+	pf = (CefT_Hash_Presence*) calloc (1, sizeof (CefT_Hash_Presence));
+	if (pf == NULL) {
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+	pf->bits = (uint8_t*) calloc (bit_num / 8, sizeof (uint8_t));
+	if (pf->bits == NULL) {
+		free (pf);
+		return ((CefT_Hash_Presence_Handle) NULL);
+	}
+	pf->bit_num 	= bit_num;
+	pf->mask 		= bit_num - 1;
+	pf->hash_num 	= hash_num;
+
+	return ((CefT_Hash_Presence_Handle) pf);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the presence filter
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_destroy (
+	CefT_Hash_Presence_Handle handle
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+
+	if (pf == NULL) {
+		return;
+	}
+	free (pf->cnt);
+	free (pf->bits);
+	free (pf->delta);
+	free (pf);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the key to the presence filter
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_add (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+	uint32_t idx[CefC_Hash_Presence_Hash_Max];
+	int i;
+
+	if ((pf == NULL) || (pf->cnt == NULL)) {
+		return;
+	}
+	cef_hash_presence_index_get (pf, key, klen, idx);
+
+	for (i = 0 ; i < pf->hash_num ; i++) {
+		if (pf->cnt[idx[i]] == CefC_Hash_Presence_Cnt_Max) {
+			continue;
+		}
+		pf->cnt[idx[i]]++;
+		if (pf->cnt[idx[i]] == 1) {
+			pf->bits[idx[i] >> 3] |= (uint8_t)(1 << (idx[i] & 7));
+			cef_hash_presence_delta_put (pf, idx[i] | CefC_Hash_Presence_Delta_Set);
+		}
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Removes the key added before from the presence filter
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_remove (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+	uint32_t idx[CefC_Hash_Presence_Hash_Max];
+	int i;
+
+	if ((pf == NULL) || (pf->cnt == NULL)) {
+		return;
+	}
+	cef_hash_presence_index_get (pf, key, klen, idx);
+
+	for (i = 0 ; i < pf->hash_num ; i++) {
+		if ((pf->cnt[idx[i]] == 0) ||
+			(pf->cnt[idx[i]] == CefC_Hash_Presence_Cnt_Max)) {
+			continue;
+		}
+		pf->cnt[idx[i]]--;
+		if (pf->cnt[idx[i]] == 0) {
+			pf->bits[idx[i] >> 3] &= (uint8_t) ~(1 << (idx[i] & 7));
+			cef_hash_presence_delta_put (pf, idx[i]);
+		}
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Removes all keys from the presence filter
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_clear (
+	CefT_Hash_Presence_Handle handle
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+
+	if (pf == NULL) {
+		return;
+	}
+	if (pf->cnt) {
+		memset (pf->cnt, 0, pf->bit_num);
+	}
+	memset (pf->bits, 0, pf->bit_num / 8);
+	pf->delta_num 	= 0;
+	pf->resync_f 	= 1;
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the key may have been added
+----------------------------------------------------------------------------------------*/
+int											/* 0 if the key has surely not been added 	*/
+cef_hash_presence_check (
+	CefT_Hash_Presence_Handle handle,
+	const unsigned char* key,
+	uint32_t klen
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+	uint32_t idx[CefC_Hash_Presence_Hash_Max];
+	int i;
+
+	if (pf == NULL) {
+		return (1);
+	}
+	cef_hash_presence_index_get (pf, key, klen, idx);
+
+	for (i = 0 ; i < pf->hash_num ; i++) {
+		if ((pf->bits[idx[i] >> 3] & (1 << (idx[i] & 7))) == 0) {
+			return (0);
+		}
+	}
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the geometry of the presence filter
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_info_get (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t* bit_num,
+	int* hash_num
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+
+	*bit_num 	= (pf) ? pf->bit_num : 0;
+	*hash_num 	= (pf) ? pf->hash_num : 0;
+}
+/*--------------------------------------------------------------------------------------
+	Drains the bit changes recorded since the last call
+----------------------------------------------------------------------------------------*/
+int											/* number of deltas, -1 if the deltas were 	*/
+											/* lost and the whole bitmap must be sent 	*/
+cef_hash_presence_delta_get (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t* delta,						/* buffer to which the deltas are copied 	*/
+	int max									/* size of the buffer 						*/
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+	int num;
+
+	if ((pf == NULL) || (pf->delta == NULL)) {
+		return (0);
+	}
+	if (pf->resync_f) {
+		pf->resync_f 	= 0;
+		pf->delta_num 	= 0;
+		return (-1);
+	}
+	num = (pf->delta_num < max) ? pf->delta_num : max;
+	memcpy (delta, pf->delta, sizeof (uint32_t) * num);
+	pf->delta_num -= num;
+	memmove (pf->delta, &pf->delta[num], sizeof (uint32_t) * pf->delta_num);
+
+	return (num);
+}
+/*--------------------------------------------------------------------------------------
+	Applies the bit change received from csmgrd to the mirror
+----------------------------------------------------------------------------------------*/
+void
+cef_hash_presence_delta_apply (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t delta
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+	uint32_t idx;
+
+	if (pf == NULL) {
+		return;
+	}
+	idx = (delta & ~CefC_Hash_Presence_Delta_Set) & pf->mask;
+
+	if (delta & CefC_Hash_Presence_Delta_Set) {
+		pf->bits[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+	} else {
+		pf->bits[idx >> 3] &= (uint8_t) ~(1 << (idx & 7));
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Copies a part of the bitmap out of the presence filter
+----------------------------------------------------------------------------------------*/
+uint32_t									/* number of copied bytes 					*/
+cef_hash_presence_bitmap_read (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t offset,						/* offset in bytes 							*/
+	unsigned char* buff,
+	uint32_t len
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+
+	if ((pf == NULL) || (offset >= pf->bit_num / 8)) {
+		return (0);
+	}
+	if (len > pf->bit_num / 8 - offset) {
+		len = pf->bit_num / 8 - offset;
+	}
+	memcpy (buff, &pf->bits[offset], len);
+
+	return (len);
+}
+/*--------------------------------------------------------------------------------------
+	Copies a part of the bitmap into the mirror
+----------------------------------------------------------------------------------------*/
+uint32_t									/* number of copied bytes 					*/
+cef_hash_presence_bitmap_write (
+	CefT_Hash_Presence_Handle handle,
+	uint32_t offset,						/* offset in bytes 							*/
+	const unsigned char* buff,
+	uint32_t len
+) {
+	CefT_Hash_Presence* pf = (CefT_Hash_Presence*) handle;
+
+	if ((pf == NULL) || (offset >= pf->bit_num / 8)) {
+		return (0);
+	}
+	if (len > pf->bit_num / 8 - offset) {
+		len = pf->bit_num / 8 - offset;
+	}
+	memcpy (&pf->bits[offset], buff, len);
+
+	return (len);
+}
+
 /****************************************************************************************
  ****************************************************************************************/
 
@@ -1516,3 +2028,76 @@ cef_lhash_number_create (
 
 	return (hash);
 }
+
+static uint64_t
+cef_hash_sketch_number_create (
+	const unsigned char* key,
+	uint32_t klen
+) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	uint32_t i;
+
+	/* FNV-1a with the finalizer of splitmix64, MD5 is too heavy for every lookup 	*/
+	for (i = 0 ; i < klen ; i++) {
+		hash ^= key[i];
+		hash *= 0x100000001b3ULL;
+	}
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+
+	return (hash);
+}
+
+static void
+cef_hash_sketch_age (
+	CefT_Hash_Sketch* sk
+) {
+	uint32_t i, num;
+	uint8_t  v;
+
+	num = CefC_Hash_Sketch_Depth * sk->width;
+	for (i = 0 ; i < num ; i++) {
+		v = __atomic_load_n (&sk->cnt[i], __ATOMIC_RELAXED);
+		__atomic_store_n (&sk->cnt[i], v >> 1, __ATOMIC_RELAXED);
+	}
+	__atomic_sub_fetch (&sk->sample_num, sk->sample_max / 2, __ATOMIC_RELAXED);
+}
+
+static void
+cef_hash_presence_index_get (
+	CefT_Hash_Presence* pf,
+	const unsigned char* key,
+	uint32_t klen,
+	uint32_t idx[]
+) {
+	uint64_t hv;
+	uint32_t h1, h2;
+	int i;
+
+	hv = cef_hash_sketch_number_create (key, klen);
+	h1 = (uint32_t) hv;
+	h2 = (uint32_t)(hv >> 32) | 1;
+
+	for (i = 0 ; i < pf->hash_num ; i++) {
+		idx[i] = (h1 + i * h2) & pf->mask;
+	}
+}
+
+static void
+cef_hash_presence_delta_put (
+	CefT_Hash_Presence* pf,
+	uint32_t delta
+) {
+	if (pf->resync_f) {
+		return;
+	}
+	if (pf->delta_num == CefC_Hash_Presence_Delta_Max) {
+		pf->resync_f = 1;
+		return;
+	}
+	pf->delta[pf->delta_num] = delta;
+	pf->delta_num++;
+}
@@ -58,6 +58,7 @@
 #include <cefore/cef_frame.h>
 #include <cefore/cef_hash.h>
 #include <cefore/cef_mem_cache.h>
+#include <cefore/cef_rngque.h>
 
 /****************************************************************************************
  Macros
@@ -84,7 +85,14 @@ static int xpthread_mutex_lock (const char* pname, int pline, pthread_mutex_t *m
 
 
 #define Cef_Mstat_HashTbl_Size				1009
-#define Cef_Mstat_Delete_Cob_AtOnce			1000
+#define CefMemCacheC_Shard_Num				16		/* number of the cache partitions 	*/
+#define CefMemCacheC_Slab_Max				65536	/* largest size class of the slab 	*/
+#define CefMemCacheC_Put_Que_Size			65536	/* entries waiting for the put thread */
+#define CefMemCacheC_Put_Batch				64		/* entries stored under one lock 	*/
+#define CefMemCacheC_Expire_Batch			256		/* entries expired under one lock 	*/
+#define CefMemCacheC_Expire_Max				65536	/* entries expired per shard and check */
+#define CefMemCacheC_Map_Unit				16		/* words added when the map grows 	*/
+#define CefMemCacheC_Map_Max				0x40000	/* words of the map (16M chunks) 	*/
 
 /****************************************************************************************
  Structures Declaration
@@ -97,6 +105,7 @@ typedef struct _FifoT_Entry {
 	int 					key_len;
 	int 					ver_len;
     int             		valid;
+	uint32_t				bytes;				/* bytes charged to the shard 			*/
 	struct _FifoT_Entry*	before;
  	struct _FifoT_Entry*	next;
 } FifoT_Entry;
@@ -118,9 +127,27 @@ typedef struct CefT_Mem_Hash {
 	uint32_t 				tabl_max;
 	uint32_t 				elem_max;
 	uint32_t 				elem_num;
+	CefT_Expque*			exp_que;			/* entries in the order of expiry		*/
 
 } CefT_Mem_Hash;
 
+/*** partition of the memory cache ***/
+typedef struct CefT_Mem_Shard {
+	pthread_mutex_t			mutex;				/* protects all members of this shard	*/
+	CefT_Mem_Hash*			hash_tbl;			/* caching hash table					*/
+	CefT_Hash_Handle		lookup_table;		/* hash-table to look-up FIFO entries	*/
+	FifoT_Entry*			fifo_head;
+	FifoT_Entry*			fifo_tail;
+	int						cache_cap;			/* maximum number of entries			*/
+	int						cache_count;		/* number of cache entries				*/
+	int						count;				/* number of entries in lookup table	*/
+	uint64_t				mem_cap;			/* byte budget (0 means unlimited)		*/
+	uint64_t				mem_used;			/* bytes of the cached entries			*/
+	uint64_t				evict_num;			/* entries evicted to keep the budget	*/
+	CefT_Hash_Sketch_Handle	sketch;				/* access frequency (NULL: admit all)	*/
+	uint64_t				reject_num;			/* entries refused by the admission		*/
+} CefT_Mem_Shard;
+
 typedef struct CefT_Mem_Hash_Stat {
 	unsigned char* 				contents_name;		/* Name of Contents					*/
 	uint32_t 					cname_len;			/* Length of Name					*/
@@ -132,6 +159,9 @@ typedef struct CefT_Mem_Hash_Stat {
 	uint64_t					ver_ac_cnt;			/* 0.8.3c */
 	uint64_t					min_seq;			/* 0.8.3c */
 	uint64_t					max_seq;			/* 0.8.3c */
+	uint64_t*					chunk_map;			/* bit per cached chunk number		*/
+	uint32_t					map_num;			/* words of chunk_map				*/
+	int							map_over;			/* a chunk did not fit in the map	*/
 	struct CefT_Mem_Hash_Stat*	next;
 } CefT_Mem_Hash_Stat;
 
@@ -142,6 +172,8 @@ typedef struct CefT_Mem_Hash_Stat_Del {
 	uint16_t					cver_len;
 	uint64_t					min_seq;
 	uint64_t					max_seq;
+	uint64_t*					chunk_map;			/* taken over by the delete thread	*/
+	uint32_t					map_num;			/* (NULL: scan min_seq to max_seq)	*/
 } CefT_Mem_Hash_Stat_Del;
 
 
@@ -149,25 +181,18 @@ typedef struct CefT_Mem_Hash_Stat_Del {
  State Variables
  ****************************************************************************************/
 
-static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
-											/* listed (it is the same value as the 		*/
-											/* maximum value of the cache table) 		*/
-
-/* pointers of functions which stores and removes the content entry into/from the cache */
-/* table (implementation of the functions are in a plugin which uses this library) 		*/
-
-static int              fifo_hand;          /* position of hand                         */
-static int              cache_count;        /* number of cache entries                  */
-FifoT_Entry*			cache_entry_head;
-FifoT_Entry*			cache_entry_tail;
-static CefT_Hash_Handle lookup_table;       /* hash-table to look-up cache entries      */
-static int              count;              /* the number of entries in lookup table    */
+/* The memory cache is partitioned into shards by the hash of the name with the chunk	*/
+/* number. Each shard has its own lock, hash table and FIFO list, so a lookup from the	*/
+/* forwarding thread only waits for the operations on the same shard.					*/
+static CefT_Mem_Shard			mem_shards[CefMemCacheC_Shard_Num];
+static int						mem_shard_num = 0;
+static uint64_t					mem_cap_bytes = 0;		/* byte budget of the cache 	*/
 
-static CefT_Mem_Hash* 			mem_hash_tbl = NULL;	/* caching hash table			*/
-static uint32_t 				mem_tabl_max;			/* max size 					*/
-														/* of caching hash table		*/
+/* Each entry is stored in one block of the slab with its message, name and version */
+static CefT_Mp_Slab_Handle		mem_slab = 0;
 
-static pthread_mutex_t 			cef_mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Protects mstat_tbl. It may be taken while a shard lock is held, not vice versa.		*/
+static pthread_mutex_t 			cef_mem_mstat_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static int	cache_cs_expire_check_stat = 0;
 
@@ -175,6 +200,10 @@ static CefT_Mem_Hash_Stat*		mstat_tbl[Cef_Mstat_HashTbl_Size];
 static int				delete_pipe_fd[2];
 static pthread_t		cef_mem_cache_delete_th;
 
+/* Parsed entries handed over from the forwarding thread(s) to the put thread 	*/
+static CefT_Rngque*		put_que = NULL;
+static sem_t			put_sem;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -184,32 +213,47 @@ static pthread_t		cef_mem_cache_delete_th;
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefT_Mem_Shard* shard,
+	uint32_t capacity
 );
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefT_Mem_Shard* shard
 );
 static void
 cef_mem_cache_fifo_insert (
-	CefMemCacheT_Content_Entry* entry
+	CefT_Mem_Shard* shard,
+	uint32_t hash,
+	CefMemCacheT_Content_Mem_Entry* entry
+);
+static int
+cef_mem_cache_fifo_admit (
+	CefT_Mem_Shard* shard,
+	unsigned char* key,
+	int key_len,
+	CefMemCacheT_Content_Mem_Entry* entry
 );
 static void
 cef_mem_cache_fifo_erase (
+	CefT_Mem_Shard* shard,
 	unsigned char* key,
 	int key_len
 );
 static void
 cef_mem_cache_fifo_store_entry(
-	CefMemCacheT_Content_Entry* entry
+	CefT_Mem_Shard* shard,
+	uint32_t hash,
+	CefMemCacheT_Content_Mem_Entry* entry
 );
 static void
 cef_mem_cache_fifo_remove_entry(
+	CefT_Mem_Shard* shard,
 	FifoT_Entry*   entry,
 	int is_removed
 );
 static FifoT_Entry*
 cef_mem_cache_fifo_cache_entry_enqueue(
+	CefT_Mem_Shard* shard,
 	unsigned char* key,
 	int key_len,
 	unsigned char* ver,
@@ -217,6 +261,7 @@ cef_mem_cache_fifo_cache_entry_enqueue(
 );
 static void
 cef_mem_cache_fifo_cache_entry_dequeue(
+	CefT_Mem_Shard* shard,
 	FifoT_Entry* p
 );
 
@@ -226,14 +271,23 @@ cef_mem_cache_fifo_cache_entry_dequeue(
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_cs_create (
-		uint32_t		capacity
+		uint32_t		capacity,
+		uint64_t		max_bytes,
+		int				admission
+);
+static CefT_Mem_Shard*
+cef_mem_cache_shard_get (
+	uint32_t hash
 );
 static int
 cef_mem_cache_cs_store (
-	CefMemCacheT_Content_Entry* new_entry
+	CefT_Mem_Shard* shard,
+	uint32_t hash,
+	CefMemCacheT_Content_Mem_Entry* entry
 );
 static void
 cef_mem_cache_cs_remove (
+	CefT_Mem_Shard* shard,
 	unsigned char* key,
 	int key_len
 );
@@ -247,7 +301,24 @@ cef_mem_cache_cs_expire_check (
 );
 static int
 cef_mem_cache_cob_write (
-	CefMemCacheT_Content_Entry* cob
+	CefMemCacheT_Content_Mem_Entry* cob
+);
+static CefMemCacheT_Content_Mem_Entry*
+cef_mem_cache_mem_entry_create (
+	const unsigned char* msg,
+	uint16_t msg_len,
+	const unsigned char* name,
+	uint16_t name_len,
+	const unsigned char* version,
+	uint16_t ver_len
+);
+static void
+cef_mem_cache_mem_entry_free (
+	CefMemCacheT_Content_Mem_Entry* entry
+);
+static size_t
+cef_mem_cache_mem_entry_size (
+	CefMemCacheT_Content_Mem_Entry* entry
 );
 /*--------------------------------------------------------------------------------------
 	Hash Functions
@@ -256,6 +327,19 @@ static CefT_Mem_Hash*
 cef_mem_hash_tbl_create (
 	uint32_t capacity
 );
+static void
+cef_mem_hash_tbl_destroy (
+	CefT_Mem_Hash* ht
+);
+static void
+cef_mem_cache_exp_pos_set (
+	void* elem,
+	unsigned int pos
+);
+static uint64_t
+cef_mem_cache_exp_time_get (
+	CefMemCacheT_Content_Mem_Entry* entry
+);
 static uint32_t
 cef_mem_hash_number_create (
 	const unsigned char* key,
@@ -263,6 +347,8 @@ cef_mem_hash_number_create (
 );
 static int
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem,
@@ -270,16 +356,22 @@ cef_mem_cache_hash_tbl_item_set (
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove_version (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	unsigned char* ver,
@@ -290,11 +382,6 @@ cef_mem_cache_key_create_by_Mem_Entry (
 	CefMemCacheT_Content_Mem_Entry* entry,
 	unsigned char* key
 );
-static int
-cef_mem_cache_key_create (
-	CefMemCacheT_Content_Entry* entry,
-	unsigned char* key
-);
 
 /*--------------------------------------------------------------------------------------
 	MISC. Functions
@@ -341,6 +428,16 @@ cef_mem_cache_mstat_get_out (
 	uint16_t vlen
 );
 static void
+cef_mem_cache_mstat_map_set (
+	CefT_Mem_Hash_Stat* mstat_p,
+	uint32_t seqno
+);
+static void
+cef_mem_cache_chunk_delete (
+	CefT_Mem_Hash_Stat_Del* mstat_p,
+	uint32_t seqno
+);
+static void
 cef_mem_cache_mstat_ac_cnt_inc (
 	unsigned char* key,
 	uint32_t klen,
@@ -354,6 +451,14 @@ cef_mem_cache_version_compare (
 	unsigned char* ver2,
 	uint16_t vlen2
 );
+#if ((defined CefC_CefnetdCache) && (defined CefC_Develop))
+static int
+cef_mem_cache_entry_probe (
+	unsigned char* key,
+	uint32_t klen,
+	uint64_t nowt
+);
+#endif //((defined CefC_CefnetdCache) && (defined CefC_Develop))
 
 
 #if 0
@@ -374,14 +479,30 @@ cef_mem_cache_mstat_print (
 ----------------------------------------------------------------------------------------*/
 int
 cef_mem_cache_init(
-		uint32_t		capacity
+		uint32_t		capacity,
+		uint64_t		max_bytes,
+		int				admission
 ){
 	int rtc;
 	int flags;
 
-	rtc = cef_mem_cache_cs_create (capacity);
+	mem_slab = cef_mpool_slab_init ("CefMemCacheSlab", CefMemCacheC_Slab_Max);
+	if (mem_slab == 0) {
+		cef_log_write (CefC_Log_Error, "%s slab creation error\n", __func__);
+		return (-1);
+	}
+	rtc = cef_mem_cache_cs_create (capacity, max_bytes, admission);
 	cef_mem_cache_mstat_init ();
 
+	/* Create the queue to the put thread */
+	put_que = cef_rngque_create_ext (CefMemCacheC_Put_Que_Size, CefC_Rngque_Type_Mpsc);
+	if ((put_que == NULL) || (sem_init (&put_sem, 0, 0) != 0)) {
+		cef_mem_cache_cs_destroy();
+		cef_mem_cache_mstat_destroy();
+		cef_log_write (CefC_Log_Error, "%s put queue creation error\n", __func__);
+		return (-1);
+	}
+
 	/* Create delete thread */
 	delete_pipe_fd[0] = -1;
 	delete_pipe_fd[1] = -1;
@@ -422,6 +543,45 @@ cef_mem_cache_init(
 
 	return rtc;
 }
+/*--------------------------------------------------------------------------------------
+	Hands over the parsed content object to the put thread.
+	The entry is built here, so the put thread neither re-parses nor copies it.
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_mem_cache_put (
+	unsigned char* msg,							/* content object						*/
+	uint16_t msg_len,							/* length of content object				*/
+	CefT_CcnMsg_MsgBdy* pm,						/* parsed content object				*/
+	CefT_CcnMsg_OptHdr* poh						/* parsed option header					*/
+) {
+	CefMemCacheT_Content_Mem_Entry* entry;
+	int chunk_field_len = CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum;
+
+	if ((put_que == NULL) || (pm->chunk_num_f == 0)) {
+		return (-1);
+	}
+	entry = cef_mem_cache_mem_entry_create (
+				msg, msg_len, pm->name, pm->name_len - chunk_field_len,
+				(pm->org.version_f) ? pm->org.version_val : NULL,
+				(pm->org.version_f) ? pm->org.version_len : 0);
+	if (entry == NULL) {
+		return (-1);
+	}
+	entry->pay_len 		= pm->payload_len;
+	entry->chunk_num 	= pm->chunk_num;
+	entry->cache_time 	= poh->cachetime;
+	entry->expiry 		= pm->expiry;
+	/* entry->node does not care */
+
+	if (cef_rngque_push (put_que, entry) < 1) {
+		/* The put thread is behind, drops this object as the socket did 	*/
+		cef_mem_cache_mem_entry_free (entry);
+		return (-1);
+	}
+	sem_post (&put_sem);
+
+	return (0);
+}
 /*--------------------------------------------------------------------------------------
 	A thread that puts a content object in the memory cache
 ----------------------------------------------------------------------------------------*/
@@ -429,81 +589,29 @@ void *
 cef_mem_cache_put_thread (
 	void *p
 ){
-	int 						read_fd;
-	CefMemCacheT_Content_Entry*	entry;
-	struct pollfd 				fds[1];
-	unsigned char				msg[CefC_Max_Length];
-	int							msg_len;
-	struct fixed_hdr* 			chp;
-	uint16_t					pkt_len;
-	uint16_t					hdr_len;
-	uint16_t					payload_len;
-	uint16_t					header_len;
-	CefT_CcnMsg_MsgBdy 			pm = { 0 };
-	CefT_CcnMsg_OptHdr 			poh = { 0 };
-	int							res;
-	int 						chunk_field_len;
-
-	read_fd = *(int *)p;
+	CefMemCacheT_Content_Mem_Entry*	entries[CefMemCacheC_Put_Batch];
+	int 							num;
+	int 							i;
 
 	pthread_t self_thread = pthread_self();
 	pthread_detach(self_thread);
 
-	memset(&fds, 0, sizeof(fds));
-	fds[0].fd = read_fd;
-	fds[0].events = POLLIN | POLLERR;
-
 	while (1){
-	    poll(fds, 1, 1);
-	    if (fds[0].revents & POLLIN) {
-
-			if((msg_len = read(read_fd, msg, sizeof(msg))) < 1){
-				continue;
-			}
-			chp = (struct fixed_hdr*) msg;
-			pkt_len = ntohs (chp->pkt_len);
-			hdr_len = chp->hdr_len;
-			payload_len = pkt_len - hdr_len;
-			header_len 	= hdr_len;
-			res = cef_frame_message_parse (
-							msg, payload_len, header_len, &poh, &pm, CefC_PT_OBJECT);
-
-			if (res < 0) {
-				continue;
-			}
-			chunk_field_len = CefC_S_Type + CefC_S_Length + CefC_S_ChunkNum;
-			entry = (CefMemCacheT_Content_Entry*)malloc (sizeof (CefMemCacheT_Content_Entry));
-			memcpy (entry->msg, msg, msg_len);
-			entry->msg_len = msg_len;
-			if (pm.chunk_num_f) {
-				memcpy (entry->name, pm.name, pm.name_len - chunk_field_len);
-				entry->name_len = pm.name_len - chunk_field_len;
-			} else {
-				free (entry);
-				continue;
-			}
-			entry->pay_len = pm.payload_len;
-			entry->chunk_num = pm.chunk_num;
-			entry->cache_time = poh.cachetime;
-			entry->expiry = pm.expiry;
-			/* entry->node does not care */
-			if (pm.org.version_f) {
-				entry->ver_len = pm.org.version_len;
-				if (pm.org.version_len) {
-					entry->version = (unsigned char*) malloc (pm.org.version_len);
-					memcpy (entry->version, pm.org.version_val, pm.org.version_len);
-				} else {
-					entry->version = NULL;
-				}
-			} else {
-				entry->ver_len = 0;
-				entry->version = NULL;
-			}
-			cef_mem_cache_item_set (entry);
-			if (entry->ver_len > 0)
-				free (entry->version);
-			free (entry);
-	    }
+		if (sem_wait (&put_sem) != 0) {
+			continue;
+		}
+		num = cef_rngque_pop_batch (put_que, (void**) entries, CefMemCacheC_Put_Batch);
+		if (num < 1) {
+			continue;
+		}
+		/* sem_wait consumed the count of the first entry 	*/
+		for (i = 1 ; i < num ; i++) {
+			sem_trywait (&put_sem);
+		}
+		/* Each entry locks only the shard it belongs to 	*/
+		for (i = 0 ; i < num ; i++) {
+			cef_mem_cache_cob_write (entries[i]);
+		}
 	}
 	pthread_exit (NULL);
 	return 0;
@@ -537,10 +645,9 @@ cef_mem_cache_clear_thread (
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Fine, "Checks for expired contents.\n");
 #endif // CefC_Debug
-			if (cache_cs_expire_check_stat == 0){
-				cache_cs_expire_check_stat = 1;
+			if (__atomic_exchange_n (&cache_cs_expire_check_stat, 1, __ATOMIC_ACQ_REL) == 0) {
 				cef_mem_cache_cs_expire_check ();
-				cache_cs_expire_check_stat = 0;
+				__atomic_store_n (&cache_cs_expire_check_stat, 0, __ATOMIC_RELEASE);
 			}
 			/* set interval */
 			expire_check_time = nowt + interval;
@@ -562,10 +669,9 @@ cef_mem_cache_delete_thread (
 	CefT_Mem_Hash_Stat_Del*		mstat_p;
 	unsigned char				buff[CefC_Max_Length*3];
 	uint32_t					max_seq;
-	int							del_count = 0;
 	int							del_seq;
-	unsigned char 				key[CefMemCacheC_Key_Max];
-	int 						key_len;
+	uint32_t					i;
+	uint64_t					word;
 
 	read_fd = *(int *)p;
 
@@ -604,42 +710,64 @@ cef_mem_cache_delete_thread (
 }
 #endif // CefC_Debug
 
-			pthread_mutex_lock (&cef_mem_cs_mutex);
-			for (; del_seq <= max_seq; del_seq++) {
-				CefMemCacheT_Content_Mem_Entry* entry;
-
-				if (del_count >= Cef_Mstat_Delete_Cob_AtOnce) {
-					del_count = 0;
-					pthread_mutex_unlock (&cef_mem_cs_mutex);
-					usleep (50);
-					pthread_mutex_lock (&cef_mem_cs_mutex);
+			if (mstat_p->chunk_map != NULL) {
+				/* Visits only the chunks which were cached 	*/
+				for (i = 0 ; i < mstat_p->map_num ; i++) {
+					word = mstat_p->chunk_map[i];
+					while (word) {
+						cef_mem_cache_chunk_delete (
+							mstat_p, i * 64 + __builtin_ctzll (word));
+						word &= word - 1;
+					}
 				}
-
-				key_len = cef_mem_cache_name_chunknum_concatenate (
-							mstat_p->cname, mstat_p->cname_len, del_seq, key);
-				/* Delete from CS */
-				entry = cef_mem_cache_hash_tbl_item_remove_version (
-							key, key_len, mstat_p->cver, mstat_p->cver_len);
-				if (entry != NULL) {
-					free (entry->msg);
-					free (entry->name);
-					if (entry->ver_len)
-						free (entry->version);
-					free (entry);
-					/* Delete from FIFO queue */
-					cef_lhash_tbl_item_remove(lookup_table, key, key_len);
-					count--;
+				free (mstat_p->chunk_map);
+			} else {
+				for (; del_seq <= max_seq; del_seq++) {
+					cef_mem_cache_chunk_delete (mstat_p, del_seq);
 				}
-
-				del_count++;
 			}
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
 		}
 	}
 
 	pthread_exit (NULL);
 	return 0;
 }
+/*--------------------------------------------------------------------------------------
+	Deletes a chunk of the old version passed to the delete thread
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_chunk_delete (
+	CefT_Mem_Hash_Stat_Del* mstat_p,
+	uint32_t seqno
+) {
+	CefMemCacheT_Content_Mem_Entry* entry;
+	CefT_Mem_Shard* shard;
+	unsigned char 	key[CefMemCacheC_Key_Max];
+	int 			key_len;
+	uint32_t 		hash;
+
+	key_len = cef_mem_cache_name_chunknum_concatenate (
+				mstat_p->cname, mstat_p->cname_len, seqno, key);
+	hash = cef_mem_hash_number_create (key, key_len);
+	shard = cef_mem_cache_shard_get (hash);
+
+	/* Chunks of a content are spread over the shards, so the lock is 	*/
+	/* held for one chunk only and lookups never wait for the purge.	*/
+	pthread_mutex_lock (&shard->mutex);
+	/* Delete from CS */
+	entry = cef_mem_cache_hash_tbl_item_remove_version (
+				shard->hash_tbl, hash, key, key_len,
+				mstat_p->cver, mstat_p->cver_len);
+	if (entry != NULL) {
+		/* Delete from FIFO queue */
+		cef_mem_cache_fifo_erase (shard, key, key_len);
+	}
+	pthread_mutex_unlock (&shard->mutex);
+
+	if (entry != NULL) {
+		cef_mem_cache_mem_entry_free (entry);
+	}
+}
 /*--------------------------------------------------------------------------------------
 	Thread to clear expirly content object of memory cache by demand
 ----------------------------------------------------------------------------------------*/
@@ -650,10 +778,9 @@ cef_mem_cache_clear_demand_thread (
 	pthread_t self_thread = pthread_self();
 	pthread_detach(self_thread);
 
-	if (cache_cs_expire_check_stat == 0){
-		cache_cs_expire_check_stat = 1;
+	if (__atomic_exchange_n (&cache_cs_expire_check_stat, 1, __ATOMIC_ACQ_REL) == 0) {
 		cef_mem_cache_cs_expire_check ();
-		cache_cs_expire_check_stat = 0;
+		__atomic_store_n (&cache_cs_expire_check_stat, 0, __ATOMIC_RELEASE);
 	}
 
 	pthread_exit (NULL);
@@ -666,9 +793,21 @@ int									/* The return value is negative if an error occurs	*/
 cef_mem_cache_item_set (
 	CefMemCacheT_Content_Entry* entry
 ) {
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_cob_write (entry);
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	CefMemCacheT_Content_Mem_Entry* mem_entry;
+
+	mem_entry = cef_mem_cache_mem_entry_create (
+					entry->msg, entry->msg_len, entry->name, entry->name_len,
+					entry->version, entry->ver_len);
+	if (mem_entry == NULL) {
+		return (-1);
+	}
+	mem_entry->pay_len 		= entry->pay_len;
+	mem_entry->chunk_num 	= entry->chunk_num;
+	mem_entry->cache_time 	= entry->cache_time;
+	mem_entry->expiry 		= entry->expiry;
+	mem_entry->node 		= entry->node;
+
+	cef_mem_cache_cob_write (mem_entry);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -680,12 +819,21 @@ cef_mem_cache_item_get (
 	uint16_t trg_key_len						/* content name Length					*/
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
+	CefT_Mem_Shard* shard;
+	uint32_t		hash;
 	uint64_t 		nowt;
 	struct timeval 	tv;
 
+	if (mem_shard_num == 0) {
+		return (0);
+	}
+	hash = cef_mem_hash_number_create (trg_key, trg_key_len);
+	shard = cef_mem_cache_shard_get (hash);
+
 	/* Access the specified entry 	*/
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	pthread_mutex_lock (&shard->mutex);
+	cef_hash_sketch_increment (shard->sketch, trg_key, trg_key_len);
+	entry = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, trg_key, trg_key_len);
 
 	if (entry) {
 
@@ -694,12 +842,13 @@ cef_mem_cache_item_get (
 
 		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
 			(nowt < entry->cache_time)) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
+			/* The version is read under the shard lock, the entry may be replaced 	*/
 			cef_mem_cache_mstat_ac_cnt_inc (trg_key, trg_key_len, entry->version, entry->ver_len);
+			pthread_mutex_unlock (&shard->mutex);
 			return (entry);
  		}
 		else {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
+			pthread_mutex_unlock (&shard->mutex);
 			{
 				pthread_t th;
 				if (pthread_create (&th, NULL, cef_mem_cache_clear_demand_thread, NULL) == -1) {
@@ -710,7 +859,7 @@ cef_mem_cache_item_get (
 		}
 	}
 
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	pthread_mutex_unlock (&shard->mutex);
 
 	return (0);
 }
@@ -721,13 +870,34 @@ void
 cef_mem_cache_destroy (
 	void
 ) {
-pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_fifo_destroy ();
 	cef_mem_cache_cs_destroy ();
-pthread_mutex_unlock (&cef_mem_cs_mutex);
-	pthread_mutex_destroy (&cef_mem_cs_mutex);
-
 	cef_mem_cache_mstat_destroy ();
+	cef_mpool_slab_destroy (mem_slab);
+	mem_slab = 0;
+}
+/*--------------------------------------------------------------------------------------
+	Gets the occupancy of memory cache
+----------------------------------------------------------------------------------------*/
+void
+cef_mem_cache_stat_get (
+	CefMemCacheT_Stat* stat
+) {
+	CefT_Mem_Shard* shard;
+	int s;
+
+	memset (stat, 0, sizeof (CefMemCacheT_Stat));
+	for (s = 0 ; s < mem_shard_num ; s++) {
+		shard = &mem_shards[s];
+		pthread_mutex_lock (&shard->mutex);
+		stat->entry_num += shard->cache_count;
+		stat->entry_max += shard->cache_cap;
+		stat->mem_used 	+= shard->mem_used;
+		stat->evict_num += shard->evict_num;
+		stat->reject_num += shard->reject_num;
+		pthread_mutex_unlock (&shard->mutex);
+	}
+	stat->mem_max = mem_cap_bytes;
+	cef_mpool_slab_stat_get (mem_slab, &stat->slab);
 }
 
 /****************************************************************************************
@@ -738,27 +908,27 @@ pthread_mutex_unlock (&cef_mem_cs_mutex);
 ----------------------------------------------------------------------------------------*/
 static int 							/* If the error occurs, this value is a negative value	*/
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefT_Mem_Shard* shard,
+	uint32_t capacity
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
+    shard->cache_count = 0;
 	/* Records the capacity of cache		*/
 	if (capacity < 1) {
 		fprintf (stderr, "[FIFO] Invalid Cacacity\n");
 		return (-1);
 	}
-	cache_cap = capacity;
+	shard->cache_cap = capacity;
 
 	/* Initialize FIFO list management unit */
-	cache_entry_head = (FifoT_Entry*)NULL;
-	cache_entry_tail = (FifoT_Entry*)NULL;
+	shard->fifo_head = (FifoT_Entry*)NULL;
+	shard->fifo_tail = (FifoT_Entry*)NULL;
 
     /* Creates lookup table */
-    lookup_table = cef_lhash_tbl_create_u32_ext(capacity, CefC_Hash_Coef_Cache);
-	if(lookup_table == (CefT_Hash_Handle)NULL){
+    shard->lookup_table = cef_lhash_tbl_create_u32_ext(capacity, CefC_Hash_Coef_Cache);
+	if(shard->lookup_table == (CefT_Hash_Handle)NULL){
 		return (-1);
 	}
-    count = 0;
+    shard->count = 0;
 
 	return (0);
 }
@@ -768,25 +938,28 @@ cef_mem_cache_fifo_init (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefT_Mem_Shard* shard
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
-	cache_cap 		= 0;
+    shard->cache_count = 0;
+	shard->cache_cap   = 0;
+	shard->mem_used    = 0;
 	{
 		FifoT_Entry* p;
 		FifoT_Entry* np;
-		p = cache_entry_head;
+		p = shard->fifo_head;
 		while (p != (FifoT_Entry*)NULL){
 			np = p->next;
 			free(p);
 			p = np;
 		}
-		cache_entry_head = (FifoT_Entry*)NULL;
-		cache_entry_tail = (FifoT_Entry*)NULL;
+		shard->fifo_head = (FifoT_Entry*)NULL;
+		shard->fifo_tail = (FifoT_Entry*)NULL;
+	}
+	if (shard->lookup_table != (CefT_Hash_Handle)NULL) {
+	    cef_lhash_tbl_destroy(shard->lookup_table);
+		shard->lookup_table = (CefT_Hash_Handle)NULL;
 	}
-    cef_lhash_tbl_destroy(lookup_table);
-    count = 0;
+    shard->count = 0;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -794,13 +967,57 @@ cef_mem_cache_fifo_destroy (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_insert (
-	CefMemCacheT_Content_Entry* entry	/* content entry 							*/
+	CefT_Mem_Shard* shard,					/* shard locked by the caller 				*/
+	uint32_t hash,							/* hash of the key of the entry 			*/
+	CefMemCacheT_Content_Mem_Entry* entry	/* content entry (owned by the cache) 	*/
 ) {
-    if (cache_count == cache_cap) {
+	uint64_t bytes;
+
+    if (shard->cache_count == shard->cache_cap) {
         /* when cache is full, replace entry */
-    	cef_mem_cache_fifo_remove_entry(cache_entry_head, 0);
+    	cef_mem_cache_fifo_remove_entry(shard, shard->fifo_head, 0);
     }
-    cef_mem_cache_fifo_store_entry(entry);
+	if (shard->mem_cap > 0) {
+		/* evicts the oldest entries until the new one fits in the budget */
+		bytes = cef_mpool_slab_block_size (mem_slab, cef_mem_cache_mem_entry_size (entry));
+		while ((shard->fifo_head != (FifoT_Entry*)NULL) &&
+			   (shard->mem_used + bytes > shard->mem_cap)) {
+			cef_mem_cache_fifo_remove_entry(shard, shard->fifo_head, 0);
+			shard->evict_num++;
+		}
+	}
+    cef_mem_cache_fifo_store_entry(shard, hash, entry);
+}
+
+/*--------------------------------------------------------------------------------------
+	Admission API
+----------------------------------------------------------------------------------------*/
+static int									/* 1 if the entry may be inserted 			*/
+cef_mem_cache_fifo_admit (
+	CefT_Mem_Shard* shard,					/* shard locked by the caller 				*/
+	unsigned char* key, 					/* key of the new entry 					*/
+	int key_len,
+	CefMemCacheT_Content_Mem_Entry* entry	/* new entry 								*/
+) {
+	uint64_t bytes;
+
+	if ((shard->sketch == (CefT_Hash_Sketch_Handle)NULL) ||
+		(shard->fifo_head == (FifoT_Entry*)NULL)) {
+		return (1);
+	}
+	/* Nothing is evicted while the shard has room for the entry 	*/
+	if (shard->cache_count < shard->cache_cap) {
+		if (shard->mem_cap == 0) {
+			return (1);
+		}
+		bytes = cef_mpool_slab_block_size (mem_slab, cef_mem_cache_mem_entry_size (entry));
+		if (shard->mem_used + bytes <= shard->mem_cap) {
+			return (1);
+		}
+	}
+	/* The new entry must be accessed more often than the oldest one 	*/
+	return (cef_hash_sketch_admit (shard->sketch,
+				key, key_len, shard->fifo_head->key, shard->fifo_head->key_len));
 }
 
 /*--------------------------------------------------------------------------------------
@@ -808,26 +1025,29 @@ cef_mem_cache_fifo_insert (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_erase (
+	CefT_Mem_Shard* shard,					/* shard locked by the caller 				*/
 	unsigned char* key, 					/* key of content entry removed from cache 	*/
 											/* table									*/
 	int key_len								/* length of the key 						*/
 ) {
 
 	FifoT_Entry*	del_entry;
-	void* val = cef_lhash_tbl_item_get(lookup_table, key, key_len);
+	void* val = cef_lhash_tbl_item_get(shard->lookup_table, key, key_len);
     if (val == NULL) {
         fprintf(stderr, "[FIFO] failed to erace\n");
         return;
     }
 	del_entry = (FifoT_Entry*) val;
-    cef_mem_cache_fifo_remove_entry(del_entry, 1);
+    cef_mem_cache_fifo_remove_entry(shard, del_entry, 1);
 }
 /*--------------------------------------------------------------------------------------
 	MISC. Functions
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_store_entry(
-	CefMemCacheT_Content_Entry* entry
+	CefT_Mem_Shard* shard,
+	uint32_t hash,
+	CefMemCacheT_Content_Mem_Entry* entry
 ) {
     unsigned char 	key[CefMemCacheC_Key_Max];
     int 			key_len;
@@ -836,37 +1056,45 @@ cef_mem_cache_fifo_store_entry(
 
     key_len = cef_mem_cache_name_chunknum_concatenate (
                     entry->name, entry->name_len, entry->chunk_num, key);
-	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(key, key_len, entry->version, entry->ver_len);
+	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(
+					shard, key, key_len, entry->version, entry->ver_len);
 
 	if (rsentry == (FifoT_Entry*) NULL){
+		cef_mem_cache_mem_entry_free (entry);
 		return;
 	}
-    cef_lhash_tbl_item_set(lookup_table, rsentry->key, rsentry->key_len
+	rsentry->bytes = (uint32_t) cef_mpool_slab_block_size (
+									mem_slab, cef_mem_cache_mem_entry_size (entry));
+    cef_lhash_tbl_item_set(shard->lookup_table, rsentry->key, rsentry->key_len
     	, (void*)rsentry);
-    count++;
-    cef_mem_cache_cs_store(entry);
-    cache_count++;
+    shard->count++;
+    cef_mem_cache_cs_store(shard, hash, entry);
+    shard->cache_count++;
+	shard->mem_used += rsentry->bytes;
 }
 /*-----*/
 static void
 cef_mem_cache_fifo_remove_entry(
+	CefT_Mem_Shard* shard,
 	FifoT_Entry*   entry,
     int is_removed
 ) {
     FifoT_Entry* rsentry;
     rsentry = entry;
-    cef_lhash_tbl_item_remove(lookup_table, rsentry->key, rsentry->key_len);
-    count--;
+    cef_lhash_tbl_item_remove(shard->lookup_table, rsentry->key, rsentry->key_len);
+    shard->count--;
 
-    if (!is_removed) cef_mem_cache_cs_remove(rsentry->key, rsentry->key_len);
-	cef_mem_cache_fifo_cache_entry_dequeue(rsentry);
+    if (!is_removed) cef_mem_cache_cs_remove(shard, rsentry->key, rsentry->key_len);
+	shard->mem_used -= rsentry->bytes;
+	cef_mem_cache_fifo_cache_entry_dequeue(shard, rsentry);
 
-	cache_count--;
+	shard->cache_count--;
 
 }
 
 static FifoT_Entry*
-cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len, unsigned char* ver, uint16_t ver_len) {
+cef_mem_cache_fifo_cache_entry_enqueue(
+	CefT_Mem_Shard* shard, unsigned char* key, int key_len, unsigned char* ver, uint16_t ver_len) {
 
 	FifoT_Entry*	q;
 	q = (FifoT_Entry*) calloc(1, sizeof(FifoT_Entry) + key_len + ver_len);
@@ -879,27 +1107,27 @@ cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len, unsigned
 	q->ver = ((unsigned char*) q) + sizeof(FifoT_Entry) + key_len;
 	memcpy (q->ver, ver, ver_len);
 	q->ver_len = ver_len;
-	if(cache_entry_tail == (FifoT_Entry*)NULL){
-		cache_entry_head = q;
-		cache_entry_tail = q;
+	if(shard->fifo_tail == (FifoT_Entry*)NULL){
+		shard->fifo_head = q;
+		shard->fifo_tail = q;
 	} else {
-		cache_entry_tail->next = q;
-		q->before = cache_entry_tail;
-		cache_entry_tail = q;
+		shard->fifo_tail->next = q;
+		q->before = shard->fifo_tail;
+		shard->fifo_tail = q;
 	}
   	return(q);
 }
 
 static void
-cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
+cef_mem_cache_fifo_cache_entry_dequeue(CefT_Mem_Shard* shard, FifoT_Entry* p){
 
 	 if(p->before == (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
-	 	cache_entry_head = p->next;
+	 	shard->fifo_head = p->next;
 	 	p->next->before = (FifoT_Entry*)NULL;
 	 } else
 	 if(p->before == (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
-	 	cache_entry_head = (FifoT_Entry*)NULL;
-	 	cache_entry_tail = (FifoT_Entry*)NULL;
+	 	shard->fifo_head = (FifoT_Entry*)NULL;
+	 	shard->fifo_tail = (FifoT_Entry*)NULL;
 	 } else
 	 if(p->before != (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
@@ -907,7 +1135,7 @@ cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
 	 } else
 	 if(p->before != (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
-	 	cache_entry_tail = p->before;
+	 	shard->fifo_tail = p->before;
 	 }
 	free (p);
 }
@@ -920,106 +1148,170 @@ cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cs_create (
-		uint32_t		capacity
+		uint32_t		capacity,			/* maximum number of entries 				*/
+		uint64_t		max_bytes,			/* byte budget (0 means unlimited) 			*/
+		int				admission			/* 1 enables the TinyLFU admission 			*/
 ) {
+	CefT_Mem_Shard* shard;
+	uint32_t shard_cap;
+	int i;
 
-	/* Creates the memory cache 		*/
-	mem_hash_tbl = cef_mem_hash_tbl_create (capacity);
-	if (mem_hash_tbl ==  NULL) {
-		cef_log_write (CefC_Log_Error, "create mem hash table\n");
+	if (capacity < 1) {
+		cef_log_write (CefC_Log_Error, "create mem hash table (capacity=0)\n");
 		return (-1);
 	}
-	if (cef_mem_cache_fifo_init (capacity) == -1) {
-		cef_log_write (CefC_Log_Error, "create fifo cache\n");
-		return (-1);
+	memset (mem_shards, 0, sizeof (mem_shards));
+
+	/* Every shard holds at least one entry 	*/
+	mem_shard_num = (capacity < CefMemCacheC_Shard_Num) ? capacity : CefMemCacheC_Shard_Num;
+	mem_cap_bytes = max_bytes;
+
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		shard = &mem_shards[i];
+		shard_cap = capacity / mem_shard_num + ((i < capacity % mem_shard_num) ? 1 : 0);
+		shard->mem_cap = max_bytes / mem_shard_num;
+
+		pthread_mutex_init (&shard->mutex, NULL);
+
+		/* Creates the memory cache 		*/
+		shard->hash_tbl = cef_mem_hash_tbl_create (shard_cap);
+		if (shard->hash_tbl ==  NULL) {
+			cef_log_write (CefC_Log_Error, "create mem hash table\n");
+			cef_mem_cache_cs_destroy ();
+			return (-1);
+		}
+		if (cef_mem_cache_fifo_init (shard, shard_cap) == -1) {
+			cef_log_write (CefC_Log_Error, "create fifo cache\n");
+			cef_mem_cache_cs_destroy ();
+			return (-1);
+		}
+		if (admission) {
+			shard->sketch = cef_hash_sketch_create (shard_cap);
+			if (shard->sketch == (CefT_Hash_Sketch_Handle)NULL) {
+				cef_log_write (CefC_Log_Error, "create admission sketch\n");
+				cef_mem_cache_cs_destroy ();
+				return (-1);
+			}
+		}
 	}
 
-	cef_log_write (CefC_Log_Info, "Local cache capacity : %u\n", capacity);
+	cef_log_write (CefC_Log_Info, "Local cache capacity : %u (%d shards)\n"
+					, capacity, mem_shard_num);
+	if (max_bytes > 0) {
+		cef_log_write (CefC_Log_Info, "Local cache memory   : "FMTU64" MB\n"
+						, max_bytes / (1024 * 1024));
+	}
+	if (admission) {
+		cef_log_write (CefC_Log_Info, "Local cache admission: TinyLFU\n");
+	}
 
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Selects the shard which holds the key of the specified hash
+----------------------------------------------------------------------------------------*/
+static CefT_Mem_Shard*
+cef_mem_cache_shard_get (
+	uint32_t hash								/* cef_mem_hash_number_create() of key 	*/
+) {
+	/* The low bits select the bucket in the shard, so uses the high bits here */
+	return (&mem_shards[(hash >> 16) % mem_shard_num]);
+}
 /*--------------------------------------------------------------------------------------
 	Store API
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_cs_store (
-	CefMemCacheT_Content_Entry* new_entry
+	CefT_Mem_Shard* shard,						/* shard locked by the caller 			*/
+	uint32_t hash,								/* hash of the key of the entry 		*/
+	CefMemCacheT_Content_Mem_Entry* entry		/* entry to store (owned by the cache) 	*/
 ) {
-	CefMemCacheT_Content_Mem_Entry* entry;
 	CefMemCacheT_Content_Mem_Entry* old_entry = NULL;
 	int key_len;
 	unsigned char key[65535];
 
 	/* Creates the key 		*/
-	key_len = cef_mem_cache_key_create (new_entry, key);
+	key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, key);
 
-	/* Creates the entry 		*/
-	entry =
-		(CefMemCacheT_Content_Mem_Entry*) calloc (1, sizeof (CefMemCacheT_Content_Mem_Entry));
-	if (entry == NULL) {
+	/* Inserts the cache entry 		*/
+	if (cef_mem_cache_hash_tbl_item_set (
+		shard->hash_tbl, hash, key, key_len, entry, &old_entry) < 0) {
+		cef_mem_cache_mem_entry_free (entry);
 		return (-1);
 	}
-	entry->msg =
-		(unsigned char*) calloc (1, new_entry->msg_len);
-	if (entry->msg == NULL) {
-		free (entry);
-		return (-1);
+
+	if (old_entry) {
+		cef_mem_cache_mem_entry_free (old_entry);
 	}
-	entry->name =
-		(unsigned char*) calloc (1, new_entry->name_len);
-	if (entry->name == NULL) {
-		free (entry->msg);
-		free (entry);
-		return (-1);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates the entry of the memory cache
+----------------------------------------------------------------------------------------*/
+static CefMemCacheT_Content_Mem_Entry*
+cef_mem_cache_mem_entry_create (
+	const unsigned char* msg,
+	uint16_t msg_len,
+	const unsigned char* name,
+	uint16_t name_len,
+	const unsigned char* version,
+	uint16_t ver_len
+) {
+	CefMemCacheT_Content_Mem_Entry* entry;
+	unsigned char* wp;
+
+	/* The entry, message, name and version are put in one block of the slab 	*/
+	entry = (CefMemCacheT_Content_Mem_Entry*) cef_mpool_slab_alloc (mem_slab,
+				sizeof (CefMemCacheT_Content_Mem_Entry) + msg_len + name_len + ver_len);
+	if (entry == NULL) {
+		return (NULL);
 	}
-	entry->ver_len = new_entry->ver_len;
-	if (new_entry->ver_len) {
-		entry->version =
-			(unsigned char*) calloc (1, new_entry->ver_len);
-		if (entry->version == NULL) {
-			free (entry->msg);
-			free (entry->name);
-			free (entry);
-			return (-1);
-		}
-		memcpy (entry->version, new_entry->version, new_entry->ver_len);
+	memset (entry, 0, sizeof (CefMemCacheT_Content_Mem_Entry));
+	entry->exp_pos = CefC_Expque_Invalid;
+	wp = (unsigned char*)(entry + 1);
+
+	entry->msg = wp;
+	memcpy (entry->msg, msg, msg_len);
+	entry->msg_len 	= msg_len;
+	wp += msg_len;
+
+	entry->name = wp;
+	memcpy (entry->name, name, name_len);
+	entry->name_len = name_len;
+	wp += name_len;
+
+	if (ver_len) {
+		entry->version = wp;
+		memcpy (entry->version, version, ver_len);
 	} else {
 		entry->version = NULL;
 	}
+	entry->ver_len 	= ver_len;
 
-	/* Inserts the cache entry 		*/
-	memcpy (entry->msg, new_entry->msg, new_entry->msg_len);
-	entry->msg_len		 = new_entry->msg_len;
-	memcpy (entry->name, new_entry->name, new_entry->name_len);
-	entry->name_len		 = new_entry->name_len;
-	entry->pay_len		 = new_entry->pay_len;
-	entry->chunk_num		 = new_entry->chunk_num;
-	entry->cache_time	 = new_entry->cache_time;
-	entry->expiry		 = new_entry->expiry;
-	entry->node			 = new_entry->node;
-
-	if (cef_mem_cache_hash_tbl_item_set (
-		key, key_len, entry, &old_entry) < 0) {
-		free (entry->msg);
-		free (entry->name);
-		if (entry->version != NULL) {
-			free (entry->version);
-		}
-		free (entry);
-		return (-1);
-	}
-
+	return (entry);
+}
 
-	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
-		if (old_entry->version != NULL) {
-			free (old_entry->version);
-		}
-		free (old_entry);
-	}
+/*--------------------------------------------------------------------------------------
+	Frees the entry of the memory cache
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_mem_entry_free (
+	CefMemCacheT_Content_Mem_Entry* entry
+) {
+	cef_mpool_slab_free (mem_slab, entry, cef_mem_cache_mem_entry_size (entry));
+}
 
-	return (0);
+/*--------------------------------------------------------------------------------------
+	Returns the size of the entry passed to the slab
+----------------------------------------------------------------------------------------*/
+static size_t
+cef_mem_cache_mem_entry_size (
+	CefMemCacheT_Content_Mem_Entry* entry
+) {
+	return (sizeof (CefMemCacheT_Content_Mem_Entry)
+				+ entry->msg_len + entry->name_len + entry->ver_len);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -1027,21 +1319,19 @@ cef_mem_cache_cs_store (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_cs_remove (
+	CefT_Mem_Shard* shard,						/* shard locked by the caller 			*/
 	unsigned char* key,
 	int key_len
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
 
 	/* Removes the specified entry 	*/
-	entry = cef_mem_cache_hash_tbl_item_remove (key, key_len);
+	entry = cef_mem_cache_hash_tbl_item_remove (
+				shard->hash_tbl, cef_mem_hash_number_create (key, key_len), key, key_len);
 
 	if (entry) {
 		cef_mem_cache_mstat_remove (key, key_len, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
-		if (entry->ver_len)
-			free (entry->version);
-		free (entry);
+		cef_mem_cache_mem_entry_free (entry);
 	}
 
 	return;
@@ -1054,23 +1344,35 @@ static void
 cef_mem_cache_cs_destroy (
 	void
 ) {
-	int i;
-
-	if (mem_hash_tbl) {
-		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[i];
-			while (cp != NULL) {
-				wcp = cp->next;
-				free (cp->elem);
-				free(cp);
-				cp = wcp;
+	CefT_Mem_Shard* shard;
+	int i, s;
+
+	for (s = 0 ; s < mem_shard_num ; s++) {
+		shard = &mem_shards[s];
+
+		pthread_mutex_lock (&shard->mutex);
+		cef_mem_cache_fifo_destroy (shard);
+		if (shard->hash_tbl) {
+			for (i = 0 ; i < shard->hash_tbl->tabl_max ; i++) {
+				CefT_Mem_Hash_Cell* cp;
+				CefT_Mem_Hash_Cell* wcp;
+				cp = shard->hash_tbl->tbl[i];
+				while (cp != NULL) {
+					wcp = cp->next;
+					cef_mem_cache_mem_entry_free (cp->elem);
+					free(cp);
+					cp = wcp;
+				}
 			}
+			cef_mem_hash_tbl_destroy (shard->hash_tbl);
+			shard->hash_tbl = NULL;
 		}
-		free (mem_hash_tbl->tbl);
-		free (mem_hash_tbl);
+		cef_hash_sketch_destroy (shard->sketch);
+		shard->sketch = (CefT_Hash_Sketch_Handle)NULL;
+		pthread_mutex_unlock (&shard->mutex);
+		pthread_mutex_destroy (&shard->mutex);
 	}
+	mem_shard_num = 0;
 
 	return;
 }
@@ -1084,44 +1386,43 @@ cef_mem_cache_cs_expire_check (
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry = NULL;
 	CefMemCacheT_Content_Mem_Entry* entry1 = NULL;
+	CefT_Mem_Shard* shard;
 	uint64_t 	nowt;
 	struct timeval tv;
-	int n;
+	int n, s, done;
 	unsigned char trg_key[65535];
 	int trg_key_len;
 
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		pthread_mutex_lock (&cef_mem_cs_mutex);
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
-			continue;
-		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_cache_hash_tbl_item_remove (trg_key, trg_key_len);
-					cef_mem_cache_fifo_erase(trg_key, trg_key_len);
-					cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
-					free (entry1->msg);
-					free (entry1->name);
-					if (entry1->ver_len)
-						free (entry1->version);
-					free (entry1);
+	for (s = 0 ; s < mem_shard_num ; s++) {
+		shard = &mem_shards[s];
+
+		/* Takes the expired entries in time order. The lock is released after	*/
+		/* each batch, so lookups on this shard are not kept waiting.			*/
+		for (done = 0 ; done < CefMemCacheC_Expire_Max ; done += n) {
+			pthread_mutex_lock (&shard->mutex);
+			for (n = 0 ; n < CefMemCacheC_Expire_Batch ; n++) {
+				entry = (CefMemCacheT_Content_Mem_Entry*)
+							cef_expque_pop_expired (shard->hash_tbl->exp_que, nowt);
+				if (entry == NULL) {
+					break;
 				}
+				/* Removes the expiry cache entry 		*/
+				trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
+				entry1 = cef_mem_cache_hash_tbl_item_remove (shard->hash_tbl,
+							cef_mem_hash_number_create (trg_key, trg_key_len),
+							trg_key, trg_key_len);
+				cef_mem_cache_fifo_erase(shard, trg_key, trg_key_len);
+				cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
+				cef_mem_cache_mem_entry_free (entry1);
+			}
+			pthread_mutex_unlock (&shard->mutex);
+			if (n < CefMemCacheC_Expire_Batch) {
+				break;
 			}
 		}
-		pthread_mutex_unlock (&cef_mem_cs_mutex);
 	}
 
 	return;
@@ -1131,9 +1432,11 @@ cef_mem_cache_cs_expire_check (
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cob_write (
-	CefMemCacheT_Content_Entry* cob
+	CefMemCacheT_Content_Mem_Entry* cob		/* entry to write, the cache takes it over 	*/
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry = NULL;
+	CefT_Mem_Shard* shard;
+	uint32_t		hash;
 	unsigned char 	trg_key[CefMemCacheC_Key_Max];
 	int 			trg_key_len;
 	uint64_t nowt;
@@ -1144,11 +1447,16 @@ cef_mem_cache_cob_write (
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 	if(cob->expiry < nowt){
+		cef_mem_cache_mem_entry_free (cob);
 		return (0);
 	}
 
-	trg_key_len = cef_mem_cache_key_create (cob, trg_key);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (cob, trg_key);
+	hash = cef_mem_hash_number_create (trg_key, trg_key_len);
+	shard = cef_mem_cache_shard_get (hash);
+
+	pthread_mutex_lock (&shard->mutex);
+	entry = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, trg_key, trg_key_len);
 #if 0
 	if (entry == NULL) {
 		cef_mem_cache_fifo_insert(cob);
@@ -1164,6 +1472,8 @@ cef_mem_cache_cob_write (
 		if (rc != Cef_InconsistentVersion) {
 			if (rc == Cef_NewestVersion_1stArg) {
 				/* The version of the entry is newer than the version of the receiving cob. */
+				pthread_mutex_unlock (&shard->mutex);
+				cef_mem_cache_mem_entry_free (cob);
 				return (0);
 			} else if (rc == Cef_SameVersion) {
 				/* The version of the entry is the same as the version of the receiving cob. */
@@ -1171,6 +1481,10 @@ cef_mem_cache_cob_write (
 				entry->cache_time	 = cob->cache_time;
 				entry->expiry		 = cob->expiry;
 				entry->node			 = cob->node;
+				cef_expque_update (shard->hash_tbl->exp_que,
+					entry->exp_pos, cef_mem_cache_exp_time_get (entry));
+				pthread_mutex_unlock (&shard->mutex);
+				cef_mem_cache_mem_entry_free (cob);
 				return (0);
 			} else {
 				CefT_Mem_Hash_Stat* mstat_p;
@@ -1178,17 +1492,14 @@ cef_mem_cache_cob_write (
 				/* Pass the Stat table entry to the delete thread */
 
 				/* Delete only this Cob entry first */
-				cef_mem_cache_fifo_erase (trg_key, trg_key_len);
-				entry = cef_mem_cache_hash_tbl_item_remove (trg_key, trg_key_len);
+				cef_mem_cache_fifo_erase (shard, trg_key, trg_key_len);
+				entry = cef_mem_cache_hash_tbl_item_remove (
+							shard->hash_tbl, hash, trg_key, trg_key_len);
 
 				mstat_p = cef_mem_cache_mstat_get_out (trg_key, trg_key_len, entry->version, entry->ver_len);
 
 				if (entry) {
-					free (entry->msg);
-					free (entry->name);
-					if (entry->ver_len)
-						free (entry->version);
-					free (entry);
+					cef_mem_cache_mem_entry_free (entry);
 				}
 
 				if (mstat_p != NULL) {
@@ -1203,11 +1514,17 @@ cef_mem_cache_cob_write (
 					mstat_del.cver_len = mstat_p->ver_len;
 					mstat_del.min_seq = mstat_p->min_seq;
 					mstat_del.max_seq = mstat_p->max_seq;
+					if (!mstat_p->map_over) {
+						mstat_del.chunk_map = mstat_p->chunk_map;
+						mstat_del.map_num = mstat_p->map_num;
+						mstat_p->chunk_map = NULL;
+					}
 
 					/* Delete the remaining Cob entries */
 					if (write (delete_pipe_fd[0], &mstat_del, sizeof (CefT_Mem_Hash_Stat_Del)) != sizeof(CefT_Mem_Hash_Stat_Del)) {
-						;/* NOP */
+						free (mstat_del.chunk_map);
 					}
+					free (mstat_p->chunk_map);
 					if (mstat_p->version != NULL)
 						free (mstat_p->version);
 					if (mstat_p->contents_name != NULL)
@@ -1229,15 +1546,25 @@ cef_mem_cache_cob_write (
 			} else {
 				sprintf(rstr, "None");rstr[4] = 0x00;
 			}
+			pthread_mutex_unlock (&shard->mutex);
 			cef_frame_conversion_name_to_uri (trg_key, trg_key_len, uri);
 			cef_log_write (CefC_Log_Warn,
 				"Inconsistent version number used for URI[%s]. Cache=%s, Recvd=%s.\n"
 				, uri, cstr, rstr);
+			cef_mem_cache_mem_entry_free (cob);
 			return (0);
 		}
 	}
-	cef_mem_cache_fifo_insert(cob);
+	if (!cef_mem_cache_fifo_admit (shard, trg_key, trg_key_len, cob)) {
+		shard->reject_num++;
+		pthread_mutex_unlock (&shard->mutex);
+		cef_mem_cache_mem_entry_free (cob);
+		return (0);
+	}
+	/* cob may be freed by the insertion, so updates the stat first 	*/
 	cef_mem_cache_mstat_insert (trg_key, trg_key_len, cob->pay_len, cob->version, cob->ver_len, old_ver_ac_cnt);
+	cef_mem_cache_fifo_insert(shard, hash, cob);
+	pthread_mutex_unlock (&shard->mutex);
 #endif
 	return (0);
 }
@@ -1294,32 +1621,70 @@ cef_mem_hash_tbl_create (
 	}
 	memset (ht->tbl, 0, sizeof (CefT_Mem_Hash_Cell*) * table_size);
 
+	ht->exp_que = cef_expque_create (cef_mem_cache_exp_pos_set);
+	if (ht->exp_que == NULL) {
+		free (ht->tbl);
+		free (ht);
+		return (NULL);
+	}
+
 	srand ((unsigned) time (NULL));
 	ht->elem_max = capacity;
 	ht->tabl_max = table_size;
-	mem_tabl_max = ht->tabl_max;
 
 	return (ht);
 }
+/*--------------------------------------------------------------------------------------
+	Destroy memory hash table (the entries are freed by the caller)
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_hash_tbl_destroy (
+	CefT_Mem_Hash* ht
+) {
+	cef_expque_destroy (ht->exp_que);
+	free (ht->tbl);
+	free (ht);
+}
+/*--------------------------------------------------------------------------------------
+	Records the position of the entry in the expiry queue
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_exp_pos_set (
+	void* elem,
+	unsigned int pos
+) {
+	((CefMemCacheT_Content_Mem_Entry*) elem)->exp_pos = pos;
+}
+/*--------------------------------------------------------------------------------------
+	Time when the entry is no longer served
+----------------------------------------------------------------------------------------*/
+static uint64_t
+cef_mem_cache_exp_time_get (
+	CefMemCacheT_Content_Mem_Entry* entry
+) {
+	if ((entry->expiry != 0) && (entry->expiry < entry->cache_time)) {
+		return (entry->expiry);
+	}
+	return (entry->cache_time);
+}
 /*--------------------------------------------------------------------------------------
 	Set item to memory hash table
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem,
 	CefMemCacheT_Content_Mem_Entry** old_elem
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
 
 	*old_elem = NULL;
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	if(ht->tbl[y] == NULL){
@@ -1327,8 +1692,14 @@ cef_mem_cache_hash_tbl_item_set (
 		if (ht->tbl[y] == NULL) {
 			return (-1);
 		}
+		if (cef_expque_push (ht->exp_que, elem, cef_mem_cache_exp_time_get (elem)) < 0) {
+			free (ht->tbl[y]);
+			ht->tbl[y] = NULL;
+			return (-1);
+		}
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1342,6 +1713,9 @@ cef_mem_cache_hash_tbl_item_set (
 			   (memcmp (cp->key, key, klen) == 0)){
 				*old_elem = cp->elem;
 				cp->elem = elem;
+				/* never fails, the old one has just left the queue 	*/
+				cef_expque_remove (ht->exp_que, (*old_elem)->exp_pos);
+				cef_expque_push (ht->exp_que, elem, cef_mem_cache_exp_time_get (elem));
 				return (1);
 		   }
 		}
@@ -1349,11 +1723,18 @@ cef_mem_cache_hash_tbl_item_set (
 		wcp = ht->tbl[y];
 		ht->tbl[y] = (CefT_Mem_Hash_Cell* )calloc(1, sizeof(CefT_Mem_Hash_Cell) + klen);
 		if (ht->tbl[y] == NULL) {
+			ht->tbl[y] = wcp;
+			return (-1);
+		}
+		if (cef_expque_push (ht->exp_que, elem, cef_mem_cache_exp_time_get (elem)) < 0) {
+			free (ht->tbl[y]);
+			ht->tbl[y] = wcp;
 			return (-1);
 		}
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
 		cp->next = wcp;
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1367,18 +1748,17 @@ cef_mem_cache_hash_tbl_item_set (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 
 	if ((klen > CefMemCacheC_Key_Max) || (ht == NULL)) {
 		return (NULL);
 	}
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1400,11 +1780,11 @@ cef_mem_cache_hash_tbl_item_get (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefMemCacheT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
@@ -1414,7 +1794,6 @@ cef_mem_cache_hash_tbl_item_remove (
 		return (NULL);
 	}
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1427,6 +1806,7 @@ cef_mem_cache_hash_tbl_item_remove (
 		   	ht->tbl[y] = cp->next;
 			ht->elem_num--;
 		   	ret_elem = cp->elem;
+			cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 		   	free(cp);
 		   	return (ret_elem);
 		} else {
@@ -1437,6 +1817,7 @@ cef_mem_cache_hash_tbl_item_remove (
 				   	cp->next = cp->next->next;
 					ht->elem_num--;
 				   	ret_elem = wcp->elem;
+					cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 		   			free(wcp);
 		   			return (ret_elem);
 				}
@@ -1451,13 +1832,13 @@ cef_mem_cache_hash_tbl_item_remove (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove_version (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	unsigned char* ver,
 	uint16_t vlen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefMemCacheT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
@@ -1467,7 +1848,6 @@ cef_mem_cache_hash_tbl_item_remove_version (
 		return (NULL);
 	}
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1482,6 +1862,7 @@ cef_mem_cache_hash_tbl_item_remove_version (
 			ht->tbl[y] = cp->next;
 			ht->elem_num--;
 			ret_elem = cp->elem;
+			cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 			free(cp);
 			return (ret_elem);
 		} else {
@@ -1494,6 +1875,7 @@ cef_mem_cache_hash_tbl_item_remove_version (
 					cp->next = cp->next->next;
 					ht->elem_num--;
 					ret_elem = wcp->elem;
+					cef_expque_remove (ht->exp_que, ret_elem->exp_pos);
 					free(wcp);
 					return (ret_elem);
 				}
@@ -1567,26 +1949,6 @@ cef_mem_cache_name_chunknum_concatenate (
 
 	return (name_len + 4 + sizeof (uint32_t));
 }
-/*--------------------------------------------------------------------------------------
-	Creates tye key from name and chunk number
-----------------------------------------------------------------------------------------*/
-static int												/* length of the created key 			*/
-cef_mem_cache_key_create (
-	CefMemCacheT_Content_Entry* entry,
-	unsigned char* key
-) {
-	uint32_t chunk_num;
-
-	memcpy (&key[0], entry->name, entry->name_len);
-	key[entry->name_len] 		= 0x00;
-	key[entry->name_len + 1] 	= 0x10;
-	key[entry->name_len + 2] 	= 0x00;
-	key[entry->name_len + 3] 	= 0x04;
-	chunk_num = htonl (entry->chunk_num);
-	memcpy (&key[entry->name_len + 4], &chunk_num, sizeof (uint32_t));
-
-	return (entry->name_len + 4 + sizeof (uint32_t));
-}
 /*--------------------------------------------------------------------------------------
 	Initialize stat
 ----------------------------------------------------------------------------------------*/
@@ -1609,6 +1971,7 @@ cef_mem_cache_mstat_destroy (
 	CefT_Mem_Hash_Stat*		wk_mstat_p;
 	int i;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
 	for (i = 0; i < Cef_Mstat_HashTbl_Size; i++) {
 		mstat_p = mstat_tbl[i];
 		while (mstat_p != NULL) {
@@ -1616,11 +1979,14 @@ cef_mem_cache_mstat_destroy (
 				free (mstat_p->contents_name);
 			if (mstat_p->version != NULL)
 				free (mstat_p->version);
+			free (mstat_p->chunk_map);
 			wk_mstat_p = mstat_p;
 			mstat_p = mstat_p->next;
 			free (wk_mstat_p);
 		}
+		mstat_tbl[i] = NULL;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return;
 }
@@ -1651,6 +2017,7 @@ cef_mem_cache_mstat_insert (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
 	if(mstat_tbl[y] == NULL){
 		mstat_tbl[y] = (CefT_Mem_Hash_Stat*)malloc (sizeof (CefT_Mem_Hash_Stat));
 		mstat_p = mstat_tbl[y];
@@ -1665,6 +2032,8 @@ cef_mem_cache_mstat_insert (
 					mstat_p->min_seq = seqno;
 				if (mstat_p->max_seq < seqno)
 					mstat_p->max_seq = seqno;
+				cef_mem_cache_mstat_map_set (mstat_p, seqno);
+				pthread_mutex_unlock (&cef_mem_mstat_mutex);
 				return;
 			}
 			if (mstat_p->next == NULL)
@@ -1684,6 +2053,10 @@ cef_mem_cache_mstat_insert (
 	mstat_p->ver_ac_cnt = 0;
 	mstat_p->min_seq = seqno;
 	mstat_p->max_seq = seqno;
+	mstat_p->chunk_map = NULL;
+	mstat_p->map_num = 0;
+	mstat_p->map_over = 0;
+	cef_mem_cache_mstat_map_set (mstat_p, seqno);
 	mstat_p->ver_len = ver_len;
 	if (ver_len > 0) {
 		mstat_p->version = (unsigned char*) malloc (ver_len);
@@ -1691,6 +2064,7 @@ cef_mem_cache_mstat_insert (
 	} else {
 		mstat_p->version = NULL;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return;
 }
@@ -1704,6 +2078,7 @@ cef_mem_cache_mstat_remove (
 	uint16_t pay_len							/* Length of ContentObject Payload		*/
 ) {
 	CefT_Mem_Hash_Stat* mstat_p;
+	CefT_Mem_Hash_Stat* prev_p;
 	uint16_t tmp_klen;
 	uint32_t seqno;		/* work variable */
 	uint32_t hash = 0;
@@ -1718,31 +2093,39 @@ cef_mem_cache_mstat_remove (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+	prev_p = NULL;
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
 			memcmp (mstat_p->contents_name, key, tmp_klen) == 0) {
 			mstat_p->contents_size -= pay_len;
 			mstat_p->cob_num--;
+			if (seqno / 64 < mstat_p->map_num) {
+				mstat_p->chunk_map[seqno / 64] &= ~(1llu << (seqno % 64));
+			}
 
 			if (mstat_p->cob_num == 0) {
-				CefT_Mem_Hash_Stat*		wk_mstat_p;
-
-				if (mstat_p->contents_name != NULL)
-					free (mstat_p->contents_name);
-				if (mstat_p != mstat_tbl[y]) {
-					wk_mstat_p = mstat_p;
-					mstat_p = mstat_p->next;
-					free (wk_mstat_p);
+				/* Unlinks the stat of the content which has no cob 	*/
+				if (prev_p != NULL) {
+					prev_p->next = mstat_p->next;
 				} else {
-					free (mstat_p);
-					mstat_tbl[y] = NULL;
+					mstat_tbl[y] = mstat_p->next;
 				}
+				if (mstat_p->contents_name != NULL)
+					free (mstat_p->contents_name);
+				if (mstat_p->version != NULL)
+					free (mstat_p->version);
+				free (mstat_p->chunk_map);
+				free (mstat_p);
 			}
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return;
 		}
+		prev_p = mstat_p;
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return;
 }
@@ -1770,6 +2153,7 @@ cef_mem_cache_mstat_get (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1802,10 +2186,12 @@ cef_mem_cache_mstat_get (
 			info_p->max_seq = mstat_p->max_seq;
 #endif //-----@@@@@ CCNINFO
 
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return (1);
 		}
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return (-1);
 }
@@ -1820,6 +2206,7 @@ cef_mem_cache_mstat_get_out (
 	uint16_t vlen
 ) {
 	CefT_Mem_Hash_Stat* mstat_p;
+	CefT_Mem_Hash_Stat* prev_p;
 	uint16_t tmp_klen;
 	uint32_t seqno;		/* work variable */
 	uint32_t hash = 0;
@@ -1834,27 +2221,68 @@ cef_mem_cache_mstat_get_out (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+	prev_p = NULL;
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
 			memcmp (mstat_p->contents_name, key, tmp_klen) == 0 &&
 			mstat_p->ver_len == vlen &&
 			memcmp (mstat_p->version, ver, vlen) == 0) {
-			CefT_Mem_Hash_Stat*		wk_mstat_p;
-			wk_mstat_p = mstat_p;
-			if (mstat_p != mstat_tbl[y]) {
-				mstat_p = mstat_p->next;
+			/* Unlinks the stat and passes it to the caller 	*/
+			if (prev_p != NULL) {
+				prev_p->next = mstat_p->next;
 			} else {
-				mstat_tbl[y] = NULL;
+				mstat_tbl[y] = mstat_p->next;
 			}
+			mstat_p->next = NULL;
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
-			return (wk_mstat_p);
+			return (mstat_p);
 		}
+		prev_p = mstat_p;
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return (NULL);
 }
+/*--------------------------------------------------------------------------------------
+	Records the chunk number in the map of the stat (mstat mutex held by the caller)
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_mstat_map_set (
+	CefT_Mem_Hash_Stat* mstat_p,
+	uint32_t seqno
+) {
+	uint32_t x = seqno / 64;
+	uint32_t map_num;
+	uint64_t* map;
+
+	if (mstat_p->map_over) {
+		return;
+	}
+	if (x >= mstat_p->map_num) {
+		map_num = (x / CefMemCacheC_Map_Unit + 1) * CefMemCacheC_Map_Unit;
+		if (map_num > CefMemCacheC_Map_Max) {
+			map = NULL;
+		} else {
+			map = (uint64_t*) realloc (mstat_p->chunk_map, sizeof (uint64_t) * map_num);
+		}
+		if (map == NULL) {
+			/* The old version will be purged by the range of the chunk numbers 	*/
+			free (mstat_p->chunk_map);
+			mstat_p->chunk_map = NULL;
+			mstat_p->map_num = 0;
+			mstat_p->map_over = 1;
+			return;
+		}
+		memset (&map[mstat_p->map_num], 0, sizeof (uint64_t) * (map_num - mstat_p->map_num));
+		mstat_p->chunk_map = map;
+		mstat_p->map_num = map_num;
+	}
+	mstat_p->chunk_map[x] |= 1llu << (seqno % 64);
+}
 /*--------------------------------------------------------------------------------------
 	Increment access count
 ----------------------------------------------------------------------------------------*/
@@ -1876,6 +2304,7 @@ cef_mem_cache_mstat_ac_cnt_inc (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if ((mstat_p->cname_len == tmp_klen &&
@@ -1884,10 +2313,12 @@ cef_mem_cache_mstat_ac_cnt_inc (
 			memcmp (mstat_p->version, version, ver_len) == 0)) {
 			mstat_p->ver_ac_cnt++;
 			mstat_p->ac_cnt++;
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return;
 		}
 		mstat_p = mstat_p->next;
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	return;
 }
@@ -1961,6 +2392,40 @@ cef_mem_cache_mstat_print (
 }
 #endif
 #if ((defined CefC_CefnetdCache) && (defined CefC_Develop))
+/*--------------------------------------------------------------------------------------
+	Probes the entry without waiting for its shard (called with cef_mem_mstat_mutex,
+	so the shard lock must not be waited for)
+----------------------------------------------------------------------------------------*/
+static int							/* 1: cached, 0: expired, -1: not cached, 			*/
+									/* -2: the shard is busy							*/
+cef_mem_cache_entry_probe (
+	unsigned char* key,
+	uint32_t klen,
+	uint64_t nowt
+) {
+	CefMemCacheT_Content_Mem_Entry* ent_p;
+	CefT_Mem_Shard* shard;
+	uint32_t hash;
+	int rc = -1;
+
+	hash = cef_mem_hash_number_create (key, klen);
+	shard = cef_mem_cache_shard_get (hash);
+	if (pthread_mutex_trylock (&shard->mutex) != 0) {
+		return (-2);
+	}
+	ent_p = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, key, klen);
+	if (ent_p != NULL) {
+		if ((ent_p->cache_time < nowt) ||
+			((ent_p->expiry != 0) && (ent_p->expiry < nowt))) {
+			rc = 0;
+		} else {
+			rc = 1;
+		}
+	}
+	pthread_mutex_unlock (&shard->mutex);
+
+	return (rc);
+}
 /*--------------------------------------------------------------------------------------
 	Get mstat info in buffer
 ----------------------------------------------------------------------------------------*/
@@ -1980,11 +2445,21 @@ cef_mem_cache_mstat_get_buff (
 	char ver_none[] = "None";
 	char* wk = buff;
 	uint32_t entry_num = 0;
+	uint64_t nowt;
+	struct timeval tv;
 
 	/* num of entry */
 	wk += 4;
 	index += 4;
 
+	if (mem_shard_num == 0) {
+		memcpy (buff, &entry_num, 4);
+		return (index);
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
 	for (k = 0; k < Cef_Mstat_HashTbl_Size; k++) {
 		mstat_p = mstat_tbl[k];
 		while (mstat_p != NULL) {
@@ -1995,12 +2470,11 @@ cef_mem_cache_mstat_get_buff (
 			for (uint64_t m = mstat_p->min_seq; m <= mstat_p->max_seq; m++) {
 				unsigned char	key[CefMemCacheC_Key_Max];
 				int 			key_len;
-				CefMemCacheT_Content_Mem_Entry* ent_p;
 
 				key_len = cef_mem_cache_name_chunknum_concatenate (
 							mstat_p->contents_name, mstat_p->cname_len, m, key);
-				ent_p = cef_mem_cache_hash_tbl_item_get (key, key_len);
-				if (ent_p == NULL) {
+				/* A busy shard is counted as cached to keep the range */
+				if (cef_mem_cache_entry_probe (key, key_len, nowt) == -1) {
 					continue;
 				}
 				if (m < mins) {
@@ -2017,17 +2491,10 @@ cef_mem_cache_mstat_get_buff (
 			{
 				unsigned char	key[CefMemCacheC_Key_Max];
 				int 			key_len;
-				CefMemCacheT_Content_Mem_Entry* ent_p;
-				uint64_t		nowt;
-				struct timeval	tv;
 
-				gettimeofday (&tv, NULL);
-				nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 				key_len = cef_mem_cache_name_chunknum_concatenate (
 							mstat_p->contents_name, mstat_p->cname_len, mstat_p->min_seq, key);
-				ent_p = cef_mem_cache_hash_tbl_item_get (key, key_len);
-				if ((ent_p->cache_time < nowt) ||
-					((ent_p->expiry != 0) && (ent_p->expiry < nowt))) {
+				if (cef_mem_cache_entry_probe (key, key_len, nowt) == 0) {
 					/* exclude */
 					mstat_p = mstat_p->next;
 					continue;
@@ -2106,6 +2573,7 @@ cef_mem_cache_mstat_get_buff (
 			index += add_size;
 		}
 	}
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 
 	/* num of entry */
 	memcpy (buff, &entry_num, 4);
@@ -37,6 +37,7 @@
  ****************************************************************************************/
 #include <cefore/cef_mpool.h>
 #include <errno.h>
+#include <stdint.h>
 #include <pthread.h>
 
 
@@ -47,15 +48,75 @@
 #define CefC_Mp_Block_UnitBytes		16
 #define CefC_Mp_Max_Elem_Size		819200
 
+/*
+ * Every block is preceded by a header which points to the owning pool, so that
+ * cef_mpool_free finds the owner in O(1).
+ */
+#define CefC_Mp_Hdr_Size			16
+#define CefC_Mp_Hdr_Magic			((uintptr_t) 0x4365664D706F6F6CULL)
+
+/*
+ * Magazines are fixed-size stacks of free blocks. Each thread caches up to two
+ * magazines per pool, full and empty magazines are exchanged with the pool's
+ * lock-free depot.
+ */
+#define CefC_Mp_Mag_Max				64		/* max blocks in one magazine 			*/
+#define CefC_Mp_Mag_Min				4		/* min blocks in one magazine 			*/
+#define CefC_Mp_Mag_Bytes			262144	/* bytes a magazine holds at most 		*/
+#define CefC_Mp_Mag_Chunk			64		/* magazines allocated at one time 		*/
+#define CefC_Mp_Mag_Chunk_Max		16384	/* max number of magazine chunks 		*/
+
+/* Number of pools which can use the per-thread cache at the same time. The	*/
+/* other pools share one magazine pair guarded by the pool mutex.				*/
+#define CefC_Mp_Tcache_Max			64
+
+/* Depot stack head : upper 32 bits are the ABA tag, lower 32 bits are the 		*/
+/* magazine index + 1 (0 means empty). 											*/
+#define CefC_Mp_Depot_Idx(h)		((uint32_t)((h) & 0xFFFFFFFFULL))
+#define CefC_Mp_Depot_Tag(h)		((h) >> 32)
+#define CefC_Mp_Depot_Val(t, i)		((((t) + 1) << 32) | (uint64_t)(i))
+
+/*
+ * Size classes of a slab are the powers of two and 1.5 times of them, so that a
+ * block wastes less than a third of its size. The pool of a class is created when
+ * the class is used first.
+ */
+#define CefC_Mp_Slab_Min			64		/* size of the smallest class 			*/
+#define CefC_Mp_Slab_Class_Max		40		/* max number of size classes 			*/
+#define CefC_Mp_Slab_Seg_Bytes		1048576	/* bytes a class pool grows at one time	*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
-typedef struct CefT_Mp_Pool {
-	unsigned char* 			head;
-	unsigned char* 			tail;
-	unsigned char* 			blocks;
-} CefT_Mp_Pool;
+struct CefT_Mp_Mng;
+
+/*
+ * Header placed in front of each pooled memory block.
+ */
+typedef struct CefT_Mp_Hdr {
+	struct CefT_Mp_Mng*		mng;			/* pool which owns this block 				*/
+	uintptr_t				magic;			/* CefC_Mp_Hdr_Magic ^ uid of the pool 		*/
+} CefT_Mp_Hdr;
+
+/*
+ * Stack of free blocks which is moved between threads as a unit.
+ */
+typedef struct CefT_Mp_Mag {
+	uint32_t				self;			/* index of this magazine + 1 				*/
+	uint32_t				next;			/* next magazine in the depot stack 		*/
+	uint32_t				num;			/* number of blocks in this magazine 		*/
+	void*					blocks[CefC_Mp_Mag_Max];
+} CefT_Mp_Mag;
+
+/*
+ * Magazines cached by one thread for one pool.
+ */
+typedef struct CefT_Mp_Tcache {
+	uint64_t				uid;			/* uid of the pool, 0 means unused 			*/
+	CefT_Mp_Mag*			loaded;
+	CefT_Mp_Mag*			prev;
+} CefT_Mp_Tcache;
 
 /*
  * The information to manage a memory pool.
@@ -65,25 +126,60 @@ typedef struct CefT_Mp_Mng {
 	size_t					klen;
 
 	size_t					size;			/* size of one memory block 				*/
+	size_t					stride;			/* size of one block including the header 	*/
 	int						increment;		/* number of blocks to allocate at one time	*/
+	uint32_t				mag_size;		/* number of blocks in one magazine 		*/
+
+	uint64_t				uid;			/* unique id of this pool 					*/
+	int						tc_idx;			/* index of the per-thread cache, or -1 	*/
+
+	unsigned char**			segs;			/* memory segments of the pooled blocks 	*/
+	size_t 					seg_num;
+	size_t 					seg_max;
+
+	CefT_Mp_Mag**			mag_tbl;		/* chunks of magazines 						*/
+	uint32_t				mag_num;		/* number of created magazines 				*/
 
-	CefT_Mp_Pool*			pool;			/* memory pool 		 						*/
-	size_t 					pool_num;
+	uint64_t				full_depot;		/* lock-free stack of non-empty magazines 	*/
+	uint64_t				empty_depot;	/* lock-free stack of empty magazines 		*/
 
-	unsigned char**			free;
-	size_t 					head;
-	size_t 					tail;
-	size_t 					block_num;		/* number of allocated memory blocked 		*/
-	size_t 					mask;
-	
-	pthread_mutex_t 		mp_mutex_pt;	/* mutex for thread safe for Pthread 		*/
+	CefT_Mp_Tcache			shared;			/* magazines used when no per-thread cache 	*/
+											/* is available (guarded by mp_mutex_pt) 	*/
+	pthread_mutex_t 		mp_mutex_pt;	/* mutex for growing the pool 				*/
 
 } CefT_Mp_Mng;
 
+/*
+ * The information to manage a slab (a set of pools of size classes).
+ */
+typedef struct CefT_Mp_Slab {
+	char*					key;
+	size_t					max_size;		/* size of the largest class 				*/
+	int						class_num;
+	size_t					class_size[CefC_Mp_Slab_Class_Max];
+	CefT_Mp_Mng*			class_mp[CefC_Mp_Slab_Class_Max];
+	uint64_t				class_used[CefC_Mp_Slab_Class_Max];	/* blocks in use 		*/
+
+	uint64_t				req_bytes;		/* bytes requested by the users 			*/
+	uint64_t				large_num;		/* blocks over max_size (from malloc) 		*/
+	uint64_t				large_bytes;
+
+	pthread_mutex_t 		mutex;			/* mutex for creating the class pools 		*/
+} CefT_Mp_Slab;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
 
+/* Pools which own a per-thread cache slot 		*/
+static CefT_Mp_Mng* mp_registry[CefC_Mp_Tcache_Max];
+static uint64_t mp_uid_next = 1;
+static pthread_mutex_t mp_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t mp_tcache_key;
+static pthread_once_t mp_tcache_once = PTHREAD_ONCE_INIT;
+static __thread CefT_Mp_Tcache mp_tcache[CefC_Mp_Tcache_Max];
+static __thread int mp_tcache_reg_f = 0;
 
 /****************************************************************************************
  Static Function Declaration
@@ -105,6 +201,82 @@ cef_mpool_handle_destroy (
 	CefT_Mp_Mng* mpmng
 );
 
+static CefT_Mp_Mag*
+cef_mpool_mag_create (
+	CefT_Mp_Mng* mpmng
+);
+
+static CefT_Mp_Mag*
+cef_mpool_depot_pop (
+	CefT_Mp_Mng* mpmng,
+	uint64_t* depot
+);
+
+static void
+cef_mpool_depot_push (
+	CefT_Mp_Mng* mpmng,
+	uint64_t* depot,
+	CefT_Mp_Mag* mag
+);
+
+static void*
+cef_mpool_cache_alloc (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc
+);
+
+static void
+cef_mpool_cache_free (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc,
+	void* ptr
+);
+
+static void
+cef_mpool_cache_flush (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc
+);
+
+static CefT_Mp_Tcache*
+cef_mpool_tcache_get (
+	CefT_Mp_Mng* mpmng
+);
+
+static void
+cef_mpool_tcache_key_create (
+	void
+);
+
+static void
+cef_mpool_tcache_destructor (
+	void* arg
+);
+
+static int
+cef_mpool_slab_class_get (
+	CefT_Mp_Slab* slab,
+	size_t size
+);
+
+static uint64_t
+cef_mpool_trim (
+	CefT_Mp_Mng* mpmng
+);
+
+static long
+cef_mpool_seg_find (
+	CefT_Mp_Mng* mpmng,
+	void* ptr,
+	size_t seg_bytes
+);
+
+static int
+cef_mpool_seg_compare (
+	const void* a,
+	const void* b
+);
+
 /****************************************************************************************
  ****************************************************************************************/
 
@@ -144,41 +316,19 @@ cef_mpool_alloc (
 	CefT_Mp_Handle mph
 ) {
 	CefT_Mp_Mng* mpmng = (CefT_Mp_Mng*) mph;
-	size_t index;
-	int res;
-
-	while (1) {
-		res = pthread_mutex_trylock (&mpmng->mp_mutex_pt);
-		
-		if (res != 0) {
-			if (res == EBUSY) {
-				continue;
-			}
-			return (NULL);
-		}
-		break;
-	}
-
-	
-	if (mpmng->tail != mpmng->head) {
-		index = mpmng->head;
-		mpmng->head = (mpmng->head + 1) & mpmng->mask;
-		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
-		return ((void*) mpmng->free[index]);
-	}
-
-	res = cef_mpool_handle_update (mpmng);
+	CefT_Mp_Tcache* tc;
+	void* ptr;
 
-	if (res > 0) {
-		index = mpmng->head;
-		mpmng->head = (mpmng->head + 1) & mpmng->mask;
+	if (mpmng->tc_idx < 0) {
+		pthread_mutex_lock (&mpmng->mp_mutex_pt);
+		ptr = cef_mpool_cache_alloc (mpmng, &mpmng->shared);
 		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
-		return ((void*) mpmng->free[index]);
+		return (ptr);
 	}
 
-	pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+	tc = cef_mpool_tcache_get (mpmng);
 
-	return ((void*) NULL);
+	return (cef_mpool_cache_alloc (mpmng, tc));
 }
 
 void
@@ -187,32 +337,29 @@ cef_mpool_free (
 	void* ptr
 ) {
 	CefT_Mp_Mng* mpmng = (CefT_Mp_Mng*) mph;
-	int i = 0;
-	int res;
+	CefT_Mp_Hdr* hdr;
+	CefT_Mp_Tcache* tc;
 
-	while (1) {
-		res = pthread_mutex_trylock (&mpmng->mp_mutex_pt);
-		
-		if (res != 0) {
-			if (EBUSY == res) {
-				continue;
-			}
-			return;
-		}
-		break;
+	if (ptr == NULL) {
+		return;
 	}
-	
-	while (i < mpmng->pool_num) {
-		if (((unsigned char*) ptr > mpmng->pool[i].head) &&
-			((unsigned char*) ptr < mpmng->pool[i].tail)) {
-			mpmng->tail = (mpmng->tail + 1) & mpmng->mask;
-			mpmng->free[mpmng->tail] = ptr;
-			break;
-		}
-		i++;
+
+	/* Ignores the block which does not belong to this pool 	*/
+	hdr = (CefT_Mp_Hdr*)((unsigned char*) ptr - CefC_Mp_Hdr_Size);
+	if ((hdr->mng != mpmng) ||
+		(hdr->magic != (CefC_Mp_Hdr_Magic ^ (uintptr_t) mpmng->uid))) {
+		return;
 	}
 
-	pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+	if (mpmng->tc_idx < 0) {
+		pthread_mutex_lock (&mpmng->mp_mutex_pt);
+		cef_mpool_cache_free (mpmng, &mpmng->shared, ptr);
+		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		return;
+	}
+
+	tc = cef_mpool_tcache_get (mpmng);
+	cef_mpool_cache_free (mpmng, tc, ptr);
 
 	return;
 }
@@ -224,11 +371,234 @@ cef_mpool_destroy (
 	CefT_Mp_Mng* mpmng = (CefT_Mp_Mng*) mph;
 
 	if (mpmng) {
+		pthread_mutex_lock (&mp_registry_mutex);
+		if (mpmng->tc_idx >= 0) {
+			mp_registry[mpmng->tc_idx] = NULL;
+		}
+		pthread_mutex_unlock (&mp_registry_mutex);
 		pthread_mutex_destroy (&mpmng->mp_mutex_pt);
 		cef_mpool_handle_destroy (mpmng);
 	}
 }
 
+/*
+ * Creates a slab which stores variable size objects up to max_size bytes in the
+ * pools of size classes. The larger objects are allocated with malloc.
+ */
+CefT_Mp_Slab_Handle 						/* Handle to access the slab.				*/
+cef_mpool_slab_init (
+	const char* 	key, 					/* Key to identify the slab.				*/
+	size_t 			max_size				/* Size of the largest size class.			*/
+) {
+	CefT_Mp_Slab* slab;
+	size_t size;
+
+	if ((key == NULL) ||
+		(max_size < CefC_Mp_Slab_Min) || (max_size > CefC_Mp_Max_Elem_Size)) {
+		fprintf (stderr, "[error] cef_mpool_slab_init - parameter\n");
+		return ((CefT_Mp_Slab_Handle) 0);
+	}
+	slab = (CefT_Mp_Slab*) calloc (1, sizeof (CefT_Mp_Slab));
+	if (slab == NULL) {
+		fprintf (stderr, "[error] cef_mpool_slab_init - no more memory\n");
+		return ((CefT_Mp_Slab_Handle) 0);
+	}
+	slab->key = strdup (key);
+	if (slab->key == NULL) {
+		free (slab);
+		fprintf (stderr, "[error] cef_mpool_slab_init - no more memory\n");
+		return ((CefT_Mp_Slab_Handle) 0);
+	}
+	pthread_mutex_init (&slab->mutex, NULL);
+
+	/* 64, 96, 128, 192, 256, 384, ... and max_size 	*/
+	for (size = CefC_Mp_Slab_Min ; size < max_size ; ) {
+		slab->class_size[slab->class_num] = size;
+		slab->class_num++;
+		if (slab->class_num == CefC_Mp_Slab_Class_Max - 1) {
+			break;
+		}
+		if ((size & (size - 1)) == 0) {
+			size += size / 2;
+		} else {
+			size = (size / 3) * 4;
+		}
+	}
+	slab->class_size[slab->class_num] = max_size;
+	slab->class_num++;
+	slab->max_size = max_size;
+
+	return ((CefT_Mp_Slab_Handle) slab);
+}
+
+void*
+cef_mpool_slab_alloc (
+	CefT_Mp_Slab_Handle sh,
+	size_t size								/* Size of the object.						*/
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	CefT_Mp_Mng* mpmng;
+	char name[256];
+	void* ptr;
+	int idx;
+	int inc;
+
+	idx = cef_mpool_slab_class_get (slab, size);
+	if (idx < 0) {
+		ptr = malloc (size);
+		if (ptr != NULL) {
+			__atomic_add_fetch (&slab->large_num, 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch (&slab->large_bytes, size, __ATOMIC_RELAXED);
+		}
+		return (ptr);
+	}
+
+	mpmng = __atomic_load_n (&slab->class_mp[idx], __ATOMIC_ACQUIRE);
+	if (mpmng == NULL) {
+		pthread_mutex_lock (&slab->mutex);
+		mpmng = slab->class_mp[idx];
+		if (mpmng == NULL) {
+			snprintf (name, sizeof (name), "%s_%zu", slab->key, slab->class_size[idx]);
+			inc = (int)(CefC_Mp_Slab_Seg_Bytes / slab->class_size[idx]);
+			mpmng = (CefT_Mp_Mng*) cef_mpool_init (name, slab->class_size[idx], inc);
+			__atomic_store_n (&slab->class_mp[idx], mpmng, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock (&slab->mutex);
+		if (mpmng == NULL) {
+			return (NULL);
+		}
+	}
+
+	ptr = cef_mpool_alloc ((CefT_Mp_Handle) mpmng);
+	if (ptr != NULL) {
+		__atomic_add_fetch (&slab->class_used[idx], 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch (&slab->req_bytes, size, __ATOMIC_RELAXED);
+	}
+	return (ptr);
+}
+
+void
+cef_mpool_slab_free (
+	CefT_Mp_Slab_Handle sh,
+	void* ptr,
+	size_t size								/* Size passed to cef_mpool_slab_alloc.		*/
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	int idx;
+
+	if (ptr == NULL) {
+		return;
+	}
+	idx = cef_mpool_slab_class_get (slab, size);
+	if (idx < 0) {
+		free (ptr);
+		__atomic_sub_fetch (&slab->large_num, 1, __ATOMIC_RELAXED);
+		__atomic_sub_fetch (&slab->large_bytes, size, __ATOMIC_RELAXED);
+		return;
+	}
+	cef_mpool_free ((CefT_Mp_Handle) slab->class_mp[idx], ptr);
+	__atomic_sub_fetch (&slab->class_used[idx], 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch (&slab->req_bytes, size, __ATOMIC_RELAXED);
+}
+
+/*
+ * Returns the bytes which an object of the specified size occupies in the slab.
+ */
+size_t
+cef_mpool_slab_block_size (
+	CefT_Mp_Slab_Handle sh,
+	size_t size
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	int idx;
+
+	idx = cef_mpool_slab_class_get (slab, size);
+	if (idx < 0) {
+		return (size);
+	}
+	return (slab->class_size[idx]);
+}
+
+void
+cef_mpool_slab_stat_get (
+	CefT_Mp_Slab_Handle sh,
+	CefT_Mp_Slab_Stat* stat
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	CefT_Mp_Mng* mpmng;
+	uint64_t used;
+	int i;
+
+	memset (stat, 0, sizeof (CefT_Mp_Slab_Stat));
+	if (slab == NULL) {
+		return;
+	}
+	for (i = 0 ; i < slab->class_num ; i++) {
+		mpmng = __atomic_load_n (&slab->class_mp[i], __ATOMIC_ACQUIRE);
+		if (mpmng == NULL) {
+			continue;
+		}
+		used = __atomic_load_n (&slab->class_used[i], __ATOMIC_RELAXED);
+		pthread_mutex_lock (&mpmng->mp_mutex_pt);
+		stat->reserved_bytes += (uint64_t) mpmng->seg_num * mpmng->increment * mpmng->size;
+		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		stat->used_bytes += used * slab->class_size[i];
+		stat->obj_num += used;
+		stat->class_num++;
+	}
+	stat->large_num = __atomic_load_n (&slab->large_num, __ATOMIC_RELAXED);
+	stat->large_bytes = __atomic_load_n (&slab->large_bytes, __ATOMIC_RELAXED);
+	stat->req_bytes = __atomic_load_n (&slab->req_bytes, __ATOMIC_RELAXED)
+						+ stat->large_bytes;
+	stat->used_bytes += stat->large_bytes;
+	stat->obj_num += stat->large_num;
+}
+
+/*
+ * Releases the segments of the size classes whose blocks are all free. The blocks
+ * cached by the threads are not seen, so the segments holding them are kept.
+ */
+uint64_t									/* bytes released 							*/
+cef_mpool_slab_trim (
+	CefT_Mp_Slab_Handle sh
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	CefT_Mp_Mng* mpmng;
+	uint64_t released = 0;
+	int i;
+
+	if (slab == NULL) {
+		return (0);
+	}
+	for (i = 0 ; i < slab->class_num ; i++) {
+		mpmng = __atomic_load_n (&slab->class_mp[i], __ATOMIC_ACQUIRE);
+		if (mpmng != NULL) {
+			released += cef_mpool_trim (mpmng);
+		}
+	}
+	return (released);
+}
+
+void
+cef_mpool_slab_destroy (
+	CefT_Mp_Slab_Handle sh
+) {
+	CefT_Mp_Slab* slab = (CefT_Mp_Slab*) sh;
+	int i;
+
+	if (slab == NULL) {
+		return;
+	}
+	for (i = 0 ; i < slab->class_num ; i++) {
+		if (slab->class_mp[i] != NULL) {
+			cef_mpool_destroy ((CefT_Mp_Handle) slab->class_mp[i]);
+		}
+	}
+	pthread_mutex_destroy (&slab->mutex);
+	free (slab->key);
+	free (slab);
+}
+
 /*=======================================================================================
  =======================================================================================*/
 
@@ -241,10 +611,9 @@ cef_mpool_handle_create (
 											/* one time.								*/
 ) {
 	CefT_Mp_Mng* mpmng;
-	size_t i;
-	unsigned char* bp;
-
+	size_t mag_size;
 	int p;
+	int i;
 
 	increment--;
 
@@ -259,7 +628,8 @@ cef_mpool_handle_create (
 		return (NULL);
 	}
 	memset (mpmng, 0, sizeof (CefT_Mp_Mng));
-
+	mpmng->tc_idx = -1;
+	pthread_mutex_init (&mpmng->mp_mutex_pt, NULL);
 
 	if (key != NULL) {
 		mpmng->klen = (size_t) strlen (key);
@@ -275,6 +645,7 @@ cef_mpool_handle_create (
 	mpmng->size
 		= ((size + CefC_Mp_Block_UnitBytes - 1) / CefC_Mp_Block_UnitBytes)
 			* CefC_Mp_Block_UnitBytes;
+	mpmng->stride = CefC_Mp_Hdr_Size + mpmng->size;
 
 	/* record the number of blocks to allocate at one time 		*/
 	mpmng->increment = increment;
@@ -282,141 +653,565 @@ cef_mpool_handle_create (
 		mpmng->increment = CefC_Mp_Block_Min;
 	}
 
-	/* allocate the memory pool 	*/
-	mpmng->pool_num = 1;
-	mpmng->pool = (CefT_Mp_Pool*) calloc (mpmng->pool_num, sizeof (CefT_Mp_Pool));
-
-	if (mpmng->pool == NULL) {
-		cef_mpool_handle_destroy (mpmng);
-		return (NULL);
+	/* large blocks use small magazines not to keep much memory per thread 	*/
+	mag_size = CefC_Mp_Mag_Bytes / mpmng->size;
+	if (mag_size > CefC_Mp_Mag_Max) {
+		mag_size = CefC_Mp_Mag_Max;
 	}
-	memset (mpmng->pool, 0, sizeof (CefT_Mp_Pool) * mpmng->pool_num);
+	if (mag_size < CefC_Mp_Mag_Min) {
+		mag_size = CefC_Mp_Mag_Min;
+	}
+	mpmng->mag_size = (uint32_t) mag_size;
 
-	mpmng->pool[0].blocks
-		= (unsigned char*) calloc (mpmng->increment, mpmng->size);
-	if (mpmng->pool[0].blocks == NULL) {
+	mpmng->mag_tbl
+		= (CefT_Mp_Mag**) calloc (CefC_Mp_Mag_Chunk_Max, sizeof (CefT_Mp_Mag*));
+	if (mpmng->mag_tbl == NULL) {
 		cef_mpool_handle_destroy (mpmng);
 		return (NULL);
 	}
-	memset (mpmng->pool[0].blocks, 0, mpmng->increment * mpmng->size);
 
-	mpmng->pool[0].head = mpmng->pool[0].blocks - 1;
-	mpmng->pool[0].tail
-		= mpmng->pool[0].blocks + mpmng->increment * (mpmng->size - 1) + 1;
+	pthread_mutex_lock (&mp_registry_mutex);
+	mpmng->uid = mp_uid_next++;
+	pthread_mutex_unlock (&mp_registry_mutex);
 
-	/* prepare management information 	*/
-	mpmng->block_num = mpmng->increment;
-	mpmng->mask = mpmng->block_num - 1;
-	mpmng->free
-		= (unsigned char**) malloc (sizeof (unsigned char*) * mpmng->block_num);
-	if (mpmng->free == NULL) {
+	/* allocate the first memory segment 	*/
+	if (cef_mpool_handle_update (mpmng) < 0) {
 		cef_mpool_handle_destroy (mpmng);
 		return (NULL);
 	}
-	mpmng->head = 0;
-	mpmng->tail = mpmng->block_num - 1;
-
-	bp = mpmng->pool[0].blocks;
 
-	for (i = 0 ; i < mpmng->block_num ; i++) {
-		mpmng->free[i] = bp;
-		bp += mpmng->size;
+	/* assign a per-thread cache slot 	*/
+	pthread_mutex_lock (&mp_registry_mutex);
+	for (i = 0 ; i < CefC_Mp_Tcache_Max ; i++) {
+		if (mp_registry[i] == NULL) {
+			mp_registry[i] = mpmng;
+			mpmng->tc_idx = i;
+			break;
+		}
 	}
-	pthread_mutex_init (&mpmng->mp_mutex_pt, NULL);
+	pthread_mutex_unlock (&mp_registry_mutex);
 
 	return (mpmng);
 }
 
+/*--------------------------------------------------------------------------------------
+	Adds one memory segment of increment blocks and pushes them to the depot.
+	Called with mp_mutex_pt held (or before the pool is published).
+----------------------------------------------------------------------------------------*/
 static int
 cef_mpool_handle_update (
 	CefT_Mp_Mng* mpmng
 ) {
-	CefT_Mp_Pool* new_pool;
-	unsigned char** new_free;
-	size_t new_block_num;
+	unsigned char** new_segs;
+	unsigned char* seg;
+	CefT_Mp_Hdr* hdr;
+	CefT_Mp_Mag* mag = NULL;
 	size_t i;
-	unsigned char* bp;
 
-	/* allocate the memory pool 	*/
-	new_pool = (CefT_Mp_Pool*) calloc (mpmng->pool_num + 1, sizeof (CefT_Mp_Pool));
-	if (new_pool == NULL) {
+	if (mpmng->seg_num == mpmng->seg_max) {
+		new_segs = (unsigned char**) realloc (mpmng->segs,
+			sizeof (unsigned char*) * (mpmng->seg_max + CefC_Mp_Block_Min));
+		if (new_segs == NULL) {
+			return (-1);
+		}
+		mpmng->segs = new_segs;
+		mpmng->seg_max += CefC_Mp_Block_Min;
+	}
+
+	seg = (unsigned char*) calloc (mpmng->increment, mpmng->stride);
+	if (seg == NULL) {
 		return (-1);
 	}
-	memset (new_pool, 0, sizeof (CefT_Mp_Pool) * (mpmng->pool_num + 1));
+	mpmng->segs[mpmng->seg_num] = seg;
+	mpmng->seg_num++;
+
+	for (i = 0 ; i < (size_t) mpmng->increment ; i++) {
+		hdr = (CefT_Mp_Hdr*)(seg + i * mpmng->stride);
+		hdr->mng 	= mpmng;
+		hdr->magic 	= CefC_Mp_Hdr_Magic ^ (uintptr_t) mpmng->uid;
+
+		if (mag == NULL) {
+			mag = cef_mpool_depot_pop (mpmng, &mpmng->empty_depot);
+			if (mag == NULL) {
+				mag = cef_mpool_mag_create (mpmng);
+				if (mag == NULL) {
+					/* blocks which are not in any magazine are never used 	*/
+					break;
+				}
+			}
+		}
+		mag->blocks[mag->num] = (unsigned char*) hdr + CefC_Mp_Hdr_Size;
+		mag->num++;
 
-	for (i = 0 ; i < mpmng->pool_num ; i++) {
-		new_pool[i].blocks 	= mpmng->pool[i].blocks;
-		new_pool[i].head 	= mpmng->pool[i].head;
-		new_pool[i].tail 	= mpmng->pool[i].tail;
+		if (mag->num == mpmng->mag_size) {
+			cef_mpool_depot_push (mpmng, &mpmng->full_depot, mag);
+			mag = NULL;
+		}
+	}
+	if (mag) {
+		if (mag->num > 0) {
+			cef_mpool_depot_push (mpmng, &mpmng->full_depot, mag);
+		} else {
+			cef_mpool_depot_push (mpmng, &mpmng->empty_depot, mag);
+		}
 	}
-	new_pool[i].blocks = (unsigned char*) calloc (mpmng->increment, mpmng->size);
-	if (new_pool[i].blocks == NULL) {
-		free (new_pool);
+	if (i == 0) {
 		return (-1);
 	}
-	memset (new_pool[i].blocks, 0, mpmng->increment * mpmng->size);
 
-	new_pool[i].head = new_pool[i].blocks - 1;
-	new_pool[i].tail = new_pool[i].blocks + mpmng->increment * (mpmng->size - 1) + 1;
+	return (1);
+}
 
+static void
+cef_mpool_handle_destroy (
+	CefT_Mp_Mng* mpmng
+) {
+	size_t i;
 
-	free (mpmng->pool);
-	mpmng->pool = new_pool;
-	mpmng->pool_num++;
+	if (mpmng == NULL) {
+		return;
+	}
 
-	/* prepare management information 	*/
-	new_block_num = mpmng->block_num + mpmng->increment;
-	new_free = (unsigned char**) malloc (sizeof (unsigned char*) * new_block_num);
-	if (new_free == NULL) {
-		mpmng->pool_num--;
-		return (-1);
+	if (mpmng->segs) {
+		for (i = 0 ; i < mpmng->seg_num ; i++) {
+			free (mpmng->segs[i]);
+		}
+		free (mpmng->segs);
 	}
 
-	bp = mpmng->pool[i].blocks;
-	for (i = mpmng->block_num ; i < new_block_num ; i++) {
-		new_free[i] = bp;
-		bp += mpmng->size;
+	if (mpmng->mag_tbl) {
+		for (i = 0 ; i < CefC_Mp_Mag_Chunk_Max ; i++) {
+			if (mpmng->mag_tbl[i] == NULL) {
+				break;
+			}
+			free (mpmng->mag_tbl[i]);
+		}
+		free (mpmng->mag_tbl);
 	}
-	for (i = 0 ; i < mpmng->block_num ; i++) {
-		new_free[i] = mpmng->free[i];
+
+	if (mpmng->key) {
+		free (mpmng->key);
 	}
-	free (mpmng->free);
-	mpmng->free = new_free;
 
-	mpmng->head = mpmng->block_num;
-	mpmng->block_num = new_block_num;
-	mpmng->mask = mpmng->block_num - 1;
-	mpmng->tail = mpmng->block_num - 1;
+	free (mpmng);
 
-	return (1);
+	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Creates an empty magazine. Called with mp_mutex_pt held.
+	Magazines live in fixed chunks until the pool is destroyed, so the depot can
+	refer to them by index and a racing pop never touches freed memory.
+----------------------------------------------------------------------------------------*/
+static CefT_Mp_Mag*
+cef_mpool_mag_create (
+	CefT_Mp_Mng* mpmng
+) {
+	CefT_Mp_Mag* chunk;
+	CefT_Mp_Mag* mag;
+	uint32_t idx = mpmng->mag_num;
+	uint32_t c = idx / CefC_Mp_Mag_Chunk;
+
+	if (c >= CefC_Mp_Mag_Chunk_Max) {
+		return (NULL);
+	}
+	if (mpmng->mag_tbl[c] == NULL) {
+		chunk = (CefT_Mp_Mag*) calloc (CefC_Mp_Mag_Chunk, sizeof (CefT_Mp_Mag));
+		if (chunk == NULL) {
+			return (NULL);
+		}
+		__atomic_store_n (&mpmng->mag_tbl[c], chunk, __ATOMIC_RELEASE);
+	}
+	mag = &mpmng->mag_tbl[c][idx % CefC_Mp_Mag_Chunk];
+	mag->self 	= idx + 1;
+	mag->next 	= 0;
+	mag->num 	= 0;
+	mpmng->mag_num++;
+
+	return (mag);
+}
+
+/*--------------------------------------------------------------------------------------
+	Pops a magazine from the lock-free depot stack
+----------------------------------------------------------------------------------------*/
+static CefT_Mp_Mag*
+cef_mpool_depot_pop (
+	CefT_Mp_Mng* mpmng,
+	uint64_t* depot
+) {
+	uint64_t head;
+	uint64_t next;
+	uint32_t idx;
+	CefT_Mp_Mag* mag;
+
+	head = __atomic_load_n (depot, __ATOMIC_ACQUIRE);
+	while (1) {
+		idx = CefC_Mp_Depot_Idx (head);
+		if (idx == 0) {
+			return (NULL);
+		}
+		idx--;
+		mag = &mpmng->mag_tbl[idx / CefC_Mp_Mag_Chunk][idx % CefC_Mp_Mag_Chunk];
+		next = CefC_Mp_Depot_Val (
+			CefC_Mp_Depot_Tag (head), __atomic_load_n (&mag->next, __ATOMIC_RELAXED));
+		if (__atomic_compare_exchange_n (depot, &head, next, 1,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return (mag);
+		}
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Pushes a magazine to the lock-free depot stack
+----------------------------------------------------------------------------------------*/
 static void
-cef_mpool_handle_destroy (
+cef_mpool_depot_push (
+	CefT_Mp_Mng* mpmng,
+	uint64_t* depot,
+	CefT_Mp_Mag* mag
+) {
+	uint64_t head;
+	uint64_t next;
+
+	head = __atomic_load_n (depot, __ATOMIC_RELAXED);
+	do {
+		__atomic_store_n (&mag->next, CefC_Mp_Depot_Idx (head), __ATOMIC_RELAXED);
+		next = CefC_Mp_Depot_Val (CefC_Mp_Depot_Tag (head), mag->self);
+	} while (!__atomic_compare_exchange_n (depot, &head, next, 1,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*--------------------------------------------------------------------------------------
+	Allocates one block from the magazines of the specified cache
+----------------------------------------------------------------------------------------*/
+static void*
+cef_mpool_cache_alloc (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc
+) {
+	CefT_Mp_Mag* mag;
+	CefT_Mp_Mag* work;
+
+	if (tc->loaded && tc->loaded->num > 0) {
+		tc->loaded->num--;
+		return (tc->loaded->blocks[tc->loaded->num]);
+	}
+	if (tc->prev && tc->prev->num > 0) {
+		work 		= tc->loaded;
+		tc->loaded 	= tc->prev;
+		tc->prev 	= work;
+		tc->loaded->num--;
+		return (tc->loaded->blocks[tc->loaded->num]);
+	}
+
+	/* Both magazines are empty, exchanges one for a full one 	*/
+	mag = cef_mpool_depot_pop (mpmng, &mpmng->full_depot);
+	while (mag == NULL) {
+		if (tc != &mpmng->shared) {
+			pthread_mutex_lock (&mpmng->mp_mutex_pt);
+		}
+		/* Another thread may have grown the pool while waiting 	*/
+		mag = cef_mpool_depot_pop (mpmng, &mpmng->full_depot);
+		if ((mag == NULL) && (cef_mpool_handle_update (mpmng) < 0)) {
+			if (tc != &mpmng->shared) {
+				pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+			}
+			return (NULL);
+		}
+		if (tc != &mpmng->shared) {
+			pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		}
+		if (mag == NULL) {
+			mag = cef_mpool_depot_pop (mpmng, &mpmng->full_depot);
+		}
+	}
+	if (tc->prev) {
+		cef_mpool_depot_push (mpmng, &mpmng->empty_depot, tc->prev);
+	}
+	tc->prev 	= tc->loaded;
+	tc->loaded 	= mag;
+	tc->loaded->num--;
+
+	return (tc->loaded->blocks[tc->loaded->num]);
+}
+
+/*--------------------------------------------------------------------------------------
+	Returns one block to the magazines of the specified cache
+----------------------------------------------------------------------------------------*/
+static void
+cef_mpool_cache_free (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc,
+	void* ptr
+) {
+	CefT_Mp_Mag* mag;
+	CefT_Mp_Mag* work;
+
+	if (tc->loaded && tc->loaded->num < mpmng->mag_size) {
+		tc->loaded->blocks[tc->loaded->num] = ptr;
+		tc->loaded->num++;
+		return;
+	}
+	if (tc->prev && tc->prev->num < mpmng->mag_size) {
+		work 		= tc->loaded;
+		tc->loaded 	= tc->prev;
+		tc->prev 	= work;
+		tc->loaded->blocks[tc->loaded->num] = ptr;
+		tc->loaded->num++;
+		return;
+	}
+
+	/* Both magazines are full, exchanges one for an empty one 	*/
+	mag = cef_mpool_depot_pop (mpmng, &mpmng->empty_depot);
+	if (mag == NULL) {
+		if (tc != &mpmng->shared) {
+			pthread_mutex_lock (&mpmng->mp_mutex_pt);
+		}
+		mag = cef_mpool_mag_create (mpmng);
+		if (tc != &mpmng->shared) {
+			pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		}
+		if (mag == NULL) {
+			/* The block is lost for this pool until it is destroyed 	*/
+			return;
+		}
+	}
+	if (tc->prev) {
+		cef_mpool_depot_push (mpmng, &mpmng->full_depot, tc->prev);
+	}
+	tc->prev 	= tc->loaded;
+	tc->loaded 	= mag;
+	tc->loaded->blocks[0] = ptr;
+	tc->loaded->num = 1;
+
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Returns the magazines of the specified cache to the depot
+----------------------------------------------------------------------------------------*/
+static void
+cef_mpool_cache_flush (
+	CefT_Mp_Mng* mpmng,
+	CefT_Mp_Tcache* tc
+) {
+	if (tc->loaded) {
+		cef_mpool_depot_push (mpmng,
+			(tc->loaded->num > 0) ? &mpmng->full_depot : &mpmng->empty_depot,
+			tc->loaded);
+		tc->loaded = NULL;
+	}
+	if (tc->prev) {
+		cef_mpool_depot_push (mpmng,
+			(tc->prev->num > 0) ? &mpmng->full_depot : &mpmng->empty_depot,
+			tc->prev);
+		tc->prev = NULL;
+	}
+	tc->uid = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the cache of the calling thread for the specified pool
+----------------------------------------------------------------------------------------*/
+static CefT_Mp_Tcache*
+cef_mpool_tcache_get (
 	CefT_Mp_Mng* mpmng
 ) {
+	CefT_Mp_Tcache* tc = &mp_tcache[mpmng->tc_idx];
+
+	if (tc->uid != mpmng->uid) {
+		/* The slot was used by a destroyed pool, its magazines are gone 	*/
+		tc->uid 	= mpmng->uid;
+		tc->loaded 	= NULL;
+		tc->prev 	= NULL;
+		if (mp_tcache_reg_f == 0) {
+			pthread_once (&mp_tcache_once, cef_mpool_tcache_key_create);
+			pthread_setspecific (mp_tcache_key, mp_tcache);
+			mp_tcache_reg_f = 1;
+		}
+	}
+	return (tc);
+}
+
+static void
+cef_mpool_tcache_key_create (
+	void
+) {
+	pthread_key_create (&mp_tcache_key, cef_mpool_tcache_destructor);
+}
+
+/*--------------------------------------------------------------------------------------
+	Returns the magazines of the exiting thread to the pools which are still alive
+----------------------------------------------------------------------------------------*/
+static void
+cef_mpool_tcache_destructor (
+	void* arg
+) {
+	CefT_Mp_Tcache* tcache = (CefT_Mp_Tcache*) arg;
 	int i;
 
-	if (mpmng == NULL) {
-		return;
+	pthread_mutex_lock (&mp_registry_mutex);
+	for (i = 0 ; i < CefC_Mp_Tcache_Max ; i++) {
+		if ((tcache[i].uid != 0) && (mp_registry[i] != NULL) &&
+			(mp_registry[i]->uid == tcache[i].uid)) {
+			cef_mpool_cache_flush (mp_registry[i], &tcache[i]);
+		}
 	}
+	pthread_mutex_unlock (&mp_registry_mutex);
+}
 
-	if (mpmng->pool) {
-		for (i = 0 ; i < mpmng->pool_num ; i++) {
-			free (mpmng->pool[i].blocks);
+/*--------------------------------------------------------------------------------------
+	Frees the segments whose blocks are all in the depot. The full magazines are taken
+	from the depot while the segments are counted, so no block of them is handed out;
+	the threads which find the depot empty wait for mp_mutex_pt.
+----------------------------------------------------------------------------------------*/
+static uint64_t
+cef_mpool_trim (
+	CefT_Mp_Mng* mpmng
+) {
+	CefT_Mp_Mag** mags;
+	CefT_Mp_Mag* mag;
+	uint32_t* free_num;
+	size_t seg_bytes;
+	size_t i, n;
+	long idx;
+	uint32_t k, m;
+	uint32_t mag_num = 0;
+	uint64_t released = 0;
+
+	pthread_mutex_lock (&mpmng->mp_mutex_pt);
+	if (mpmng->seg_num == 0) {
+		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		return (0);
+	}
+	mags = (CefT_Mp_Mag**) malloc (sizeof (CefT_Mp_Mag*) * mpmng->mag_num);
+	free_num = (uint32_t*) calloc (mpmng->seg_num, sizeof (uint32_t));
+	if ((mags == NULL) || (free_num == NULL)) {
+		pthread_mutex_unlock (&mpmng->mp_mutex_pt);
+		free (mags);
+		free (free_num);
+		return (0);
+	}
+	while ((mag = cef_mpool_depot_pop (mpmng, &mpmng->full_depot)) != NULL) {
+		mags[mag_num] = mag;
+		mag_num++;
+	}
+
+	/* Counts the free blocks of each segment 	*/
+	qsort (mpmng->segs, mpmng->seg_num, sizeof (unsigned char*), cef_mpool_seg_compare);
+	seg_bytes = (size_t) mpmng->increment * mpmng->stride;
+	for (k = 0 ; k < mag_num ; k++) {
+		for (m = 0 ; m < mags[k]->num ; m++) {
+			idx = cef_mpool_seg_find (mpmng, mags[k]->blocks[m], seg_bytes);
+			if (idx >= 0) {
+				free_num[idx]++;
+			}
 		}
-		free (mpmng->pool);
 	}
 
-	if (mpmng->key) {
-		free (mpmng->key);
+	/* Drops the blocks of the free segments from the magazines 	*/
+	for (i = 0, n = 0 ; i < mpmng->seg_num ; i++) {
+		if (free_num[i] == (uint32_t) mpmng->increment) {
+			n++;
+		}
+	}
+	if (n > 0) {
+		for (k = 0 ; k < mag_num ; k++) {
+			mag = mags[k];
+			for (m = 0, n = 0 ; m < mag->num ; m++) {
+				idx = cef_mpool_seg_find (mpmng, mag->blocks[m], seg_bytes);
+				if ((idx >= 0) && (free_num[idx] == (uint32_t) mpmng->increment)) {
+					continue;
+				}
+				mag->blocks[n] = mag->blocks[m];
+				n++;
+			}
+			mag->num = (uint32_t) n;
+		}
+		for (i = 0, n = 0 ; i < mpmng->seg_num ; i++) {
+			if (free_num[i] == (uint32_t) mpmng->increment) {
+				free (mpmng->segs[i]);
+				released += seg_bytes;
+				continue;
+			}
+			mpmng->segs[n] = mpmng->segs[i];
+			n++;
+		}
+		mpmng->seg_num = n;
 	}
+	for (k = 0 ; k < mag_num ; k++) {
+		cef_mpool_depot_push (mpmng,
+			(mags[k]->num > 0) ? &mpmng->full_depot : &mpmng->empty_depot, mags[k]);
+	}
+	pthread_mutex_unlock (&mpmng->mp_mutex_pt);
 
-	if (mpmng->free) {
-		free (mpmng->free);
+	free (mags);
+	free (free_num);
+
+	return (released);
+}
+
+/*--------------------------------------------------------------------------------------
+	Returns the index of the segment (sorted by address) holding the block, or -1
+----------------------------------------------------------------------------------------*/
+static long
+cef_mpool_seg_find (
+	CefT_Mp_Mng* mpmng,
+	void* ptr,
+	size_t seg_bytes
+) {
+	unsigned char* blk = (unsigned char*) ptr;
+	size_t lo = 0;
+	size_t hi = mpmng->seg_num;
+	size_t mid;
+
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (mpmng->segs[mid] <= blk) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
 	}
+	if ((mpmng->segs[lo] <= blk) && (blk < mpmng->segs[lo] + seg_bytes)) {
+		return ((long) lo);
+	}
+	return (-1);
+}
 
-	free (mpmng);
+static int
+cef_mpool_seg_compare (
+	const void* a,
+	const void* b
+) {
+	const unsigned char* sa = *(unsigned char* const*) a;
+	const unsigned char* sb = *(unsigned char* const*) b;
 
-	return;
+	return ((sa > sb) - (sa < sb));
+}
+
+/*--------------------------------------------------------------------------------------
+	Returns the index of the smallest class which holds size bytes, or -1 if none
+----------------------------------------------------------------------------------------*/
+static int
+cef_mpool_slab_class_get (
+	CefT_Mp_Slab* slab,
+	size_t size
+) {
+	int lo = 0;
+	int hi = slab->class_num - 1;
+	int mid;
+
+	if (size > slab->max_size) {
+		return (-1);
+	}
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (slab->class_size[mid] < size) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return (lo);
 }
@@ -36,6 +36,8 @@
  Include Files
  ****************************************************************************************/
 
+#include <string.h>
+
 #include <cefore/cef_rngque.h>
 
 /****************************************************************************************
@@ -45,6 +47,9 @@
 #define cef_mpool_mutex_lock		pthread_mutex_lock
 #define cef_mpool_mutex_unlock		pthread_mutex_unlock
 
+#define cef_rngque_load_acq(p)		__atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define cef_rngque_store_rel(p, v)	__atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -58,6 +63,42 @@
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
+static int
+cef_rngque_spsc_push (
+	CefT_Rngque* qp,
+	void** items,
+	int num
+);
+static int
+cef_rngque_spsc_pop (
+	CefT_Rngque* qp,
+	void** items,
+	int num,
+	int remove_f
+);
+static int
+cef_rngque_mpsc_push (
+	CefT_Rngque* qp,
+	void** items,
+	int num
+);
+static int
+cef_rngque_mpsc_pop (
+	CefT_Rngque* qp,
+	void** items,
+	int num,
+	int remove_f
+);
+static void
+cef_expque_sift_up (
+	CefT_Expque* eq,
+	unsigned int pos
+);
+static void
+cef_expque_sift_down (
+	CefT_Expque* eq,
+	unsigned int pos
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -68,10 +109,28 @@
 CefT_Rngque* 								/* Created Ring Queue Information 			*/
 cef_rngque_create (
 	int capacity							/* Capacity of Ring queue 					*/
+) {
+	return (cef_rngque_create_ext (capacity, CefC_Rngque_Type_Mutex));
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates Ring Queue of the specified type
+----------------------------------------------------------------------------------------*/
+CefT_Rngque* 								/* Created Ring Queue Information 			*/
+cef_rngque_create_ext (
+	int capacity,							/* Capacity of Ring queue 					*/
+	int type								/* CefC_Rngque_Type_XXX 					*/
 ) {
 	int p;
+	unsigned int i;
 	CefT_Rngque* qp;
 
+	if ((type != CefC_Rngque_Type_Mutex) &&
+		(type != CefC_Rngque_Type_Spsc) &&
+		(type != CefC_Rngque_Type_Mpsc)) {
+		return (NULL);
+	}
+
 	/* Obtains the capacity of index queue 		*/
 	if (capacity < 32) {
 		capacity = 32;
@@ -88,11 +147,24 @@ cef_rngque_create (
 
 	/* Allocates the index queue 			*/
 	qp = (CefT_Rngque*) malloc (sizeof (CefT_Rngque));
+	if (qp == NULL) {
+		return (NULL);
+	}
+	memset (qp, 0, sizeof (CefT_Rngque));
+	qp->type = type;
 	qp->top = 0;
 	qp->bottom = 0;
 	qp->mask = capacity - 1;
 	qp->que = (CefT_Rngque_Elem*) malloc (sizeof (CefT_Rngque_Elem) * capacity);
-	
+	if (qp->que == NULL) {
+		free (qp);
+		return (NULL);
+	}
+	for (i = 0 ; i < (unsigned int) capacity ; i++) {
+		qp->que[i].body = NULL;
+		qp->que[i].seq  = i;
+	}
+
 	pthread_mutex_init (&qp->mutex, NULL);
 
 	return (qp);
@@ -118,16 +190,33 @@ cef_rngque_pop (
 	CefT_Rngque* qp							/* Ring Queue Information 					*/
 ) {
 	int value;
+	void* item = NULL;
+
+	switch (qp->type) {
+		case CefC_Rngque_Type_Spsc: {
+			cef_rngque_spsc_pop (qp, &item, 1, 1);
+			return (item);
+		}
+		case CefC_Rngque_Type_Mpsc: {
+			cef_rngque_mpsc_pop (qp, &item, 1, 1);
+			return (item);
+		}
+		default: {
+			break;
+		}
+	}
 
 	if (qp->bottom != qp->top) {
 		cef_mpool_mutex_lock (&qp->mutex);
-		value = qp->top;
-		qp->top = (qp->top + 1) & qp->mask;
+		if (qp->bottom != qp->top) {
+			value = qp->top;
+			qp->top = (qp->top + 1) & qp->mask;
+			item = qp->que[value].body;
+		}
 		cef_mpool_mutex_unlock (&qp->mutex);
-		return (qp->que[value].body);
 	}
 
-	return (NULL);
+	return (item);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -138,16 +227,31 @@ cef_rngque_push (
 	CefT_Rngque* qp, 						/* Ring Queue Information 					*/
 	void* item
 ) {
+	int res = 0;
+
+	switch (qp->type) {
+		case CefC_Rngque_Type_Spsc: {
+			return (cef_rngque_spsc_push (qp, &item, 1));
+		}
+		case CefC_Rngque_Type_Mpsc: {
+			return (cef_rngque_mpsc_push (qp, &item, 1));
+		}
+		default: {
+			break;
+		}
+	}
 
 	if (((qp->bottom + 1) & qp->mask) != qp->top) {
 		cef_mpool_mutex_lock (&qp->mutex);
-		qp->que[qp->bottom].body = item;
-		qp->bottom = (qp->bottom + 1) & qp->mask;
+		if (((qp->bottom + 1) & qp->mask) != qp->top) {
+			qp->que[qp->bottom].body = item;
+			qp->bottom = (qp->bottom + 1) & qp->mask;
+			res = 1;
+		}
 		cef_mpool_mutex_unlock (&qp->mutex);
-		return (1);
 	}
 
-	return (0);
+	return (res);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -158,6 +262,21 @@ cef_rngque_read (
 	CefT_Rngque* qp							/* Ring Queue Information 					*/
 ) {
 	int value;
+	void* item = NULL;
+
+	switch (qp->type) {
+		case CefC_Rngque_Type_Spsc: {
+			cef_rngque_spsc_pop (qp, &item, 1, 0);
+			return (item);
+		}
+		case CefC_Rngque_Type_Mpsc: {
+			cef_rngque_mpsc_pop (qp, &item, 1, 0);
+			return (item);
+		}
+		default: {
+			break;
+		}
+	}
 
 	if (qp->bottom != qp->top) {
 		cef_mpool_mutex_lock (&qp->mutex);
@@ -168,3 +287,410 @@ cef_rngque_read (
 
 	return (NULL);
 }
+
+/*--------------------------------------------------------------------------------------
+	Inserts the items to the bottom of Ring Queue
+----------------------------------------------------------------------------------------*/
+int 										/* number of inserted items 				*/
+cef_rngque_push_batch (
+	CefT_Rngque* qp, 						/* Ring Queue Information 					*/
+	void** items,
+	int num
+) {
+	int i;
+
+	if (num < 1) {
+		return (0);
+	}
+	switch (qp->type) {
+		case CefC_Rngque_Type_Spsc: {
+			return (cef_rngque_spsc_push (qp, items, num));
+		}
+		case CefC_Rngque_Type_Mpsc: {
+			return (cef_rngque_mpsc_push (qp, items, num));
+		}
+		default: {
+			break;
+		}
+	}
+
+	cef_mpool_mutex_lock (&qp->mutex);
+	for (i = 0 ; i < num ; i++) {
+		if (((qp->bottom + 1) & qp->mask) == qp->top) {
+			break;
+		}
+		qp->que[qp->bottom].body = items[i];
+		qp->bottom = (qp->bottom + 1) & qp->mask;
+	}
+	cef_mpool_mutex_unlock (&qp->mutex);
+
+	return (i);
+}
+
+/*--------------------------------------------------------------------------------------
+	Removes the items from the top of Ring Queue
+----------------------------------------------------------------------------------------*/
+int 										/* number of removed items 					*/
+cef_rngque_pop_batch (
+	CefT_Rngque* qp, 						/* Ring Queue Information 					*/
+	void** items,
+	int num
+) {
+	int i;
+
+	if (num < 1) {
+		return (0);
+	}
+	switch (qp->type) {
+		case CefC_Rngque_Type_Spsc: {
+			return (cef_rngque_spsc_pop (qp, items, num, 1));
+		}
+		case CefC_Rngque_Type_Mpsc: {
+			return (cef_rngque_mpsc_pop (qp, items, num, 1));
+		}
+		default: {
+			break;
+		}
+	}
+
+	cef_mpool_mutex_lock (&qp->mutex);
+	for (i = 0 ; i < num ; i++) {
+		if (qp->bottom == qp->top) {
+			break;
+		}
+		items[i] = qp->que[qp->top].body;
+		qp->top = (qp->top + 1) & qp->mask;
+	}
+	cef_mpool_mutex_unlock (&qp->mutex);
+
+	return (i);
+}
+
+/*--------------------------------------------------------------------------------------
+	Inserts the items to the SPSC ring.
+	top and bottom run freely and are masked on access, so all mask + 1 slots are
+	usable. Each side caches the index of the other side and reloads it only when
+	the ring looks full (or empty), which keeps the two cache lines apart.
+----------------------------------------------------------------------------------------*/
+static int
+cef_rngque_spsc_push (
+	CefT_Rngque* qp,
+	void** items,
+	int num
+) {
+	unsigned int bottom = qp->bottom;
+	unsigned int cap = qp->mask + 1;
+	unsigned int room;
+	int i;
+
+	room = cap - (bottom - qp->top_cache);
+	if (room < (unsigned int) num) {
+		qp->top_cache = cef_rngque_load_acq (&qp->top);
+		room = cap - (bottom - qp->top_cache);
+	}
+	if (room < (unsigned int) num) {
+		num = (int) room;
+	}
+	for (i = 0 ; i < num ; i++) {
+		qp->que[(bottom + i) & qp->mask].body = items[i];
+	}
+	if (num > 0) {
+		cef_rngque_store_rel (&qp->bottom, bottom + num);
+	}
+
+	return (num);
+}
+
+/*--------------------------------------------------------------------------------------
+	Removes (or reads if remove_f is 0) the items from the SPSC ring
+----------------------------------------------------------------------------------------*/
+static int
+cef_rngque_spsc_pop (
+	CefT_Rngque* qp,
+	void** items,
+	int num,
+	int remove_f
+) {
+	unsigned int top = qp->top;
+	unsigned int avail;
+	int i;
+
+	avail = qp->bottom_cache - top;
+	if (avail < (unsigned int) num) {
+		qp->bottom_cache = cef_rngque_load_acq (&qp->bottom);
+		avail = qp->bottom_cache - top;
+	}
+	if (avail < (unsigned int) num) {
+		num = (int) avail;
+	}
+	for (i = 0 ; i < num ; i++) {
+		items[i] = qp->que[(top + i) & qp->mask].body;
+	}
+	if ((num > 0) && (remove_f)) {
+		cef_rngque_store_rel (&qp->top, top + num);
+	}
+
+	return (num);
+}
+
+/*--------------------------------------------------------------------------------------
+	Inserts the items to the MPSC ring.
+	Producers claim consecutive slots by CAS on bottom, then publish each slot by
+	setting its seq to the position + 1. The consumer gives a slot back by setting
+	seq to the position + capacity before advancing top.
+----------------------------------------------------------------------------------------*/
+static int
+cef_rngque_mpsc_push (
+	CefT_Rngque* qp,
+	void** items,
+	int num
+) {
+	unsigned int bottom;
+	unsigned int cap = qp->mask + 1;
+	unsigned int room;
+	CefT_Rngque_Elem* elem;
+	int i;
+
+	bottom = __atomic_load_n (&qp->bottom, __ATOMIC_RELAXED);
+	do {
+		room = cap - (bottom - cef_rngque_load_acq (&qp->top));
+		if (room > cap) {
+			/* bottom was advanced by others after it was loaded 	*/
+			bottom = __atomic_load_n (&qp->bottom, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (room == 0) {
+			return (0);
+		}
+		if (room < (unsigned int) num) {
+			num = (int) room;
+		}
+	} while (!__atomic_compare_exchange_n (&qp->bottom, &bottom,
+				bottom + num, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	for (i = 0 ; i < num ; i++) {
+		elem = &qp->que[(bottom + i) & qp->mask];
+		/* The consumer may not have given this slot back yet 	*/
+		while (cef_rngque_load_acq (&elem->seq) != bottom + i) {
+			;
+		}
+		elem->body = items[i];
+		cef_rngque_store_rel (&elem->seq, bottom + i + 1);
+	}
+
+	return (num);
+}
+
+/*--------------------------------------------------------------------------------------
+	Removes (or reads if remove_f is 0) the items from the MPSC ring
+----------------------------------------------------------------------------------------*/
+static int
+cef_rngque_mpsc_pop (
+	CefT_Rngque* qp,
+	void** items,
+	int num,
+	int remove_f
+) {
+	unsigned int top = qp->top;
+	CefT_Rngque_Elem* elem;
+	int i;
+
+	for (i = 0 ; i < num ; i++) {
+		elem = &qp->que[(top + i) & qp->mask];
+		if (cef_rngque_load_acq (&elem->seq) != top + i + 1) {
+			/* empty, or the producer has not finished writing the slot 	*/
+			break;
+		}
+		items[i] = elem->body;
+		if (remove_f) {
+			cef_rngque_store_rel (&elem->seq, top + i + qp->mask + 1);
+		}
+	}
+	if ((i > 0) && (remove_f)) {
+		cef_rngque_store_rel (&qp->top, top + i);
+	}
+
+	return (i);
+}
+
+/****************************************************************************************
+	Expiry queue
+
+	The bodies are kept in a binary min-heap ordered by the expiry time, so the cache
+	finds the expired entries in time order without scanning all entries. Each body
+	remembers its position through pos_set(), so it is removed in O(log n) when the
+	entry leaves the cache for any other reason.
+ ****************************************************************************************/
+/*--------------------------------------------------------------------------------------
+	Creates Expiry Queue
+----------------------------------------------------------------------------------------*/
+CefT_Expque* 								/* Created Expiry Queue 					*/
+cef_expque_create (
+	void (*pos_set)(void*, unsigned int)	/* records the position in the body 		*/
+) {
+	CefT_Expque* eq;
+
+	eq = (CefT_Expque*) calloc (1, sizeof (CefT_Expque));
+	if (eq == NULL) {
+		return (NULL);
+	}
+	eq->heap = (CefT_Expque_Elem*) malloc (sizeof (CefT_Expque_Elem) * CefC_Expque_Init_Size);
+	if (eq->heap == NULL) {
+		free (eq);
+		return (NULL);
+	}
+	eq->max 	= CefC_Expque_Init_Size;
+	eq->num 	= 0;
+	eq->pos_set = pos_set;
+
+	return (eq);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys Expiry Queue (the bodies are not freed)
+----------------------------------------------------------------------------------------*/
+void
+cef_expque_destroy (
+	CefT_Expque* eq
+) {
+	if (eq == NULL) {
+		return;
+	}
+	free (eq->heap);
+	free (eq);
+}
+/*--------------------------------------------------------------------------------------
+	Inserts the body which expires at the specified time
+----------------------------------------------------------------------------------------*/
+int 										/* negative value if an error occurs 		*/
+cef_expque_push (
+	CefT_Expque* eq,
+	void* body,
+	uint64_t time
+) {
+	CefT_Expque_Elem* heap;
+
+	if (eq->num == eq->max) {
+		heap = (CefT_Expque_Elem*) realloc (
+					eq->heap, sizeof (CefT_Expque_Elem) * eq->max * 2);
+		if (heap == NULL) {
+			return (-1);
+		}
+		eq->heap = heap;
+		eq->max *= 2;
+	}
+	eq->heap[eq->num].time = time;
+	eq->heap[eq->num].body = body;
+	(*eq->pos_set)(body, eq->num);
+	eq->num++;
+	cef_expque_sift_up (eq, eq->num - 1);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the body at the specified position
+----------------------------------------------------------------------------------------*/
+void
+cef_expque_remove (
+	CefT_Expque* eq,
+	unsigned int pos						/* position recorded by pos_set() 			*/
+) {
+	if (pos >= eq->num) {
+		return;
+	}
+	(*eq->pos_set)(eq->heap[pos].body, CefC_Expque_Invalid);
+	eq->num--;
+	if (pos == eq->num) {
+		return;
+	}
+	/* Fills the hole with the last one 	*/
+	eq->heap[pos] = eq->heap[eq->num];
+	(*eq->pos_set)(eq->heap[pos].body, pos);
+	cef_expque_sift_up (eq, pos);
+	cef_expque_sift_down (eq, pos);
+}
+/*--------------------------------------------------------------------------------------
+	Changes the expiry time of the body at the specified position
+----------------------------------------------------------------------------------------*/
+void
+cef_expque_update (
+	CefT_Expque* eq,
+	unsigned int pos,						/* position recorded by pos_set() 			*/
+	uint64_t time
+) {
+	if (pos >= eq->num) {
+		return;
+	}
+	if (time < eq->heap[pos].time) {
+		eq->heap[pos].time = time;
+		cef_expque_sift_up (eq, pos);
+	} else {
+		eq->heap[pos].time = time;
+		cef_expque_sift_down (eq, pos);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Removes the body which expired first
+----------------------------------------------------------------------------------------*/
+void* 										/* NULL if no body has expired 				*/
+cef_expque_pop_expired (
+	CefT_Expque* eq,
+	uint64_t nowt
+) {
+	void* body;
+
+	if ((eq->num == 0) || (eq->heap[0].time > nowt)) {
+		return (NULL);
+	}
+	body = eq->heap[0].body;
+	cef_expque_remove (eq, 0);
+
+	return (body);
+}
+/*--------------------------------------------------------------------------------------
+	Moves up the element until its parent expires earlier
+----------------------------------------------------------------------------------------*/
+static void
+cef_expque_sift_up (
+	CefT_Expque* eq,
+	unsigned int pos
+) {
+	CefT_Expque_Elem elem = eq->heap[pos];
+	unsigned int parent;
+
+	while (pos > 0) {
+		parent = (pos - 1) / 2;
+		if (eq->heap[parent].time <= elem.time) {
+			break;
+		}
+		eq->heap[pos] = eq->heap[parent];
+		(*eq->pos_set)(eq->heap[pos].body, pos);
+		pos = parent;
+	}
+	eq->heap[pos] = elem;
+	(*eq->pos_set)(elem.body, pos);
+}
+/*--------------------------------------------------------------------------------------
+	Moves down the element until its children expire later
+----------------------------------------------------------------------------------------*/
+static void
+cef_expque_sift_down (
+	CefT_Expque* eq,
+	unsigned int pos
+) {
+	CefT_Expque_Elem elem = eq->heap[pos];
+	unsigned int child;
+
+	while ((child = pos * 2 + 1) < eq->num) {
+		if ((child + 1 < eq->num) && (eq->heap[child + 1].time < eq->heap[child].time)) {
+			child++;
+		}
+		if (elem.time <= eq->heap[child].time) {
+			break;
+		}
+		eq->heap[pos] = eq->heap[child];
+		(*eq->pos_set)(eq->heap[pos].body, pos);
+		pos = child;
+	}
+	eq->heap[pos] = elem;
+	(*eq->pos_set)(elem.body, pos);
+}
@@ -38,6 +38,8 @@
 
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 
 #include <openssl/rsa.h>
@@ -45,17 +47,29 @@
 #include <openssl/objects.h>
 #include <openssl/pem.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CefC_Crc_Pclmul
+#include <immintrin.h>
+#endif // __x86_64__ || __i386__
+
 #include <cefore/cef_define.h>
 #include <cefore/cef_log.h>
 #include <cefore/cef_client.h>
 #include <cefore/cef_frame.h>
 #include <cefore/cef_valid.h>
 #include <cefore/cef_hash.h>
+#include <cefore/cef_rngque.h>
 
 /****************************************************************************************
  Macros
  ****************************************************************************************/
 
+#define CefC_Crc_Slice_Num			8		/* number of tables for slice-by-8 			*/
+#define CefC_Crc_Fold_Min_Len		64		/* minimum length for the PCLMULQDQ folding	*/
+#define CefC_Crc_Fold_Blk_Mask		0x0F	/* the folding consumes 16 byte blocks 		*/
+
+#define CefC_Vcache_Ways			4		/* entries per bucket of verified cache 	*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -75,13 +89,53 @@ typedef struct {
 
 } CefT_Keys;
 
+/********** Verification offload pool 	**********/
+typedef struct {
+
+	CefT_Rngque* 			in_que;			/* jobs waiting for the verification 		*/
+	CefT_Rngque* 			out_que;		/* jobs whose verification is completed 	*/
+	int 					que_size;		/* maximum number of jobs in the pool 		*/
+	int 					que_num;		/* number of jobs in the pool 				*/
+	pthread_t 				threads[CefC_Valid_Pool_Thread_Max];
+	int 					thread_num;
+	pthread_mutex_t 		mutex;
+	pthread_cond_t 			cond;
+	volatile int 			running_f;
+	CefT_Valid_Pool_Stat 	stat;
+
+} CefT_Valid_Pool;
+
+/********** Verified-object cache 	**********/
+typedef struct {
+
+	unsigned char 	digest[SHA256_DIGEST_LENGTH];	/* SHA256 of the verified message 	*/
+	uint64_t 		expire;							/* expiry time [us] (0: unused) 	*/
+
+} CefT_Vcache_Entry;
+
+typedef struct {
+
+	CefT_Vcache_Entry* 		entries;		/* bucket_num * CefC_Vcache_Ways entries 	*/
+	uint32_t 				bucket_num;
+	uint64_t 				ttl;			/* lifetime of the entry [us] 				*/
+	pthread_mutex_t 		mutex;
+	CefT_Valid_Vcache_Stat 	stat;
+
+} CefT_Vcache;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
 
-static uint32_t 			crc_table[256];
+static uint32_t 			crc_table[CefC_Crc_Slice_Num][256];
+static int 					crc_engine = CefC_Crc_Engine_Auto;
+#ifdef CefC_Crc_Pclmul
+static int 					crc_pclmul_f = 0;
+#endif // CefC_Crc_Pclmul
 static CefT_Hash_Handle		key_table;
 static CefT_Keys* 			default_key_entry = NULL;
+static CefT_Valid_Pool 		vrf_pool;
+static CefT_Vcache 			vcache = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
 static char					ccninfo_sha256_prvkey_path[PATH_MAX*2];
 static char					ccninfo_sha256_pubkey_path[PATH_MAX*2];
 unsigned char* 				ccninfo_sha256_pub_key_bi;
@@ -98,6 +152,42 @@ cef_valid_crc_init (
 	void
 );
 static int
+cef_valid_msg_alg_parse (
+	const unsigned char* msg,
+	int msg_len,
+	uint16_t* pkt_len,
+	uint16_t* hdr_len,
+	uint16_t* alg_offset,
+	uint16_t* pld_offset
+);
+static void*
+cef_valid_pool_worker_thread (
+	void* arg
+);
+static int 							/* If the return value is 0 the code is equal, 		*/
+									/* otherwise the code is different. 				*/
+cef_valid_rsa_sha256_cached_verify (
+	const unsigned char* msg,
+	uint16_t pkt_len, 				/* PacketLength 									*/
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset		 		/* offset of T_VALIDATION_PAYLOAD 					*/
+);
+static uint32_t
+cef_valid_crc32_slice8 (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+);
+#ifdef CefC_Crc_Pclmul
+static uint32_t
+cef_valid_crc32_pclmul (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+);
+#endif // CefC_Crc_Pclmul
+static int
 cef_valid_conf_value_get (
 	const char* p,
 	char* name,
@@ -264,17 +354,74 @@ cef_valid_type_get (
 	return (res);
 }
 
+/*--------------------------------------------------------------------------------------
+	Selects the engine of cef_valid_crc32_calc. All engines produce the same code,
+	so this is used only to compare them.
+----------------------------------------------------------------------------------------*/
+int 								/* Returns a negative value if it is not available	*/
+cef_valid_crc_engine_set (
+	int engine 						/* CefC_Crc_Engine_XXX 								*/
+) {
+	cef_valid_crc_init ();
+
+	switch (engine) {
+		case CefC_Crc_Engine_Auto:
+		case CefC_Crc_Engine_Bytewise: {
+			break;
+		}
+		case CefC_Crc_Engine_Slice8: {
+#ifdef CefC_Crc_Pclmul
+			crc_pclmul_f = 0;
+#endif // CefC_Crc_Pclmul
+			break;
+		}
+		case CefC_Crc_Engine_Pclmul: {
+#ifdef CefC_Crc_Pclmul
+			if (crc_pclmul_f) {
+				break;
+			}
+#endif // CefC_Crc_Pclmul
+			return (-1);
+		}
+		default: {
+			return (-1);
+		}
+	}
+	crc_engine = engine;
+
+	return (1);
+}
+
 uint32_t
 cef_valid_crc32_calc (
 	const unsigned char* buf,
 	size_t len
 ) {
 	uint32_t c = 0xFFFFFFFF;
-	size_t i;
+#ifdef CefC_Crc_Pclmul
+	size_t blk_len;
+#endif // CefC_Crc_Pclmul
+
+	if (crc_engine == CefC_Crc_Engine_Bytewise) {
+		while (len > 0) {
+			c = crc_table[0][(c ^ *buf) & 0xFF] ^ (c >> 8);
+			buf++;
+			len--;
+		}
+		return (c ^ 0xFFFFFFFF);
+	}
 
-	for (i = 0 ; i < len ; i++) {
-		c = crc_table[(c ^ buf[i]) & 0xFF] ^ (c >> 8);
+#ifdef CefC_Crc_Pclmul
+	/* Folds the 16 byte aligned part with PCLMULQDQ if the CPU supports it 	*/
+	if ((crc_pclmul_f) && (len >= CefC_Crc_Fold_Min_Len)) {
+		blk_len = len & ~((size_t) CefC_Crc_Fold_Blk_Mask);
+		c = cef_valid_crc32_pclmul (c, buf, blk_len);
+		buf += blk_len;
+		len -= blk_len;
 	}
+#endif // CefC_Crc_Pclmul
+
+	c = cef_valid_crc32_slice8 (c, buf, len);
 
 	return (c ^ 0xFFFFFFFF);
 }
@@ -416,64 +563,20 @@ cef_valid_msg_verify (
 	int msg_len
 ) {
 	int res = -1;
-	struct fixed_hdr* 	fixed_hp;
-	struct tlv_hdr* 	tlv_ptr;
-
-	uint16_t 	index;
+	int alg_type;
 	uint16_t 	pkt_len;
 	uint16_t 	hdr_len;
-	uint16_t 	val_len;
-	uint16_t 	type, alg_type;
 	uint16_t 	alg_offset = 0;
 	uint16_t 	pld_offset = 0;
 
-	/* Obtains header length and packet length 		*/
-	fixed_hp = (struct fixed_hdr*) msg;
-	pkt_len  = ntohs (fixed_hp->pkt_len);
-	if (pkt_len != msg_len) {
+	alg_type = cef_valid_msg_alg_parse (
+					msg, msg_len, &pkt_len, &hdr_len, &alg_offset, &pld_offset);
+	if (alg_type < 0) {
 		return (-1);
 	}
-	hdr_len = fixed_hp->hdr_len;
-
-	/* Obtains CCN message size 		*/
-	tlv_ptr = (struct tlv_hdr*) &msg[hdr_len];
-	val_len = ntohs (tlv_ptr->length);
-	if (hdr_len + CefC_S_TLF + val_len == pkt_len) {
+	if (alg_type == CefC_T_ALG_INVALID) {
 		return (0);
 	}
-	index = hdr_len + CefC_S_TLF + val_len;
-
-	/* Checks Validation Algorithm TLVs 	*/
-	alg_offset = index;
-	tlv_ptr = (struct tlv_hdr*) &msg[alg_offset];
-	type = ntohs (tlv_ptr->type);
-	if (type != CefC_T_VALIDATION_ALG) {
-		return (-1);
-	}
-
-	val_len = ntohs (tlv_ptr->length);
-	if (index + CefC_S_TLF + val_len >= pkt_len) {
-		return (-1);
-	}
-	index += CefC_S_TLF;
-
-	/* Checks Algorithm Type 		*/
-	tlv_ptr = (struct tlv_hdr*) &msg[index];
-	alg_type = ntohs (tlv_ptr->type);
-	index += val_len;
-
-	/* Checks Validation Payload TLVs 	*/
-	pld_offset = index;
-	tlv_ptr = (struct tlv_hdr*) &msg[pld_offset];
-	type = ntohs (tlv_ptr->type);
-	if (type != CefC_T_VALIDATION_PAYLOAD) {
-		return (-1);
-	}
-
-	val_len = ntohs (tlv_ptr->length);
-	if (index + CefC_S_TLF + val_len > pkt_len) {
-		return (-1);
-	}
 
 	switch (alg_type) {
 		case CefC_T_CRC32C: {
@@ -482,8 +585,13 @@ cef_valid_msg_verify (
 			break;
 		}
 		case CefC_T_RSA_SHA256: {
-			res = cef_valid_rsa_sha256_verify (
-					msg, pkt_len, hdr_len, alg_offset, pld_offset);
+			if (vcache.entries != NULL) {
+				res = cef_valid_rsa_sha256_cached_verify (
+						msg, pkt_len, hdr_len, alg_offset, pld_offset);
+			} else {
+				res = cef_valid_rsa_sha256_verify (
+						msg, pkt_len, hdr_len, alg_offset, pld_offset);
+			}
 			break;
 		}
 		default: {
@@ -494,6 +602,274 @@ cef_valid_msg_verify (
 	return (res);
 }
 
+int 								/* Validation Algorithm Type (CefC_T_XXX). 			*/
+									/* CefC_T_ALG_INVALID means no validation and a 	*/
+									/* negative value means the malformed message. 		*/
+cef_valid_msg_alg_get (
+	const unsigned char* msg,
+	int msg_len
+) {
+	uint16_t 	pkt_len;
+	uint16_t 	hdr_len;
+	uint16_t 	alg_offset = 0;
+	uint16_t 	pld_offset = 0;
+
+	return (cef_valid_msg_alg_parse (
+				msg, msg_len, &pkt_len, &hdr_len, &alg_offset, &pld_offset));
+}
+
+/*--------------------------------------------------------------------------------------
+	Starts the worker threads which verify the messages in the background
+----------------------------------------------------------------------------------------*/
+int 								/* Returns a negative value if it fails 			*/
+cef_valid_pool_init (
+	int thread_num, 				/* number of the worker threads 					*/
+	int que_size 					/* maximum number of jobs in the pool 				*/
+) {
+	int i;
+
+	if ((thread_num < 1) || (thread_num > CefC_Valid_Pool_Thread_Max)) {
+		return (-1);
+	}
+	if ((que_size < 1) || (que_size > CefC_Valid_Pool_Que_Max)) {
+		return (-1);
+	}
+	memset (&vrf_pool, 0, sizeof (CefT_Valid_Pool));
+
+	vrf_pool.in_que  = cef_rngque_create_ext (que_size + 1, CefC_Rngque_Type_Spsc);
+	vrf_pool.out_que = cef_rngque_create_ext (que_size + 1, CefC_Rngque_Type_Mpsc);
+	vrf_pool.que_size = que_size;
+	pthread_mutex_init (&vrf_pool.mutex, NULL);
+	pthread_cond_init (&vrf_pool.cond, NULL);
+	vrf_pool.running_f = 1;
+
+	for (i = 0 ; i < thread_num ; i++) {
+		if (pthread_create (&vrf_pool.threads[i], NULL
+				, cef_valid_pool_worker_thread, NULL) != 0) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to create the verification thread (%s)\n", strerror (errno));
+			cef_valid_pool_destroy ();
+			cef_valid_pool_pop ();
+			return (-1);
+		}
+		vrf_pool.thread_num++;
+	}
+
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Stops the worker threads. Jobs which have not been verified are moved to the
+	completed queue with a failure result, so the owner frees them with
+	cef_valid_pool_pop after this call.
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pool_destroy (
+	void
+) {
+	CefT_Valid_Job* job;
+	int i;
+
+	if (vrf_pool.in_que == NULL) {
+		return;
+	}
+	pthread_mutex_lock (&vrf_pool.mutex);
+	vrf_pool.running_f = 0;
+	pthread_cond_broadcast (&vrf_pool.cond);
+	pthread_mutex_unlock (&vrf_pool.mutex);
+
+	for (i = 0 ; i < vrf_pool.thread_num ; i++) {
+		pthread_join (vrf_pool.threads[i], NULL);
+	}
+	while ((job = (CefT_Valid_Job*) cef_rngque_pop (vrf_pool.in_que)) != NULL) {
+		job->res = -1;
+		cef_rngque_push (vrf_pool.out_que, job);
+	}
+	cef_rngque_destroy (vrf_pool.in_que);
+	vrf_pool.in_que = NULL;
+	vrf_pool.thread_num = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+	Queues the job to the worker threads
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if queued, 0 if the pool is full		*/
+cef_valid_pool_push (
+	CefT_Valid_Job* job
+) {
+	int res = 0;
+
+	if (vrf_pool.running_f == 0) {
+		return (0);
+	}
+	pthread_mutex_lock (&vrf_pool.mutex);
+	if ((vrf_pool.que_num < vrf_pool.que_size) &&
+		(cef_rngque_push (vrf_pool.in_que, job) > 0)) {
+		vrf_pool.que_num++;
+		if (vrf_pool.que_num > vrf_pool.stat.que_max) {
+			vrf_pool.stat.que_max = vrf_pool.que_num;
+		}
+		vrf_pool.stat.push_num++;
+		pthread_cond_signal (&vrf_pool.cond);
+		res = 1;
+	} else {
+		vrf_pool.stat.full_num++;
+	}
+	pthread_mutex_unlock (&vrf_pool.mutex);
+
+	return (res);
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the job whose verification has been completed. After the pool is
+	stopped, the pool is released when the last job has been obtained.
+----------------------------------------------------------------------------------------*/
+CefT_Valid_Job* 					/* completed job, or NULL if there is none 			*/
+cef_valid_pool_pop (
+	void
+) {
+	CefT_Valid_Job* job;
+
+	if (vrf_pool.out_que == NULL) {
+		return (NULL);
+	}
+	job = (CefT_Valid_Job*) cef_rngque_pop (vrf_pool.out_que);
+	if (job != NULL) {
+		pthread_mutex_lock (&vrf_pool.mutex);
+		vrf_pool.que_num--;
+		pthread_mutex_unlock (&vrf_pool.mutex);
+	} else if (vrf_pool.in_que == NULL) {
+		/* The pool has been stopped and all jobs were returned 	*/
+		pthread_cond_destroy (&vrf_pool.cond);
+		pthread_mutex_destroy (&vrf_pool.mutex);
+		cef_rngque_destroy (vrf_pool.out_que);
+		vrf_pool.out_que = NULL;
+	}
+
+	return (job);
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the pool
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_pool_stat_get (
+	CefT_Valid_Pool_Stat* stat
+) {
+	pthread_mutex_lock (&vrf_pool.mutex);
+	memcpy (stat, &vrf_pool.stat, sizeof (CefT_Valid_Pool_Stat));
+	stat->que_num 		= vrf_pool.que_num;
+	stat->que_size 		= vrf_pool.que_size;
+	stat->thread_num 	= vrf_pool.thread_num;
+	pthread_mutex_unlock (&vrf_pool.mutex);
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates the cache of the RSA-SHA256 verification results
+----------------------------------------------------------------------------------------*/
+int 								/* Returns a negative value if it fails 			*/
+cef_valid_vcache_init (
+	size_t mem_size, 				/* upper limit of the memory [bytes] 				*/
+	uint32_t ttl 					/* lifetime of the cached result [sec] 				*/
+) {
+	uint32_t bucket_num;
+	CefT_Vcache_Entry* entries;
+
+	bucket_num = (uint32_t)(mem_size / (sizeof (CefT_Vcache_Entry) * CefC_Vcache_Ways));
+	if ((bucket_num < 1) || (ttl < 1)) {
+		return (-1);
+	}
+	entries = (CefT_Vcache_Entry*) calloc (
+					(size_t) bucket_num * CefC_Vcache_Ways, sizeof (CefT_Vcache_Entry));
+	if (entries == NULL) {
+		return (-1);
+	}
+
+	pthread_mutex_lock (&vcache.mutex);
+	if (vcache.entries != NULL) {
+		free (vcache.entries);
+	}
+	memset (&vcache.stat, 0, sizeof (CefT_Valid_Vcache_Stat));
+	vcache.bucket_num = bucket_num;
+	vcache.ttl = (uint64_t) ttl * 1000000;
+	vcache.stat.entry_max = bucket_num * CefC_Vcache_Ways;
+	vcache.entries = entries;
+	pthread_mutex_unlock (&vcache.mutex);
+
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroys the cache of the RSA-SHA256 verification results
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_vcache_destroy (
+	void
+) {
+	pthread_mutex_lock (&vcache.mutex);
+	if (vcache.entries != NULL) {
+		free (vcache.entries);
+		vcache.entries = NULL;
+	}
+	vcache.bucket_num = 0;
+	pthread_mutex_unlock (&vcache.mutex);
+}
+
+/*--------------------------------------------------------------------------------------
+	Removes all cached results. The hop-by-hop results depend on the keys read
+	from cefnetd.key, which are read only when cefnetd starts. Reloading the keys
+	while cefnetd runs is not supported, so no entry is invalidated per KeyId.
+----------------------------------------------------------------------------------------*/
+int 								/* number of the removed entries 					*/
+cef_valid_vcache_flush (
+	void
+) {
+	uint64_t nowt;
+	uint32_t i;
+	int num = 0;
+
+	nowt = cef_client_present_timeus_calc ();
+	pthread_mutex_lock (&vcache.mutex);
+	if (vcache.entries != NULL) {
+		for (i = 0 ; i < vcache.bucket_num * CefC_Vcache_Ways ; i++) {
+			if (vcache.entries[i].expire > nowt) {
+				num++;
+			}
+			vcache.entries[i].expire = 0;
+		}
+		vcache.stat.invalidate_num += num;
+	}
+	pthread_mutex_unlock (&vcache.mutex);
+
+	return (num);
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the statistics of the cache
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_vcache_stat_get (
+	CefT_Valid_Vcache_Stat* stat
+) {
+	uint64_t nowt;
+	uint32_t i;
+
+	nowt = cef_client_present_timeus_calc ();
+	pthread_mutex_lock (&vcache.mutex);
+	memcpy (stat, &vcache.stat, sizeof (CefT_Valid_Vcache_Stat));
+
+	/* Counts only the entries which have not expired yet 	*/
+	stat->entry_num = 0;
+	if (vcache.entries != NULL) {
+		for (i = 0 ; i < vcache.bucket_num * CefC_Vcache_Ways ; i++) {
+			if (vcache.entries[i].expire > nowt) {
+				stat->entry_num++;
+			}
+		}
+	}
+	pthread_mutex_unlock (&vcache.mutex);
+}
+
 int
 cef_valid_keyid_create_forccninfo (
 	unsigned char* pubkey,
@@ -836,6 +1212,84 @@ cef_valid_rsa_sha256_verify (
 	return (res);
 }
 
+/*--------------------------------------------------------------------------------------
+	Verifies RSA-SHA256 using the cache of the verified messages. The cache key
+	is the digest of the whole CCN message and Validation TLVs, so that only the
+	byte-identical message (including the public key and the signature) hits.
+	Only the successes are cached, a failure is verified again each time.
+----------------------------------------------------------------------------------------*/
+static int 							/* If the return value is 0 the code is equal, 		*/
+									/* otherwise the code is different. 				*/
+cef_valid_rsa_sha256_cached_verify (
+	const unsigned char* msg,
+	uint16_t pkt_len, 				/* PacketLength 									*/
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset		 		/* offset of T_VALIDATION_PAYLOAD 					*/
+) {
+	unsigned char 		digest[SHA256_DIGEST_LENGTH];
+	uint32_t 			bucket;
+	uint64_t 			nowt;
+	CefT_Vcache_Entry* 	ent;
+	CefT_Vcache_Entry* 	victim;
+	int 				res;
+	int 				i;
+
+	SHA256 (&msg[hdr_len], pkt_len - hdr_len, digest);
+
+	/* Looks up the cache 		*/
+	nowt = cef_client_present_timeus_calc ();
+	pthread_mutex_lock (&vcache.mutex);
+	if (vcache.entries == NULL) {
+		pthread_mutex_unlock (&vcache.mutex);
+		return (cef_valid_rsa_sha256_verify (
+					msg, pkt_len, hdr_len, alg_offset, pld_offset));
+	}
+	memcpy (&bucket, digest, sizeof (uint32_t));
+	ent = &vcache.entries[(bucket % vcache.bucket_num) * CefC_Vcache_Ways];
+	for (i = 0 ; i < CefC_Vcache_Ways ; i++) {
+		if ((ent[i].expire > nowt) &&
+			(memcmp (ent[i].digest, digest, SHA256_DIGEST_LENGTH) == 0)) {
+			vcache.stat.hit_num++;
+			pthread_mutex_unlock (&vcache.mutex);
+			return (0);
+		}
+	}
+	vcache.stat.miss_num++;
+	pthread_mutex_unlock (&vcache.mutex);
+
+	res = cef_valid_rsa_sha256_verify (
+				msg, pkt_len, hdr_len, alg_offset, pld_offset);
+
+	/* A rejection is not pinned, the key may be corrected or be being updated 	*/
+	if (res != 0) {
+		return (res);
+	}
+
+	/* Records the message, replacing the entry which expires first 	*/
+	pthread_mutex_lock (&vcache.mutex);
+	if (vcache.entries != NULL) {
+		ent = &vcache.entries[(bucket % vcache.bucket_num) * CefC_Vcache_Ways];
+		victim = &ent[0];
+		for (i = 0 ; i < CefC_Vcache_Ways ; i++) {
+			if (ent[i].expire <= nowt) {
+				victim = &ent[i];
+				break;
+			}
+			if (ent[i].expire < victim->expire) {
+				victim = &ent[i];
+			}
+		}
+		if (victim->expire > nowt) {
+			vcache.stat.evict_num++;
+		}
+		memcpy (victim->digest, digest, SHA256_DIGEST_LENGTH);
+		victim->expire = nowt + vcache.ttl;
+	}
+	pthread_mutex_unlock (&vcache.mutex);
+
+	return (res);
+}
 static int 							/* If the return value is 0 the code is equal, 		*/
 									/* otherwise the code is different. 				*/
 cef_valid_rsa_sha256_std_verify (
@@ -1153,6 +1607,9 @@ cef_valid_read_conf (
 	unsigned char name[CefC_Max_Length];
 	CefT_Keys* 	key_entry;
 
+	/* Forgets the results verified with the previous keys, the keys are not read 	*/
+	/* again while cefnetd runs 													*/
+	cef_valid_vcache_flush ();
 
 	key_table = cef_hash_tbl_create (128);
 
@@ -1361,6 +1818,124 @@ cef_valid_sha256_keypass_ccninfoRT(
 	return (0);
 }
 
+/*--------------------------------------------------------------------------------------
+	Obtains the offsets of the Validation TLVs
+----------------------------------------------------------------------------------------*/
+static int 							/* Validation Algorithm Type, CefC_T_ALG_INVALID 	*/
+									/* if no validation, or -1 if malformed 			*/
+cef_valid_msg_alg_parse (
+	const unsigned char* msg,
+	int msg_len,
+	uint16_t* pkt_len, 				/* PacketLength 									*/
+	uint16_t* hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t* alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t* pld_offset		 	/* offset of T_VALIDATION_PAYLOAD 					*/
+) {
+	struct fixed_hdr* 	fixed_hp;
+	struct tlv_hdr* 	tlv_ptr;
+
+	uint16_t 	index;
+	uint16_t 	val_len;
+	uint16_t 	type, alg_type;
+
+	/* Obtains header length and packet length 		*/
+	fixed_hp = (struct fixed_hdr*) msg;
+	*pkt_len  = ntohs (fixed_hp->pkt_len);
+	if (*pkt_len != msg_len) {
+		return (-1);
+	}
+	*hdr_len = fixed_hp->hdr_len;
+
+	/* Obtains CCN message size 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[*hdr_len];
+	val_len = ntohs (tlv_ptr->length);
+	if (*hdr_len + CefC_S_TLF + val_len == *pkt_len) {
+		return (CefC_T_ALG_INVALID);
+	}
+	index = *hdr_len + CefC_S_TLF + val_len;
+
+	/* Checks Validation Algorithm TLVs 	*/
+	*alg_offset = index;
+	tlv_ptr = (struct tlv_hdr*) &msg[*alg_offset];
+	type = ntohs (tlv_ptr->type);
+	if (type != CefC_T_VALIDATION_ALG) {
+		return (-1);
+	}
+
+	val_len = ntohs (tlv_ptr->length);
+	if (index + CefC_S_TLF + val_len >= *pkt_len) {
+		return (-1);
+	}
+	index += CefC_S_TLF;
+
+	/* Checks Algorithm Type 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[index];
+	alg_type = ntohs (tlv_ptr->type);
+	index += val_len;
+
+	/* Checks Validation Payload TLVs 	*/
+	*pld_offset = index;
+	tlv_ptr = (struct tlv_hdr*) &msg[*pld_offset];
+	type = ntohs (tlv_ptr->type);
+	if (type != CefC_T_VALIDATION_PAYLOAD) {
+		return (-1);
+	}
+
+	val_len = ntohs (tlv_ptr->length);
+	if (index + CefC_S_TLF + val_len > *pkt_len) {
+		return (-1);
+	}
+
+	return (alg_type);
+}
+
+/*--------------------------------------------------------------------------------------
+	Worker thread of the verification offload pool
+----------------------------------------------------------------------------------------*/
+static void*
+cef_valid_pool_worker_thread (
+	void* arg
+) {
+	CefT_Valid_Job* job;
+
+	while (1) {
+		/* Only the job popped in this round is handed back, the previous one 	*/
+		/* is already owned by cefnetd 											*/
+		job = NULL;
+		pthread_mutex_lock (&vrf_pool.mutex);
+		while ((vrf_pool.running_f) &&
+			((job = (CefT_Valid_Job*) cef_rngque_pop (vrf_pool.in_que)) == NULL)) {
+			pthread_cond_wait (&vrf_pool.cond, &vrf_pool.mutex);
+		}
+		pthread_mutex_unlock (&vrf_pool.mutex);
+
+		if (job == NULL) {
+			break;
+		}
+		if (vrf_pool.running_f == 0) {
+			/* The popped job is returned unverified so that the owner frees it 	*/
+			job->res = -1;
+			cef_rngque_push (vrf_pool.out_que, job);
+			break;
+		}
+
+		job->res = cef_valid_msg_verify (job->msg, job->msg_len);
+
+		pthread_mutex_lock (&vrf_pool.mutex);
+		vrf_pool.stat.done_num++;
+		if (job->res != 0) {
+			vrf_pool.stat.ng_num++;
+		}
+		pthread_mutex_unlock (&vrf_pool.mutex);
+
+		/* The out queue can hold que_size jobs, so this never fails 	*/
+		cef_rngque_push (vrf_pool.out_que, job);
+	}
+
+	pthread_exit (NULL);
+	return ((void*) NULL);
+}
+
 static void
 cef_valid_crc_init (
 	void
@@ -1373,9 +1948,166 @@ cef_valid_crc_init (
 		for (j = 0 ; j < 8 ; j++) {
 			c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
 		}
-		crc_table[i] = c;
+		crc_table[0][i] = c;
+	}
+
+	/* Creates the tables for slice-by-8 		*/
+	for (i = 0 ; i < 256 ; i++) {
+		c = crc_table[0][i];
+		for (j = 1 ; j < CefC_Crc_Slice_Num ; j++) {
+			c = crc_table[0][c & 0xFF] ^ (c >> 8);
+			crc_table[j][i] = c;
+		}
+	}
+
+#ifdef CefC_Crc_Pclmul
+	/* Selects the folding engine at runtime 		*/
+	__builtin_cpu_init ();
+	if ((__builtin_cpu_supports ("pclmul")) && (__builtin_cpu_supports ("sse4.1"))) {
+		crc_pclmul_f = 1;
+	} else {
+		crc_pclmul_f = 0;
 	}
+#endif // CefC_Crc_Pclmul
+}
+
+static uint32_t
+cef_valid_crc32_slice8 (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+) {
+	uint32_t c = crc;
+	uint32_t one, two;
+
+	while (len >= CefC_Crc_Slice_Num) {
+		one = c ^ ((uint32_t) buf[0]
+				| ((uint32_t) buf[1] << 8)
+				| ((uint32_t) buf[2] << 16)
+				| ((uint32_t) buf[3] << 24));
+		two = (uint32_t) buf[4]
+				| ((uint32_t) buf[5] << 8)
+				| ((uint32_t) buf[6] << 16)
+				| ((uint32_t) buf[7] << 24);
+		c = crc_table[7][one & 0xFF]
+			^ crc_table[6][(one >> 8) & 0xFF]
+			^ crc_table[5][(one >> 16) & 0xFF]
+			^ crc_table[4][one >> 24]
+			^ crc_table[3][two & 0xFF]
+			^ crc_table[2][(two >> 8) & 0xFF]
+			^ crc_table[1][(two >> 16) & 0xFF]
+			^ crc_table[0][two >> 24];
+		buf += CefC_Crc_Slice_Num;
+		len -= CefC_Crc_Slice_Num;
+	}
+	while (len > 0) {
+		c = crc_table[0][(c ^ *buf) & 0xFF] ^ (c >> 8);
+		buf++;
+		len--;
+	}
+
+	return (c);
+}
+
+#ifdef CefC_Crc_Pclmul
+/*--------------------------------------------------------------------------------------
+	Folds the buffer with carry-less multiplication (Intel, "Fast CRC Computation for
+	Generic Polynomials Using PCLMULQDQ Instruction"). len must be a multiple of 16
+	and not less than CefC_Crc_Fold_Min_Len.
+----------------------------------------------------------------------------------------*/
+__attribute__ ((target ("sse4.1,pclmul")))
+static uint32_t
+cef_valid_crc32_pclmul (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+) {
+	/* Bit-reflected constants for the polynomial 0x04C11DB7 		*/
+	static const uint64_t k1k2[2] __attribute__ ((aligned (16)))
+										= { 0x0154442bd4ULL, 0x01c6e41596ULL };
+	static const uint64_t k3k4[2] __attribute__ ((aligned (16)))
+										= { 0x01751997d0ULL, 0x00ccaa009eULL };
+	static const uint64_t k5k0[2] __attribute__ ((aligned (16)))
+										= { 0x0163cd6124ULL, 0x0000000000ULL };
+	static const uint64_t poly[2] __attribute__ ((aligned (16)))
+										= { 0x01db710641ULL, 0x01f7011641ULL };
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	x1 = _mm_loadu_si128 ((const __m128i*)(buf + 0x00));
+	x2 = _mm_loadu_si128 ((const __m128i*)(buf + 0x10));
+	x3 = _mm_loadu_si128 ((const __m128i*)(buf + 0x20));
+	x4 = _mm_loadu_si128 ((const __m128i*)(buf + 0x30));
+	x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 ((int) crc));
+	x0 = _mm_load_si128 ((const __m128i*) k1k2);
+	buf += 64;
+	len -= 64;
+
+	/* Folds 4 x 128 bits in parallel 		*/
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+		y5 = _mm_loadu_si128 ((const __m128i*)(buf + 0x00));
+		y6 = _mm_loadu_si128 ((const __m128i*)(buf + 0x10));
+		y7 = _mm_loadu_si128 ((const __m128i*)(buf + 0x20));
+		y8 = _mm_loadu_si128 ((const __m128i*)(buf + 0x30));
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), y5);
+		x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), y6);
+		x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), y7);
+		x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), y8);
+		buf += 64;
+		len -= 64;
+	}
+
+	/* Folds into 128 bits 		*/
+	x0 = _mm_load_si128 ((const __m128i*) k3k4);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+
+	/* Folds the remaining 16 byte blocks 		*/
+	while (len >= 16) {
+		x2 = _mm_loadu_si128 ((const __m128i*) buf);
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	/* Folds 128 bits to 64 bits 		*/
+	x2 = _mm_clmulepi64_si128 (x1, x0, 0x10);
+	x3 = _mm_setr_epi32 (~0, 0, ~0, 0);
+	x1 = _mm_srli_si128 (x1, 8);
+	x1 = _mm_xor_si128 (x1, x2);
+	x0 = _mm_loadl_epi64 ((const __m128i*) k5k0);
+	x2 = _mm_srli_si128 (x1, 4);
+	x1 = _mm_and_si128 (x1, x3);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	/* Barrett reduction to 32 bits 		*/
+	x0 = _mm_load_si128 ((const __m128i*) poly);
+	x2 = _mm_and_si128 (x1, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x10);
+	x2 = _mm_and_si128 (x2, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	return ((uint32_t) _mm_extract_epi32 (x1, 1));
 }
+#endif // CefC_Crc_Pclmul
 
 static int
 cef_valid_conf_value_get (
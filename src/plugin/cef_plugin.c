@@ -124,7 +124,7 @@ cef_plugin_init (
 	cef_plugin_config_read ();
 
 	/* Creates the tx buffer 									*/
-	plgin_hdl->tx_que = cef_rngque_create (CefC_Tx_Que_Size);
+	plgin_hdl->tx_que = cef_rngque_create_ext (CefC_Tx_Que_Size, CefC_Rngque_Type_Mpsc);
 	plgin_hdl->tx_que_mp
 		= cef_mpool_init ("CefTxMSF", sizeof (CefT_Tx_Elem), CefC_Tx_Que_Size);
 
@@ -0,0 +1,841 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cefbench.c
+ */
+
+#define __CEF_BENCH_SOURCE__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <cefore/cef_define.h>
+#include <cefore/cef_valid.h>
+#include <cefore/cef_rngque.h>
+#include <cefore/cef_mpool.h>
+#ifdef CefC_ContentStore
+#include <cefore/cef_csmgr.h>
+#endif // CefC_ContentStore
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Bench_Crc_Size			8192		/* default message size 				*/
+#define CefC_Bench_Crc_Total		256			/* default MB per engine 				*/
+#define CefC_Bench_Crc_Check_Len	4096		/* lengths compared with the reference 	*/
+#define CefC_Bench_Crc_Check_Off	16			/* offsets compared with the reference	*/
+
+#define CefC_Bench_Que_Size			4096		/* capacity of the ring queue 			*/
+#define CefC_Bench_Que_Items		4			/* default M items through the queue 	*/
+#define CefC_Bench_Thread_Max		64			/* max producers / threads 				*/
+#define CefC_Bench_Batch_Max		256			/* max items pushed or popped at once 	*/
+
+#define CefC_Bench_Mp_Ops			4			/* default M allocs per thread 			*/
+#define CefC_Bench_Mp_Size			256			/* default block size 					*/
+#define CefC_Bench_Mp_Burst			32			/* blocks held by a thread at once 		*/
+
+#define CefC_Bench_Lz_Size			8192		/* default block size 					*/
+#define CefC_Bench_Lz_Total			64			/* default MB compressed per corpus 	*/
+#define CefC_Bench_Lz_Rounds		20000		/* blocks of the round-trip test 		*/
+#define CefC_Bench_Lz_Flips			8			/* corrupted copies of each block 		*/
+#define CefC_Bench_Lz_Corpus_Num	4
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+typedef struct {
+	const char* name;
+	int (*run)(int argc, char** argv);
+	const char* usage;
+} CefT_Bench_Cmd;
+
+/***** Arguments of the queue and pool benchmark threads 	*****/
+typedef struct {
+	CefT_Rngque* 	que;
+	CefT_Mp_Handle 	mp;				/* 0 uses malloc/free 								*/
+	uint64_t 		num;			/* items to push, or allocations to make 			*/
+	int 			batch;
+	size_t 			size;
+	uint64_t 		sum;			/* checks that nothing was lost 					*/
+} CefT_Bench_Arg;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void
+print_usage (
+	void
+);
+static uint64_t
+bench_time_get (
+	void
+);
+static long
+bench_opt_get (
+	int argc,
+	char** argv,
+	const char* opt,
+	long def
+);
+static void
+bench_rand_fill (
+	unsigned char* buf,
+	size_t len
+);
+static int
+bench_crc_run (
+	int argc,
+	char** argv
+);
+static int
+bench_rngque_run (
+	int argc,
+	char** argv
+);
+static void*
+bench_rngque_producer (
+	void* arg
+);
+static int
+bench_mpool_run (
+	int argc,
+	char** argv
+);
+static void*
+bench_mpool_local (
+	void* arg
+);
+static void*
+bench_mpool_producer (
+	void* arg
+);
+#ifdef CefC_ContentStore
+static int
+bench_lz_run (
+	int argc,
+	char** argv
+);
+static void
+bench_lz_corpus_fill (
+	int corpus,
+	unsigned char* buf,
+	int len
+);
+#endif // CefC_ContentStore
+
+/****************************************************************************************
+ Commands
+ ****************************************************************************************/
+
+static CefT_Bench_Cmd bench_cmds[] = {
+	{ "crc", 	bench_crc_run,
+		"[-s msg_size] [-m MB]  CRC32 engines, GB/s" },
+	{ "rngque", bench_rngque_run,
+		"[-p producers] [-n M_items] [-b batch]  ring queue types, Mops/s" },
+	{ "mpool", 	bench_mpool_run,
+		"[-t threads] [-n M_allocs] [-s size]  cef_mpool and malloc, Mops/s" },
+#ifdef CefC_ContentStore
+	{ "lz", 	bench_lz_run,
+		"[-s block_size] [-m MB]  cache block codec, round-trip/fuzz test and MB/s" },
+#endif // CefC_ContentStore
+	{ NULL, NULL, NULL }
+};
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	int i;
+
+	if (argc < 2) {
+		print_usage ();
+		return (-1);
+	}
+	for (i = 0 ; bench_cmds[i].name != NULL ; i++) {
+		if (strcmp (argv[1], bench_cmds[i].name) == 0) {
+			return ((*bench_cmds[i].run) (argc - 2, &argv[2]));
+		}
+	}
+	fprintf (stderr, "ERROR: unknown benchmark (%s)\n", argv[1]);
+	print_usage ();
+
+	return (-1);
+}
+
+static void
+print_usage (
+	void
+) {
+	int i;
+
+	fprintf (stderr, "\nUsage: cefbench\n\n");
+	for (i = 0 ; bench_cmds[i].name != NULL ; i++) {
+		fprintf (stderr, "  cefbench %-8s %s\n", bench_cmds[i].name, bench_cmds[i].usage);
+	}
+	fprintf (stderr, "\n");
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the monotonic time in nanoseconds
+----------------------------------------------------------------------------------------*/
+static uint64_t
+bench_time_get (
+	void
+) {
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec);
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the value of the option, or the default if it is not specified
+----------------------------------------------------------------------------------------*/
+static long
+bench_opt_get (
+	int argc,
+	char** argv,
+	const char* opt,
+	long def
+) {
+	int i;
+
+	for (i = 0 ; i + 1 < argc ; i++) {
+		if (strcmp (argv[i], opt) == 0) {
+			return (atol (argv[i + 1]));
+		}
+	}
+
+	return (def);
+}
+
+/*--------------------------------------------------------------------------------------
+	Fills the buffer with pseudo random bytes (xorshift, fixed seed)
+----------------------------------------------------------------------------------------*/
+static void
+bench_rand_fill (
+	unsigned char* buf,
+	size_t len
+) {
+	static uint64_t x = 88172645463325252ULL;
+	size_t i;
+
+	for (i = 0 ; i < len ; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		buf[i] = (unsigned char) x;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	CRC32: checks that every engine matches the bytewise reference, then measures
+	the throughput of each engine on messages of the specified size
+----------------------------------------------------------------------------------------*/
+static int
+bench_crc_run (
+	int argc,
+	char** argv
+) {
+	static const struct {
+		int engine;
+		const char* name;
+	} engines[] = {
+		{ CefC_Crc_Engine_Bytewise, "bytewise" },
+		{ CefC_Crc_Engine_Slice8, 	"slice-by-8" },
+		{ CefC_Crc_Engine_Pclmul, 	"pclmulqdq" },
+		{ CefC_Crc_Engine_Auto, 	"auto" },
+	};
+	unsigned char* buf;
+	uint32_t* ref;
+	size_t buf_len;
+	size_t msg_size;
+	uint64_t total;
+	uint64_t loops;
+	uint64_t i;
+	uint64_t t1, t2;
+	uint32_t sum;
+	int len, off, e;
+	int res = 0;
+
+	msg_size = (size_t) bench_opt_get (argc, argv, "-s", CefC_Bench_Crc_Size);
+	total = (uint64_t) bench_opt_get (argc, argv, "-m", CefC_Bench_Crc_Total) * 1024 * 1024;
+	if ((msg_size < 1) || (total < msg_size)) {
+		fprintf (stderr, "ERROR: invalid size\n");
+		return (-1);
+	}
+	buf_len = CefC_Bench_Crc_Check_Len + CefC_Bench_Crc_Check_Off;
+	if (buf_len < msg_size) {
+		buf_len = msg_size;
+	}
+	buf = (unsigned char*) malloc (buf_len);
+	ref = (uint32_t*) malloc (
+			sizeof (uint32_t) * CefC_Bench_Crc_Check_Len * CefC_Bench_Crc_Check_Off);
+	if ((buf == NULL) || (ref == NULL)) {
+		fprintf (stderr, "ERROR: malloc\n");
+		free (buf);
+		free (ref);
+		return (-1);
+	}
+	bench_rand_fill (buf, buf_len);
+
+	/* Results of the reference 	*/
+	cef_valid_crc_engine_set (CefC_Crc_Engine_Bytewise);
+	for (off = 0 ; off < CefC_Bench_Crc_Check_Off ; off++) {
+		for (len = 0 ; len < CefC_Bench_Crc_Check_Len ; len++) {
+			ref[off * CefC_Bench_Crc_Check_Len + len] =
+				cef_valid_crc32_calc (&buf[off], (size_t) len);
+		}
+	}
+
+	fprintf (stdout, "CRC32 (%zu byte messages, %llu MB per engine)\n",
+		msg_size, (unsigned long long)(total / 1024 / 1024));
+	loops = total / msg_size;
+
+	for (e = 0 ; e < (int)(sizeof (engines) / sizeof (engines[0])) ; e++) {
+		if (cef_valid_crc_engine_set (engines[e].engine) < 0) {
+			fprintf (stdout, "  %-12s not supported on this CPU\n", engines[e].name);
+			continue;
+		}
+		for (off = 0 ; off < CefC_Bench_Crc_Check_Off ; off++) {
+			for (len = 0 ; len < CefC_Bench_Crc_Check_Len ; len++) {
+				if (cef_valid_crc32_calc (&buf[off], (size_t) len) !=
+						ref[off * CefC_Bench_Crc_Check_Len + len]) {
+					break;
+				}
+			}
+			if (len < CefC_Bench_Crc_Check_Len) {
+				break;
+			}
+		}
+		if (off < CefC_Bench_Crc_Check_Off) {
+			fprintf (stdout, "  %-12s MISMATCH (offset %d, length %d)\n",
+				engines[e].name, off, len);
+			res = -1;
+			continue;
+		}
+
+		sum = 0;
+		t1 = bench_time_get ();
+		for (i = 0 ; i < loops ; i++) {
+			sum += cef_valid_crc32_calc (buf, msg_size);
+		}
+		t2 = bench_time_get ();
+		fprintf (stdout, "  %-12s %8.2f GB/s  (sum %08x)\n", engines[e].name,
+			(double)(loops * msg_size) / (double)(t2 - t1), sum);
+	}
+
+	free (buf);
+	free (ref);
+
+	return (res);
+}
+
+/*--------------------------------------------------------------------------------------
+	Ring queue: the producers push the items to one consumer through each type
+	of CefT_Rngque, the SPSC type only with one producer
+----------------------------------------------------------------------------------------*/
+static int
+bench_rngque_run (
+	int argc,
+	char** argv
+) {
+	static const struct {
+		int type;
+		const char* name;
+	} types[] = {
+		{ CefC_Rngque_Type_Mutex, 	"mutex" },
+		{ CefC_Rngque_Type_Spsc, 	"spsc" },
+		{ CefC_Rngque_Type_Mpsc, 	"mpsc" },
+	};
+	CefT_Bench_Arg args[CefC_Bench_Thread_Max];
+	pthread_t threads[CefC_Bench_Thread_Max];
+	void* items[CefC_Bench_Batch_Max];
+	CefT_Rngque* que;
+	uint64_t total;
+	uint64_t recv;
+	uint64_t sum;
+	uint64_t expect;
+	uint64_t t1, t2;
+	int prod_num;
+	int batch;
+	int t, i, n;
+	int res = 0;
+
+	prod_num = (int) bench_opt_get (argc, argv, "-p", 1);
+	total = (uint64_t) bench_opt_get (argc, argv, "-n", CefC_Bench_Que_Items) * 1000000;
+	batch = (int) bench_opt_get (argc, argv, "-b", 1);
+	if ((prod_num < 1) || (prod_num > CefC_Bench_Thread_Max) ||
+		(batch < 1) || (batch > CefC_Bench_Batch_Max) || (total < (uint64_t) prod_num)) {
+		fprintf (stderr, "ERROR: invalid parameter\n");
+		return (-1);
+	}
+	total -= total % prod_num;
+
+	fprintf (stdout, "Ring queue (%d producer(s), 1 consumer, %llu items, batch %d)\n",
+		prod_num, (unsigned long long) total, batch);
+
+	for (t = 0 ; t < (int)(sizeof (types) / sizeof (types[0])) ; t++) {
+		if ((types[t].type == CefC_Rngque_Type_Spsc) && (prod_num > 1)) {
+			fprintf (stdout, "  %-8s needs a single producer\n", types[t].name);
+			continue;
+		}
+		que = cef_rngque_create_ext (CefC_Bench_Que_Size, types[t].type);
+		if (que == NULL) {
+			fprintf (stderr, "ERROR: cef_rngque_create_ext\n");
+			return (-1);
+		}
+
+		t1 = bench_time_get ();
+		for (i = 0 ; i < prod_num ; i++) {
+			memset (&args[i], 0, sizeof (CefT_Bench_Arg));
+			args[i].que 	= que;
+			args[i].num 	= total / prod_num;
+			args[i].batch 	= batch;
+			pthread_create (&threads[i], NULL, bench_rngque_producer, &args[i]);
+		}
+
+		/* The main thread is the consumer 	*/
+		recv = 0;
+		sum  = 0;
+		while (recv < total) {
+			if (batch > 1) {
+				n = cef_rngque_pop_batch (que, items, batch);
+			} else {
+				items[0] = cef_rngque_pop (que);
+				n = (items[0] != NULL) ? 1 : 0;
+			}
+			if (n == 0) {
+				sched_yield ();
+				continue;
+			}
+			for (i = 0 ; i < n ; i++) {
+				sum += (uint64_t)(uintptr_t) items[i];
+			}
+			recv += n;
+		}
+		t2 = bench_time_get ();
+		for (i = 0 ; i < prod_num ; i++) {
+			pthread_join (threads[i], NULL);
+		}
+		cef_rngque_destroy (que);
+
+		/* Each producer pushes 1 .. num 	*/
+		expect = (total / prod_num) * (total / prod_num + 1) / 2 * prod_num;
+		if (sum != expect) {
+			fprintf (stdout, "  %-8s LOST ITEMS\n", types[t].name);
+			res = -1;
+			continue;
+		}
+		fprintf (stdout, "  %-8s %8.2f Mops/s\n", types[t].name,
+			(double) total * 1000.0 / (double)(t2 - t1));
+	}
+
+	return (res);
+}
+
+/*--------------------------------------------------------------------------------------
+	Producer of the ring queue benchmark
+----------------------------------------------------------------------------------------*/
+static void*
+bench_rngque_producer (
+	void* arg
+) {
+	CefT_Bench_Arg* ap = (CefT_Bench_Arg*) arg;
+	void* items[CefC_Bench_Batch_Max];
+	uint64_t next = 1;
+	int num;
+	int done;
+	int i;
+
+	while (next <= ap->num) {
+		num = ap->batch;
+		if ((uint64_t) num > ap->num - next + 1) {
+			num = (int)(ap->num - next + 1);
+		}
+		for (i = 0 ; i < num ; i++) {
+			items[i] = (void*)(uintptr_t)(next + i);
+		}
+		if (num > 1) {
+			done = cef_rngque_push_batch (ap->que, items, num);
+		} else {
+			done = (cef_rngque_push (ap->que, items[0]) > 0) ? 1 : 0;
+		}
+		if (done == 0) {
+			sched_yield ();
+		}
+		next += done;
+	}
+
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Memory pool: each thread allocates and frees the blocks of one shared pool
+	("local"), and the blocks allocated on one thread are freed on another thread
+	through a ring queue ("cross"), which is how the transport threads use it
+----------------------------------------------------------------------------------------*/
+static int
+bench_mpool_run (
+	int argc,
+	char** argv
+) {
+	static const char* modes[] = { "malloc", "cef_mpool" };
+	CefT_Bench_Arg args[CefC_Bench_Thread_Max];
+	pthread_t threads[CefC_Bench_Thread_Max * 2];
+	CefT_Mp_Handle mp;
+	uint64_t num;
+	uint64_t freed;
+	uint64_t t1, t2;
+	size_t size;
+	void* ptr;
+	int th_num;
+	int m, i, n;
+
+	th_num = (int) bench_opt_get (argc, argv, "-t", 4);
+	num = (uint64_t) bench_opt_get (argc, argv, "-n", CefC_Bench_Mp_Ops) * 1000000;
+	size = (size_t) bench_opt_get (argc, argv, "-s", CefC_Bench_Mp_Size);
+	if ((th_num < 1) || (th_num > CefC_Bench_Thread_Max) || (num < 1) || (size < 1)) {
+		fprintf (stderr, "ERROR: invalid parameter\n");
+		return (-1);
+	}
+
+	fprintf (stdout, "Memory pool (%d thread(s), %llu allocs per thread, %zu bytes)\n",
+		th_num, (unsigned long long) num, size);
+
+	for (m = 0 ; m < 2 ; m++) {
+		mp = 0;
+		if (m == 1) {
+			mp = cef_mpool_init ("CefBench", size, CefC_Bench_Que_Size);
+			if (mp == 0) {
+				fprintf (stderr, "ERROR: cef_mpool_init\n");
+				return (-1);
+			}
+		}
+
+		/* local: alloc and free on the same thread 	*/
+		t1 = bench_time_get ();
+		for (i = 0 ; i < th_num ; i++) {
+			memset (&args[i], 0, sizeof (CefT_Bench_Arg));
+			args[i].mp 		= mp;
+			args[i].num 	= num;
+			args[i].size 	= size;
+			pthread_create (&threads[i], NULL, bench_mpool_local, &args[i]);
+		}
+		for (i = 0 ; i < th_num ; i++) {
+			pthread_join (threads[i], NULL);
+		}
+		t2 = bench_time_get ();
+		fprintf (stdout, "  %-10s local %8.2f Mops/s\n", modes[m],
+			(double)(num * th_num) * 1000.0 / (double)(t2 - t1));
+
+		/* cross: the threads allocate, this thread frees 	*/
+		t1 = bench_time_get ();
+		for (i = 0 ; i < th_num ; i++) {
+			memset (&args[i], 0, sizeof (CefT_Bench_Arg));
+			args[i].que 	= cef_rngque_create_ext (CefC_Bench_Que_Size, CefC_Rngque_Type_Spsc);
+			args[i].mp 		= mp;
+			args[i].num 	= num;
+			args[i].size 	= size;
+			pthread_create (&threads[i], NULL, bench_mpool_producer, &args[i]);
+		}
+		freed = 0;
+		while (freed < num * th_num) {
+			n = 0;
+			for (i = 0 ; i < th_num ; i++) {
+				while ((ptr = cef_rngque_pop (args[i].que)) != NULL) {
+					if (mp) {
+						cef_mpool_free (mp, ptr);
+					} else {
+						free (ptr);
+					}
+					n++;
+				}
+			}
+			if (n == 0) {
+				sched_yield ();
+			}
+			freed += n;
+		}
+		for (i = 0 ; i < th_num ; i++) {
+			pthread_join (threads[i], NULL);
+			cef_rngque_destroy (args[i].que);
+		}
+		t2 = bench_time_get ();
+		fprintf (stdout, "  %-10s cross %8.2f Mops/s\n", modes[m],
+			(double)(num * th_num) * 1000.0 / (double)(t2 - t1));
+
+		if (mp) {
+			cef_mpool_destroy (mp);
+		}
+	}
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Allocates a burst of blocks and frees them on the same thread
+----------------------------------------------------------------------------------------*/
+static void*
+bench_mpool_local (
+	void* arg
+) {
+	CefT_Bench_Arg* ap = (CefT_Bench_Arg*) arg;
+	unsigned char* blocks[CefC_Bench_Mp_Burst];
+	uint64_t done = 0;
+	int i;
+
+	while (done < ap->num) {
+		for (i = 0 ; i < CefC_Bench_Mp_Burst ; i++) {
+			if (ap->mp) {
+				blocks[i] = (unsigned char*) cef_mpool_alloc (ap->mp);
+			} else {
+				blocks[i] = (unsigned char*) malloc (ap->size);
+			}
+			blocks[i][0] = (unsigned char) i;
+		}
+		for (i = 0 ; i < CefC_Bench_Mp_Burst ; i++) {
+			ap->sum += blocks[i][0];
+			if (ap->mp) {
+				cef_mpool_free (ap->mp, blocks[i]);
+			} else {
+				free (blocks[i]);
+			}
+		}
+		done += CefC_Bench_Mp_Burst;
+	}
+
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Allocates the blocks and hands them to the freeing thread
+----------------------------------------------------------------------------------------*/
+static void*
+bench_mpool_producer (
+	void* arg
+) {
+	CefT_Bench_Arg* ap = (CefT_Bench_Arg*) arg;
+	unsigned char* block;
+	uint64_t done;
+
+	for (done = 0 ; done < ap->num ; done++) {
+		if (ap->mp) {
+			block = (unsigned char*) cef_mpool_alloc (ap->mp);
+		} else {
+			block = (unsigned char*) malloc (ap->size);
+		}
+		block[0] = 0x01;
+		while (cef_rngque_push (ap->que, block) < 1) {
+			sched_yield ();
+		}
+	}
+
+	return (NULL);
+}
+
+#ifdef CefC_ContentStore
+/*--------------------------------------------------------------------------------------
+	Block codec of the filesystem caches: checks the round trip and the size limit
+	on random blocks, decompresses corrupted blocks to check that the decoder stays
+	in the bounds, and measures the speed on each corpus. Returns a negative value
+	if any check fails.
+----------------------------------------------------------------------------------------*/
+static int
+bench_lz_run (
+	int argc,
+	char** argv
+) {
+	static const char* corpus_names[CefC_Bench_Lz_Corpus_Num] = {
+		"random", "json", "periodic", "mixed"
+	};
+	static unsigned char src[UINT16_MAX];
+	static unsigned char cmp[UINT16_MAX];
+	static unsigned char dec[UINT16_MAX];
+	static unsigned char bad[UINT16_MAX];
+	uint64_t total;
+	uint64_t loops;
+	uint64_t i;
+	uint64_t t1, t2, t3;
+	int blk_size;
+	int len, limit, clen, dlen;
+	int corpus;
+	int err_num = 0;
+	int comp_num = 0;
+	int r, k;
+
+	blk_size = (int) bench_opt_get (argc, argv, "-s", CefC_Bench_Lz_Size);
+	total = (uint64_t) bench_opt_get (argc, argv, "-m", CefC_Bench_Lz_Total) * 1024 * 1024;
+	if ((blk_size < 1) || (blk_size >= UINT16_MAX) || (total < (uint64_t) blk_size)) {
+		fprintf (stderr, "ERROR: invalid size\n");
+		return (-1);
+	}
+
+	/* Round trip and size limit 	*/
+	srand (1);
+	for (r = 0 ; r < CefC_Bench_Lz_Rounds ; r++) {
+		len 	= 1 + rand () % (UINT16_MAX - 1);
+		corpus 	= rand () % CefC_Bench_Lz_Corpus_Num;
+		limit 	= (rand () % 2) ? len : len * 88 / 100;
+		bench_lz_corpus_fill (corpus, src, len);
+
+		clen = cef_csmgr_lz_compress (src, len, cmp, limit);
+		if (clen > limit) {
+			fprintf (stdout, "  NG: %d bytes exceed the limit %d\n", clen, limit);
+			err_num++;
+			continue;
+		}
+		if (clen == 0) {
+			continue;
+		}
+		comp_num++;
+		dlen = cef_csmgr_lz_decompress (cmp, clen, dec, sizeof (dec));
+		if ((dlen != len) || (memcmp (src, dec, len))) {
+			fprintf (stdout, "  NG: %s block of %d bytes is not restored\n",
+				corpus_names[corpus], len);
+			err_num++;
+			continue;
+		}
+		/* A short output buffer must be refused, not overrun 	*/
+		if (cef_csmgr_lz_decompress (cmp, clen, dec, len - 1) >= 0) {
+			fprintf (stdout, "  NG: output of %d bytes fits in %d\n", len, len - 1);
+			err_num++;
+		}
+
+		/* Corrupted blocks only have to be decoded within the bounds 	*/
+		for (k = 0 ; k < CefC_Bench_Lz_Flips ; k++) {
+			memcpy (bad, cmp, clen);
+			bad[rand () % clen] ^= (unsigned char)(1 << (rand () % 8));
+			dlen = cef_csmgr_lz_decompress (bad, rand () % (clen + 1), dec, len);
+			if (dlen > len) {
+				fprintf (stdout, "  NG: corrupted block decoded to %d > %d\n", dlen, len);
+				err_num++;
+			}
+		}
+	}
+	fprintf (stdout, "Block codec round trip : %d blocks (%d compressed), %s\n",
+		CefC_Bench_Lz_Rounds, comp_num, (err_num == 0) ? "OK" : "NG");
+
+	/* Speed 	*/
+	fprintf (stdout, "Block codec (%d byte blocks, %llu MB per corpus)\n",
+		blk_size, (unsigned long long)(total / 1024 / 1024));
+	loops = total / blk_size;
+	for (corpus = 0 ; corpus < CefC_Bench_Lz_Corpus_Num ; corpus++) {
+		bench_lz_corpus_fill (corpus, src, blk_size);
+
+		t1 = bench_time_get ();
+		clen = 0;
+		for (i = 0 ; i < loops ; i++) {
+			clen = cef_csmgr_lz_compress (src, blk_size, cmp, blk_size);
+		}
+		t2 = bench_time_get ();
+		if (clen > 0) {
+			for (i = 0 ; i < loops ; i++) {
+				cef_csmgr_lz_decompress (cmp, clen, dec, blk_size);
+			}
+		}
+		t3 = bench_time_get ();
+
+		if (clen > 0) {
+			fprintf (stdout, "  %-10s %5.1f%%  compress %8.1f MB/s  decompress %8.1f MB/s\n",
+				corpus_names[corpus], (double) clen * 100.0 / blk_size,
+				(double)(loops * blk_size) * 1000.0 / (double)(t2 - t1),
+				(double)(loops * blk_size) * 1000.0 / (double)(t3 - t2));
+		} else {
+			fprintf (stdout, "  %-10s stored raw  compress %8.1f MB/s\n",
+				corpus_names[corpus],
+				(double)(loops * blk_size) * 1000.0 / (double)(t2 - t1));
+		}
+	}
+
+	return ((err_num == 0) ? 0 : -1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Fills the block with the data of the corpus
+----------------------------------------------------------------------------------------*/
+static void
+bench_lz_corpus_fill (
+	int corpus,
+	unsigned char* buf,
+	int len
+) {
+	static const char json[] = "{\"name\":\"/cefore/chunk\",\"seq\":1024,\"ok\":true},";
+	int i;
+
+	switch (corpus) {
+		case 0: {
+			bench_rand_fill (buf, (size_t) len);
+			break;
+		}
+		case 1: {
+			for (i = 0 ; i < len ; i++) {
+				buf[i] = (unsigned char) json[(i + rand () % 2) % (sizeof (json) - 1)];
+			}
+			break;
+		}
+		case 2: {
+			for (i = 0 ; i < len ; i++) {
+				buf[i] = (unsigned char)(i % 7);
+			}
+			break;
+		}
+		default: {
+			/* Copies of the recent bytes mixed with the random bytes 	*/
+			bench_rand_fill (buf, (size_t) len);
+			for (i = 100 ; i < len ; i++) {
+				if (rand () % 3) {
+					buf[i] = buf[i - 1 - rand () % 100];
+				}
+			}
+			break;
+		}
+	}
+}
+#endif // CefC_ContentStore
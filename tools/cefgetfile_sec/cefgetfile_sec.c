@@ -308,8 +308,10 @@ int main (
 			}
 			work_arg = argv[i + 1];
 			mode_val = atoi (work_arg);
-			if ( (mode_val < 0) && (mode_val > 2) ) {
-				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2.\n");
+			if ( (mode_val < 0) || (mode_val > 3) ) {
+				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2 or 3.\n");
+				print_usage ();
+				return (-1);
 			}
 			mode_f++;
 			i++;
@@ -448,7 +450,7 @@ int main (
 	/*---------------------------------------------------------------------------
 		Get	Manifest
 	-----------------------------------------------------------------------------*/
-	if ( (mode_val == 1) || (mode_val == 2) ) {
+	if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 		srand((unsigned)time(NULL));
 		uint32_t rand_n = rand();
 		sprintf( man_fpath, "%s/manifest_%d", getenv("HOME"), rand_n );
@@ -479,6 +481,23 @@ printf ("Manifest URI=%s\n", man_uri);
 		man_params.chunk_num			= 0;
 		man_params.chunk_num_f			= 1;
 		
+		/* Signed Manifest: only the Manifest is requested with KeyIdRestriction,	*/
+		/* so the signature is verified once per Manifest and each Cob is 			*/
+		/* checked against the ObjHash listed in it.								*/
+		if (mode_val == 3) {
+			unsigned char	keyid[32];
+			unsigned char 	pubkey[CefC_Max_Length];
+			
+			cef_valid_init (conf_path);
+			if (cef_valid_keyid_create (
+					man_params.name, man_params.name_len, pubkey, keyid) < 1) {
+				fprintf (stdout, "ERROR: KeyIdRestriction not get KeyId.\n");
+				exit (1);
+			}
+			man_params.KeyIdRester_f = 1;
+			memcpy (man_params.KeyIdRester_val, keyid, 32);
+		}
+		
 		/*---------------------------------------------------------------------------
 			Sends first Interest(s)
 		-----------------------------------------------------------------------------*/
@@ -739,7 +758,7 @@ printf( "man_rec_num:%d\n", man_rec_num );
 		params.KeyIdRester_f = 0;
 	}
 
-	if ( (mode_val == 1) || (mode_val == 2) ) {
+	if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 		/* Read Manifest */
 #ifdef __DEV_COBH__
 printf( "Manifest:%s\n", man_fpath );
@@ -790,13 +809,13 @@ printf( "man_rec.chunk:%d   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec.chunk,
 			rxwnd_prev = rxwnd;
 			rxwnd_head = rxwnd;
 			rxwnd_tail = rxwnd;
-			if ( (mode_val == 1) || (mode_val == 2) ) {
+			if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 				if ( params.chunk_num == man_rec.chunk ) {
 #ifdef __DEV_COBH__
 printf( "CKP-000 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef	__DEB_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -852,12 +871,12 @@ printf( "CKP-004 man_rec.chunk:%d   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec
 			rxwnd_prev->next = rxwnd;
 			rxwnd_tail = rxwnd;
 			rxwnd_prev = rxwnd;
-			if ( (mode_val == 1) || (mode_val == 2) ) {
+			if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 #ifdef __DEV_COBH__
 printf( "CKP-005 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef	__DEV_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1065,12 +1084,12 @@ printf( "Content stat_recv_frames:%ld   end_chunk_num+1:%ld\n", stat_recv_frames
 						/* Sends an interest with the next chunk number 	*/
 						params.chunk_num = rxwnd_tail->seq;
 						if (params.chunk_num <= UINT32_MAX) {
-							if ( (mode_val == 1) || (mode_val == 2) ) {
+							if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 #ifdef __DEV_COBH__
 printf( "CKP-100 params.chunk_num:%u   man_rec.chunk:%u\n", params.chunk_num, man_rec.chunk );
 #endif
 #ifdef __DEB_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 	if ( params.chunk_num == man_rec.chunk ) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1171,7 +1190,7 @@ printf( "CKP-105 man_rec.chunk:%u   man_buff_idx:%d   man_rec_ctr:%d\n", man_rec
 printf( "CKP-200 params.chunk_num:%u\n", params.chunk_num );
 #endif
 #ifdef	__DEV_GET__
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 	if (rxwnd_head->CobHash_f == 1) {
 		int hidx;
 		char	hash_dbg[1024];
@@ -1185,7 +1204,7 @@ if ( (mode_val == 1) || ( mode_val == 2) ) {
 	}
 }
 #endif
-					if ( (mode_val == 1) || (mode_val == 2) ) {
+					if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 						if (rxwnd_head->CobHash_f == 1) {
 							params.ObjHash_f= 1;
 							memcpy( params.ObjHash_val, rxwnd->cob_hash, 32 );
@@ -1228,7 +1247,8 @@ print_usage (
 	fprintf (stdout, "  file             Specify the file name of output. \n");
 	fprintf (stdout, "  mode             0: Send Interest with KeyIdRestriction TLV set.\n"
 	                 "                   1: Send Interest requesting Manifest, and send Interest with a CobHash value set.\n"
-	                 "                   2: Send Interest requesting Manifest, and send Interest with KeyIdRestriction TLV and CobHash value set.\n");
+	                 "                   2: Send Interest requesting Manifest, and send Interest with KeyIdRestriction TLV and CobHash value set.\n"
+	                 "                   3: Send Interest with KeyIdRestriction TLV set requesting signed Manifest, and send Interest with a CobHash value set.\n");
 	fprintf (stdout, "  pipeline         Number of pipeline\n");
 	fprintf (stderr, "  config_file_dir  Configure file directory\n");
 	fprintf (stderr, "  port_num         Port Number\n\n");
@@ -339,8 +339,10 @@ int main (
 			}
 			work_arg = argv[i + 1];
 			mode_val = atoi (work_arg);
-			if ( (mode_val < 0) && (mode_val > 2) ) {
-				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2.\n");
+			if ( (mode_val < 0) || (mode_val > 3) ) {
+				fprintf (stderr, "ERROR: [-m] parameter is 0 or 1 or 2 or 3.\n");
+				print_usage ();
+				return (-1);
 			}
 			mode_f++;
 			i++;
@@ -493,7 +495,7 @@ int main (
 	/*--------------------------------------------
 		For ConHash
 	--------------------------------------------*/
-	if ( (mode_val == 1) || ( mode_val == 2) ) {
+	if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 		memset (&man_opt, 0, sizeof (CefT_CcnMsg_OptHdr));	
 		memset (&man_params, 0, sizeof (CefT_CcnMsg_MsgBdy));
 		strcat( man_uri, CefC_MANIFEST_NAME );
@@ -519,6 +521,22 @@ int main (
 		}
 	}
 	
+	/*--------------------------------------------
+		For Signed Manifest
+	--------------------------------------------*/
+	/* Only the Manifest carries the signature. Each Cob is bound to it by the	*/
+	/* ObjHash listed in the record, so RSA signing runs once per Manifest		*/
+	/* (CefC_MANIFEST_REC_MAX chunks) instead of once per chunk.				*/
+	if (mode_val == 3) {
+		cef_valid_init (conf_path);
+		man_params.KeyIdRester_f = 1;
+		man_params.alg.valid_type = (uint16_t) cef_valid_type_get ("sha256");
+		if (man_params.alg.valid_type == CefC_T_ALG_INVALID) {
+			fprintf (stdout, "ERROR: KeyIdRestriction not get KeyId.\n");
+			exit (1);
+		}
+	}
+	
 
 
 	
@@ -586,7 +604,7 @@ printf ( "CKP-010 params.end_chunk_num_f:%d  params.end_chunk_num:%d\n", params.
 #endif
 				}
 				//0.8.3
-				if ( (mode_val == 1) || ( mode_val == 2) ) {
+				if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 					params.ObjHash_f= 1;
 					memset( params.ObjHash_val, 0x00, 32 );
 					man_params.end_chunk_num_f = params.end_chunk_num_f;
@@ -605,13 +623,13 @@ printf ( "CKP-020 cob_len:%d\n", cob_len );
 					exit (1);
 				}
 				//0.8.3 ObjHash
-				if ( (mode_val == 1) || ( mode_val == 2) ) {
+				if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 					if ( man_buff_idx == 0 ) {
 						man_buff_idx = 4;
 					}
 #ifdef	__DEB_PUT__
 printf ( "CKP-030 man_buff_idx:%d\n", man_buff_idx );
-if ( (mode_val == 1) || ( mode_val == 2) ) {
+if ( (mode_val == 1) || (mode_val == 2) || (mode_val == 3) ) {
 	int hidx;
 	char	hash_dbg[1024];
 	sprintf (hash_dbg, "CobHash [");
@@ -758,7 +776,8 @@ print_usage (
 	fprintf (stdout, "  cache_time       Specifies the period (seconds) after which Content Objects are cached before they are deleted.\n");
 	fprintf (stdout, "  m                0: Create Cob with added security information corresponding to KeyIdRestriction.\n"
 	                 "                   1: Create a Manifest paired with the content and register it as content.\n"
-	                 "                   2: Create a Cob with added security information corresponding to KeyIdRestriction, create a Manifest paired with the content, and register it as content.\n");
+	                 "                   2: Create a Cob with added security information corresponding to KeyIdRestriction, create a Manifest paired with the content, and register it as content.\n"
+	                 "                   3: Create a Manifest signed with the security information corresponding to KeyIdRestriction and paired with the content, and register it as content. Each Cob carries only its hash in the Manifest.\n");
 	fprintf (stderr, "  config_file_dir  Configure file directory\n");
 	fprintf (stderr, "  port_num         Port Number\n\n");
 }
@@ -462,10 +462,47 @@ output_result (
 	memcpy (&stat_hdr, &frame[0], sizeof (struct CefT_Csmgr_Status_Hdr));
 	stat_hdr.node_num 	= ntohs (stat_hdr.node_num);
 	stat_hdr.con_num 	= ntohl (stat_hdr.con_num);
+	stat_hdr.insert_rcv 	= cef_client_ntohb (stat_hdr.insert_rcv);
+	stat_hdr.insert_drop 	= cef_client_ntohb (stat_hdr.insert_drop);
+	stat_hdr.insert_grant 	= cef_client_ntohb (stat_hdr.insert_grant);
+	stat_hdr.comp_raw 		= cef_client_ntohb (stat_hdr.comp_raw);
+	stat_hdr.comp_stored 	= cef_client_ntohb (stat_hdr.comp_stored);
+	stat_hdr.comp_skip 		= cef_client_ntohb (stat_hdr.comp_skip);
+	stat_hdr.comp_ns 		= cef_client_ntohb (stat_hdr.comp_ns);
+	stat_hdr.decomp_cobs 	= cef_client_ntohb (stat_hdr.decomp_cobs);
+	stat_hdr.decomp_ns 		= cef_client_ntohb (stat_hdr.decomp_ns);
 	
 	fprintf (stderr, "*****   Connection Status Report   *****\n");
 	fprintf (stderr, "All Connection Num             : %d\n\n", stat_hdr.node_num);
 	
+	fprintf (stderr, "*****   Insert Status Report       *****\n");
+	fprintf (stderr, "Received Bytes                 : %llu\n",
+		(unsigned long long) stat_hdr.insert_rcv);
+	fprintf (stderr, "Dropped Bytes                  : %llu\n",
+		(unsigned long long) stat_hdr.insert_drop);
+	fprintf (stderr, "Granted Bytes                  : %llu\n\n",
+		(unsigned long long) stat_hdr.insert_grant);
+	
+	/* Reported only by the cache plugin which compresses the cobs 	*/
+	if (stat_hdr.comp_raw || stat_hdr.comp_skip || stat_hdr.decomp_cobs) {
+		fprintf (stderr, "*****   Compression Status Report  *****\n");
+		fprintf (stderr, "Input Bytes                    : %llu\n",
+			(unsigned long long) stat_hdr.comp_raw);
+		fprintf (stderr, "Stored Bytes                   : %llu\n",
+			(unsigned long long) stat_hdr.comp_stored);
+		fprintf (stderr, "Compression Ratio              : %.1f %%\n",
+			stat_hdr.comp_raw ? 
+				(double) stat_hdr.comp_stored * 100.0 / stat_hdr.comp_raw : 100.0);
+		fprintf (stderr, "Stored Raw Cobs                : %llu\n",
+			(unsigned long long) stat_hdr.comp_skip);
+		fprintf (stderr, "Compression Time (us)          : %llu\n",
+			(unsigned long long)(stat_hdr.comp_ns / 1000));
+		fprintf (stderr, "Decompressed Cobs              : %llu\n",
+			(unsigned long long) stat_hdr.decomp_cobs);
+		fprintf (stderr, "Decompression Time (us)        : %llu\n\n",
+			(unsigned long long)(stat_hdr.decomp_ns / 1000));
+	}
+	
 	fprintf (stderr, "*****   Cache Status Report        *****\n");
 	fprintf (stderr, "Number of Cached Contents      : %d\n\n", stat_hdr.con_num);
 	index += sizeof (struct CefT_Csmgr_Status_Hdr);